@@ -0,0 +1,261 @@
+// memprof-gui/bench/snapshot_decode.cpp
+// Decodificación de una línea JSON del runtime (MEMPROF_WIRE_FORMAT=json) en
+// la GUI: el camino anterior (QJsonDocument + conversión campo a campo) frente
+// a SnapshotDecoder reutilizado entre ticks. Comprueba que general, per_file
+// y leaks salen iguales (son las secciones que pesan; la copia del camino
+// anterior solo cubre esas).
+//
+// Uso: bench_snapshot_decode [captura.ndjson | bloques] [ticks]
+// Con una captura (p. ej. de 'nc -l 7070 > cap.ndjson') se usa su última
+// línea; si no, se sintetiza un snapshot con N bloques vivos (500k).
+#include "frontend/net/SnapshotDecoder.h"
+#include "memprof/proto/JsonWriter.h"
+
+#include <QByteArray>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonValue>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <string>
+
+namespace {
+
+// ---- camino anterior (copia de ServerWorker.cpp antes de SnapshotDecoder) ----
+
+quint64 toU64(const QJsonValue& v, quint64 def = 0) {
+    if (v.isUndefined() || v.isNull()) return def;
+    if (v.isString()) {
+        QString s = v.toString().trimmed();
+        bool ok = false;
+        const quint64 x = s.startsWith("0x", Qt::CaseInsensitive) ? s.mid(2).toULongLong(&ok, 16)
+                                                                   : s.toULongLong(&ok, 10);
+        return ok ? x : def;
+    }
+    if (v.isDouble()) {
+        const double d = v.toDouble();
+        if (d < 0) return def;
+        const long double ld = static_cast<long double>(d);
+        if (ld > static_cast<long double>(std::numeric_limits<quint64>::max())) return def;
+        return static_cast<quint64>(ld);
+    }
+    bool ok = false;
+    const quint64 x = v.toVariant().toULongLong(&ok);
+    return ok ? x : def;
+}
+
+qlonglong toI64(const QJsonValue& v, qlonglong def = 0) {
+    if (v.isUndefined() || v.isNull()) return def;
+    if (v.isString()) {
+        bool ok = false;
+        const qlonglong x = v.toString().toLongLong(&ok, 10);
+        return ok ? x : def;
+    }
+    if (v.isDouble()) return static_cast<qlonglong>(static_cast<long double>(v.toDouble()));
+    bool ok = false;
+    const qlonglong x = v.toVariant().toLongLong(&ok);
+    return ok ? x : def;
+}
+
+int toInt(const QJsonValue& v, int def = 0) {
+    if (v.isString()) {
+        bool ok = false;
+        const int x = v.toString().toInt(&ok, 10);
+        return ok ? x : def;
+    }
+    if (v.isDouble()) return v.toInt(def);
+    return def;
+}
+
+bool legacy(const QByteArray& line, MetricsSnapshot& out) {
+    QJsonParseError err{};
+    const QJsonDocument doc = QJsonDocument::fromJson(line, &err);
+    if (err.error != QJsonParseError::NoError || !doc.isObject()) return false;
+    const QJsonObject obj = doc.object();
+
+    const QJsonObject g = obj["general"].toObject();
+    out.heapCurrent     = toU64(g.value("heap_current"));
+    out.heapPeak        = toU64(g.value("heap_peak"));
+    out.activeAllocs    = toU64(g.value("active_allocs"));
+    out.totalAllocs     = toU64(g.value("total_allocs"));
+    out.leakBytes       = toU64(g.value("leak_bytes"));
+    out.allocRate       = g.value("alloc_rate").toDouble();
+    out.freeRate        = g.value("free_rate").toDouble();
+    out.uptimeMs        = toU64(g.value("uptime_ms"));
+    out.leakRate        = g.value("leak_rate").toDouble();
+    out.largestLeakSz   = toU64(g.value("largest_size"));
+    out.largestLeakFile = g.value("largest_file").toString();
+    out.topLeakFile     = g.value("top_file").toString();
+    out.topLeakCount    = toInt(g.value("top_file_count"));
+    out.topLeakBytes    = toI64(g.value("top_file_bytes"));
+
+    const QJsonArray files = obj["per_file"].toArray();
+    out.perFile.reserve(files.size());
+    for (const QJsonValue& v : files) {
+        const QJsonObject o = v.toObject();
+        FileStat fs;
+        fs.file       = o.value("file").toString();
+        fs.totalBytes = toI64(o.value("totalBytes"));
+        fs.allocs     = toInt(o.value("allocs"));
+        fs.frees      = toInt(o.value("frees"));
+        fs.netBytes   = toI64(o.value("netBytes"));
+        out.perFile.push_back(fs);
+    }
+
+    const QJsonArray leaks = obj["leaks"].toArray();
+    out.leaks.reserve(leaks.size());
+    for (const QJsonValue& v : leaks) {
+        const QJsonObject o = v.toObject();
+        LeakItem li;
+        li.ptr     = toU64(o.value("ptr"));
+        li.size    = toI64(o.value("size"));
+        li.file    = o.value("file").toString();
+        li.line    = toInt(o.value("line"));
+        li.type    = o.value("type").toString();
+        li.ts_ns   = toU64(o.value("ts_ns"));
+        li.isLeak  = o.value("is_leak").toBool(false);
+        li.stackId = unsigned(toU64(o.value("stack")));
+        li.pc      = toU64(o.value("pc"));
+        out.leaks.push_back(li);
+    }
+    return true;
+}
+
+// ---- entrada ----
+
+// Snapshot con el esquema de write_json (Runtime.cpp): general, per_file y leaks
+QByteArray synthesize(size_t n) {
+    static const char* types[] = {"int", "Node", "std::string", "std::vector<int>", "char"};
+    std::string s;
+    json::Writer w(s);
+    w.raw("{\"general\":{");
+    w.key("heap_current"); w.u64(n * 512);     w.ch(',');
+    w.key("heap_peak");    w.u64(n * 600);     w.ch(',');
+    w.key("active_allocs"); w.u64(n);          w.ch(',');
+    w.key("total_allocs"); w.u64(n * 3);       w.ch(',');
+    w.key("leak_bytes");   w.u64(n * 40);      w.ch(',');
+    w.key("alloc_rate");   w.f64(12345.5);     w.ch(',');
+    w.key("free_rate");    w.f64(12000.25);    w.ch(',');
+    w.key("uptime_ms");    w.u64(987654);      w.ch(',');
+    w.key("leak_rate");    w.f64(0.0909);      w.ch(',');
+    w.key("largest_size"); w.u64(4096);        w.ch(',');
+    w.key("largest_file"); w.str("src/module1/file1.cpp"); w.ch(',');
+    w.key("top_file");     w.str("C:\\proj\\src\\win17.cpp"); w.ch(',');
+    w.key("top_file_count"); w.i64(4242);      w.ch(',');
+    w.key("top_file_bytes"); w.i64(int64_t(1) << 40);
+    w.raw("},\"per_file\":[");
+    for (unsigned f = 0; f < 256; ++f) {
+        if (f) w.ch(',');
+        w.raw("{\"file\":"); w.str("src/module" + std::to_string(f % 32) + "/file" + std::to_string(f) + ".cpp");
+        w.raw(",\"totalBytes\":"); w.i64(int64_t(f) * 100003);
+        w.raw(",\"allocs\":");     w.i64(f * 7);
+        w.raw(",\"frees\":");      w.i64(f * 5);
+        w.raw(",\"netBytes\":");   w.i64(int64_t(f) * 4099);
+        w.ch('}');
+    }
+    w.raw("],\"leaks\":[");
+    uint64_t ts = 1'000'000;
+    for (size_t i = 0; i < n; ++i) {
+        const unsigned site = unsigned((i * 31) % 256);
+        if (i) w.ch(',');
+        w.raw("{\"ptr\":");  w.hex((uintptr_t(0x7f00) << 32) | (uintptr_t(i) << 4));
+        w.raw(",\"size\":"); w.u64(16 + (i * 7919) % 4096);
+        if (site % 3 == 0) { w.raw(",\"pc\":"); w.hex(0x400000 + site * 0x40); }
+        w.raw(",\"file\":"); w.str("src/module" + std::to_string(site % 32) + "/file" + std::to_string(site) + ".cpp");
+        w.raw(",\"line\":"); w.i64(10 + site);
+        w.raw(",\"type\":"); w.str(types[site % 5]);
+        w.raw(",\"ts_ns\":"); w.u64(ts += 137);
+        w.raw(",\"is_leak\":"); w.boolean(i % 11 == 0);
+        w.raw(",\"stack\":"); w.u64(1 + i % 1000);
+        w.ch('}');
+    }
+    w.raw("]}");
+    return QByteArray(s.data(), int(s.size()));
+}
+
+QByteArray lastLine(const char* path) {
+    QFile f(QString::fromLocal8Bit(path));
+    if (!f.open(QIODevice::ReadOnly)) return {};
+    const QByteArray all = f.readAll();
+    qsizetype end = all.size();
+    while (end > 0 && (all[end - 1] == '\n' || all[end - 1] == '\r')) --end;
+    const qsizetype start = all.lastIndexOf('\n', end - 1) + 1;
+    return all.mid(start, end - start);
+}
+
+bool sameGeneral(const MetricsSnapshot& a, const MetricsSnapshot& b) {
+    return a.heapCurrent == b.heapCurrent && a.heapPeak == b.heapPeak
+        && a.activeAllocs == b.activeAllocs && a.totalAllocs == b.totalAllocs
+        && a.leakBytes == b.leakBytes && a.allocRate == b.allocRate && a.freeRate == b.freeRate
+        && a.uptimeMs == b.uptimeMs && a.leakRate == b.leakRate
+        && a.largestLeakSz == b.largestLeakSz && a.largestLeakFile == b.largestLeakFile
+        && a.topLeakFile == b.topLeakFile && a.topLeakCount == b.topLeakCount
+        && a.topLeakBytes == b.topLeakBytes;
+}
+
+bool sameRows(const MetricsSnapshot& a, const MetricsSnapshot& b) {
+    if (a.perFile.size() != b.perFile.size() || a.leaks.size() != b.leaks.size()) return false;
+    for (qsizetype i = 0; i < a.perFile.size(); ++i) {
+        const FileStat &x = a.perFile[i], &y = b.perFile[i];
+        if (x.file != y.file || x.totalBytes != y.totalBytes || x.allocs != y.allocs
+            || x.frees != y.frees || x.netBytes != y.netBytes) return false;
+    }
+    for (qsizetype i = 0; i < a.leaks.size(); ++i) {
+        const LeakItem &x = a.leaks[i], &y = b.leaks[i];
+        if (x.ptr != y.ptr || x.size != y.size || x.file != y.file || x.line != y.line
+            || x.type != y.type || x.ts_ns != y.ts_ns || x.isLeak != y.isLeak
+            || x.stackId != y.stackId || x.pc != y.pc) return false;
+    }
+    return true;
+}
+
+double ms_since(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const char* arg = argc > 1 ? argv[1] : "500000";
+    const int ticks = argc > 2 ? std::max(1, std::atoi(argv[2])) : 5;
+
+    char* rest = nullptr;
+    const unsigned long long n = std::strtoull(arg, &rest, 10);
+    const QByteArray line = (*rest == '\0') ? synthesize(size_t(n)) : lastLine(arg);
+    if (line.isEmpty()) {
+        std::fprintf(stderr, "no se pudo leer %s\n", arg);
+        return 2;
+    }
+    std::printf("línea: %.1f MB  ticks: %d\n", line.size() / 1e6, ticks);
+
+    // Un decodificador para todos los ticks, como el de cada cliente en ServerWorker
+    SnapshotDecoder dec;
+    MetricsSnapshot a, b;
+    bool okA = true, okB = true;
+    double ta = 1e300, tb = 1e300;
+    for (int k = 0; k < ticks; ++k) {
+        a = MetricsSnapshot();
+        auto t0 = std::chrono::steady_clock::now();
+        okA = legacy(line, a) && okA;
+        ta = std::min(ta, ms_since(t0));
+
+        b = MetricsSnapshot();
+        t0 = std::chrono::steady_clock::now();
+        okB = dec.decode(line.constData(), line.size(), b) && okB;
+        tb = std::min(tb, ms_since(t0));
+    }
+
+    const bool same = okA && okB && sameGeneral(a, b) && sameRows(a, b);
+    std::printf("%-16s %10.1f ms  %8.1f MB/s\n", "QJsonDocument", ta, line.size() / 1e3 / ta);
+    std::printf("%-16s %10.1f ms  %8.1f MB/s  (x%.1f)\n", "SnapshotDecoder", tb, line.size() / 1e3 / tb, ta / tb);
+    std::printf("leaks: %lld  per_file: %lld  %s\n", (long long)b.leaks.size(), (long long)b.perFile.size(),
+                same ? "iguales" : "DISTINTOS");
+    return same ? 0 : 1;
+}
@@ -1,4 +1,7 @@
 #include "MainWindow.h"
+#include <QComboBox>
+#include <QLabel>
+#include <QSignalBlocker>
 #include <QTabWidget>
 #include <QStatusBar>
 #include <QThread>
@@ -8,14 +11,31 @@
 #include "frontend/tabs/MapTab.h"
 #include "frontend/tabs/PerFileTab.h"
 #include "frontend/tabs/LeaksTab.h"
+#include "frontend/tabs/SnapshotsTab.h"
+#include "frontend/tabs/PeakTab.h"
+#include "frontend/tabs/LifetimesTab.h"
 #include "frontend/net/ServerWorker.h"
+#include "memprof/proto/LocalChannel.h"
 #include "memprof/proto/MetricsSnapshot.h"
 
 #include <QMetaType>
 
+namespace {
+static inline QString bytesToHuman(qulonglong b) {
+    const double a = double(b);
+    if (a < 1024) return QString::number(b) + " B";
+    if (a < 1024.0 * 1024) return QString::number(a / 1024.0, 'f', 1) + " KB";
+    if (a < 1024.0 * 1024 * 1024) return QString::number(a / (1024.0 * 1024), 'f', 1) + " MB";
+    return QString::number(a / (1024.0 * 1024 * 1024), 'f', 2) + " GB";
+}
+} // namespace
+
 MainWindow::MainWindow(QWidget* parent) : QMainWindow(parent) {
     // Registrar el metatipo de QSharedPointer<MetricsSnapshot>
     qRegisterMetaType<QSharedPointer<const MetricsSnapshot>>("QSharedPointer<const MetricsSnapshot>");
+    qRegisterMetaType<QVector<ClientInfo>>("QVector<ClientInfo>");
+    qRegisterMetaType<QSharedPointer<const LeakTables>>("QSharedPointer<const LeakTables>");
+    qRegisterMetaType<LeakView>("LeakView");
 
     // Pestañas
     tabs_    = new QTabWidget(this);
@@ -23,13 +43,29 @@ MainWindow::MainWindow(QWidget* parent) : QMainWindow(parent) {
     map_     = new MapTab(this);
     perFile_ = new PerFileTab(this);
     leaks_   = new LeaksTab(this);
+    snapshots_ = new SnapshotsTab(this);
+    peak_    = new PeakTab(this);
+    lifetimes_ = new LifetimesTab(this);
 
     tabs_->addTab(general_, "General");
     tabs_->addTab(map_,     "Mapa");
     tabs_->addTab(perFile_, "Por archivo");
     tabs_->addTab(leaks_,   "Leaks");
+    tabs_->addTab(snapshots_, "Snapshots");
+    tabs_->addTab(peak_,    "Pico");
+    tabs_->addTab(lifetimes_, "Vida");
     setCentralWidget(tabs_);
+
+    // Selector de proceso: solo visible con más de un runtime conectado
+    process_ = new QComboBox(this);
+    process_->setSizeAdjustPolicy(QComboBox::AdjustToContents);
+    process_->setVisible(false);
+    tabs_->setCornerWidget(process_, Qt::TopRightCorner);
+    connect(process_, QOverload<int>::of(&QComboBox::currentIndexChanged),
+            this, &MainWindow::onProcessSelected);
     statusBar()->showMessage("Listo");
+    ingest_ = new QLabel(this);
+    statusBar()->addPermanentWidget(ingest_);
 
     // Hilo + worker (worker sin padre para moveToThread)
     thread_ = new QThread(this);
@@ -38,7 +74,11 @@ MainWindow::MainWindow(QWidget* parent) : QMainWindow(parent) {
 
     // Arrancar escucha en el hilo del worker (encolado)
     connect(thread_, &QThread::started, worker_,
-            [w = worker_]{ w->listen(QHostAddress::LocalHost, 7070); },
+            [w = worker_]{
+                w->listen(QHostAddress::LocalHost, 7070);
+                // Runtimes locales: memprof_init("unix:" / "shm:" ...)
+                w->listenLocal(qEnvironmentVariable("MEMPROF_SOCKET", QString::fromLatin1(shmring::kDefaultSocket)));
+            },
             Qt::QueuedConnection);
 
     // Estado a la barra de estado (encolado)
@@ -46,11 +86,34 @@ MainWindow::MainWindow(QWidget* parent) : QMainWindow(parent) {
             this,     &MainWindow::onStatus,
             Qt::QueuedConnection);
 
+    // Procesos conectados -> selector
+    connect(worker_, &ServerWorker::clientsChanged,
+            this,     &MainWindow::onClients,
+            Qt::QueuedConnection);
+
+    // Contadores de recepción -> barra de estado
+    connect(worker_, &ServerWorker::ingestStats,
+            this,     &MainWindow::onIngestStats,
+            Qt::QueuedConnection);
+
     // Guardar snapshot (no pintar aquí)
     connect(worker_, &ServerWorker::snapshotReady,
             this,     &MainWindow::onSnapshot,
             Qt::QueuedConnection);
 
+    // Tablas de bloques ordenadas en el pool del worker (tampoco se pinta aquí)
+    connect(worker_, &ServerWorker::leakTablesReady,
+            this,     &MainWindow::onLeakTables,
+            Qt::QueuedConnection);
+
+    // Orden/filtro de las tablas -> el worker rehace la permutación
+    connect(leaks_, &LeaksTab::viewChanged, worker_,
+            [w = worker_](const LeakView& v) { w->setLeakView(ServerWorker::kLeaksTable, v); },
+            Qt::QueuedConnection);
+    connect(map_, &MapTab::viewChanged, worker_,
+            [w = worker_](const LeakView& v) { w->setLeakView(ServerWorker::kBlocksTable, v); },
+            Qt::QueuedConnection);
+
     // Limpieza segura
     connect(thread_, &QThread::finished, worker_, &QObject::deleteLater);
 
@@ -77,19 +140,62 @@ void MainWindow::onSnapshot(QSharedPointer<const MetricsSnapshot> s) {
     pending_.swap(s);
 }
 
+void MainWindow::onLeakTables(QSharedPointer<const LeakTables> t) {
+    pendingTables_.swap(t);
+}
+
 void MainWindow::uiTick() {
+    // Pinta SOLO la pestaña visible (reduce trabajo)
+    const int idx = tabs_->currentIndex();
+
+    // Mapa y Leaks, desde las tablas que ordenó el worker (llegan detrás del snapshot)
+    if (idx == 1 || idx == 3) {
+        if (!pendingTables_) return;
+        auto t = pendingTables_;
+        pendingTables_.reset();
+        if (idx == 1) map_->updateTables(t);
+        else          leaks_->updateTables(t);
+        return;
+    }
+
     if (!pending_) return;
     auto s = pending_;     // copia barata del shared_ptr
     pending_.reset();
 
-    // Pinta SOLO la pestaña visible (reduce trabajo)
-    const int idx = tabs_->currentIndex();
     if      (idx == 0) general_->updateSnapshot(*s);
-    else if (idx == 1) map_->updateSnapshot(*s);
     else if (idx == 2) perFile_->updateSnapshot(*s);
-    else if (idx == 3) leaks_->updateSnapshot(*s);
+    else if (idx == 4) snapshots_->updateSnapshot(*s);
+    else if (idx == 5) peak_->updateSnapshot(*s);
+    else if (idx == 6) lifetimes_->updateSnapshot(*s);
 }
 
 void MainWindow::onStatus(const QString& st) {
     statusBar()->showMessage(st, 3000);
 }
+
+void MainWindow::onClients(const QVector<ClientInfo>& clients) {
+    const quint32 current = process_->currentIndex() >= 0
+                          ? process_->currentData().toUInt() : ServerWorker::kFleet;
+    QSignalBlocker block(process_);
+    process_->clear();
+    process_->addItem(tr("Flota (%1 procesos)").arg(clients.size()), ServerWorker::kFleet);
+    for (const ClientInfo& c : clients)
+        process_->addItem(QStringLiteral("%1 (pid %2, %3)").arg(c.name).arg(c.pid).arg(c.kind), c.id);
+    // El worker ya vuelve a la flota si el proceso elegido se fue
+    const int idx = process_->findData(current);
+    process_->setCurrentIndex(idx >= 0 ? idx : 0);
+    process_->setVisible(clients.size() > 1 || process_->currentData().toUInt() != ServerWorker::kFleet);
+}
+
+void MainWindow::onProcessSelected(int index) {
+    if (index < 0) return;
+    const quint32 id = process_->itemData(index).toUInt();
+    pending_.reset();   // lo recibido era de la vista anterior
+    pendingTables_.reset();
+    QMetaObject::invokeMethod(worker_, [w = worker_, id] { w->selectClient(id); }, Qt::QueuedConnection);
+}
+
+void MainWindow::onIngestStats(quint64 bytes, quint64 messages, quint64 dropped) {
+    ingest_->setText(tr("Recibido: %1 · mensajes: %2 · descartados: %3")
+                     .arg(bytesToHuman(bytes)).arg(messages).arg(dropped));
+}
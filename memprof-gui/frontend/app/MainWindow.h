@@ -5,14 +5,19 @@
 #include <QTimer>
 
 #include "memprof/proto/MetricsSnapshot.h"
+#include "frontend/net/ServerWorker.h"
 
+class QComboBox;
+class QLabel;
 class QTabWidget;
 class QThread;
-class ServerWorker;
 class GeneralTab;
 class MapTab;
 class PerFileTab;
 class LeaksTab;
+class SnapshotsTab;
+class PeakTab;
+class LifetimesTab;
 
 class MainWindow : public QMainWindow {
     Q_OBJECT
@@ -22,19 +27,29 @@ public:
 
 private slots:
     void onSnapshot(QSharedPointer<const MetricsSnapshot> s); // recibe puntero compartido
+    void onLeakTables(QSharedPointer<const LeakTables> t);    // Mapa y Leaks, ya ordenadas
     void onStatus(const QString& st);
+    void onClients(const QVector<ClientInfo>& clients);   // rehace el selector de proceso
+    void onProcessSelected(int index);
+    void onIngestStats(quint64 bytes, quint64 messages, quint64 dropped);
     void uiTick(); // pinta a ~12.5 FPS el último snapshot guardado
 
 private:
     QTabWidget* tabs_ = nullptr;
+    QComboBox*  process_ = nullptr;   // flota / un proceso (esquina de las pestañas)
+    QLabel*     ingest_  = nullptr;   // contadores de recepción (barra de estado)
     GeneralTab* general_ = nullptr;
     MapTab*     map_ = nullptr;
     PerFileTab* perFile_ = nullptr;
     LeaksTab*   leaks_ = nullptr;
+    SnapshotsTab* snapshots_ = nullptr;
+    PeakTab*    peak_ = nullptr;
+    LifetimesTab* lifetimes_ = nullptr;
 
     QThread*      thread_  = nullptr;
     ServerWorker* worker_  = nullptr;
 
     QTimer* uiTimer_ = nullptr;
     QSharedPointer<const MetricsSnapshot> pending_; // último snapshot recibido
+    QSharedPointer<const LeakTables> pendingTables_; // últimas tablas de bloques recibidas
 };
@@ -0,0 +1,158 @@
+#pragma once
+#include <QAbstractTableModel>
+#include <QHash>
+#include <QVector>
+
+#include <utility>
+#include <vector>
+
+// Base de las tablas que se rellenan con cada snapshot. En vez de
+// beginResetModel, sync() casa las filas por clave con las del snapshot
+// nuevo y emite solo lo que cambió: tramos quitados, filas modificadas y las
+// nuevas al final. La vista conserva selección, scroll y orden, y el proxy
+// solo recoloca las filas tocadas.
+//
+// El orden interno no importa (lo pone el proxy): las filas que siguen no se
+// mueven. Con muchos huecos dispersos (kMaxRuns) un borrado por tramo saldría
+// más caro que reordenar una vez, y se agrupan con un cambio de layout que
+// mantiene los índices persistentes.
+template <class Row, class Key>
+class KeyedTableModel : public QAbstractTableModel {
+public:
+    using QAbstractTableModel::QAbstractTableModel;
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override {
+        return parent.isValid() ? 0 : int(rows_.size() - gap_);
+    }
+
+protected:
+    virtual Key  keyOf(const Row& r) const = 0;
+    virtual bool sameRow(const Row& a, const Row& b) const = 0;   // iguales para la vista
+    virtual bool accepts(const Row&) const { return true; }       // filtro de filas
+
+    // Fila visible 'row' (válida también en mitad de sync())
+    const Row& rowAt(int row) const { return rows_[row < gapAt_ ? row : row + gap_]; }
+    const QVector<Row>& rows() const { return rows_; }
+
+    void sync(const QVector<Row>& next);
+
+private:
+    QVector<Row> rows_;
+    // Durante sync(): [0, gapAt_) ya compactadas y gap_ filas quitadas detrás
+    qsizetype    gapAt_ = 0;
+    qsizetype    gap_   = 0;
+
+    static constexpr qsizetype kMaxRuns = 256;   // tramos/rangos sueltos antes de agrupar
+};
+
+template <class Row, class Key>
+void KeyedTableModel<Row, Key>::sync(const QVector<Row>& next) {
+    // Filas entrantes por clave; 'taken' marca las ya casadas o descartadas
+    // (filtradas o repetidas: gana la última)
+    std::vector<char> taken(size_t(next.size()), 0);
+    QHash<Key, qsizetype> incoming;
+    incoming.reserve(int(next.size()));
+    for (qsizetype i = 0; i < next.size(); ++i) {
+        if (!accepts(next[i])) { taken[size_t(i)] = 1; continue; }
+        auto it = incoming.find(keyOf(next[i]));
+        if (it == incoming.end()) { incoming.insert(keyOf(next[i]), i); continue; }
+        taken[size_t(*it)] = 1;
+        *it = i;
+    }
+
+    // Destino de cada fila actual en 'next' (-1: se va)
+    const qsizetype n = rows_.size();
+    std::vector<qsizetype> match(size_t(n), -1);
+    qsizetype runs = 0;
+    for (qsizetype i = 0; i < n; ++i) {
+        const auto it = incoming.constFind(keyOf(rows_[i]));
+        if (it != incoming.constEnd() && !taken[size_t(*it)]) {
+            match[size_t(i)] = *it;
+            taken[size_t(*it)] = 1;
+        } else if (i == 0 || match[size_t(i - 1)] != -1) {
+            ++runs;   // empieza un tramo a quitar
+        }
+    }
+
+    // ----- quitar -----
+    qsizetype w = 0;
+    if (runs > kMaxRuns) {
+        // Las que se van pasan al final (orden estable) y salen de una vez
+        std::vector<qsizetype> to(static_cast<size_t>(n));
+        for (qsizetype i = 0; i < n; ++i) if (match[size_t(i)] != -1) to[size_t(i)] = w++;
+        qsizetype tail = w;
+        for (qsizetype i = 0; i < n; ++i) if (match[size_t(i)] == -1) to[size_t(i)] = tail++;
+
+        emit layoutAboutToBeChanged();
+        QVector<Row> moved(static_cast<int>(n));
+        std::vector<qsizetype> movedMatch(static_cast<size_t>(n));
+        for (qsizetype i = 0; i < n; ++i) {
+            moved[to[size_t(i)]] = std::move(rows_[i]);
+            movedMatch[size_t(to[size_t(i)])] = match[size_t(i)];
+        }
+        rows_.swap(moved);
+        match.swap(movedMatch);
+        const QModelIndexList from = persistentIndexList();
+        QModelIndexList dest;
+        dest.reserve(from.size());
+        for (const QModelIndex& ix : from) dest.push_back(index(int(to[size_t(ix.row())]), ix.column()));
+        changePersistentIndexList(from, dest);
+        emit layoutChanged();
+
+        beginRemoveRows(QModelIndex(), int(w), int(n - 1));
+        rows_.resize(w);
+        endRemoveRows();
+    } else if (runs > 0) {
+        // Compactación en una pasada: cada tramo se anuncia con los índices
+        // visibles en ese momento (rowAt salta el hueco ya quitado)
+        for (qsizetype i = 0; i < n;) {
+            if (match[size_t(i)] == -1) {
+                qsizetype j = i + 1;
+                while (j < n && match[size_t(j)] == -1) ++j;
+                beginRemoveRows(QModelIndex(), int(w), int(w + (j - i) - 1));
+                gap_ += j - i;
+                endRemoveRows();
+                i = j;
+                continue;
+            }
+            if (gap_) {
+                rows_[w] = std::move(rows_[i]);
+                match[size_t(w)] = match[size_t(i)];
+            }
+            gapAt_ = ++w;
+            ++i;
+        }
+        rows_.resize(w);
+        gapAt_ = gap_ = 0;
+    } else {
+        w = n;
+    }
+
+    // ----- modificar -----
+    std::vector<std::pair<qsizetype, qsizetype>> changed;   // rangos [a, b]
+    for (qsizetype r = 0; r < w; ++r) {
+        const Row& src = next[match[size_t(r)]];
+        if (sameRow(rows_[r], src)) continue;
+        rows_[r] = src;
+        if (!changed.empty() && changed.back().second == r - 1) changed.back().second = r;
+        else changed.emplace_back(r, r);
+    }
+    if (!changed.empty()) {
+        const int last = columnCount() - 1;
+        if (qsizetype(changed.size()) > kMaxRuns)
+            changed = {{changed.front().first, changed.back().second}};
+        for (const auto& c : changed)
+            emit dataChanged(index(int(c.first), 0), index(int(c.second), last));
+    }
+
+    // ----- añadir (al final, en el orden del snapshot) -----
+    qsizetype added = 0;
+    for (char t : taken) added += !t;
+    if (added) {
+        beginInsertRows(QModelIndex(), int(w), int(w + added - 1));
+        rows_.reserve(w + added);
+        for (qsizetype i = 0; i < next.size(); ++i)
+            if (!taken[size_t(i)]) rows_.push_back(next[i]);
+        endInsertRows();
+    }
+}
@@ -0,0 +1,115 @@
+#include "LeakOrder.h"
+
+#include <QHash>
+#include <QSet>
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+namespace {
+// Fila a ordenar: clave de la columna, desempate por ptr (estable entre ticks)
+struct SortKey {
+    quint64 key;
+    quint64 ptr;
+    int     idx;
+    bool operator<(const SortKey& o) const { return key != o.key ? key < o.key : ptr < o.ptr; }
+};
+
+// Con signo -> sin signo conservando el orden
+inline quint64 signedKey(qint64 v) { return quint64(v) ^ (quint64(1) << 63); }
+
+inline double bytesToMB(qint64 bytes) { return bytes / (1024.0 * 1024.0); }
+
+constexpr int kTimelineBuckets = 1024;   // puntos de la curva temporal, como mucho
+} // namespace
+
+QVector<int> buildLeakOrder(const QVector<LeakItem>& leaks, const LeakView& view) {
+    // Filtro: se evalúa una vez por cadena distinta. Las cadenas de un
+    // snapshot vienen compartidas por sitio (ver SnapshotDecoder), así que la
+    // caché va por puntero; dos copias iguales solo cuestan una evaluación más.
+    QHash<const QChar*, bool> hit;
+    auto matches = [&](const QString& str) {
+        auto it = hit.constFind(str.constData());
+        if (it != hit.constEnd()) return *it;
+        const bool m = str.contains(view.filter, Qt::CaseInsensitive);
+        hit.insert(str.constData(), m);
+        return m;
+    };
+
+    QVector<int> order;
+    order.reserve(leaks.size());
+    for (int i = 0; i < leaks.size(); ++i) {
+        const LeakItem& li = leaks[i];
+        if (view.leaksOnly && !li.isLeak) continue;
+        if (!view.filter.isEmpty() && !matches(li.file) && !matches(li.type)) continue;
+        order.push_back(i);
+    }
+    const LeakField f = view.sortField;
+    if (f == LeakField::None) return order;
+
+    // Solo la columna de orden, en un array compacto
+    QHash<QString, quint64> rank;   // texto -> posición entre los distintos
+    if (f == LeakField::File || f == LeakField::Type) {
+        QSet<QString> distinct;
+        for (int i : order) distinct.insert(f == LeakField::File ? leaks[i].file : leaks[i].type);
+        QList<QString> sorted = distinct.values();
+        std::sort(sorted.begin(), sorted.end());
+        rank.reserve(sorted.size());
+        for (int r = 0; r < sorted.size(); ++r) rank.insert(sorted[r], quint64(r));
+    }
+    std::vector<SortKey> keys;
+    keys.reserve(size_t(order.size()));
+    for (int i : order) {
+        const LeakItem& li = leaks[i];
+        quint64 k = 0;
+        switch (f) {
+            case LeakField::None:  break;
+            case LeakField::Ptr:   k = li.ptr; break;
+            case LeakField::Size:  k = signedKey(li.size); break;
+            case LeakField::File:  k = rank.value(li.file); break;
+            case LeakField::Line:  k = signedKey(li.line); break;
+            case LeakField::Type:  k = rank.value(li.type); break;
+            case LeakField::Ts:    k = li.ts_ns; break;
+            case LeakField::State: k = li.isLeak ? 1 : 0; break;
+        }
+        keys.push_back({k, li.ptr, i});
+    }
+    std::sort(keys.begin(), keys.end());
+    if (view.order == Qt::DescendingOrder) std::reverse(keys.begin(), keys.end());
+    for (size_t r = 0; r < keys.size(); ++r) order[int(r)] = keys[r].idx;
+    return order;
+}
+
+LeakCharts buildLeakCharts(const QVector<LeakItem>& leaks) {
+    LeakCharts out;
+
+    // MB por archivo y rango temporal, en una pasada
+    QHash<QString, double> mbByFile;
+    qulonglong tmin = std::numeric_limits<qulonglong>::max(), tmax = 0;
+    for (const LeakItem& L : leaks) {
+        if (!L.isLeak) continue;
+        mbByFile[L.file] += bytesToMB(L.size);
+        tmin = std::min(tmin, L.ts_ns);
+        tmax = std::max(tmax, L.ts_ns);
+    }
+    out.mbByFile.reserve(mbByFile.size());
+    for (auto it = mbByFile.cbegin(); it != mbByFile.cend(); ++it)
+        out.mbByFile.push_back({it.key(), it.value()});
+    if (mbByFile.isEmpty()) return out;
+
+    // Curva: la fuga mayor de cada cubeta (ya queda ordenada por tiempo)
+    const qulonglong span = tmax - tmin;
+    out.spanSec = double(span) / 1e9;
+    std::vector<QPointF> best(kTimelineBuckets, QPointF(-1.0, -1.0));
+    for (const LeakItem& L : leaks) {
+        if (!L.isLeak) continue;
+        const qulonglong dt = L.ts_ns - tmin;
+        const int b = span ? int(double(dt) / double(span) * (kTimelineBuckets - 1)) : 0;
+        const double mb = bytesToMB(L.size);
+        if (mb > best[size_t(b)].y()) best[size_t(b)] = QPointF(double(dt) / 1e9, mb);
+    }
+    for (const QPointF& p : best)
+        if (p.y() >= 0.0) out.timeline.push_back(p);
+    return out;
+}
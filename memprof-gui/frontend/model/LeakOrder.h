@@ -0,0 +1,54 @@
+#pragma once
+#include <QMetaType>
+#include <QPair>
+#include <QPointF>
+#include <QSharedPointer>
+#include <QString>
+#include <QVector>
+
+#include "memprof/proto/MetricsSnapshot.h"
+
+// -------------------- Orden de las tablas de bloques --------------------
+// Filtrado, orden y datos de las gráficas de Leaks/Mapa. Son funciones puras
+// sobre el vector de bloques del snapshot: el worker las corre en su pool
+// junto a residentSnapshot y la GUI recibe la permutación ya hecha
+// (LeakPageModel::setTables), sin recorrer millones de filas en su hilo.
+
+enum class LeakField { None, Ptr, Size, File, Line, Type, Ts, State };
+
+// Lo que pide una tabla: qué filas y en qué orden
+struct LeakView {
+    bool          leaksOnly = false;   // solo isLeak (pestaña Leaks)
+    QString       filter;              // subcadena de archivo o tipo, sin distinguir mayúsculas
+    LeakField     sortField = LeakField::None;   // None: orden del snapshot
+    Qt::SortOrder order     = Qt::AscendingOrder;
+
+    bool operator==(const LeakView& o) const {
+        return leaksOnly == o.leaksOnly && filter == o.filter
+            && sortField == o.sortField && order == o.order;
+    }
+    bool operator!=(const LeakView& o) const { return !(*this == o); }
+};
+Q_DECLARE_METATYPE(LeakView)
+
+// Índices de 'leaks' que pasan el filtro, ya ordenados (desempate por ptr)
+QVector<int> buildLeakOrder(const QVector<LeakItem>& leaks, const LeakView& view);
+
+// Gráficas de la pestaña Leaks, ya reducidas: su coste en la GUI va con el
+// número de archivos y de cubetas, no con el de fugas
+struct LeakCharts {
+    QVector<QPair<QString, double>> mbByFile;   // archivo (tal cual) -> MB fugados
+    QVector<QPointF> timeline;                  // (s desde la primera fuga, MB), máximo por cubeta
+    double spanSec = 0.0;                       // de la primera a la última fuga
+};
+
+LeakCharts buildLeakCharts(const QVector<LeakItem>& leaks);
+
+// Lo que el worker entrega de una vez: el snapshot y, para cada tabla, la
+// vista con la que se ordenó (la GUI descarta las que ya no coinciden)
+struct LeakTables {
+    QSharedPointer<const MetricsSnapshot> snapshot;
+    LeakView     leaksView, blocksView;
+    QVector<int> leaks, blocks;   // permutaciones sobre snapshot->leaks
+    LeakCharts   charts;
+};
@@ -0,0 +1,151 @@
+#include "LeakPageModel.h"
+
+#include <QColor>
+#include <QHash>
+
+#include <algorithm>
+#include <vector>
+
+// ==================== LeakPageModel ====================
+LeakPageModel::LeakPageModel(Kind kind, QObject* parent)
+    : QAbstractTableModel(parent), kind_(kind) {
+    columns_ = {LeakField::Ptr, LeakField::Size, LeakField::File, LeakField::Line, LeakField::Type,
+                kind == Kind::Leaks ? LeakField::Ts : LeakField::State};
+    view_.leaksOnly = (kind == Kind::Leaks);
+}
+
+int LeakPageModel::rowCount(const QModelIndex& parent) const {
+    return parent.isValid() ? 0 : loaded_;
+}
+
+int LeakPageModel::columnCount(const QModelIndex& parent) const {
+    return parent.isValid() ? 0 : int(columns_.size());
+}
+
+QVariant LeakPageModel::headerData(int section, Qt::Orientation orientation, int role) const {
+    if (role != Qt::DisplayRole || orientation != Qt::Horizontal) return {};
+    if (section < 0 || section >= columns_.size()) return {};
+    switch (columns_[section]) {
+        case LeakField::None:  break;
+        case LeakField::Ptr:   return "Ptr";
+        case LeakField::Size:  return "Size (B)";
+        case LeakField::File:  return "File";
+        case LeakField::Line:  return "Line";
+        case LeakField::Type:  return "Type";
+        case LeakField::Ts:    return "ts_ns";
+        case LeakField::State: return "Estado";
+    }
+    return {};
+}
+
+QVariant LeakPageModel::data(const QModelIndex& index, int role) const {
+    if (!index.isValid() || index.row() >= loaded_ || index.column() >= columns_.size()) return {};
+    const LeakItem& it = leak(index.row());
+    const LeakField f = columns_[index.column()];
+
+    if (role == Qt::DisplayRole) {
+        switch (f) {
+            case LeakField::None:  break;
+            case LeakField::Ptr:   return QString("0x%1").arg(QString::number(it.ptr, 16));
+            case LeakField::Size:  return it.size;
+            case LeakField::File:  return it.file;
+            case LeakField::Line:  return it.line;
+            case LeakField::Type:  return it.type;
+            case LeakField::Ts:    return QString::number(it.ts_ns);
+            case LeakField::State: return it.isLeak ? "LEAK" : "Activo";   // ← directo del runtime
+        }
+    }
+    if (role == Qt::TextAlignmentRole && (f == LeakField::Size || f == LeakField::Line))
+        return static_cast<int>(Qt::AlignRight | Qt::AlignVCenter);
+    if (role == Qt::ForegroundRole && kind_ == Kind::Blocks)
+        return it.isLeak ? QColor(200,40,40) : QColor(40,140,60);
+    if (role == Qt::ToolTipRole && (f == LeakField::File || f == LeakField::Line) && !it.function.isEmpty())
+        return it.function;
+    return {};
+}
+
+bool LeakPageModel::canFetchMore(const QModelIndex& parent) const {
+    return !parent.isValid() && loaded_ < order_.size();
+}
+
+void LeakPageModel::fetchMore(const QModelIndex& parent) {
+    if (parent.isValid()) return;
+    const int n = std::min(kPage, int(order_.size()) - loaded_);
+    if (n <= 0) return;
+    beginInsertRows(QModelIndex(), loaded_, loaded_ + n - 1);
+    loaded_ += n;
+    endInsertRows();
+}
+
+void LeakPageModel::sort(int column, Qt::SortOrder order) {
+    LeakView v = view_;
+    v.sortField = (column >= 0 && column < columns_.size()) ? columns_[column] : LeakField::None;
+    v.order     = order;
+    if (v == view_) return;
+    view_ = v;
+    emit viewChanged(view_);
+}
+
+void LeakPageModel::setFilter(const QString& text) {
+    if (text == view_.filter) return;
+    view_.filter = text;
+    emit viewChanged(view_);
+}
+
+void LeakPageModel::setTables(const QSharedPointer<const LeakTables>& t) {
+    if (!t || !t->snapshot) return;
+    const bool leaks = (kind_ == Kind::Leaks);
+    // Permutación de otra vista (sort/filtro pedido después): se espera a la siguiente
+    if ((leaks ? t->leaksView : t->blocksView) != view_) return;
+    apply(t->snapshot, leaks ? t->leaks : t->blocks);
+}
+
+LeakItem LeakPageModel::itemAt(int row) const {
+    return (row >= 0 && row < loaded_) ? leak(row) : LeakItem{};
+}
+
+void LeakPageModel::apply(const QSharedPointer<const MetricsSnapshot>& s, QVector<int> order) {
+    // Se entregan tantas filas como antes (mínimo una página): el scroll no salta
+    const int want = std::min(int(order.size()), std::max(loaded_, kPage));
+
+    // 1) Recortar lo que ya no existe
+    if (want < loaded_) {
+        beginRemoveRows(QModelIndex(), want, loaded_ - 1);
+        loaded_ = want;
+        endRemoveRows();
+    }
+
+    // 2) Cambiar de datos con las filas cargadas reordenadas: cada índice
+    //    persistente (selección, actual) sigue a su bloque si sigue cargado
+    emit layoutAboutToBeChanged();
+    const QModelIndexList from = persistentIndexList();
+    std::vector<qulonglong> ptrs;   // bloque de cada persistente (datos viejos)
+    ptrs.reserve(size_t(from.size()));
+    QHash<qulonglong, int> rowOf;   // ptr seguido -> fila nueva (-1: fuera de lo cargado)
+    for (const QModelIndex& ix : from) {
+        ptrs.push_back(leak(ix.row()).ptr);
+        rowOf.insert(ptrs.back(), -1);
+    }
+    snap_  = s;
+    order_ = std::move(order);
+    int pending = int(rowOf.size());
+    for (int r = 0; r < loaded_ && pending > 0; ++r) {
+        auto it = rowOf.find(leak(r).ptr);
+        if (it != rowOf.end() && *it < 0) { *it = r; --pending; }
+    }
+    QModelIndexList dest;
+    dest.reserve(from.size());
+    for (int k = 0; k < from.size(); ++k) {
+        const int r = rowOf.value(ptrs[size_t(k)], -1);
+        dest.push_back(r >= 0 ? index(r, from[k].column()) : QModelIndex());
+    }
+    changePersistentIndexList(from, dest);
+    emit layoutChanged();
+
+    // 3) Completar hasta 'want'
+    if (want > loaded_) {
+        beginInsertRows(QModelIndex(), loaded_, want - 1);
+        loaded_ = want;
+        endInsertRows();
+    }
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <QAbstractTableModel>
+#include <QSharedPointer>
+#include <QString>
+#include <QVector>
+
+#include "frontend/model/LeakOrder.h"
+#include "memprof/proto/MetricsSnapshot.h"
+
+// -------------------- LeakPageModel --------------------
+// Tabla de bloques vivos para millones de filas (pestañas Leaks y Mapa).
+//
+// No copia filas ni ordena: se queda con el snapshot compartido y la
+// permutación que el worker preparó en su pool (LeakOrder.h). sort() y
+// setFilter() solo cambian la vista pedida y la anuncian (viewChanged); las
+// tablas que llegan con otra vista se ignoran hasta que llega la buena. La
+// vista recibe las filas por páginas (canFetchMore/fetchMore) según se
+// desplaza, y cada permutación nueva reordena solo lo ya entregado con un
+// cambio de layout: la selección sigue a su bloque (por ptr) y el scroll no
+// salta.
+class LeakPageModel : public QAbstractTableModel {
+    Q_OBJECT
+public:
+    enum class Kind {
+        Leaks,    // solo fugas: Ptr | Size | File | Line | Type | ts_ns
+        Blocks,   // todos los vivos: Ptr | Size | File | Line | Type | Estado
+    };
+
+    explicit LeakPageModel(Kind kind, QObject* parent = nullptr);
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role) const override;
+    QVariant data(const QModelIndex& index, int role) const override;
+
+    bool canFetchMore(const QModelIndex& parent) const override;
+    void fetchMore(const QModelIndex& parent) override;
+    void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override;
+
+    void setTables(const QSharedPointer<const LeakTables>& t);
+    void setFilter(const QString& text);   // subcadena de archivo o tipo, sin distinguir mayúsculas
+    const LeakView& view() const { return view_; }
+    LeakItem itemAt(int row) const;
+    int matchCount() const { return int(order_.size()); }   // filas que pasan el filtro
+
+signals:
+    void viewChanged(const LeakView& view);   // hay que pedir otra permutación
+
+private:
+    const LeakItem& leak(int row) const { return snap_->leaks[order_[row]]; }
+    void apply(const QSharedPointer<const MetricsSnapshot>& s, QVector<int> order);
+
+    Kind               kind_;
+    QVector<LeakField> columns_;
+    QSharedPointer<const MetricsSnapshot> snap_;
+    QVector<int>       order_;        // índices en snap_->leaks, filtrados y ordenados
+    int                loaded_ = 0;   // filas entregadas a la vista (prefijo de order_)
+    LeakView           view_;         // la pedida; order_ puede ser de la anterior
+
+    static constexpr int kPage = 512;
+};
@@ -1,7 +1,10 @@
 #include "Reducers.h"
 #include <QHash>
+#include <QMap>
+#include <QPair>
 #include <QString>
 #include <algorithm>
+#include <utility>
 
 void MetricsReducer::onAlloc(quint64 ptr, qint64 size, const QString& file, int line, const QString& type, qint64 ts_ns) {
     std::scoped_lock lk(m_);
@@ -129,3 +132,103 @@ MetricsSnapshot MetricsReducer::makeSnapshot(qint64 uptimeMs) {
 
     return s;
 }
+
+// Flota: contadores y tasas se suman (el pico es la suma de los picos de cada
+// proceso: cota superior); uptime, intervalo de muestreo y umbral de vida
+// corta, el máximo; leak_rate se pondera por total_allocs. Por archivo y
+// clases de tamaño se funden por clave; bloques, pilas, vidas y snapshots se
+// concatenan (las etiquetas de los snapshots llevan el proceso) y los ids de
+// pila y de snapshot se desplazan por proceso para que no choquen: cada
+// runtime numera los suyos desde 1 y SnapshotsTab los elige por id.
+MetricsSnapshot mergeSnapshots(const QVector<FleetPart>& parts) {
+    MetricsSnapshot out;
+    QHash<QString, int> fileRow;
+    QMap<QPair<qulonglong, qulonglong>, BinRange> bins;
+    double   leakWeighted = 0.0;
+    unsigned stackBase = 0;
+    unsigned snapBase  = 0;
+
+    for (const FleetPart& p : parts) {
+        if (!p.snapshot) continue;
+        const MetricsSnapshot& s = *p.snapshot;
+
+        out.heapCurrent   += s.heapCurrent;
+        out.heapPeak      += s.heapPeak;
+        out.activeAllocs  += s.activeAllocs;
+        out.totalAllocs   += s.totalAllocs;
+        out.leakBytes     += s.leakBytes;
+        out.allocRate     += s.allocRate;
+        out.freeRate      += s.freeRate;
+        out.droppedFrames += s.droppedFrames;
+        out.uptimeMs       = std::max(out.uptimeMs, s.uptimeMs);
+        out.sampleInterval = std::max(out.sampleInterval, s.sampleInterval);
+        out.shortLivedNs   = std::max(out.shortLivedNs, s.shortLivedNs);
+        leakWeighted      += s.leakRate * double(s.totalAllocs);
+        if (s.largestLeakSz > out.largestLeakSz) {
+            out.largestLeakSz   = s.largestLeakSz;
+            out.largestLeakFile = s.largestLeakFile;
+        }
+        if (s.topLeakCount > out.topLeakCount) {
+            out.topLeakFile  = s.topLeakFile;
+            out.topLeakCount = s.topLeakCount;
+            out.topLeakBytes = s.topLeakBytes;
+        }
+
+        for (const BinRange& b : s.bins) {
+            BinRange& acc = bins[qMakePair(b.lo, b.hi)];
+            acc.lo = b.lo;
+            acc.hi = b.hi;
+            acc.bytes       += b.bytes;
+            acc.allocations += b.allocations;
+            acc.allocBytes  += b.allocBytes;
+            acc.allocCount  += b.allocCount;
+        }
+        for (const FileStat& fs : s.perFile) {
+            auto it = fileRow.constFind(fs.file);
+            if (it == fileRow.constEnd()) {
+                fileRow.insert(fs.file, int(out.perFile.size()));
+                out.perFile.push_back(fs);
+                continue;
+            }
+            FileStat& acc = out.perFile[*it];
+            acc.totalBytes += fs.totalBytes;
+            acc.allocs     += fs.allocs;
+            acc.frees      += fs.frees;
+            acc.netBytes   += fs.netBytes;
+        }
+
+        unsigned maxStack = 0;
+        out.stacks.reserve(out.stacks.size() + s.stacks.size());
+        for (StackStat st : s.stacks) {
+            maxStack = std::max(maxStack, st.id);
+            st.id += stackBase;
+            out.stacks.push_back(std::move(st));
+        }
+        out.leaks.reserve(out.leaks.size() + s.leaks.size());
+        for (LeakItem li : s.leaks) {
+            if (li.stackId) li.stackId += stackBase;
+            out.leaks.push_back(std::move(li));
+        }
+        stackBase += maxStack;
+
+        out.symbols   += s.symbols;
+        out.lifetimes += s.lifetimes;
+        unsigned maxSnap = 0;
+        for (HeapSnapshotItem hs : s.heapSnapshots) {
+            maxSnap = std::max(maxSnap, hs.id);
+            hs.id += snapBase;
+            hs.label = p.label + QStringLiteral(": ") + hs.label;
+            out.heapSnapshots.push_back(std::move(hs));
+        }
+        snapBase += maxSnap;
+        if (s.peakSnapshot.id && s.peakSnapshot.bytes > out.peakSnapshot.bytes) {
+            out.peakSnapshot = s.peakSnapshot;
+            out.peakSnapshot.label = p.label;
+        }
+    }
+
+    out.leakRate = out.totalAllocs ? leakWeighted / double(out.totalAllocs) : 0.0;
+    out.bins.reserve(bins.size());
+    for (const BinRange& b : std::as_const(bins)) out.bins.push_back(b);
+    return out;
+}
@@ -5,6 +5,8 @@
 #include <mutex>
 #include <QtGlobal>   // qint64, quint64
 #include <QString>
+#include <QSharedPointer>
+#include <QVector>
 
 // Acumulador interno (evita chocar con el FileStat del DTO)
 struct PerFileAcc {
@@ -47,3 +49,13 @@ private:
 
     std::mutex m_;
 };
+
+// Vista de flota: último snapshot de cada proceso conectado
+struct FleetPart {
+    quint32 id = 0;
+    QString label;     // "binario (pid)"
+    QSharedPointer<const MetricsSnapshot> snapshot;
+};
+
+// Agrega los snapshots de varios procesos en uno (criterio por campo en Reducers.cpp)
+MetricsSnapshot mergeSnapshots(const QVector<FleetPart>& parts);
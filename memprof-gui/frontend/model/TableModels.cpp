@@ -1,131 +1,296 @@
 #include "TableModels.h"
 #include <QString>
 
-// ==================== LeaksModel ====================
-LeaksModel::LeaksModel(QObject* parent) : QAbstractTableModel(parent) {}
+// ==================== PerFileModel ====================
+PerFileModel::PerFileModel(QObject* parent) : FileRowsModel(parent) {}
+
+int PerFileModel::columnCount(const QModelIndex& parent) const {
+    Q_UNUSED(parent);
+    // ↓↓↓ Solo 3 columnas: Archivo | Total [MB] | Allocs
+    return 3;
+}
+
+QVariant PerFileModel::headerData(int section, Qt::Orientation orientation, int role) const {
+    if (role != Qt::DisplayRole) return {};
+    if (orientation == Qt::Horizontal) {
+        switch (section) {
+            case 0: return "Archivo";
+            case 1: return "Total [MB]";
+            case 2: return "Allocs";
+        }
+    }
+    return {};
+}
+
+QVariant PerFileModel::data(const QModelIndex& index, int role) const {
+    if (!index.isValid() || index.row() >= rowCount()) return {};
+    const auto& it = rowAt(index.row());
+
+    // Para ordenamiento correcto: devolver valores numéricos en UserRole
+    if (role == Qt::UserRole) {
+        switch (index.column()) {
+            case 1: { // Total [MB] numérico
+                const double mb = static_cast<double>(it.totalBytes) / (1024.0 * 1024.0);
+                return mb;
+            }
+            case 2: { // Allocs
+                return it.allocs;
+            }
+            default: break;
+        }
+    }
+
+    // Alineación de numéricos
+    if (role == Qt::TextAlignmentRole) {
+        if (index.column() == 1 || index.column() == 2)
+            return static_cast<int>(Qt::AlignRight | Qt::AlignVCenter);
+    }
+
+    if (role == Qt::DisplayRole) {
+        switch (index.column()) {
+            case 0: return it.file;
+            case 1: {
+                const double mb = static_cast<double>(it.totalBytes) / (1024.0 * 1024.0);
+                return QString::number(mb, 'f', 2);
+            }
+            case 2: return it.allocs;
+        }
+    }
+    return {};
+}
 
-int LeaksModel::rowCount(const QModelIndex& parent) const {
+void PerFileModel::setDataSet(const QVector<FileStat>& v) {
+    sync(v);
+}
+
+const QVector<FileStat>& PerFileModel::items() const {
+    return rows();
+}
+
+bool PerFileModel::sameRow(const FileStat& a, const FileStat& b) const {
+    return a.totalBytes == b.totalBytes && a.allocs == b.allocs
+        && a.frees == b.frees && a.netBytes == b.netBytes && a.file == b.file;
+}
+// ==================== SnapshotDiffModel ====================
+SnapshotDiffModel::SnapshotDiffModel(QObject* parent) : QAbstractTableModel(parent) {}
+
+int SnapshotDiffModel::rowCount(const QModelIndex& parent) const {
     return parent.isValid() ? 0 : rows_.size();
 }
 
-int LeaksModel::columnCount(const QModelIndex& parent) const {
+int SnapshotDiffModel::columnCount(const QModelIndex& parent) const {
     Q_UNUSED(parent);
-    return 6; // ptr, size, file, line, type, ts_ns
+    return 7;
 }
 
-QVariant LeaksModel::headerData(int section, Qt::Orientation orientation, int role) const {
+QVariant SnapshotDiffModel::headerData(int section, Qt::Orientation orientation, int role) const {
     if (role != Qt::DisplayRole) return {};
     if (orientation == Qt::Horizontal) {
         switch (section) {
-            case 0: return "Ptr";
-            case 1: return "Size (B)";
-            case 2: return "File";
-            case 3: return "Line";
-            case 4: return "Type";
-            case 5: return "ts_ns";
+            case 0: return "Archivo";
+            case 1: return "Línea";
+            case 2: return "Tipo";
+            case 3: return "Δ Bytes";
+            case 4: return "Δ Bloques";
+            case 5: return "Bytes A";
+            case 6: return "Bytes B";
         }
     }
     return {};
 }
 
-QVariant LeaksModel::data(const QModelIndex& index, int role) const {
+QVariant SnapshotDiffModel::data(const QModelIndex& index, int role) const {
     if (!index.isValid() || index.row() >= rows_.size()) return {};
     const auto& it = rows_[index.row()];
+
+    // Valores numéricos para ordenar (ver sortRole del proxy)
+    if (role == Qt::UserRole) {
+        switch (index.column()) {
+            case 0: return it.file;
+            case 1: return it.line;
+            case 2: return it.type;
+            case 3: return it.dBytes();
+            case 4: return it.dCount();
+            case 5: return it.bytesA;
+            case 6: return it.bytesB;
+        }
+    }
+
+    if (role == Qt::TextAlignmentRole && index.column() >= 3)
+        return static_cast<int>(Qt::AlignRight | Qt::AlignVCenter);
+
     if (role == Qt::DisplayRole) {
         switch (index.column()) {
-            case 0: return QString("0x%1").arg(QString::number(it.ptr, 16));
-            case 1: return it.size;
-            case 2: return it.file;
-            case 3: return it.line;
-            case 4: return it.type;
-            case 5: return QString::number(it.ts_ns);
+            case 0: return it.file;
+            case 1: return it.line;
+            case 2: return it.type;
+            case 3: return (it.dBytes() > 0 ? "+" : "") + QString::number(it.dBytes());
+            case 4: return (it.dCount() > 0 ? "+" : "") + QString::number(it.dCount());
+            case 5: return it.bytesA;
+            case 6: return it.bytesB;
         }
     }
     return {};
 }
 
-void LeaksModel::setDataSet(const QVector<LeakItem>& v) {
+void SnapshotDiffModel::setDataSet(const QVector<SiteDiffRow>& v) {
     beginResetModel();
-    rows_.clear();
-    rows_.reserve(v.size());
-    for (const auto& it : v) {
-        if (it.isLeak) rows_.push_back(it); // <-- SOLO fugas reales
+    rows_ = v;
+    endResetModel();
+}
+
+// ==================== PeakSitesModel ====================
+PeakSitesModel::PeakSitesModel(QObject* parent) : QAbstractTableModel(parent) {}
+
+int PeakSitesModel::rowCount(const QModelIndex& parent) const {
+    return parent.isValid() ? 0 : rows_.size();
+}
+
+int PeakSitesModel::columnCount(const QModelIndex& parent) const {
+    Q_UNUSED(parent);
+    return 6;
+}
+
+QVariant PeakSitesModel::headerData(int section, Qt::Orientation orientation, int role) const {
+    if (role != Qt::DisplayRole) return {};
+    if (orientation == Qt::Horizontal) {
+        switch (section) {
+            case 0: return "Archivo";
+            case 1: return "Línea";
+            case 2: return "Tipo";
+            case 3: return "Bytes";
+            case 4: return "Bloques";
+            case 5: return "% del pico";
+        }
+    }
+    return {};
+}
+
+QVariant PeakSitesModel::data(const QModelIndex& index, int role) const {
+    if (!index.isValid() || index.row() >= rows_.size()) return {};
+    const auto& it = rows_[index.row()];
+    const double pct = total_ ? 100.0 * double(it.bytes) / double(total_) : 0.0;
+
+    // Valores numéricos para ordenar (ver sortRole del proxy)
+    if (role == Qt::UserRole) {
+        switch (index.column()) {
+            case 0: return it.file;
+            case 1: return it.line;
+            case 2: return it.type;
+            case 3: return it.bytes;
+            case 4: return it.count;
+            case 5: return pct;
+        }
     }
+
+    if (role == Qt::TextAlignmentRole && index.column() >= 3)
+        return static_cast<int>(Qt::AlignRight | Qt::AlignVCenter);
+
+    if (role == Qt::DisplayRole) {
+        switch (index.column()) {
+            case 0: return it.file;
+            case 1: return it.line;
+            case 2: return it.type;
+            case 3: return it.bytes;
+            case 4: return it.count;
+            case 5: return QString::number(pct, 'f', 1) + " %";
+        }
+    }
+    return {};
+}
+
+void PeakSitesModel::setDataSet(const HeapSnapshotItem& peak) {
+    beginResetModel();
+    rows_  = peak.sites;
+    total_ = peak.bytes;
     endResetModel();
 }
 
-LeakItem LeaksModel::itemAt(int row) const {
-    return (row >= 0 && row < rows_.size()) ? rows_[row] : LeakItem{};
+// ==================== LifetimeModel ====================
+namespace {
+QString nsToHuman(qulonglong ns) {
+    const double v = double(ns);
+    if (v < 1e3) return QString::number(ns) + " ns";
+    if (v < 1e6) return QString::number(v / 1e3, 'f', 1) + " µs";
+    if (v < 1e9) return QString::number(v / 1e6, 'f', 1) + " ms";
+    return QString::number(v / 1e9, 'f', 1) + " s";
 }
+} // namespace
 
-// ==================== PerFileModel ====================
-PerFileModel::PerFileModel(QObject* parent) : QAbstractTableModel(parent) {}
+LifetimeModel::LifetimeModel(QObject* parent) : QAbstractTableModel(parent) {}
 
-int PerFileModel::rowCount(const QModelIndex& parent) const {
+int LifetimeModel::rowCount(const QModelIndex& parent) const {
     return parent.isValid() ? 0 : rows_.size();
 }
 
-int PerFileModel::columnCount(const QModelIndex& parent) const {
+int LifetimeModel::columnCount(const QModelIndex& parent) const {
     Q_UNUSED(parent);
-    // ↓↓↓ Solo 3 columnas: Archivo | Total [MB] | Allocs
-    return 3;
+    return 9;
 }
 
-QVariant PerFileModel::headerData(int section, Qt::Orientation orientation, int role) const {
+QVariant LifetimeModel::headerData(int section, Qt::Orientation orientation, int role) const {
     if (role != Qt::DisplayRole) return {};
     if (orientation == Qt::Horizontal) {
         switch (section) {
             case 0: return "Archivo";
-            case 1: return "Total [MB]";
-            case 2: return "Allocs";
+            case 1: return "Línea";
+            case 2: return "Tipo";
+            case 3: return "Frees";
+            case 4: return "Frees/s";
+            case 5: return QString("Vida < %1").arg(nsToHuman(shortNs_));
+            case 6: return "Vida p50";
+            case 7: return "Vida p99";
+            case 8: return "Tamaño medio";
         }
     }
     return {};
 }
 
-QVariant PerFileModel::data(const QModelIndex& index, int role) const {
+QVariant LifetimeModel::data(const QModelIndex& index, int role) const {
     if (!index.isValid() || index.row() >= rows_.size()) return {};
-    const auto& it = rows_[index.row()];
+    const auto& r  = rows_[index.row()];
+    const auto& it = r.s;
+    const qulonglong avg = it.frees ? it.bytes / it.frees : 0;
 
-    // Para ordenamiento correcto: devolver valores numéricos en UserRole
+    // Valores numéricos para ordenar (ver sortRole del proxy)
     if (role == Qt::UserRole) {
         switch (index.column()) {
-            case 1: { // Total [MB] numérico
-                const double mb = static_cast<double>(it.totalBytes) / (1024.0 * 1024.0);
-                return mb;
-            }
-            case 2: { // Allocs
-                return it.allocs;
-            }
-            default: break;
+            case 0: return it.file;
+            case 1: return it.line;
+            case 2: return it.type;
+            case 3: return it.frees;
+            case 4: return r.freesPerSec;
+            case 5: return it.shortLived;
+            case 6: return it.p50Ns;
+            case 7: return it.p99Ns;
+            case 8: return avg;
         }
     }
 
-    // Alineación de numéricos
-    if (role == Qt::TextAlignmentRole) {
-        if (index.column() == 1 || index.column() == 2)
-            return static_cast<int>(Qt::AlignRight | Qt::AlignVCenter);
-    }
+    if (role == Qt::TextAlignmentRole && index.column() >= 3)
+        return static_cast<int>(Qt::AlignRight | Qt::AlignVCenter);
 
     if (role == Qt::DisplayRole) {
         switch (index.column()) {
             case 0: return it.file;
-            case 1: {
-                const double mb = static_cast<double>(it.totalBytes) / (1024.0 * 1024.0);
-                return QString::number(mb, 'f', 2);
-            }
-            case 2: return it.allocs;
+            case 1: return it.line;
+            case 2: return it.type;
+            case 3: return it.frees;
+            case 4: return QString::number(r.freesPerSec, 'f', 0);
+            case 5: return it.frees ? QString("%1 (%2 %)").arg(it.shortLived)
+                                          .arg(100.0 * double(it.shortLived) / double(it.frees), 0, 'f', 0)
+                                    : QString("0");
+            case 6: return nsToHuman(it.p50Ns);
+            case 7: return nsToHuman(it.p99Ns);
+            case 8: return QString::number(avg) + " B";
         }
     }
     return {};
 }
 
-void PerFileModel::setDataSet(const QVector<FileStat>& v) {
+void LifetimeModel::setDataSet(const QVector<LifetimeRow>& v, qulonglong shortNs) {
     beginResetModel();
-    rows_ = v;
+    rows_    = v;
+    shortNs_ = shortNs;
     endResetModel();
 }
-
-const QVector<FileStat>& PerFileModel::items() const {
-    return rows_;
-}
\ No newline at end of file
@@ -1,40 +1,98 @@
 #pragma once
 #include <QAbstractTableModel>
 #include <QVector>
+#include "frontend/model/KeyedTableModel.h"
 #include "memprof/proto/MetricsSnapshot.h"
 
-// -------------------- LeaksModel --------------------
-class LeaksModel : public QAbstractTableModel {
+// -------------------- PerFileModel --------------------
+// Filas casadas por archivo entre snapshots
+using FileRowsModel = KeyedTableModel<FileStat, QString>;
+
+class PerFileModel : public FileRowsModel {
+    Q_OBJECT
+public:
+    explicit PerFileModel(QObject* parent=nullptr);
+
+    int columnCount(const QModelIndex& parent = QModelIndex()) const override; // Archivo | Total [MB] | Allocs
+    QVariant headerData(int section, Qt::Orientation orientation, int role) const override;
+    QVariant data(const QModelIndex& index, int role) const override;
+
+    void setDataSet(const QVector<FileStat>& v);
+    const QVector<FileStat>& items() const;
+
+protected:
+    QString keyOf(const FileStat& r) const override { return r.file; }
+    bool sameRow(const FileStat& a, const FileStat& b) const override;
+};
+
+// -------------------- SnapshotDiffModel --------------------
+// Crecimiento por sitio entre dos snapshots de heap (b - a)
+struct SiteDiffRow {
+    QString    file;
+    int        line = 0;
+    QString    type;
+    qulonglong bytesA = 0, bytesB = 0;
+    qulonglong countA = 0, countB = 0;
+    qlonglong  dBytes() const { return qlonglong(bytesB) - qlonglong(bytesA); }
+    qlonglong  dCount() const { return qlonglong(countB) - qlonglong(countA); }
+};
+
+class SnapshotDiffModel : public QAbstractTableModel {
     Q_OBJECT
 public:
-    explicit LeaksModel(QObject* parent=nullptr);
+    explicit SnapshotDiffModel(QObject* parent=nullptr);
 
     int rowCount(const QModelIndex& parent = QModelIndex()) const override;
-    int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex& parent = QModelIndex()) const override; // File | Line | Type | ΔBytes | ΔCount | A | B
     QVariant headerData(int section, Qt::Orientation orientation, int role) const override;
     QVariant data(const QModelIndex& index, int role) const override;
 
-    void setDataSet(const QVector<LeakItem>& v);
-    LeakItem itemAt(int row) const;
+    void setDataSet(const QVector<SiteDiffRow>& v);
 
 private:
-    QVector<LeakItem> rows_;
+    QVector<SiteDiffRow> rows_;
 };
 
-// -------------------- PerFileModel --------------------
-class PerFileModel : public QAbstractTableModel {
+// -------------------- PeakSitesModel --------------------
+// Desglose por sitio de la captura en el pico
+class PeakSitesModel : public QAbstractTableModel {
     Q_OBJECT
 public:
-    explicit PerFileModel(QObject* parent=nullptr);
+    explicit PeakSitesModel(QObject* parent=nullptr);
 
     int rowCount(const QModelIndex& parent = QModelIndex()) const override;
-    int columnCount(const QModelIndex& parent = QModelIndex()) const override; // Archivo | Total [MB] | Allocs
+    int columnCount(const QModelIndex& parent = QModelIndex()) const override; // File | Line | Type | Bytes | Count | %
     QVariant headerData(int section, Qt::Orientation orientation, int role) const override;
     QVariant data(const QModelIndex& index, int role) const override;
 
-    void setDataSet(const QVector<FileStat>& v);
-    const QVector<FileStat>& items() const;
+    void setDataSet(const HeapSnapshotItem& peak);
+
+private:
+    QVector<SiteUsageItem> rows_;
+    qulonglong             total_ = 0;   // bytes vivos en la captura
+};
+
+// -------------------- LifetimeModel --------------------
+// Vida de los bloques liberados por sitio; la tasa de frees la calcula la
+// pestaña entre dos snapshots
+struct LifetimeRow {
+    SiteLifetime s;
+    double       freesPerSec = 0.0;
+};
+
+class LifetimeModel : public QAbstractTableModel {
+    Q_OBJECT
+public:
+    explicit LifetimeModel(QObject* parent=nullptr);
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex& parent = QModelIndex()) const override; // File | Line | Type | Frees | Frees/s | Short | p50 | p99 | Avg size
+    QVariant headerData(int section, Qt::Orientation orientation, int role) const override;
+    QVariant data(const QModelIndex& index, int role) const override;
+
+    void setDataSet(const QVector<LifetimeRow>& v, qulonglong shortNs);
 
 private:
-    QVector<FileStat> rows_;
+    QVector<LifetimeRow> rows_;
+    qulonglong           shortNs_ = 0;
 };
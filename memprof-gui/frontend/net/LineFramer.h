@@ -0,0 +1,52 @@
+#pragma once
+#include <QByteArray>
+#include <QtGlobal>
+
+#include <cstring>
+#include <utility>
+
+// Corta un flujo NDJSON en líneas completas a medida que llega: cada byte se
+// recorre una sola vez (memchr sobre lo nuevo) y la línea a medias espera a
+// la siguiente llamada. Una línea más larga que 'maxLine' se descarta entera
+// hasta su '\n' (el flujo se resincroniza solo).
+class LineFramer {
+public:
+    explicit LineFramer(qsizetype maxLine) : maxLine_(maxLine) {}
+
+    // onLine(QByteArray&&) por cada línea completa no vacía, sin '\n' ni '\r'.
+    // Devuelve cuántas líneas se descartaron por largas.
+    template <class F>
+    int feed(const char* data, qsizetype n, F&& onLine) {
+        int dropped = 0;
+        while (n > 0) {
+            const auto* nl = static_cast<const char*>(std::memchr(data, '\n', size_t(n)));
+            const qsizetype k = nl ? qsizetype(nl - data) : n;
+            if (!skipping_) {
+                if (partial_.size() + k > maxLine_) {
+                    partial_.clear();
+                    skipping_ = true;
+                    ++dropped;
+                } else {
+                    partial_.append(data, int(k));
+                }
+            }
+            if (!nl) break;
+            if (!skipping_) {
+                QByteArray line = std::exchange(partial_, QByteArray());
+                if (line.endsWith('\r')) line.chop(1);
+                if (!line.isEmpty()) onLine(std::move(line));
+            }
+            skipping_ = false;
+            data += k + 1;
+            n    -= k + 1;
+        }
+        return dropped;
+    }
+
+    qsizetype pending() const { return partial_.size(); }
+
+private:
+    QByteArray partial_;          // línea a medias
+    qsizetype  maxLine_;
+    bool       skipping_ = false; // descartando una línea demasiado larga
+};
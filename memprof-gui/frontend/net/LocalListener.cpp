@@ -0,0 +1,244 @@
+#include "LocalListener.h"
+
+#include <QFile>
+#include <QSocketNotifier>
+#include <QtGlobal>
+
+#include <cstring>
+
+#include "memprof/proto/LocalChannel.h"
+
+#if defined(Q_OS_UNIX)
+  #include <cerrno>
+  #include <fcntl.h>
+  #include <sys/socket.h>
+  #include <sys/stat.h>
+  #include <sys/un.h>
+  #include <unistd.h>
+#endif
+#if defined(Q_OS_LINUX)
+  #include <sys/mman.h>
+#endif
+
+namespace {
+#if defined(Q_OS_UNIX)
+static void setNonBlockCloexec(int fd) {
+    ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+    ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+}
+#endif
+} // namespace
+
+LocalListener::LocalListener(QObject* parent) : QObject(parent) {}
+
+LocalListener::~LocalListener() { close(); }
+
+bool LocalListener::listen(const QString& path) {
+#if defined(Q_OS_UNIX)
+    close();
+    const QByteArray p = QFile::encodeName(path);
+    sockaddr_un addr{};
+    if (p.isEmpty() || size_t(p.size()) >= sizeof(addr.sun_path)) {
+        error_ = QStringLiteral("invalid socket path");
+        return false;
+    }
+    addr.sun_family = AF_UNIX;
+    std::memcpy(addr.sun_path, p.constData(), size_t(p.size()));
+
+    const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) { error_ = QString::fromLocal8Bit(std::strerror(errno)); return false; }
+    setNonBlockCloexec(fd);
+
+    // Un socket huérfano de una sesión anterior se reemplaza; uno con alguien
+    // escuchando no
+    struct stat st{};
+    if (::stat(p.constData(), &st) == 0 && S_ISSOCK(st.st_mode)) {
+        const int probe = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        const bool inUse = probe >= 0 && ::connect(probe, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0;
+        if (probe >= 0) ::close(probe);
+        if (inUse) {
+            ::close(fd);
+            error_ = QStringLiteral("address in use");
+            return false;
+        }
+        ::unlink(p.constData());
+    }
+    if (::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || ::listen(fd, 16) != 0) {
+        error_ = QString::fromLocal8Bit(std::strerror(errno));
+        ::close(fd);
+        return false;
+    }
+    listenFd_ = fd;
+    path_     = p;
+    acceptN_  = new QSocketNotifier(fd, QSocketNotifier::Read, this);
+    connect(acceptN_, &QSocketNotifier::activated, this, &LocalListener::onAccept);
+    return true;
+#else
+    Q_UNUSED(path);
+    error_ = QStringLiteral("local sockets not supported on this platform");
+    return false;
+#endif
+}
+
+void LocalListener::close() {
+    const auto ids = clients_.keys();
+    for (quint32 id : ids) dropClient(id, false);
+#if defined(Q_OS_UNIX)
+    if (acceptN_) { acceptN_->setEnabled(false); acceptN_->deleteLater(); acceptN_ = nullptr; }
+    if (listenFd_ != -1) {
+        ::close(listenFd_);
+        listenFd_ = -1;
+        ::unlink(path_.constData());
+    }
+#endif
+}
+
+void LocalListener::closeClient(quint32 id) { dropClient(id, false); }
+
+void LocalListener::onAccept() {
+#if defined(Q_OS_UNIX)
+    for (;;) {
+        const int fd = ::accept(listenFd_, nullptr, nullptr);
+        if (fd < 0) return;   // EAGAIN: no quedan pendientes
+        setNonBlockCloexec(fd);
+        const quint32 id = nextId_++;
+        Conn c;
+        c.fd      = fd;
+        c.clientN = new QSocketNotifier(fd, QSocketNotifier::Read, this);
+        connect(c.clientN, &QSocketNotifier::activated, this, [this, id] { onClientReadable(id); });
+        clients_.insert(id, c);
+    }
+#endif
+}
+
+// Las señales pueden cerrar el cliente (closeClient): tras cada emit se
+// vuelve a buscar en clients_
+void LocalListener::onClientReadable(quint32 id) {
+#if defined(Q_OS_UNIX)
+    char buf[64 * 1024];
+    for (;;) {
+        auto it = clients_.find(id);
+        if (it == clients_.end()) return;
+        iovec iov{buf, sizeof(buf)};
+        alignas(cmsghdr) char ctrl[CMSG_SPACE(2 * sizeof(int))];
+        msghdr msg{};
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = ctrl;
+        msg.msg_controllen = sizeof(ctrl);
+        const ssize_t n = ::recvmsg(it->fd, &msg, 0);
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) return;
+        if (n <= 0) { dropClient(id, true); return; }   // EOF o error
+
+        // Descriptores adjuntos: solo valen en el saludo shm
+        int fds[2] = {-1, -1};
+        int nfds = 0;
+        for (cmsghdr* cm = CMSG_FIRSTHDR(&msg); cm; cm = CMSG_NXTHDR(&msg, cm)) {
+            if (cm->cmsg_level != SOL_SOCKET || cm->cmsg_type != SCM_RIGHTS) continue;
+            const int k = int((cm->cmsg_len - CMSG_LEN(0)) / sizeof(int));
+            for (int i = 0; i < k; ++i) {
+                int fd;
+                std::memcpy(&fd, CMSG_DATA(cm) + i * sizeof(int), sizeof(int));
+                if (nfds < 2) fds[nfds++] = fd; else ::close(fd);
+            }
+        }
+        const bool hello = !it->greeted && nfds == 2 && n == 1 && buf[0] == shmring::kHello;
+        if (!hello) for (int i = 0; i < nfds; ++i) ::close(fds[i]);
+
+        if (!it->greeted) {
+            it->greeted = true;
+            if (hello) {
+                if (!setupRing(id, *it, fds[0], fds[1])) { dropClient(id, false); return; }
+                emit clientConnected(id, QStringLiteral("shm"));
+                it = clients_.find(id);
+                if (it == clients_.end()) return;   // rechazado
+                drainRing(id, *it);
+                continue;
+            }
+            emit clientConnected(id, QStringLiteral("unix"));
+            it = clients_.find(id);
+            if (it == clients_.end()) return;   // rechazado
+        }
+        // En modo shm el socket no trae datos: lo que llegue se ignora
+        if (!it->ring) emit dataReceived(id, QByteArray(buf, int(n)));
+    }
+#else
+    Q_UNUSED(id);
+#endif
+}
+
+bool LocalListener::setupRing(quint32 id, Conn& c, int memfd, int efd) {
+#if defined(Q_OS_LINUX)
+    struct stat st{};
+    void* mem = MAP_FAILED;
+    if (::fstat(memfd, &st) == 0 && size_t(st.st_size) >= sizeof(shmring::Header))
+        mem = ::mmap(nullptr, size_t(st.st_size), PROT_READ | PROT_WRITE, MAP_SHARED, memfd, 0);
+    ::close(memfd);
+    if (mem == MAP_FAILED || !shmring::valid(static_cast<shmring::Header*>(mem), size_t(st.st_size))) {
+        if (mem != MAP_FAILED) ::munmap(mem, size_t(st.st_size));
+        ::close(efd);
+        return false;
+    }
+    c.ring    = mem;
+    c.ringLen = size_t(st.st_size);
+    c.eventFd = efd;
+    setNonBlockCloexec(efd);
+    c.ringN = new QSocketNotifier(efd, QSocketNotifier::Read, this);
+    connect(c.ringN, &QSocketNotifier::activated, this, [this, id] { onRingNotified(id); });
+    return true;
+#elif defined(Q_OS_UNIX)
+    Q_UNUSED(id);
+    Q_UNUSED(c);
+    ::close(memfd);
+    ::close(efd);
+    return false;
+#else
+    Q_UNUSED(id);
+    Q_UNUSED(c);
+    Q_UNUSED(memfd);
+    Q_UNUSED(efd);
+    return false;
+#endif
+}
+
+void LocalListener::onRingNotified(quint32 id) {
+#if defined(Q_OS_UNIX)
+    auto it = clients_.find(id);
+    if (it == clients_.end()) return;
+    quint64 v = 0;
+    while (::read(it->eventFd, &v, sizeof(v)) == ssize_t(sizeof(v))) {}   // rearmar
+    drainRing(id, *it);
+#else
+    Q_UNUSED(id);
+#endif
+}
+
+void LocalListener::drainRing(quint32 id, Conn& c) {
+    if (!c.ring) return;
+    QByteArray chunk;
+    shmring::read(static_cast<shmring::Header*>(c.ring), [&](const char* p, size_t n) {
+        chunk.append(p, int(n));
+    });
+    if (!chunk.isEmpty()) emit dataReceived(id, chunk);   // último uso de 'c'
+}
+
+void LocalListener::dropClient(quint32 id, bool notify) {
+#if defined(Q_OS_UNIX)
+    auto it = clients_.find(id);
+    if (it == clients_.end()) return;
+    Conn c = *it;
+    clients_.erase(it);
+    if (notify) drainRing(id, c);   // lo publicado antes de cerrar aún vale
+    if (c.ringN)   { c.ringN->setEnabled(false);   c.ringN->deleteLater(); }
+    if (c.clientN) { c.clientN->setEnabled(false); c.clientN->deleteLater(); }
+  #if defined(Q_OS_LINUX)
+    if (c.ring) ::munmap(c.ring, c.ringLen);
+  #endif
+    if (c.eventFd != -1) ::close(c.eventFd);
+    ::close(c.fd);
+    if (notify) emit clientDisconnected(id);
+#else
+    Q_UNUSED(id);
+    Q_UNUSED(notify);
+#endif
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <QObject>
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+
+class QSocketNotifier;
+
+// Escucha en un socket AF_UNIX para runtimes en la misma máquina (endpoints
+// "unix:" y "shm:", ver memprof/proto/LocalChannel.h). Un cliente unix manda
+// las tramas por el socket; uno shm manda en el primer mensaje el memfd del
+// anillo y un eventfd, y desde ahí se lee del anillo al saltar el eventfd.
+// Admite varios clientes a la vez; cada uno se identifica en las señales por
+// un id propio de este listener.
+class LocalListener : public QObject {
+    Q_OBJECT
+public:
+    explicit LocalListener(QObject* parent = nullptr);
+    ~LocalListener() override;
+
+    bool listen(const QString& path);   // false -> errorString()
+    QString errorString() const { return error_; }
+    int clientCount() const { return int(clients_.size()); }
+    void closeClient(quint32 id);       // sin clientDisconnected
+    void close();
+
+signals:
+    void clientConnected(quint32 id, const QString& kind);   // "unix" / "shm"
+    void dataReceived(quint32 id, const QByteArray& chunk);
+    void clientDisconnected(quint32 id);
+
+private slots:
+    void onAccept();
+
+private:
+    struct Conn {
+        int              fd      = -1;
+        int              eventFd = -1;
+        bool             greeted = false;   // ya llegó el primer mensaje
+        QSocketNotifier* clientN = nullptr;
+        QSocketNotifier* ringN   = nullptr;
+        void*            ring    = nullptr;  // shmring::Header mapeado
+        size_t           ringLen = 0;
+    };
+
+    void onClientReadable(quint32 id);
+    void onRingNotified(quint32 id);
+    bool setupRing(quint32 id, Conn& c, int memfd, int efd);
+    void drainRing(quint32 id, Conn& c);
+    void dropClient(quint32 id, bool notify);
+
+    int                  listenFd_ = -1;
+    QSocketNotifier*     acceptN_  = nullptr;
+    QHash<quint32, Conn> clients_;
+    quint32              nextId_   = 1;
+    QByteArray           path_;
+    QString              error_;
+};
@@ -1,76 +1,25 @@
 #include "ServerWorker.h"
 
-#include <QJsonArray>
-#include <QJsonValue>
+#include <QRunnable>
 #include <QString>
+#include <QThread>
 #include <QtGlobal>
 
-namespace {
-// --- util: convierte QJsonValue a quint64 soportando string (hex/dec) o número ---
-static quint64 toU64(const QJsonValue& v, quint64 def = 0) {
-    if (v.isUndefined() || v.isNull()) return def;
-
-    if (v.isString()) {
-        QString s = v.toString().trimmed();
-        if (s.startsWith("0x", Qt::CaseInsensitive)) {
-            bool ok = false;
-            quint64 x = s.mid(2).toULongLong(&ok, 16);
-            return ok ? x : def;
-        } else {
-            bool ok = false;
-            quint64 x = s.toULongLong(&ok, 10);
-            return ok ? x : def;
-        }
-    }
-
-    // Si es número JSON, suele ser double y puede perder precisión > 2^53.
-    // Pero intentamos igual:
-    if (v.isDouble()) {
-        // vía QVariant suele devolver 0 si es muy grande; probamos cast directo:
-        const double d = v.toDouble();
-        if (d < 0) return def;
-        // cuidado con overflow; clamp
-        const long double ld = static_cast<long double>(d);
-        if (ld > static_cast<long double>(std::numeric_limits<quint64>::max())) return def;
-        return static_cast<quint64>(ld);
-    }
+#include <algorithm>
+#include <functional>
+#include <utility>
 
-    // vía QVariant como fallback
-    bool ok = false;
-    quint64 x = v.toVariant().toULongLong(&ok);
-    return ok ? x : def;
-}
+#include "frontend/model/Reducers.h"
 
-static qlonglong toI64(const QJsonValue& v, qlonglong def = 0) {
-    if (v.isUndefined() || v.isNull()) return def;
-    if (v.isString()) {
-        bool ok = false;
-        qlonglong x = v.toString().toLongLong(&ok, 10);
-        return ok ? x : def;
-    }
-    if (v.isDouble()) {
-        const double d = v.toDouble();
-        const long double ld = static_cast<long double>(d);
-        if (ld > static_cast<long double>(std::numeric_limits<qlonglong>::max())) return def;
-        if (ld < static_cast<long double>(std::numeric_limits<qlonglong>::min())) return def;
-        return static_cast<qlonglong>(ld);
-    }
-    bool ok = false;
-    qlonglong x = v.toVariant().toLongLong(&ok);
-    return ok ? x : def;
-}
-
-static int toInt(const QJsonValue& v, int def = 0) {
-    if (v.isString()) {
-        bool ok = false;
-        int x = v.toString().toInt(&ok, 10);
-        return ok ? x : def;
-    }
-    if (v.isDouble()) return v.toInt(def);
-    bool ok = false;
-    int x = v.toVariant().toInt(&ok);
-    return ok ? x : def;
-}
+namespace {
+// Tarea del pool (QRunnable::create no existe antes de Qt 5.15)
+class PoolTask : public QRunnable {
+public:
+    explicit PoolTask(std::function<void()> fn) : fn_(std::move(fn)) {}
+    void run() override { fn_(); }
+private:
+    std::function<void()> fn_;
+};
 } // namespace
 
 ServerWorker::ServerWorker(QObject* parent) : QObject(parent) {
@@ -78,6 +27,13 @@ ServerWorker::ServerWorker(QObject* parent) : QObject(parent) {
     flushTimer_->setTimerType(Qt::CoarseTimer);
     flushTimer_->setInterval(kFlushMs);
     connect(flushTimer_, &QTimer::timeout, this, &ServerWorker::flushCoalesced);
+    pool_ = new QThreadPool(this);
+    pool_->setMaxThreadCount(qBound(1, QThread::idealThreadCount() - 1, kMaxParseThreads));
+    leakViews_[kLeaksTable].leaksOnly = true;   // igual que LeakPageModel::Kind::Leaks
+}
+
+ServerWorker::~ServerWorker() {
+    pool_->waitForDone();   // las tareas usan 'this'
 }
 
 void ServerWorker::listen(const QHostAddress& addr, quint16 port) {
@@ -94,172 +50,759 @@ void ServerWorker::listen(const QHostAddress& addr, quint16 port) {
     flushTimer_->start();
 }
 
+void ServerWorker::listenLocal(const QString& path) {
+    if (local_) { emit status(QStringLiteral("Local socket already listening")); return; }
+
+    local_ = new LocalListener(this);
+    connect(local_, &LocalListener::clientConnected,    this, &ServerWorker::onLocalConnected);
+    connect(local_, &LocalListener::clientDisconnected, this, &ServerWorker::onLocalDisconnected);
+    connect(local_, &LocalListener::dataReceived,       this, &ServerWorker::onLocalData);
+
+    if (!local_->listen(path)) {
+        emit status(QStringLiteral("Local listen failed: %1").arg(local_->errorString()));
+        local_->deleteLater();
+        local_ = nullptr;
+        return;
+    }
+    emit status(QStringLiteral("Listening on %1").arg(path));
+    flushTimer_->start();
+}
+
 void ServerWorker::stop() {
     flushTimer_->stop();
-    {
-        QMutexLocker lk(&m_);
-        buffer_.clear();
-    }
-    if (sock_) {
-        disconnect(sock_, nullptr, this, nullptr);
-        sock_->close();
-        sock_->deleteLater();
-        sock_ = nullptr;
+    pool_->waitForDone();
+    for (const ClientPtr& c : std::as_const(clients_)) {
+        if (!c->sock) continue;
+        disconnect(c->sock, nullptr, this, nullptr);
+        c->sock->close();
+        c->sock->deleteLater();
     }
+    clients_.clear();
+    localIds_.clear();
     if (server_) {
         disconnect(server_, nullptr, this, nullptr);
         server_->close();
         server_->deleteLater();
         server_ = nullptr;
     }
+    if (local_) {
+        disconnect(local_, nullptr, this, nullptr);
+        local_->close();
+        local_->deleteLater();
+        local_ = nullptr;
+    }
+    emitClients();
     emit status(QStringLiteral("Stopped"));
 }
 
+void ServerWorker::selectClient(quint32 id) {
+    selected_ = clients_.contains(id) ? id : kFleet;
+    if (selected_ == kFleet) {
+        fleetDirty_ = true;   // se agrega en la próxima pasada
+        return;
+    }
+    const ClientPtr c = clients_.value(selected_);
+    if (c->latest) publish(c->latest);
+}
+
+void ServerWorker::setLeakView(int table, const LeakView& view) {
+    if (table != kLeaksTable && table != kBlocksTable) return;
+    if (leakViews_[table] == view) return;
+    leakViews_[table] = view;
+    prepareTables();
+}
+
+ServerWorker::ClientPtr ServerWorker::addClient(const QString& kind) {
+    auto c = ClientPtr::create();
+    c->info.id   = nextId_++;
+    c->info.kind = kind;
+    clients_.insert(c->info.id, c);
+    return c;
+}
+
+void ServerWorker::removeClient(quint32 id) {
+    const ClientPtr c = clients_.take(id);
+    if (!c) return;
+    if (c->localId) localIds_.remove(c->localId);
+    if (selected_ == id) selected_ = kFleet;
+    fleetDirty_ = true;
+    emitClients();
+    emit status(QStringLiteral("Client disconnected: %1 (pid %2)").arg(c->info.name).arg(c->info.pid));
+}
+
+void ServerWorker::emitClients() {
+    QVector<ClientInfo> list;
+    list.reserve(clients_.size());
+    for (const ClientPtr& c : std::as_const(clients_))
+        if (c->greeted) list.push_back(c->info);
+    std::sort(list.begin(), list.end(),
+              [](const ClientInfo& a, const ClientInfo& b) { return a.id < b.id; });
+    emit clientsChanged(list);
+}
+
 void ServerWorker::onNewConnection() {
-    // Solo un cliente; cierra extras.
-    if (sock_) {
-        if (auto extra = server_->nextPendingConnection()) {
-            extra->close();
-            extra->deleteLater();
+    while (QTcpSocket* sock = server_->nextPendingConnection()) {
+        sock->setReadBufferSize(1 * 1024 * 1024); // 1 MB por cliente para evitar explosiones
+        const ClientPtr c = addClient(QStringLiteral("tcp"));
+        c->sock = sock;
+        const quint32 id = c->info.id;
+        connect(sock, &QTcpSocket::readyRead, this, [this, id] {
+            const ClientPtr cl = clients_.value(id);
+            if (cl && cl->sock) appendIncoming(*cl, cl->sock->readAll());
+        });
+        connect(sock, &QTcpSocket::disconnected, this, [this, id, sock] {
+            sock->deleteLater();
+            removeClient(id);
+        });
+    }
+}
+
+void ServerWorker::onLocalConnected(quint32 localId, const QString& kind) {
+    const ClientPtr c = addClient(kind);
+    c->localId = localId;
+    localIds_.insert(localId, c->info.id);
+}
+
+void ServerWorker::onLocalData(quint32 localId, const QByteArray& chunk) {
+    if (const ClientPtr c = clients_.value(localIds_.value(localId))) appendIncoming(*c, chunk);
+}
+
+void ServerWorker::onLocalDisconnected(quint32 localId) {
+    removeClient(localIds_.value(localId));
+}
+
+void ServerWorker::appendIncoming(Client& c, const QByteArray& chunk) {
+    bytesIn_ += quint64(chunk.size());
+    const char* data = chunk.constData();
+    qsizetype   n    = chunk.size();
+    if (!c.greeted || c.mode == Mode::Unknown || c.mode == Mode::Binary) {
+        c.buffer.append(chunk);
+        if (!c.greeted) readHello(c);
+        if (!c.greeted || c.buffer.isEmpty()) return;
+        // El primer byte tras el saludo decide el modo (ver WireFormat.h)
+        if (c.mode == Mode::Unknown)
+            c.mode = wire::looksLikeFrame(c.buffer.constData(), size_t(c.buffer.size())) ? Mode::Binary : Mode::Json;
+        if (c.mode == Mode::Binary) { frameBinary(c); return; }
+        data = c.buffer.constData();   // JSON: lo que quedó tras el saludo
+        n    = c.buffer.size();
+    }
+
+    // JSON: cada línea trae el estado completo, así que una línea completa
+    // reemplaza a la anterior aún sin parsear sin perder nada
+    droppedIn_ += quint64(c.lines.feed(data, n, [&](QByteArray&& line) {
+        ++messagesIn_;
+        c.line = std::move(line);
+    }));
+    c.buffer.clear();
+}
+
+// Mueve las tramas completas a 'frames' (la de al final puede quedar a
+// medias en 'buffer'). Solo se miran cabeceras.
+void ServerWorker::frameBinary(Client& c) {
+    qsizetype off = 0;
+    wire::FrameHeader h;
+    for (;;) {
+        const auto st = wire::peekFrame(c.buffer.constData() + off, size_t(c.buffer.size() - off), h);
+        if (st == wire::FrameStatus::NeedMore) break;
+        if (st == wire::FrameStatus::Bad) {
+            // Desincronizado: se salta hasta la próxima cabecera. Los deltas que
+            // sigan no encajarán con el epoch y se esperará al keyframe.
+            ++droppedIn_;
+            const qsizetype next = c.buffer.indexOf(QByteArray::fromRawData(wire::kMagic, sizeof(wire::kMagic)), off + 1);
+            off = next < 0 ? c.buffer.size() : next;
+            if (next < 0) break;
+            continue;
         }
-        return;
+        const qsizetype len = qsizetype(wire::kHeaderSize + h.length);
+        if (h.kind == wire::Kind::Snapshot) c.lastKey = c.frames.size();
+        c.frames.append(c.buffer.constData() + off, len);
+        ++messagesIn_;
+        off += len;
     }
-    sock_ = server_->nextPendingConnection();
-    sock_->setReadBufferSize(1 * 1024 * 1024); // 1 MB para evitar explosiones
-    connect(sock_, &QTcpSocket::readyRead,    this, &ServerWorker::onReadyRead);
-    connect(sock_, &QTcpSocket::disconnected, this, &ServerWorker::onDisconnected);
-    emit status(QStringLiteral("Client connected"));
-}
-
-void ServerWorker::onDisconnected() {
-    if (sock_) { sock_->deleteLater(); sock_ = nullptr; }
-    emit status(QStringLiteral("Client disconnected"));
-}
-
-void ServerWorker::onReadyRead() {
-    if (!sock_) return;
-    QByteArray chunk = sock_->readAll();
-    QMutexLocker lk(&m_);
-    buffer_.append(chunk);
-
-    // Tope duro: nos quedamos con el final del buffer
-    if (buffer_.size() > kMaxBuf) {
-        buffer_ = buffer_.right(kMaxBuf);
-        // Alinear a inicio de línea para no partir JSON
-        int nl = buffer_.indexOf('\n');
-        if (nl > 0) buffer_ = buffer_.mid(nl + 1);
+    c.buffer.remove(0, off);
+
+    // Sin parsear a tiempo: lo anterior al último keyframe sobra
+    if (c.frames.size() > kMaxBuf && c.lastKey > 0) {
+        for (qsizetype k = 0; k < c.lastKey; k += qsizetype(wire::kHeaderSize + h.length)) {
+            wire::peekFrame(c.frames.constData() + k, size_t(c.frames.size() - k), h);
+            ++droppedIn_;
+        }
+        c.frames.remove(0, c.lastKey);
+        c.lastKey = 0;
+    }
+    if (c.frames.size() > kMaxPending) {
+        // Ni un keyframe en 256 MB: se descarta todo y se espera al siguiente
+        for (qsizetype k = 0; k < c.frames.size(); k += qsizetype(wire::kHeaderSize + h.length)) {
+            wire::peekFrame(c.frames.constData() + k, size_t(c.frames.size() - k), h);
+            ++droppedIn_;
+        }
+        c.frames.clear();
+        c.lastKey = -1;
+    }
+}
+
+// Primera trama de la conexión: Hello (pid + binario). Un runtime anterior
+// empieza directamente con datos y queda como proceso sin identificar.
+void ServerWorker::readHello(Client& c) {
+    wire::FrameHeader h;
+    const auto st = wire::peekFrame(c.buffer.constData(), size_t(c.buffer.size()), h);
+    if (st == wire::FrameStatus::NeedMore) return;
+    if (st == wire::FrameStatus::Ok && h.kind == wire::Kind::Hello) {
+        wire::Reader r(c.buffer.constData() + wire::kHeaderSize, size_t(h.length));
+        const quint64 pid = r.varint();
+        const std::string_view name = r.bytes();
+        if (r.ok()) {
+            c.info.pid  = qint64(pid);
+            c.info.name = QString::fromUtf8(name.data(), int(name.size()));
+        }
+        c.buffer.remove(0, qsizetype(wire::kHeaderSize + h.length));
     }
+    if (c.info.name.isEmpty()) c.info.name = QStringLiteral("cliente %1").arg(c.info.id);
+    c.greeted = true;
+    emitClients();
+    emit status(QStringLiteral("Client connected (%1): %2 (pid %3)")
+                .arg(c.info.kind, c.info.name).arg(c.info.pid));
 }
 
 void ServerWorker::flushCoalesced() {
-    QByteArray chunk;
-    { QMutexLocker lk(&m_); if (buffer_.isEmpty()) return; chunk.swap(buffer_); }
-
-    // Tomar la ÚLTIMA línea completa no vacía
-    int end = chunk.size() - 1;
-    while (end >= 0 && (chunk[end] == '\n' || chunk[end] == '\r')) --end;
-    if (end < 0) return;
-    int start = chunk.lastIndexOf('\n', end);
-    QByteArray lastLine = chunk.mid(start + 1, end - start);
-
-    QJsonParseError err{};
-    const QJsonDocument doc = QJsonDocument::fromJson(lastLine, &err);
-    if (err.error != QJsonParseError::NoError || !doc.isObject()) return;
-
-    MetricsSnapshot tmp = parseSnapshotJson(doc.object());
-    auto sp = QSharedPointer<const MetricsSnapshot>::create(std::move(tmp)); // sin copias grandes
-    emit snapshotReady(sp);
-}
-
-// --- Parser robusto: acepta números o strings (hex/dec) ---
-MetricsSnapshot ServerWorker::parseSnapshotJson(const QJsonObject& obj) const {
-    MetricsSnapshot out;
-
-    // ----- general -----
-    if (obj.contains("general") && obj["general"].isObject()) {
-        const QJsonObject g = obj["general"].toObject();
-        out.heapCurrent  = toU64(g.value("heap_current"));
-        out.heapPeak     = toU64(g.value("heap_peak"));
-        out.activeAllocs = toU64(g.value("active_allocs"));
-        out.totalAllocs  = toU64(g.value("total_allocs"));
-        out.leakBytes    = toU64(g.value("leak_bytes"));
-        out.allocRate    = g.value("alloc_rate").toDouble();
-        out.freeRate     = g.value("free_rate").toDouble();
-        out.uptimeMs     = toU64(g.value("uptime_ms"));
-
-        out.leakRate        = g.value("leak_rate").toDouble();
-        out.largestLeakSz   = toU64(g.value("largest_size"));
-        out.largestLeakFile = g.value("largest_file").toString();
-        out.topLeakFile     = g.value("top_file").toString();
-        out.topLeakCount    = toInt(g.value("top_file_count"));
-        out.topLeakBytes    = toI64(g.value("top_file_bytes"));
+    for (const ClientPtr& c : std::as_const(clients_)) {
+        if (c->busy) continue;
+        const bool json = c->mode == Mode::Json;
+        QByteArray work = std::exchange(json ? c->line : c->frames, QByteArray());
+        if (work.isEmpty()) continue;
+        c->busy    = true;
+        c->lastKey = -1;
+        pool_->start(new PoolTask([this, c, json, work = std::move(work)] {
+            const Parsed p = json ? parseLine(c->decoder, work) : applyFrames(c->resident, work);
+            QMetaObject::invokeMethod(this, [this, c, p] { onParsed(c, p); }, Qt::QueuedConnection);
+        }));
     }
+    if (fleetDirty_ && selected_ == kFleet && !merging_) startFleetMerge();
+    emitIngestStats();
+}
 
-    // ----- per_file -----
-    out.perFile.clear();
-    if (obj.contains("per_file") && obj["per_file"].isArray()) {
-        const QJsonArray arr = obj["per_file"].toArray();
-        out.perFile.reserve(arr.size());
-        for (const QJsonValue& v : arr) {
-            if (!v.isObject()) continue;
-            const QJsonObject o = v.toObject();
-            FileStat fs;
-            fs.file       = o.value("file").toString();
-            // Aceptar numérico o string
-            fs.totalBytes = toI64(o.value("totalBytes"));
-            fs.allocs     = toInt(o.value("allocs"));
-            fs.frees      = toInt(o.value("frees"));
-            fs.netBytes   = toI64(o.value("netBytes"));
-            out.perFile.push_back(fs);
-        }
+void ServerWorker::onParsed(const ClientPtr& c, const Parsed& p) {
+    c->busy = false;
+    droppedIn_ += quint64(p.dropped);
+    if (clients_.value(c->info.id) != c) return;   // ya desconectado
+    if (!p.snapshot) return;
+    c->latest = p.snapshot;
+    if (selected_ == c->info.id) publish(p.snapshot);
+    else if (selected_ == kFleet) fleetDirty_ = true;
+}
+
+void ServerWorker::emitIngestStats() {
+    quint64 dropped = droppedIn_;
+    for (const ClientPtr& c : std::as_const(clients_))
+        if (c->latest) dropped += c->latest->droppedFrames;
+    if (bytesIn_ == shownBytes_ && messagesIn_ == shownMessages_ && dropped == shownDropped_) return;
+    shownBytes_    = bytesIn_;
+    shownMessages_ = messagesIn_;
+    shownDropped_  = dropped;
+    emit ingestStats(bytesIn_, messagesIn_, dropped);
+}
+
+// Flota: con un solo proceso se emite tal cual; con varios, la agregación
+// (Reducers.h) corre en el pool
+void ServerWorker::startFleetMerge() {
+    fleetDirty_ = false;
+    QVector<FleetPart> parts;
+    for (const ClientPtr& c : std::as_const(clients_))
+        if (c->latest) parts.push_back({c->info.id, QStringLiteral("%1 (%2)").arg(c->info.name).arg(c->info.pid), c->latest});
+    if (parts.isEmpty()) return;
+    if (parts.size() == 1) { publish(parts.front().snapshot); return; }
+
+    std::sort(parts.begin(), parts.end(), [](const FleetPart& a, const FleetPart& b) { return a.id < b.id; });
+    merging_ = true;
+    pool_->start(new PoolTask([this, parts] {
+        auto sp = QSharedPointer<const MetricsSnapshot>::create(mergeSnapshots(parts));
+        QMetaObject::invokeMethod(this, [this, sp] {
+            merging_ = false;
+            if (selected_ == kFleet) publish(sp);
+        }, Qt::QueuedConnection);
+    }));
+}
+
+void ServerWorker::publish(const QSharedPointer<const MetricsSnapshot>& s) {
+    shown_ = s;
+    emit snapshotReady(s);
+    prepareTables();
+}
+
+// Filtro, orden y gráficas de los bloques: O(N log N) sobre millones de
+// filas, en el pool y no en la GUI. Mientras una tarea corre solo se marca
+// 'tablesDirty_'; al volver se lanza otra con lo último (snapshot y vistas).
+void ServerWorker::prepareTables() {
+    if (!shown_) return;
+    if (preparing_) { tablesDirty_ = true; return; }
+    preparing_   = true;
+    tablesDirty_ = false;
+    auto t = QSharedPointer<LeakTables>::create();
+    t->snapshot   = shown_;
+    t->leaksView  = leakViews_[kLeaksTable];
+    t->blocksView = leakViews_[kBlocksTable];
+    pool_->start(new PoolTask([this, t] {
+        const QVector<LeakItem>& leaks = t->snapshot->leaks;
+        t->leaks  = buildLeakOrder(leaks, t->leaksView);
+        t->blocks = buildLeakOrder(leaks, t->blocksView);
+        t->charts = buildLeakCharts(leaks);
+        QSharedPointer<const LeakTables> ready = t;
+        QMetaObject::invokeMethod(this, [this, ready] {
+            preparing_ = false;
+            emit leakTablesReady(ready);
+            if (tablesDirty_) prepareTables();
+        }, Qt::QueuedConnection);
+    }));
+}
+
+// Tramas completas en orden; se emite una vez al final (los deltas dependen
+// del anterior)
+ServerWorker::Parsed ServerWorker::applyFrames(Resident& R, const QByteArray& frames) {
+    Parsed out;
+    bool changed = false;
+    qsizetype off = 0;
+    wire::FrameHeader h;
+    while (wire::peekFrame(frames.constData() + off, size_t(frames.size() - off), h) == wire::FrameStatus::Ok) {
+        if (applyFrame(R, h, frames.constData() + off + qsizetype(wire::kHeaderSize))) changed = true;
+        else ++out.dropped;
+        off += qsizetype(wire::kHeaderSize + h.length);
     }
+    if (changed && R.valid) out.snapshot = residentSnapshot(R);
+    return out;
+}
+
+// Sitios sin file/line: función, archivo y línea salen del símbolo de su pc
+// (si ya está resuelto; el simbolizador del runtime va por detrás)
+static void applySymbol(LeakItem& li, const QHash<qulonglong, FrameSymbol>& symbols) {
+    if (!li.pc) return;
+    auto it = symbols.constFind(li.pc);
+    if (it == symbols.constEnd()) return;
+    li.function = it->function;
+    if (!it->file.isEmpty() && (li.file.isEmpty() || li.file == QLatin1String("unknown"))) {
+        li.file = it->file;
+        li.line = it->line;
+    }
+}
 
-    // ----- bins -----
-    out.bins.clear();
-    if (obj.contains("bins") && obj["bins"].isArray()) {
-        const QJsonArray arr = obj["bins"].toArray();
-        out.bins.reserve(arr.size());
-        for (const QJsonValue& v : arr) {
-            if (!v.isObject()) continue;
-            const QJsonObject o = v.toObject();
-            BinRange b;
-            b.lo          = toU64(o.value("lo"));
-            b.hi          = toU64(o.value("hi"));
-            b.bytes       = toI64(o.value("bytes"));
-            b.allocations = toInt(o.value("allocations"));
-            out.bins.push_back(b);
+static void applySymbols(QVector<LeakItem>& leaks, const QHash<qulonglong, FrameSymbol>& symbols) {
+    if (symbols.isEmpty()) return;
+    for (LeakItem& li : leaks) applySymbol(li, symbols);
+}
+
+static void applySymbols(HeapSnapshotItem& hs, const QHash<qulonglong, FrameSymbol>& symbols) {
+    for (SiteUsageItem& u : hs.sites) {
+        if (!u.pc) continue;
+        auto it = symbols.constFind(u.pc);
+        if (it == symbols.constEnd() || it->file.isEmpty()) continue;
+        if (u.file.isEmpty() || u.file == QLatin1String("unknown")) {
+            u.file = it->file;
+            u.line = it->line;
         }
     }
+}
 
-    // ----- leaks (bloques vivos) -----
-    out.leaks.clear();
-    if (obj.contains("leaks") && obj["leaks"].isArray()) {
-        const QJsonArray arr = obj["leaks"].toArray();
-        out.leaks.reserve(arr.size());
-        for (const QJsonValue& v : arr) {
-            if (!v.isObject()) continue;
-            const QJsonObject o = v.toObject();
-            LeakItem li;
-
-            // Acepta "ptr" o "addr" (string hex/dec o número)
-            if (o.contains("ptr"))  li.ptr = toU64(o.value("ptr"));
-            else if (o.contains("addr")) li.ptr = toU64(o.value("addr"));
-            else li.ptr = 0;
-
-            li.size  = toI64(o.value("size"));
-            li.file  = o.value("file").toString();
-            li.line  = toInt(o.value("line"));
-            li.type  = o.value("type").toString();
-
-            // Acepta "ts_ns" o "t_ns" y string/num
-            if (o.contains("ts_ns"))      li.ts_ns = toU64(o.value("ts_ns"));
-            else if (o.contains("t_ns"))  li.ts_ns = toU64(o.value("t_ns"));
-            else                          li.ts_ns = 0;
-
-            li.isLeak = o.value("is_leak").toBool(false);
-            out.leaks.push_back(li);
+static void applySymbols(QVector<SiteLifetime>& lives, const QHash<qulonglong, FrameSymbol>& symbols) {
+    if (symbols.isEmpty()) return;
+    for (SiteLifetime& l : lives) {
+        if (!l.pc) continue;
+        auto it = symbols.constFind(l.pc);
+        if (it == symbols.constEnd() || it->file.isEmpty()) continue;
+        if (l.file.isEmpty() || l.file == QLatin1String("unknown")) {
+            l.file = it->file;
+            l.line = it->line;
         }
     }
+}
+
+static void applySymbols(QVector<HeapSnapshotItem>& snaps, const QHash<qulonglong, FrameSymbol>& symbols) {
+    if (symbols.isEmpty()) return;
+    for (HeapSnapshotItem& hs : snaps) applySymbols(hs, symbols);
+}
 
+// Modo JSON: el decodificador del cliente escribe directo sobre el snapshot
+ServerWorker::Parsed ServerWorker::parseLine(SnapshotDecoder& dec, const QByteArray& line) {
+    Parsed out;
+    auto sp = QSharedPointer<MetricsSnapshot>::create();
+    if (!dec.decode(line.constData(), line.size(), *sp)) {
+        out.dropped = 1;
+        return out;
+    }
+    if (!sp->symbols.isEmpty()) {
+        QHash<qulonglong, FrameSymbol> byPc;
+        byPc.reserve(sp->symbols.size());
+        for (const FrameSymbol& fs : std::as_const(sp->symbols)) byPc.insert(fs.pc, fs);
+        applySymbols(sp->leaks, byPc);
+        applySymbols(sp->heapSnapshots, byPc);
+        applySymbols(sp->peakSnapshot, byPc);
+        applySymbols(sp->lifetimes, byPc);
+    }
+    out.snapshot = sp;
     return out;
 }
+
+QSharedPointer<const MetricsSnapshot> ServerWorker::residentSnapshot(const Resident& R) {
+    auto sp = QSharedPointer<MetricsSnapshot>::create(R.head);
+    sp->perFile.reserve(R.files.size());
+    for (const FileStat& fs : R.files) sp->perFile.push_back(fs);
+    sp->leaks = R.blocks;   // compartido: ya simbolizados al entrar
+    sp->stacks.reserve(R.stacks.size());
+    for (StackStat ss : R.stacks) {
+        ss.frames = R.stackFrames.value(ss.id);
+        sp->stacks.push_back(std::move(ss));
+    }
+    sp->symbols.reserve(R.symbols.size());
+    for (const FrameSymbol& fs : R.symbols) sp->symbols.push_back(fs);
+    sp->heapSnapshots = R.heapSnapshots;
+    applySymbols(sp->heapSnapshots, R.symbols);
+    sp->peakSnapshot = R.peakSnapshot;
+    applySymbols(sp->peakSnapshot, R.symbols);
+    sp->lifetimes.reserve(R.lifetimes.size());
+    for (const SiteLifetime& l : R.lifetimes) sp->lifetimes.push_back(l);
+    applySymbols(sp->lifetimes, R.symbols);
+    return sp;
+}
+
+// --- Decodificador binario (formato en memprof/proto/WireFormat.h) ---
+bool ServerWorker::applyFrame(Resident& R, const wire::FrameHeader& h, const char* payload) {
+    if (h.kind != wire::Kind::Snapshot && h.kind != wire::Kind::Delta) return false;
+    const bool keyframe = (h.kind == wire::Kind::Snapshot);
+    if (!keyframe && !R.valid) return false;   // esperando keyframe
+
+    QVector<QString> strings;   // tabla local de la trama
+
+    // Las cadenas se convierten una vez por trama; LeakItem/FileStat las
+    // comparten (QString es implícitamente compartido).
+    auto str = [&](uint64_t id) -> QString {
+        return id < uint64_t(strings.size()) ? strings[qsizetype(id)] : QString();
+    };
+    auto fail = [&]() {
+        R.valid = false;
+        emit status(QStringLiteral("Malformed frame, waiting for keyframe"));
+        return false;
+    };
+    // Filas por sitio de HeapSnapshots/PeakSnapshot (Δsite, bytes, count)
+    const ResidentSite none;
+    auto siteUsage = [&](wire::Reader& body, QVector<SiteUsageItem>& sites) {
+        const uint64_t k = body.varint();
+        if (k > body.remaining()) return false;
+        sites.reserve(qsizetype(k));
+        uint64_t site = 0;
+        for (uint64_t j = 0; j < k && body.ok(); ++j) {
+            site += body.varint();
+            const ResidentSite& st = site < uint64_t(R.sites.size()) ? R.sites[qsizetype(site)] : none;
+            SiteUsageItem u;
+            u.file  = st.file;
+            u.line  = st.line;
+            u.type  = st.type;
+            u.pc    = st.pc;
+            u.bytes = body.varint();
+            u.count = body.varint();
+            sites.push_back(u);
+        }
+        return true;
+    };
+
+    if (keyframe) {
+        R.sites.clear();
+        R.blocks.clear();
+        R.blockIndex.clear();
+        R.files.clear();
+        R.stackFrames.clear();
+        R.stacks.clear();
+        R.symStrings.clear();
+        R.symbols.clear();
+        R.heapSnapshots.clear();
+        R.peakSnapshot = HeapSnapshotItem{};
+        R.lifetimes.clear();
+        R.head = MetricsSnapshot{};
+        R.valid = true;
+    }
+
+    wire::Reader r(payload, size_t(h.length));
+    wire::Section tag;
+    wire::Reader body(nullptr, 0);
+    while (r.nextSection(tag, body)) {
+        switch (tag) {
+        case wire::Section::Epoch: {
+            const quint64 epoch = body.varint();
+            const quint64 base  = body.varint();
+            if (!keyframe && base != R.epoch) {
+                R.valid = false;
+                emit status(QStringLiteral("Delta %1 does not follow %2, waiting for keyframe")
+                            .arg(epoch).arg(R.epoch));
+                return false;
+            }
+            R.epoch = epoch;
+            break;
+        }
+        case wire::Section::Strings: {
+            const uint64_t cnt = body.varint();
+            if (cnt > body.remaining()) return fail();
+            strings.reserve(qsizetype(cnt));
+            for (uint64_t i = 0; i < cnt && body.ok(); ++i) {
+                const std::string_view sv = body.bytes();
+                strings.push_back(QString::fromUtf8(sv.data(), int(sv.size())));
+            }
+            break;
+        }
+        case wire::Section::Sites: {
+            const uint64_t first = body.varint();
+            const uint64_t cnt   = body.varint();
+            if (cnt > body.remaining() || first > uint64_t(R.sites.size())) return fail();
+            R.sites.resize(qsizetype(first));
+            R.sites.reserve(qsizetype(first + cnt));
+            for (uint64_t i = 0; i < cnt && body.ok(); ++i) {
+                ResidentSite st;
+                st.file = str(body.varint());
+                st.line = int(body.zigzag());
+                st.type = str(body.varint());
+                R.sites.push_back(st);
+            }
+            break;
+        }
+        case wire::Section::General: {
+            MetricsSnapshot& out = R.head;
+            out.uptimeMs        = body.varint();
+            out.heapCurrent     = body.varint();
+            out.heapPeak        = body.varint();
+            out.activeAllocs    = body.varint();
+            out.totalAllocs     = body.varint();
+            out.leakBytes       = body.varint();
+            out.allocRate       = body.f64();
+            out.freeRate        = body.f64();
+            out.leakRate        = body.f64();
+            out.largestLeakSz   = body.varint();
+            out.largestLeakFile = str(body.varint());
+            out.topLeakFile     = str(body.varint());
+            out.topLeakCount    = int(body.varint());
+            out.topLeakBytes    = qlonglong(body.varint());
+            out.sampleInterval  = body.atEnd() ? 0 : body.varint();   // campos añadidos al final
+            out.droppedFrames   = body.atEnd() ? 0 : body.varint();
+            break;
+        }
+        case wire::Section::PerFile: {
+            const uint64_t cnt = body.varint();
+            if (cnt > body.remaining()) return fail();
+            for (uint64_t i = 0; i < cnt && body.ok(); ++i) {
+                FileStat fs;
+                fs.file       = str(body.varint());
+                fs.totalBytes = qlonglong(body.varint());
+                fs.allocs     = int(body.varint());
+                fs.frees      = int(body.varint());
+                fs.netBytes   = qlonglong(body.varint());
+                // Fila vaciada (sus sitios pasaron al archivo simbolizado)
+                if (fs.allocs == 0) R.files.remove(fs.file);
+                else                R.files.insert(fs.file, fs);
+            }
+            break;
+        }
+        case wire::Section::Bins: {
+            const uint64_t cnt = body.varint();
+            if (cnt > body.remaining()) return fail();
+            R.head.bins.clear();
+            R.head.bins.reserve(qsizetype(cnt));
+            for (uint64_t i = 0; i < cnt && body.ok(); ++i) {
+                BinRange b;
+                b.lo          = body.varint();
+                b.hi          = body.varint();
+                b.bytes       = qlonglong(body.varint());
+                b.allocations = int(body.varint());
+                R.head.bins.push_back(b);
+            }
+            break;
+        }
+        case wire::Section::AllocBins: {
+            // Mismo orden que Bins, que llega antes en la trama
+            const uint64_t cnt = body.varint();
+            if (cnt != uint64_t(R.head.bins.size())) return fail();
+            for (BinRange& b : R.head.bins) {
+                b.allocBytes = body.varint();
+                b.allocCount = body.varint();
+            }
+            break;
+        }
+        case wire::Section::Blocks: {
+            const uint64_t cnt = body.varint();
+            if (cnt > body.remaining()) return fail();
+            if (keyframe) {
+                R.blocks.reserve(qsizetype(cnt));
+                R.blockIndex.reserve(qsizetype(cnt));
+            }
+            const ResidentSite none;
+            for (uint64_t i = 0; i < cnt && body.ok(); ++i) {
+                LeakItem li;
+                li.ptr   = body.varint();
+                li.size  = qlonglong(body.varint());
+                const uint64_t s = body.varint();
+                const ResidentSite& st = s < uint64_t(R.sites.size()) ? R.sites[qsizetype(s)] : none;
+                li.file  = st.file;
+                li.line  = st.line;
+                li.type  = st.type;
+                li.pc    = st.pc;
+                li.ts_ns = body.varint();
+                const uint8_t flags = body.u8();
+                li.isLeak = (flags & wire::BlockLeak) != 0;
+                if (flags & wire::BlockStack) li.stackId = unsigned(body.varint());
+                applySymbol(li, R.symbols);
+                auto at = R.blockIndex.constFind(li.ptr);
+                if (at != R.blockIndex.constEnd()) {
+                    R.blocks[*at] = std::move(li);
+                } else {
+                    R.blockIndex.insert(li.ptr, int(R.blocks.size()));
+                    R.blocks.push_back(std::move(li));
+                }
+            }
+            break;
+        }
+        case wire::Section::StackFrames: {
+            const uint64_t first = body.varint();
+            const uint64_t cnt   = body.varint();
+            if (cnt > body.remaining()) return fail();
+            for (uint64_t i = 0; i < cnt && body.ok(); ++i) {
+                const uint64_t depth = body.varint();
+                if (depth > body.remaining()) return fail();
+                QVector<qulonglong> pcs;
+                pcs.reserve(qsizetype(depth));
+                for (uint64_t k = 0; k < depth; ++k) pcs.push_back(body.varint());
+                R.stackFrames.insert(unsigned(first + i), pcs);
+            }
+            break;
+        }
+        case wire::Section::PerStack: {
+            const uint64_t cnt = body.varint();
+            if (cnt > body.remaining()) return fail();
+            for (uint64_t i = 0; i < cnt && body.ok(); ++i) {
+                StackStat ss;
+                ss.id         = unsigned(body.varint());
+                ss.totalBytes = body.varint();
+                ss.allocs     = body.varint();
+                ss.liveCount  = body.varint();
+                ss.liveBytes  = body.varint();
+                ss.leakCount  = body.varint();
+                ss.leakBytes  = body.varint();
+                R.stacks.insert(ss.id, ss);
+            }
+            break;
+        }
+        case wire::Section::SitePcs: {
+            const uint64_t cnt = body.varint();
+            if (cnt > body.remaining()) return fail();
+            for (uint64_t i = 0; i < cnt && body.ok(); ++i) {
+                const uint64_t s  = body.varint();
+                const uint64_t pc = body.varint();
+                if (s < uint64_t(R.sites.size())) R.sites[qsizetype(s)].pc = pc;
+            }
+            break;
+        }
+        case wire::Section::SymbolStrings: {
+            const uint64_t first = body.varint();
+            const uint64_t cnt   = body.varint();
+            if (cnt > body.remaining() || first > uint64_t(R.symStrings.size()) + 1) return fail();
+            R.symStrings.resize(qsizetype(first));   // el id 0 es la cadena vacía
+            for (uint64_t i = 0; i < cnt && body.ok(); ++i) {
+                const std::string_view sv = body.bytes();
+                R.symStrings.push_back(QString::fromUtf8(sv.data(), int(sv.size())));
+            }
+            break;
+        }
+        case wire::Section::Symbols: {
+            const uint64_t cnt = body.varint();
+            if (cnt > body.remaining()) return fail();
+            auto sym = [&](uint64_t id) -> QString {
+                return id < uint64_t(R.symStrings.size()) ? R.symStrings[qsizetype(id)] : QString();
+            };
+            QHash<qulonglong, FrameSymbol> fresh;
+            for (uint64_t i = 0; i < cnt && body.ok(); ++i) {
+                FrameSymbol fs;
+                fs.pc       = body.varint();
+                fs.function = sym(body.varint());
+                fs.file     = sym(body.varint());
+                fs.line     = int(body.zigzag());
+                R.symbols.insert(fs.pc, fs);
+                fresh.insert(fs.pc, fs);
+            }
+            // Los bloques vivos se simbolizan una vez, cuando llega su pc (los
+            // que entren después, en Blocks). Se busca sin escribir para no
+            // separar el vector del último snapshot si nada cambia.
+            const QVector<LeakItem>& blocks = R.blocks;
+            for (int b = 0; b < blocks.size(); ++b)
+                if (blocks[b].pc && fresh.contains(blocks[b].pc)) applySymbol(R.blocks[b], fresh);
+            break;
+        }
+        case wire::Section::HeapSnapshots: {
+            const uint64_t cnt = body.varint();
+            if (cnt > body.remaining()) return fail();
+            for (uint64_t i = 0; i < cnt && body.ok(); ++i) {
+                HeapSnapshotItem hs;
+                hs.id    = unsigned(body.varint());
+                const std::string_view label = body.bytes();
+                hs.label = QString::fromUtf8(label.data(), int(label.size()));
+                hs.tMs   = body.varint();
+                hs.bytes = body.varint();
+                hs.count = body.varint();
+                if (!siteUsage(body, hs.sites)) return fail();
+                if (R.heapSnapshots.isEmpty() || R.heapSnapshots.back().id < hs.id)
+                    R.heapSnapshots.push_back(std::move(hs));
+            }
+            break;
+        }
+        case wire::Section::PeakSnapshot: {
+            HeapSnapshotItem ps;
+            ps.id    = unsigned(body.varint());
+            ps.label = QStringLiteral("peak");
+            ps.tMs   = body.varint();
+            ps.bytes = body.varint();
+            ps.count = body.varint();
+            if (!siteUsage(body, ps.sites)) return fail();
+            R.peakSnapshot = std::move(ps);
+            break;
+        }
+        case wire::Section::Lifetimes: {
+            R.head.shortLivedNs = body.varint();
+            const uint64_t cnt = body.varint();
+            if (cnt > body.remaining()) return fail();
+            for (uint64_t i = 0; i < cnt && body.ok(); ++i) {
+                const uint64_t site = body.varint();
+                const ResidentSite& st = site < uint64_t(R.sites.size()) ? R.sites[qsizetype(site)] : none;
+                SiteLifetime l;
+                l.file       = st.file;
+                l.line       = st.line;
+                l.type       = st.type;
+                l.pc         = st.pc;
+                l.frees      = body.varint();
+                l.bytes      = body.varint();
+                l.shortLived = body.varint();
+                l.p50Ns      = body.varint();
+                l.p99Ns      = body.varint();
+                R.lifetimes.insert(quint32(site), l);
+            }
+            break;
+        }
+        case wire::Section::Removed: {
+            const uint64_t cnt = body.varint();
+            if (cnt > body.remaining()) return fail();
+            quint64 ptr = 0;
+            for (uint64_t i = 0; i < cnt && body.ok(); ++i) {
+                ptr += body.varint();
+                auto it = R.blockIndex.find(ptr);
+                if (it == R.blockIndex.end()) continue;
+                const int at = *it;
+                R.blockIndex.erase(it);
+                // Quitar intercambiando con el último: O(1), el orden lo pone la vista
+                const int last = int(R.blocks.size()) - 1;
+                if (at != last) {
+                    R.blocks[at] = std::move(R.blocks[last]);
+                    R.blockIndex[R.blocks[at].ptr] = at;
+                }
+                R.blocks.removeLast();
+            }
+            break;
+        }
+        default:
+            break;   // Timeline o sección desconocida (versión más nueva): se ignora
+        }
+        if (!body.ok()) return fail();
+    }
+    if (!r.ok()) return fail();
+    return true;
+}
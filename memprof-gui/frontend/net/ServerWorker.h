@@ -3,48 +3,171 @@
 #include <QTcpServer>
 #include <QTcpSocket>
 #include <QTimer>
-#include <QMutex>
 #include <QByteArray>
 #include <QHostAddress>
-#include <QJsonDocument>
-#include <QJsonObject>
 #include <QSharedPointer>
+#include <QHash>
+#include <QVector>
+#include <QThreadPool>
+#include <QMetaType>
 
+#include "frontend/model/LeakOrder.h"
+#include "frontend/net/LineFramer.h"
+#include "frontend/net/LocalListener.h"
+#include "frontend/net/SnapshotDecoder.h"
 #include "memprof/proto/MetricsSnapshot.h"
+#include "memprof/proto/WireFormat.h"
 
+// Proceso conectado (selector de la GUI)
+struct ClientInfo {
+    quint32 id = 0;
+    qint64  pid = 0;       // 0 = runtime sin saludo (anterior a la trama Hello)
+    QString name;          // binario
+    QString kind;          // "tcp" / "unix" / "shm"
+};
+Q_DECLARE_METATYPE(ClientInfo)
+
+// Recibe de varios runtimes a la vez (TCP y socket local). Cada conexión se
+// identifica con la trama Hello (pid + binario) y tiene su propio modelo
+// residente. Lo recibido se enmarca al llegar (líneas JSON / tramas
+// completas) y nada se pierde por el camino: el parseo corre en un pool
+// pequeño, como mucho una tarea por cliente (los deltas van en orden), y lo
+// único que se agrupa es el pintado. Se emite el snapshot de la vista
+// elegida: un proceso o la flota agregada (kFleet), y después, también desde
+// el pool, sus tablas de bloques filtradas y ordenadas (leakTablesReady).
 class ServerWorker : public QObject {
     Q_OBJECT
 public:
+    static constexpr quint32 kFleet = 0;
+    static constexpr int kLeaksTable  = 0;   // setLeakView: pestaña Leaks
+    static constexpr int kBlocksTable = 1;   //              pestaña Mapa
+
     explicit ServerWorker(QObject* parent = nullptr);
+    ~ServerWorker() override;
 
 public slots:
     void listen(const QHostAddress& addr = QHostAddress::LocalHost, quint16 port = 7070);
+    // Además de TCP: socket AF_UNIX para runtimes con endpoint "unix:"/"shm:"
+    void listenLocal(const QString& path);
     void stop();
+    void selectClient(quint32 id);   // kFleet = todos agregados
+    // Orden/filtro pedido por una tabla; se rehacen las del snapshot mostrado
+    void setLeakView(int table, const LeakView& view);
 
     signals:
         // Pasamos un puntero compartido para evitar copias grandes entre hilos
         void snapshotReady(QSharedPointer<const MetricsSnapshot> s);
+    // Permutaciones y gráficas de Leaks/Mapa para el último snapshot emitido
+    void leakTablesReady(QSharedPointer<const LeakTables> t);
+    void clientsChanged(const QVector<ClientInfo>& clients);
+    // Contadores acumulados: bytes recibidos, mensajes enmarcados (líneas o
+    // tramas) y mensajes perdidos (en la GUI + los que descartó el runtime)
+    void ingestStats(quint64 bytes, quint64 messages, quint64 dropped);
     void status(const QString& s);
 
 private slots:
     void onNewConnection();
-    void onReadyRead();
-    void onDisconnected();
-    void flushCoalesced();   // emite el último snapshot cada ~80 ms
+    void onLocalConnected(quint32 localId, const QString& kind);
+    void onLocalData(quint32 localId, const QByteArray& chunk);
+    void onLocalDisconnected(quint32 localId);
+    void flushCoalesced();   // reparte el parseo y emite la vista cada ~80 ms
 
 private:
-    MetricsSnapshot parseSnapshotJson(const QJsonObject& obj) const;
+    // Modelo residente del modo binario: se actualiza con cada delta y de él
+    // sale el snapshot que se emite (el coste de parseo sigue al churn).
+    struct ResidentSite { QString file; int line = 0; QString type; qulonglong pc = 0; };
+    struct Resident {
+        bool    valid = false;              // hay un keyframe aplicado
+        quint64 epoch = 0;
+        QVector<ResidentSite>    sites;     // SiteId -> sitio
+        QVector<LeakItem>        blocks;    // bloques vivos (sin orden; el snapshot lo comparte)
+        QHash<quint64, int>      blockIndex;   // ptr -> posición en 'blocks'
+        QHash<QString, FileStat> files;     // archivo -> fila
+        QHash<unsigned, QVector<qulonglong>> stackFrames;   // id de pila -> direcciones
+        QHash<unsigned, StackStat> stacks;  // id de pila -> agregados
+        QVector<QString>         symStrings;   // tabla SymbolStrings (persiste entre tramas)
+        QHash<qulonglong, FrameSymbol> symbols;   // pc -> símbolo
+        QVector<HeapSnapshotItem> heapSnapshots;   // por id creciente
+        HeapSnapshotItem         peakSnapshot;     // última captura en el pico
+        QHash<quint32, SiteLifetime> lifetimes;    // SiteId -> vidas
+        MetricsSnapshot          head;      // generales + bins (sin perFile/leaks)
+    };
+
+    // Una conexión. Los campos se tocan en el hilo del worker salvo
+    // 'resident' y 'decoder', que son de la tarea de parseo en curso ('busy').
+    enum class Mode { Unknown, Json, Binary };
+    struct Client {
+        ClientInfo  info;
+        bool        greeted = false;      // Hello leído (o flujo sin Hello)
+        Mode        mode    = Mode::Unknown;
+        QTcpSocket* sock    = nullptr;    // TCP
+        quint32     localId = 0;          // unix/shm: id en LocalListener
+        QByteArray  buffer;               // sin enmarcar: Hello o trama a medias
+        LineFramer  lines{kMaxLine};      // JSON
+        QByteArray  line;                 // JSON: última línea completa sin parsear
+        QByteArray  frames;               // binario: tramas completas sin aplicar
+        qsizetype   lastKey = -1;         // offset del keyframe más reciente en 'frames'
+        bool        busy    = false;
+        Resident    resident;
+        SnapshotDecoder decoder;          // JSON: cadenas y reservas entre ticks
+        QSharedPointer<const MetricsSnapshot> latest;
+    };
+    using ClientPtr = QSharedPointer<Client>;
+
+    ClientPtr addClient(const QString& kind);
+    void removeClient(quint32 id);
+    void appendIncoming(Client& c, const QByteArray& chunk);   // bytes de cualquier transporte
+    void readHello(Client& c);
+    void frameBinary(Client& c);   // pasa las tramas completas de 'buffer' a 'frames'
+    void emitIngestStats();
+    void emitClients();
+
+    // --- en el pool ---
+    struct Parsed {
+        QSharedPointer<const MetricsSnapshot> snapshot;   // nulo si nada cambió
+        int dropped = 0;                                  // mensajes no aplicados
+    };
+    static Parsed parseLine(SnapshotDecoder& dec, const QByteArray& line);
+    Parsed applyFrames(Resident& R, const QByteArray& frames);
+    // Aplica una trama (keyframe o delta) al modelo residente, decodificando
+    // directamente sobre el buffer recibido. false si se descartó.
+    bool applyFrame(Resident& R, const wire::FrameHeader& h, const char* payload);
+    static QSharedPointer<const MetricsSnapshot> residentSnapshot(const Resident& R);
+
+    // --- de vuelta en el hilo del worker ---
+    void onParsed(const ClientPtr& c, const Parsed& p);
+    void startFleetMerge();
+    void publish(const QSharedPointer<const MetricsSnapshot>& s);   // emite y prepara las tablas
+    void prepareTables();   // una tarea como mucho; gana el último snapshot
 
     QTcpServer* server_ = nullptr;
-    QTcpSocket* sock_   = nullptr;
+    LocalListener* local_ = nullptr;   // unix/shm
+
+    QHash<quint32, ClientPtr> clients_;
+    QHash<quint32, quint32>   localIds_;   // id de LocalListener -> id de cliente
+    quint32 nextId_   = 1;
+    quint32 selected_ = kFleet;
+    bool    fleetDirty_ = false;           // algún cliente cambió desde la última agregación
+    bool    merging_    = false;
+    QSharedPointer<const MetricsSnapshot> shown_;   // último emitido
+    LeakView leakViews_[2];                // por tabla (kLeaksTable, kBlocksTable)
+    bool    preparing_   = false;          // tarea de tablas en el pool
+    bool    tablesDirty_ = false;          // shown_ o una vista cambió mientras tanto
+    quint64 bytesIn_    = 0;               // contadores de ingestStats
+    quint64 messagesIn_ = 0;
+    quint64 droppedIn_  = 0;
+    quint64 shownBytes_ = 0, shownMessages_ = 0, shownDropped_ = 0;   // último ingestStats
 
-    QMutex m_;
-    QByteArray buffer_;
-    QTimer* flushTimer_ = nullptr;
+    QTimer*     flushTimer_ = nullptr;
+    QThreadPool* pool_      = nullptr;   // hijo: se muda de hilo con el worker
 
     static constexpr int    kFlushMs   = 80;             // ~12.5 FPS
-    static constexpr int    kMaxBufMB  = 8;              // tope de buffer
-    static constexpr qint64 kMaxBuf    = qint64(kMaxBufMB) * 1024 * 1024;
+    // Tramas binarias sin aplicar: pasado kMaxBuf se descarta lo anterior al
+    // último keyframe (lo reemplaza entero); pasado kMaxPending, todo
+    static constexpr qint64 kMaxBuf     = qint64(8) << 20;
+    static constexpr qint64 kMaxPending = qint64(256) << 20;
+    static constexpr qint64 kMaxLine    = qint64(wire::kMaxFrameSize);   // línea JSON
+    static constexpr int    kMaxParseThreads = 4;
 };
 
 // Nota: NO usar Q_DECLARE_METATYPE para QSharedPointer en Qt6 (ya está soportado).
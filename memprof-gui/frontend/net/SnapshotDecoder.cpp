@@ -0,0 +1,182 @@
+#include "SnapshotDecoder.h"
+
+#include "memprof/proto/JsonReader.h"
+
+QString SnapshotDecoder::intern(std::string_view s) {
+    if (s.empty()) return QString();
+    const int n = int(s.size());
+    auto it = strings_.constFind(QByteArray::fromRawData(s.data(), n));   // sin copiar la clave
+    if (it != strings_.constEnd()) return *it;
+    if (strings_.size() >= kMaxInterned) strings_.clear();
+    const QString v = QString::fromUtf8(s.data(), n);
+    strings_.insert(QByteArray(s.data(), n), v);
+    return v;
+}
+
+bool SnapshotDecoder::decode(const char* data, qsizetype n, MetricsSnapshot& out) {
+    json::Reader j{data, data + n};
+    auto str = [&] { return intern(j.str(tmp_)); };
+    auto i32 = [&] { return int(j.i64()); };
+
+    // Campos de sitio comunes a heap_snapshots/peak_snapshot/lifetimes
+    auto siteField = [&](std::string_view k, auto& row) {
+        if      (k == "file") row.file = str();
+        else if (k == "line") row.line = i32();
+        else if (k == "type") row.type = str();
+        else if (k == "pc")   row.pc   = j.u64();
+        else return false;
+        return true;
+    };
+    auto heapSnapshot = [&](HeapSnapshotItem& hs) {
+        j.object([&](std::string_view k) {
+            if      (k == "id")    hs.id    = unsigned(j.u64());
+            else if (k == "label") hs.label = str();
+            else if (k == "t_ms")  hs.tMs   = j.u64();
+            else if (k == "bytes") hs.bytes = j.u64();
+            else if (k == "count") hs.count = j.u64();
+            else if (k == "sites") {
+                j.array([&] {
+                    SiteUsageItem u;
+                    j.object([&](std::string_view sk) {
+                        if (siteField(sk, u)) return;
+                        if      (sk == "bytes") u.bytes = j.u64();
+                        else if (sk == "count") u.count = j.u64();
+                        else j.skip();
+                    });
+                    hs.sites.push_back(u);
+                });
+            } else j.skip();
+        });
+    };
+
+    j.object([&](std::string_view key) {
+        if (key == "general") {
+            j.object([&](std::string_view k) {
+                if      (k == "heap_current")    out.heapCurrent     = j.u64();
+                else if (k == "heap_peak")       out.heapPeak        = j.u64();
+                else if (k == "active_allocs")   out.activeAllocs    = j.u64();
+                else if (k == "total_allocs")    out.totalAllocs     = j.u64();
+                else if (k == "leak_bytes")      out.leakBytes       = j.u64();
+                else if (k == "alloc_rate")      out.allocRate       = j.f64();
+                else if (k == "free_rate")       out.freeRate        = j.f64();
+                else if (k == "uptime_ms")       out.uptimeMs        = j.u64();
+                else if (k == "leak_rate")       out.leakRate        = j.f64();
+                else if (k == "largest_size")    out.largestLeakSz   = j.u64();
+                else if (k == "largest_file")    out.largestLeakFile = str();
+                else if (k == "top_file")        out.topLeakFile     = str();
+                else if (k == "top_file_count")  out.topLeakCount    = i32();
+                else if (k == "top_file_bytes")  out.topLeakBytes    = j.i64();
+                else if (k == "sample_interval") out.sampleInterval  = j.u64();
+                else if (k == "dropped_frames")  out.droppedFrames   = j.u64();
+                else j.skip();
+            });
+        } else if (key == "per_file") {
+            out.perFile.reserve(lastFiles_);
+            j.array([&] {
+                FileStat fs;
+                j.object([&](std::string_view k) {
+                    if      (k == "file")       fs.file       = str();
+                    else if (k == "totalBytes") fs.totalBytes = j.i64();
+                    else if (k == "allocs")     fs.allocs     = i32();
+                    else if (k == "frees")      fs.frees      = i32();
+                    else if (k == "netBytes")   fs.netBytes   = j.i64();
+                    else j.skip();
+                });
+                out.perFile.push_back(fs);
+            });
+        } else if (key == "bins") {
+            j.array([&] {
+                BinRange b;
+                j.object([&](std::string_view k) {
+                    if      (k == "lo")          b.lo          = j.u64();
+                    else if (k == "hi")          b.hi          = j.u64();
+                    else if (k == "bytes")       b.bytes       = j.i64();
+                    else if (k == "allocations") b.allocations = i32();
+                    else if (k == "alloc_bytes") b.allocBytes  = j.u64();
+                    else if (k == "alloc_count") b.allocCount  = j.u64();
+                    else j.skip();
+                });
+                out.bins.push_back(b);
+            });
+        } else if (key == "leaks") {
+            out.leaks.reserve(lastLeaks_);
+            j.array([&] {
+                LeakItem li;
+                j.object([&](std::string_view k) {
+                    if      (k == "ptr" || k == "addr")   li.ptr     = j.u64();
+                    else if (k == "size")                 li.size    = j.i64();
+                    else if (k == "file")                 li.file    = str();
+                    else if (k == "line")                 li.line    = i32();
+                    else if (k == "type")                 li.type    = str();
+                    else if (k == "ts_ns" || k == "t_ns") li.ts_ns   = j.u64();
+                    else if (k == "is_leak")              li.isLeak  = j.boolean();
+                    else if (k == "stack")                li.stackId = unsigned(j.u64());
+                    else if (k == "pc")                   li.pc      = j.u64();
+                    else j.skip();
+                });
+                out.leaks.push_back(li);
+            });
+        } else if (key == "stacks") {
+            j.array([&] {
+                StackStat ss;
+                j.object([&](std::string_view k) {
+                    if      (k == "id")         ss.id         = unsigned(j.u64());
+                    else if (k == "frames")     j.array([&] { ss.frames.push_back(j.u64()); });
+                    else if (k == "totalBytes") ss.totalBytes = j.u64();
+                    else if (k == "allocs")     ss.allocs     = j.u64();
+                    else if (k == "live_count") ss.liveCount  = j.u64();
+                    else if (k == "live_bytes") ss.liveBytes  = j.u64();
+                    else if (k == "leak_count") ss.leakCount  = j.u64();
+                    else if (k == "leak_bytes") ss.leakBytes  = j.u64();
+                    else j.skip();
+                });
+                out.stacks.push_back(ss);
+            });
+        } else if (key == "heap_snapshots") {
+            j.array([&] {
+                HeapSnapshotItem hs;
+                heapSnapshot(hs);
+                out.heapSnapshots.push_back(hs);
+            });
+        } else if (key == "peak_snapshot") {
+            if (j.peek() == '{') heapSnapshot(out.peakSnapshot);
+            else                 j.skip();   // null: aún sin captura
+        } else if (key == "lifetimes") {
+            j.object([&](std::string_view k) {
+                if (k == "short_ns") { out.shortLivedNs = j.u64(); return; }
+                if (k != "sites")    { j.skip(); return; }
+                j.array([&] {
+                    SiteLifetime l;
+                    j.object([&](std::string_view sk) {
+                        if (siteField(sk, l)) return;
+                        if      (sk == "frees")  l.frees      = j.u64();
+                        else if (sk == "bytes")  l.bytes      = j.u64();
+                        else if (sk == "short")  l.shortLived = j.u64();
+                        else if (sk == "p50_ns") l.p50Ns      = j.u64();
+                        else if (sk == "p99_ns") l.p99Ns      = j.u64();
+                        else j.skip();
+                    });
+                    out.lifetimes.push_back(l);
+                });
+            });
+        } else if (key == "symbols") {
+            j.array([&] {
+                FrameSymbol fs;
+                j.object([&](std::string_view k) {
+                    if      (k == "pc")       fs.pc       = j.u64();
+                    else if (k == "function") fs.function = str();
+                    else if (k == "file")     fs.file     = str();
+                    else if (k == "line")     fs.line     = i32();
+                    else j.skip();
+                });
+                out.symbols.push_back(fs);
+            });
+        } else {
+            j.skip();   // timeline y secciones desconocidas
+        }
+    });
+
+    lastLeaks_ = out.leaks.size();
+    lastFiles_ = out.perFile.size();
+    return j.ok;
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+
+#include <string>
+#include <string_view>
+
+#include "memprof/proto/MetricsSnapshot.h"
+
+// Decodificador de una línea JSON del runtime (MEMPROF_WIRE_FORMAT=json)
+// directamente sobre MetricsSnapshot, sin QJsonDocument: un recorrido sobre
+// el buffer (memprof/proto/JsonReader.h), enteros exactos de 64 bits y las
+// cadenas repetidas (archivo, tipo, función) convertidas a QString una sola
+// vez y compartidas entre filas y entre ticks. Una instancia por flujo; no
+// es reentrante.
+class SnapshotDecoder {
+public:
+    // false si la línea no es un snapshot válido ('out' queda a medias)
+    bool decode(const char* data, qsizetype n, MetricsSnapshot& out);
+
+private:
+    QString intern(std::string_view s);
+
+    QHash<QByteArray, QString> strings_;   // UTF-8 -> QString ya convertido
+    std::string tmp_;                      // cadenas con escapes
+
+    // Tamaños del tick anterior: reserva de una vez en el siguiente
+    qsizetype lastLeaks_ = 0;
+    qsizetype lastFiles_ = 0;
+
+    static constexpr qsizetype kMaxInterned = 1 << 16;   // tope de la tabla
+};
@@ -33,6 +33,8 @@ GeneralTab::GeneralTab(QWidget* parent) : QWidget(parent) {
   activeAllocs_ = new QLabel("Activas: 0");
   leakMb_       = new QLabel("Leaks: 0 MB");
   totalAllocs_  = new QLabel("Total allocs: 0");
+  dropped_      = new QLabel();
+  dropped_->setVisible(false);
 
   auto* topRow = new QHBoxLayout;
   topRow->addWidget(heapCur_);
@@ -40,6 +42,7 @@ GeneralTab::GeneralTab(QWidget* parent) : QWidget(parent) {
   topRow->addWidget(activeAllocs_);
   topRow->addWidget(leakMb_);
   topRow->addWidget(totalAllocs_);
+  topRow->addWidget(dropped_);
   topRow->addStretch(1);
   root->addLayout(topRow);
 
@@ -81,8 +84,10 @@ GeneralTab::GeneralTab(QWidget* parent) : QWidget(parent) {
 
 void GeneralTab::updateSnapshot(const MetricsSnapshot& s) {
   // ----- Etiquetas principales -----
-  heapCur_->setText(QString("Heap actual: %1").arg(bytesToHuman(s.heapCurrent)));
-  heapPeak_->setText(QString("Pico: %1").arg(bytesToHuman(s.heapPeak)));
+  // Con muestreo el runtime envía estimaciones (escaladas por el peso de cada muestra)
+  const QString est = s.sampleInterval > 0 ? QStringLiteral(" (est.)") : QString();
+  heapCur_->setText(QString("Heap actual: %1%2").arg(bytesToHuman(s.heapCurrent), est));
+  heapPeak_->setText(QString("Pico: %1%2").arg(bytesToHuman(s.heapPeak), est));
 
   // Calcular métricas si no vinieran en el snapshot
   qint64 leakBytes = s.leakBytes;
@@ -102,9 +107,12 @@ void GeneralTab::updateSnapshot(const MetricsSnapshot& s) {
     if (activeAllocs <= 0) activeAllocs = act;
   }
 
-  activeAllocs_->setText(QString("Activas: %1").arg(activeAllocs));
-  leakMb_->setText(QString("Leaks: %1 MB").arg(leakBytes / (1024.0 * 1024.0), 0, 'f', 2));
-  totalAllocs_->setText(QString("Total allocs: %1").arg(totalAllocs));
+  activeAllocs_->setText(QString("Activas: %1%2").arg(activeAllocs).arg(est));
+  leakMb_->setText(QString("Leaks: %1 MB%2").arg(leakBytes / (1024.0 * 1024.0), 0, 'f', 2).arg(est));
+  totalAllocs_->setText(QString("Total allocs: %1%2").arg(totalAllocs).arg(est));
+  // La GUI no leía a tiempo y el runtime tiró tramas (las gráficas tienen huecos)
+  dropped_->setVisible(s.droppedFrames > 0);
+  if (s.droppedFrames > 0) dropped_->setText(QString("Tramas descartadas: %1").arg(s.droppedFrames));
 
   // ----- Serie Memoria vs tiempo (MB) -----
   double nextX = (s.uptimeMs > 0) ? (s.uptimeMs / 1000.0) : (t_ + 0.25);
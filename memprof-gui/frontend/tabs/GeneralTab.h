@@ -28,6 +28,7 @@ private:
     QLabel*       activeAllocs_ = nullptr;
     QLabel*       leakMb_       = nullptr;
     QLabel*       totalAllocs_  = nullptr;
+    QLabel*       dropped_      = nullptr;   // solo visible si el runtime descartó tramas
 
     // Chart (MB vs tiempo)
     QChartView*   memChartView_ = nullptr;
@@ -21,7 +21,7 @@
 #include <QHash>
 #include <QPair>
 
-#include "frontend/model/TableModels.h"
+#include "frontend/model/LeakPageModel.h"
 #include "memprof/proto/MetricsSnapshot.h"
 
 // =============================================
@@ -100,21 +100,22 @@ LeaksTab::LeaksTab(QWidget* parent): QWidget(parent) {
     row->addWidget(filterEdit_); row->addWidget(copyBtn_);
 
     // --- Tabla ---
-    model_ = new LeaksModel(this);
-    proxy_ = new QSortFilterProxyModel(this);
-    proxy_->setSourceModel(model_);
-    proxy_->setFilterCaseSensitivity(Qt::CaseInsensitive);
-    proxy_->setFilterKeyColumn(-1);
+    // Sin proxy: el modelo entrega, según se desplaza la vista, páginas de
+    // la permutación que filtra y ordena el worker (viewChanged pide otra).
+    // Filas de alto fijo: la cabecera vertical no mide nada al crecer.
+    model_ = new LeakPageModel(LeakPageModel::Kind::Leaks, this);
     table_ = new QTableView(this);
-    table_->setModel(proxy_);
+    table_->setModel(model_);
     table_->setSortingEnabled(true);
     table_->horizontalHeader()->setStretchLastSection(true);
     table_->verticalHeader()->setVisible(false);
+    table_->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
     table_->setSelectionBehavior(QAbstractItemView::SelectRows);
     table_->setSelectionMode(QAbstractItemView::SingleSelection);
     root->addWidget(table_);
 
-    connect(filterEdit_, &QLineEdit::textChanged, proxy_, &QSortFilterProxyModel::setFilterFixedString);
+    connect(filterEdit_, &QLineEdit::textChanged, model_, &LeakPageModel::setFilter);
+    connect(model_, &LeakPageModel::viewChanged, this, &LeaksTab::viewChanged);
     connect(copyBtn_, &QPushButton::clicked, this, &LeaksTab::onCopySelected);
 
     // --- Charts ---
@@ -132,8 +133,10 @@ LeaksTab::LeaksTab(QWidget* parent): QWidget(parent) {
     root->addLayout(chartsRow);
 }
 
-void LeaksTab::updateSnapshot(const MetricsSnapshot& s) {
-    model_->setDataSet(s.leaks);
+void LeaksTab::updateTables(const QSharedPointer<const LeakTables>& t) {
+    if (!t || !t->snapshot) return;
+    const MetricsSnapshot& s = *t->snapshot;
+    model_->setTables(t);
 
     // KPIs de la cabecera (valores vienen del runtime)
     leakTotalLbl_->setText(QString("Total fugado: %1 MB").arg(formatMB(s.leakBytes)));
@@ -154,14 +157,15 @@ void LeaksTab::updateSnapshot(const MetricsSnapshot& s) {
 
     leakRateLbl_->setText(QString("Tasa de leaks: %1%").arg(s.leakRate * 100.0, 0, 'f', 2));
 
-    rebuildCharts(s);
+    rebuildCharts(t->charts);
 }
 
-void LeaksTab::rebuildCharts(const MetricsSnapshot& s) {
+void LeaksTab::rebuildCharts(const LeakCharts& c) {
     // ======= 1) Barras (MB por archivo) =======
+    // Llegan sumados por archivo (uno por archivo distinto, no por fuga)
     QHash<QString, double> mbByFile;
-    for (const auto& L : s.leaks)
-        if (L.isLeak) mbByFile[niceBaseName(L.file)] += bytesToMB(L.size);
+    for (const auto& f : c.mbByFile)
+        mbByFile[niceBaseName(f.first)] += f.second;
 
     QList<QPair<QString,double>> items;
     items.reserve(mbByFile.size());
@@ -206,19 +210,11 @@ void LeaksTab::rebuildCharts(const MetricsSnapshot& s) {
     pieView_->setChart(pieChart);
 
     // ======= 3) Temporal (curva MB vs tiempo con zoom) =======
-    QVector<QPointF> pts;
-    qulonglong tmin = std::numeric_limits<qulonglong>::max(), tmax = 0;
-    for (const auto& L : s.leaks)
-        if (L.isLeak) { tmin = qMin(tmin,L.ts_ns); tmax = qMax(tmax,L.ts_ns); }
-    if (tmin==std::numeric_limits<qulonglong>::max()) tmin=tmax=0;
-
-    for (const auto& L : s.leaks)
-        if (L.isLeak)
-            pts.append(QPointF(double(L.ts_ns - tmin)/1e9, bytesToMB(L.size)));
-    std::sort(pts.begin(), pts.end(), [](auto&a,auto&b){return a.x()<b.x();});
+    // Ya reducida a la fuga mayor por cubeta y en orden de tiempo
+    const QVector<QPointF>& pts = c.timeline;
 
     auto* line = new QLineSeries();
-    for (auto& p: pts) line->append(p);
+    line->replace(pts);
     line->setName("Fugas detectadas (MB)");
     line->setPointsVisible(false);
 
@@ -228,7 +224,7 @@ void LeaksTab::rebuildCharts(const MetricsSnapshot& s) {
 
     auto* axX = new QValueAxis();
     axX->setTitleText("Tiempo (s)");
-    axX->setRange(0.0, std::max(1.0, double(tmax - tmin)/1e9));
+    axX->setRange(0.0, std::max(1.0, c.spanSec));
 
     auto* axY = new QValueAxis();
     axY->setTitleText("Tamaño de fuga (MB)");
@@ -246,10 +242,10 @@ void LeaksTab::rebuildCharts(const MetricsSnapshot& s) {
 
 void LeaksTab::onCopySelected() {
     auto idx = table_->currentIndex(); if (!idx.isValid()) return;
-    int row = proxy_->mapToSource(idx).row();
-    LeakItem item = model_->itemAt(row);
+    LeakItem item = model_->itemAt(idx.row());
     QString text = QString("ptr=0x%1 size=%2 file=%3 line=%4 type=%5 ts_ns=%6")
         .arg(QString::number(item.ptr,16)).arg(item.size)
         .arg(item.file).arg(item.line).arg(item.type).arg(item.ts_ns);
+    if (!item.function.isEmpty()) text += QString(" function=%1").arg(item.function);
     QApplication::clipboard()->setText(text);
 }
@@ -1,6 +1,6 @@
 #pragma once
 #include <QWidget>
-#include <QSortFilterProxyModel>
+#include <QSharedPointer>
 
 #include <QtCharts/QChartView>
 #include <QtCharts/QPieSeries>
@@ -14,7 +14,8 @@
   QT_CHARTS_USE_NAMESPACE
 #endif
 
-#include "frontend/model/TableModels.h"
+#include "frontend/model/LeakOrder.h"
+#include "frontend/model/LeakPageModel.h"
 #include "memprof/proto/MetricsSnapshot.h"
 
 class QTableView;
@@ -26,14 +27,17 @@ class LeaksTab : public QWidget {
     Q_OBJECT
 public:
     explicit LeaksTab(QWidget* parent=nullptr);
-    void updateSnapshot(const MetricsSnapshot& s);
+    // Snapshot + permutación y gráficas ya preparadas por el worker
+    void updateTables(const QSharedPointer<const LeakTables>& t);
+
+signals:
+    void viewChanged(const LeakView& view);   // orden/filtro de la tabla
 
 private slots:
     void onCopySelected();
 
 private:
-    LeaksModel*            model_ = nullptr;
-    QSortFilterProxyModel* proxy_ = nullptr;
+    LeakPageModel*         model_ = nullptr;   // paginado; orden y filtro los hace el worker
     QTableView*            table_ = nullptr;
     QLineEdit*             filterEdit_ = nullptr;
     QPushButton*           copyBtn_ = nullptr;
@@ -47,5 +51,5 @@ private:
     QChartView* pieView_  = nullptr;
     QChartView* timeView_ = nullptr;
 
-    void rebuildCharts(const MetricsSnapshot& s);
+    void rebuildCharts(const LeakCharts& c);
 };
@@ -0,0 +1,84 @@
+#include "LifetimesTab.h"
+
+#include <QVBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QLineEdit>
+#include <QTableView>
+
+namespace {
+static inline QString siteKey(const SiteLifetime& l) {
+    return l.file + QChar(0x1F) + QString::number(l.line) + QChar(0x1F) + l.type + QChar(0x1F) +
+           QString::number(l.pc, 16);
+}
+} // namespace
+
+LifetimesTab::LifetimesTab(QWidget* parent) : QWidget(parent) {
+    auto* root = new QVBoxLayout(this);
+
+    summary_ = new QLabel("Sin frees todavía", this);
+    root->addWidget(summary_);
+
+    filterEdit_ = new QLineEdit(this);
+    filterEdit_->setPlaceholderText("Filtrar por archivo/tipo…");
+    root->addWidget(filterEdit_);
+
+    // --- Tabla ---
+    model_ = new LifetimeModel(this);
+    proxy_ = new QSortFilterProxyModel(this);
+    proxy_->setSourceModel(model_);
+    proxy_->setSortRole(Qt::UserRole);
+    proxy_->setFilterRole(Qt::DisplayRole);
+    proxy_->setFilterCaseSensitivity(Qt::CaseInsensitive);
+    proxy_->setFilterKeyColumn(-1);
+
+    table_ = new QTableView(this);
+    table_->setModel(proxy_);
+    table_->setSortingEnabled(true);
+    table_->setAlternatingRowColors(true);
+    table_->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    table_->setSelectionBehavior(QAbstractItemView::SelectRows);
+    table_->setSelectionMode(QAbstractItemView::SingleSelection);
+    auto* hh = table_->horizontalHeader();
+    hh->setSectionResizeMode(0, QHeaderView::Stretch);
+    for (int c = 1; c < 9; ++c) hh->setSectionResizeMode(c, QHeaderView::ResizeToContents);
+    table_->verticalHeader()->setVisible(false);
+    table_->sortByColumn(4, Qt::DescendingOrder);
+    root->addWidget(table_);
+
+    connect(filterEdit_, &QLineEdit::textChanged, proxy_, &QSortFilterProxyModel::setFilterFixedString);
+}
+
+void LifetimesTab::updateSnapshot(const MetricsSnapshot& s) {
+    // Tasa = Δfrees / Δuptime; sin snapshot anterior (o tras reiniciar) es 0
+    const bool   haveDt = prevUptimeMs_ && s.uptimeMs > prevUptimeMs_;
+    const double dtS    = haveDt ? double(s.uptimeMs - prevUptimeMs_) / 1000.0 : 0.0;
+
+    QVector<LifetimeRow> rows;
+    rows.reserve(s.lifetimes.size());
+    QHash<QString, qulonglong> frees;
+    frees.reserve(s.lifetimes.size());
+    qulonglong total = 0, shortLived = 0;
+    for (const SiteLifetime& l : s.lifetimes) {
+        LifetimeRow r;
+        r.s = l;
+        const QString key = siteKey(l);
+        if (haveDt) {
+            const qulonglong before = prevFrees_.value(key, 0);
+            r.freesPerSec = l.frees > before ? double(l.frees - before) / dtS : 0.0;
+        }
+        frees.insert(key, l.frees);
+        total      += l.frees;
+        shortLived += l.shortLived;
+        rows.push_back(r);
+    }
+    prevFrees_.swap(frees);
+    prevUptimeMs_ = s.uptimeMs;
+
+    model_->setDataSet(rows, s.shortLivedNs);
+    summary_->setText(rows.isEmpty() ? QString("Sin frees todavía")
+                      : QString("%1 frees en %2 sitios, %3 % de vida corta")
+                            .arg(total)
+                            .arg(rows.size())
+                            .arg(total ? 100.0 * double(shortLived) / double(total) : 0.0, 0, 'f', 1));
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <QWidget>
+#include <QHash>
+#include <QSortFilterProxyModel>
+#include "frontend/model/TableModels.h"
+#include "memprof/proto/MetricsSnapshot.h"
+
+class QLabel;
+class QLineEdit;
+class QTableView;
+
+// Vida de los bloques por sitio: los que liberan millones de temporales
+// diminutos por segundo son candidatos a arena o buffer en pila.
+class LifetimesTab : public QWidget {
+    Q_OBJECT
+public:
+    explicit LifetimesTab(QWidget* parent=nullptr);
+    void updateSnapshot(const MetricsSnapshot& s);
+
+private:
+    LifetimeModel*         model_ = nullptr;
+    QSortFilterProxyModel* proxy_ = nullptr;
+    QTableView*            table_ = nullptr;
+    QLineEdit*             filterEdit_ = nullptr;
+    QLabel*                summary_ = nullptr;
+
+    // Frees por sitio en el snapshot anterior, para la tasa
+    QHash<QString, qulonglong> prevFrees_;
+    qulonglong                 prevUptimeMs_ = 0;
+};
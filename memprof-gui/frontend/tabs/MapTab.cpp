@@ -1,6 +1,9 @@
 // src/tabs/MapTab.cpp
 #include "MapTab.h"
 #include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QComboBox>
+#include <QLabel>
 #include <QPainter>
 #include <QToolTip>
 #include <QMouseEvent>
@@ -8,84 +11,9 @@
 #include <QHeaderView>
 #include <QStyledItemDelegate>
 #include <QDateTime>
-#include <QSortFilterProxyModel>
 #include <algorithm>
 
-// ---- Modelo interno para bloques (Ptr, Size, File, Line, Type, Estado) ----
-#include <QAbstractTableModel>
-
-class BlocksModel : public QAbstractTableModel {
-    Q_OBJECT
-public:
-    explicit BlocksModel(QObject* p=nullptr) : QAbstractTableModel(p) {}
-
-    void setDataSet(const QVector<LeakItem>& v) {
-        beginResetModel();
-        rows_ = v;
-        endResetModel();
-    }
-
-    int rowCount(const QModelIndex& parent = QModelIndex()) const override {
-        return parent.isValid()? 0 : rows_.size();
-    }
-
-    int columnCount(const QModelIndex& parent = {}) const override {
-        Q_UNUSED(parent);
-        return 6; // Ptr, Size, File, Line, Type, Estado
-    }
-
-    QVariant headerData(int s, Qt::Orientation o, int role) const override {
-        if (role != Qt::DisplayRole) return {};
-        if (o == Qt::Horizontal) {
-            switch (s) {
-                case 0: return "Ptr";
-                case 1: return "Size (B)";
-                case 2: return "File";
-                case 3: return "Line";
-                case 4: return "Type";
-                case 5: return "Estado";
-            }
-        }
-        return {};
-    }
-
-    QVariant data(const QModelIndex& i, int role) const override {
-        if (!i.isValid() || i.row() >= rows_.size()) return {};
-        const auto& L = rows_[i.row()];
-        const bool isLeak = L.isLeak; // ← directo del runtime
-
-        // Valor crudo para ordenar correctamente por puntero (numérico)
-        if (role == Qt::UserRole && i.column() == 0) {
-            return static_cast<qulonglong>(L.ptr);
-        }
-
-        if (role == Qt::TextAlignmentRole) {
-            // Alinea numéricos a la derecha para lectura
-            if (i.column() == 1 || i.column() == 3) {
-                return static_cast<int>(Qt::AlignRight | Qt::AlignVCenter);
-            }
-        }
-
-        if (role == Qt::ForegroundRole) {
-            return isLeak ? QColor(200,40,40) : QColor(40,140,60);
-        }
-
-        if (role == Qt::DisplayRole) {
-            switch (i.column()) {
-                case 0: return QString("0x%1").arg(QString::number(static_cast<qulonglong>(L.ptr), 16));
-                case 1: return L.size;
-                case 2: return L.file;
-                case 3: return L.line;
-                case 4: return L.type;               // p.ej., "global_new"
-                case 5: return isLeak ? "LEAK" : "Activo";
-            }
-        }
-        return {};
-    }
-
-private:
-    QVector<LeakItem> rows_;
-};
+#include "frontend/model/LeakPageModel.h"
 
 class MapBinsCanvas : public QWidget {
     Q_OBJECT
@@ -93,7 +21,7 @@ public:
     explicit MapBinsCanvas(QWidget* p=nullptr) : QWidget(p) {
         setMouseTracking(true);
     }
-    void setBins(const QVector<BinRange>& v) { bins_ = v; update(); }
+    void setBins(const QVector<BinRange>& v, bool cumulative) { bins_ = v; cumulative_ = cumulative; update(); }
 
 protected:
     void paintEvent(QPaintEvent*) override {
@@ -105,7 +33,7 @@ protected:
         QRect area(L, T, width()-L-R, height()-T-B);
         p.drawRect(area);
 
-        qint64 maxBytes = 0; for (const auto& b : bins_) maxBytes = std::max(maxBytes, b.bytes);
+        qint64 maxBytes = 0; for (const auto& b : bins_) maxBytes = std::max(maxBytes, barBytes(b));
         if (maxBytes==0) maxBytes = 1;
 
         const int n = bins_.size();
@@ -113,14 +41,14 @@ protected:
 
         for (int i=0;i<n;++i) {
             const auto& b = bins_[i];
-            double h = static_cast<double>(b.bytes) / static_cast<double>(maxBytes) * area.height();
+            double h = static_cast<double>(barBytes(b)) / static_cast<double>(maxBytes) * area.height();
             QRectF bar(area.left()+i*w+1, area.bottom()-h, w-2, h);
             p.fillRect(bar, QColor(80,140,220));
         }
 
         // ejes simples
-        p.drawText(5, T-4, "bytes");
-        p.drawText(area.right()-40, area.bottom()+20, "addr →");
+        p.drawText(5, T-4, cumulative_ ? "bytes asignados" : "bytes vivos");
+        p.drawText(area.right()-50, area.bottom()+20, "tamaño →");
     }
 
     void mouseMoveEvent(QMouseEvent* e) override {
@@ -131,11 +59,13 @@ protected:
         double w = static_cast<double>(area.width())/n;
         int idx = std::clamp(static_cast<int>((e->pos().x()-area.left())/w), 0, n-1);
         const auto& b = bins_[idx];
-        QString txt = QString("[%1 - %2)\nbytes=%3\nallocs=%4")
-        .arg(QString("0x%1").arg(QString::number(b.lo,16)))
-        .arg(QString("0x%1").arg(QString::number(b.hi,16)))
+        QString txt = QString("[%1 B, %2 B)\nvivos: %3 B en %4 bloques\nacumulado: %5 B en %6 allocs")
+        .arg(b.lo)
+        .arg(b.hi)
         .arg(static_cast<qlonglong>(b.bytes))
-        .arg(b.allocations);
+        .arg(b.allocations)
+        .arg(b.allocBytes)
+        .arg(b.allocCount);
 #if QT_VERSION >= QT_VERSION_CHECK(6,0,0)
         QToolTip::showText(e->globalPosition().toPoint(), txt, this);
 #else
@@ -144,12 +74,26 @@ protected:
     }
 
 private:
+    qint64 barBytes(const BinRange& b) const { return cumulative_ ? qint64(b.allocBytes) : b.bytes; }
+
     QVector<BinRange> bins_;
+    bool              cumulative_ = false;
 };
 
 MapTab::MapTab(QWidget* parent): QWidget(parent) {
     auto* root = new QVBoxLayout(this);
 
+    // Clases de tamaño: vivos o acumulado
+    auto* top = new QHBoxLayout();
+    top->addWidget(new QLabel("Clases de tamaño:", this));
+    binsMode_ = new QComboBox(this);
+    binsMode_->addItem("Vivos");
+    binsMode_->addItem("Acumulado (todas las allocs)");
+    top->addWidget(binsMode_);
+    top->addStretch(1);
+    root->addLayout(top);
+    connect(binsMode_, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [this] { repaintCanvas(); });
+
     // Canvas superior de bins
     binsCanvas_ = new MapBinsCanvas(this);
     binsCanvas_->setMinimumHeight(180);
@@ -158,38 +102,29 @@ MapTab::MapTab(QWidget* parent): QWidget(parent) {
     // Tabla de bloques individuales
     table_ = new QTableView(this);
 
-    // Modelo crudo + proxy para ordenar por puntero numérico (UserRole)
-    auto* rawModel = new BlocksModel(this);
+    // Todos los bloques vivos, paginados (ver LeakPageModel): el worker
+    // ordena por el valor numérico de cada columna, sin proxy
+    blocks_ = new LeakPageModel(LeakPageModel::Kind::Blocks, this);
+    connect(blocks_, &LeakPageModel::viewChanged, this, &MapTab::viewChanged);
 
-    auto* proxy = new QSortFilterProxyModel(this);
-    proxy->setSourceModel(rawModel);
-    proxy->setSortRole(Qt::UserRole);
-
-    table_->setModel(proxy);
+    table_->setModel(blocks_);
     table_->setSortingEnabled(true);
     table_->horizontalHeader()->setStretchLastSection(true);
     table_->verticalHeader()->setVisible(false);
+    table_->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
     root->addWidget(table_);
 }
 
-void MapTab::updateSnapshot(const MetricsSnapshot& s) {
-    bins_ = s.bins;
-    blocks_ = s.leaks; // bloques vivos
+void MapTab::updateTables(const QSharedPointer<const LeakTables>& t) {
+    if (!t || !t->snapshot) return;
+    bins_ = t->snapshot->bins;
     repaintCanvas();
-
-    // Soportar tanto modelo crudo como proxy (por si cambia en el futuro)
-    BlocksModel* m = nullptr;
-    if (auto* proxy = qobject_cast<QSortFilterProxyModel*>(table_->model())) {
-        m = qobject_cast<BlocksModel*>(proxy->sourceModel());
-    } else {
-        m = qobject_cast<BlocksModel*>(table_->model());
-    }
-    if (m) m->setDataSet(blocks_);
+    blocks_->setTables(t); // bloques vivos (comparte el snapshot, no copia)
 }
 
 void MapTab::repaintCanvas() {
     if (auto* c = qobject_cast<MapBinsCanvas*>(binsCanvas_)) {
-        c->setBins(bins_);
+        c->setBins(bins_, binsMode_->currentIndex() == 1);
     }
 }
 
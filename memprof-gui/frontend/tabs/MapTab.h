@@ -1,26 +1,34 @@
 #pragma once
 #include <QWidget>
 #include <QVector>
+#include <QSharedPointer>
+#include "frontend/model/LeakOrder.h"
 #include "memprof/proto/MetricsSnapshot.h"
 
 class QTableView;
+class QComboBox;
+class LeakPageModel;
 
 class MapTab : public QWidget {
     Q_OBJECT
 public:
     explicit MapTab(QWidget* parent=nullptr);
-    void updateSnapshot(const MetricsSnapshot& s);
+    // Snapshot + permutación de la tabla ya preparada por el worker
+    void updateTables(const QSharedPointer<const LeakTables>& t);
     void setLeakThresholdMs(qulonglong ms) { leakThresholdMs_ = ms; } // nuevo
+signals:
+    void viewChanged(const LeakView& view);   // orden de la tabla de bloques
 private:
     // Canvas de bins (widget hijo que pinta)
     QWidget* binsCanvas_ = nullptr;
+    QComboBox* binsMode_ = nullptr;   // 0 = vivos, 1 = acumulado
 
     // Datos
     QVector<BinRange> bins_;
-    QVector<LeakItem> blocks_; // bloques vivos
 
     // Tabla de bloques
     QTableView* table_ = nullptr;
+    LeakPageModel* blocks_ = nullptr;   // paginado; el orden lo hace el worker
 
     // Re-render del canvas
     void repaintCanvas();
@@ -0,0 +1,75 @@
+#include "PeakTab.h"
+
+#include <QVBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QLineEdit>
+#include <QTableView>
+
+namespace {
+static inline QString bytesToHuman(qulonglong b) {
+    const double a = double(b);
+    if (a < 1024) return QString::number(b) + " B";
+    if (a < 1024.0 * 1024) return QString::number(a / 1024.0, 'f', 1) + " KB";
+    if (a < 1024.0 * 1024 * 1024) return QString::number(a / (1024.0 * 1024), 'f', 1) + " MB";
+    return QString::number(a / (1024.0 * 1024 * 1024), 'f', 2) + " GB";
+}
+} // namespace
+
+PeakTab::PeakTab(QWidget* parent) : QWidget(parent) {
+    auto* root = new QVBoxLayout(this);
+
+    summary_ = new QLabel("Sin captura de pico todavía", this);
+    root->addWidget(summary_);
+
+    filterEdit_ = new QLineEdit(this);
+    filterEdit_->setPlaceholderText("Filtrar por archivo/tipo…");
+    root->addWidget(filterEdit_);
+
+    // --- Tabla ---
+    model_ = new PeakSitesModel(this);
+    proxy_ = new QSortFilterProxyModel(this);
+    proxy_->setSourceModel(model_);
+    proxy_->setSortRole(Qt::UserRole);
+    proxy_->setFilterRole(Qt::DisplayRole);
+    proxy_->setFilterCaseSensitivity(Qt::CaseInsensitive);
+    proxy_->setFilterKeyColumn(-1);
+
+    table_ = new QTableView(this);
+    table_->setModel(proxy_);
+    table_->setSortingEnabled(true);
+    table_->setAlternatingRowColors(true);
+    table_->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    table_->setSelectionBehavior(QAbstractItemView::SelectRows);
+    table_->setSelectionMode(QAbstractItemView::SingleSelection);
+    auto* hh = table_->horizontalHeader();
+    hh->setSectionResizeMode(0, QHeaderView::Stretch);
+    for (int c = 1; c < 6; ++c) hh->setSectionResizeMode(c, QHeaderView::ResizeToContents);
+    table_->verticalHeader()->setVisible(false);
+    table_->sortByColumn(3, Qt::DescendingOrder);
+    root->addWidget(table_);
+
+    connect(filterEdit_, &QLineEdit::textChanged, proxy_, &QSortFilterProxyModel::setFilterFixedString);
+}
+
+void PeakTab::updateSnapshot(const MetricsSnapshot& s) {
+    const HeapSnapshotItem& ps = s.peakSnapshot;
+    // La tabla solo cambia con una captura nueva o al resolverse más sitios
+    if (ps.id != shownId_ || s.symbols.size() != shownSymbols_) {
+        shownId_      = ps.id;
+        shownSymbols_ = s.symbols.size();
+        model_->setDataSet(ps);
+    }
+    if (!ps.id) {
+        summary_->setText("Sin captura de pico todavía");
+        return;
+    }
+    // El pico real puede quedar por encima de la captura: solo se captura al
+    // superar la anterior en un margen y con frecuencia limitada
+    summary_->setText(QString("Captura #%1: %2 en %3 bloques, %4 sitios · pico registrado %5")
+                      .arg(ps.id)
+                      .arg(bytesToHuman(ps.bytes))
+                      .arg(ps.count)
+                      .arg(ps.sites.size())
+                      .arg(bytesToHuman(s.heapPeak)));
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <QWidget>
+#include <QSortFilterProxyModel>
+#include "frontend/model/TableModels.h"
+#include "memprof/proto/MetricsSnapshot.h"
+
+class QLabel;
+class QLineEdit;
+class QTableView;
+
+// Qué estaba vivo en el pico: el desglose por sitio que el runtime captura
+// cada vez que el heap supera en un margen la captura anterior.
+class PeakTab : public QWidget {
+    Q_OBJECT
+public:
+    explicit PeakTab(QWidget* parent=nullptr);
+    void updateSnapshot(const MetricsSnapshot& s);
+
+private:
+    PeakSitesModel*        model_ = nullptr;
+    QSortFilterProxyModel* proxy_ = nullptr;
+    QTableView*            table_ = nullptr;
+    QLineEdit*             filterEdit_ = nullptr;
+    QLabel*                summary_ = nullptr;
+
+    unsigned               shownId_ = 0;       // captura mostrada (0 = ninguna)
+    qsizetype              shownSymbols_ = 0;  // símbolos resueltos al mostrarla
+};
@@ -42,13 +42,14 @@ PerFileTab::PerFileTab(QWidget* parent) : QWidget(parent) {
     hh->setSectionResizeMode(2, QHeaderView::ResizeToContents); // Allocs
     table_->verticalHeader()->setVisible(false);
 
+    // Orden inicial: por uso total (columna 1). Después lo mantiene el proxy
+    // (las filas se actualizan en sitio) y manda el que elija el usuario.
+    table_->sortByColumn(1, Qt::DescendingOrder);
+
     root->addWidget(table_);
 }
 
 void PerFileTab::updateSnapshot(const MetricsSnapshot& s) {
     model_->setDataSet(s.perFile);
     totalRows_->setText(QString("%1 archivos").arg(s.perFile.size()));
-
-    // Orden inicial: por uso total (columna 1)
-    table_->sortByColumn(1, Qt::DescendingOrder);
 }
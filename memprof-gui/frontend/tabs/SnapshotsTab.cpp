@@ -0,0 +1,203 @@
+#include "SnapshotsTab.h"
+
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QComboBox>
+#include <QHeaderView>
+#include <QLabel>
+#include <QLineEdit>
+#include <QPushButton>
+#include <QTableView>
+#include <QHash>
+
+namespace {
+static inline QString bytesToHuman(qint64 b) {
+    const QString sign = b < 0 ? "-" : "";
+    const double a = double(b < 0 ? -b : b);
+    if (a < 1024) return sign + QString::number(qint64(a)) + " B";
+    if (a < 1024.0 * 1024) return sign + QString::number(a / 1024.0, 'f', 1) + " KB";
+    if (a < 1024.0 * 1024 * 1024) return sign + QString::number(a / (1024.0 * 1024), 'f', 1) + " MB";
+    return sign + QString::number(a / (1024.0 * 1024 * 1024), 'f', 2) + " GB";
+}
+
+static inline QString siteKey(const SiteUsageItem& u) {
+    return u.file + QChar(0x1F) + QString::number(u.line) + QChar(0x1F) + u.type + QChar(0x1F) +
+           QString::number(u.pc, 16);
+}
+
+// Une los sitios de a y b por (file, line, type, pc); solo los que cambian
+static QVector<SiteDiffRow> diffSnapshots(const HeapSnapshotItem& a, const HeapSnapshotItem& b) {
+    QVector<SiteDiffRow> rows;
+    QHash<QString, int> index;
+    index.reserve(a.sites.size() + b.sites.size());
+    auto row = [&](const SiteUsageItem& u) -> SiteDiffRow& {
+        auto it = index.constFind(siteKey(u));
+        if (it != index.constEnd()) return rows[*it];
+        index.insert(siteKey(u), rows.size());
+        SiteDiffRow r;
+        r.file = u.file;
+        r.line = u.line;
+        r.type = u.type;
+        rows.push_back(r);
+        return rows.back();
+    };
+    for (const auto& u : a.sites) { auto& r = row(u); r.bytesA += u.bytes; r.countA += u.count; }
+    for (const auto& u : b.sites) { auto& r = row(u); r.bytesB += u.bytes; r.countB += u.count; }
+
+    QVector<SiteDiffRow> out;
+    out.reserve(rows.size());
+    for (const auto& r : rows)
+        if (r.bytesA != r.bytesB || r.countA != r.countB) out.push_back(r);
+    return out;
+}
+
+static QString itemText(const HeapSnapshotItem& hs) {
+    const QString who = hs.id ? QString("#%1").arg(hs.id) : QString("GUI");
+    return QString("%1 %2 (%3)").arg(who, hs.label, bytesToHuman(qint64(hs.bytes)));
+}
+} // namespace
+
+SnapshotsTab::SnapshotsTab(QWidget* parent) : QWidget(parent) {
+    auto* root = new QVBoxLayout(this);
+
+    // --- Selección A/B + captura ---
+    auto* top = new QHBoxLayout();
+    boxA_ = new QComboBox(this);
+    boxB_ = new QComboBox(this);
+    boxA_->setSizeAdjustPolicy(QComboBox::AdjustToContents);
+    boxB_->setSizeAdjustPolicy(QComboBox::AdjustToContents);
+    captureBtn_ = new QPushButton("Capturar ahora", this);
+    top->addWidget(new QLabel("A:", this));
+    top->addWidget(boxA_);
+    top->addWidget(new QLabel("B:", this));
+    top->addWidget(boxB_);
+    top->addWidget(captureBtn_);
+    top->addStretch(1);
+    summary_ = new QLabel("Sin snapshots", this);
+    top->addWidget(summary_);
+    root->addLayout(top);
+
+    filterEdit_ = new QLineEdit(this);
+    filterEdit_->setPlaceholderText("Filtrar por archivo/tipo…");
+    root->addWidget(filterEdit_);
+
+    // --- Tabla ---
+    model_ = new SnapshotDiffModel(this);
+    proxy_ = new QSortFilterProxyModel(this);
+    proxy_->setSourceModel(model_);
+    proxy_->setSortRole(Qt::UserRole);
+    proxy_->setFilterRole(Qt::DisplayRole);
+    proxy_->setFilterCaseSensitivity(Qt::CaseInsensitive);
+    proxy_->setFilterKeyColumn(-1);
+
+    table_ = new QTableView(this);
+    table_->setModel(proxy_);
+    table_->setSortingEnabled(true);
+    table_->setAlternatingRowColors(true);
+    table_->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    table_->setSelectionBehavior(QAbstractItemView::SelectRows);
+    table_->setSelectionMode(QAbstractItemView::SingleSelection);
+    auto* hh = table_->horizontalHeader();
+    hh->setSectionResizeMode(0, QHeaderView::Stretch);
+    for (int c = 1; c < 7; ++c) hh->setSectionResizeMode(c, QHeaderView::ResizeToContents);
+    table_->verticalHeader()->setVisible(false);
+    table_->sortByColumn(3, Qt::DescendingOrder);
+    root->addWidget(table_);
+
+    connect(filterEdit_, &QLineEdit::textChanged, proxy_, &QSortFilterProxyModel::setFilterFixedString);
+    connect(captureBtn_, &QPushButton::clicked, this, &SnapshotsTab::onCapture);
+    connect(boxA_, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &SnapshotsTab::recompute);
+    connect(boxB_, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &SnapshotsTab::recompute);
+}
+
+void SnapshotsTab::updateSnapshot(const MetricsSnapshot& s) {
+    lastLeaks_    = s.leaks;   // compartido implícitamente
+    lastUptimeMs_ = s.uptimeMs;
+
+    // La lista del runtime solo crece (o se vacía al reconectar)
+    const bool same = s.heapSnapshots.size() == runtime_.size() &&
+                      (runtime_.isEmpty() || s.heapSnapshots.back().id == runtime_.back().id);
+    if (same) return;
+    runtime_ = s.heapSnapshots;
+    rebuildCombos();
+}
+
+void SnapshotsTab::onCapture() {
+    // Agrupa los bloques vivos del último estado por sitio
+    HeapSnapshotItem hs;
+    hs.label = QString("captura %1 (t=%2 s)").arg(local_.size() + 1).arg(double(lastUptimeMs_) / 1000.0, 0, 'f', 1);
+    QHash<QString, int> index;
+    for (const LeakItem& li : lastLeaks_) {
+        SiteUsageItem key;
+        key.file = li.file;
+        key.line = li.line;
+        key.type = li.type;
+        key.pc   = li.pc;
+        const QString k = siteKey(key);
+        auto it = index.constFind(k);
+        if (it == index.constEnd()) {
+            it = index.insert(k, hs.sites.size());
+            hs.sites.push_back(key);
+        }
+        SiteUsageItem& u = hs.sites[*it];
+        u.bytes += qulonglong(li.size);
+        u.count += 1;
+        hs.bytes += qulonglong(li.size);
+        hs.count += 1;
+    }
+    local_.push_back(std::move(hs));
+    rebuildCombos();
+    boxB_->setCurrentIndex(boxB_->count() - 1);
+}
+
+void SnapshotsTab::rebuildCombos() {
+    const QVariant keepA = boxA_->currentData();
+    const QVariant keepB = boxB_->currentData();
+    const QSignalBlocker blockA(boxA_);
+    const QSignalBlocker blockB(boxB_);
+    boxA_->clear();
+    boxB_->clear();
+    // Clave: id del runtime (> 0) o -(índice local + 1)
+    for (const auto& hs : runtime_) {
+        boxA_->addItem(itemText(hs), int(hs.id));
+        boxB_->addItem(itemText(hs), int(hs.id));
+    }
+    for (int i = 0; i < local_.size(); ++i) {
+        boxA_->addItem(itemText(local_[i]), -(i + 1));
+        boxB_->addItem(itemText(local_[i]), -(i + 1));
+    }
+    const int n = boxA_->count();
+    const int a = keepA.isValid() ? boxA_->findData(keepA) : -1;
+    const int b = keepB.isValid() ? boxB_->findData(keepB) : -1;
+    boxA_->setCurrentIndex(a >= 0 ? a : 0);
+    boxB_->setCurrentIndex(b >= 0 ? b : n - 1);
+    recompute();
+}
+
+const HeapSnapshotItem* SnapshotsTab::selected(const QComboBox* box) const {
+    const QVariant v = box->currentData();
+    if (!v.isValid()) return nullptr;
+    const int key = v.toInt();
+    if (key < 0) return -key - 1 < local_.size() ? &local_[-key - 1] : nullptr;
+    for (const auto& hs : runtime_)
+        if (int(hs.id) == key) return &hs;
+    return nullptr;
+}
+
+void SnapshotsTab::recompute() {
+    const HeapSnapshotItem* a = selected(boxA_);
+    const HeapSnapshotItem* b = selected(boxB_);
+    if (!a || !b) {
+        model_->setDataSet({});
+        summary_->setText(boxA_->count() ? "Elige A y B" : "Sin snapshots");
+        return;
+    }
+    const QVector<SiteDiffRow> rows = diffSnapshots(*a, *b);
+    model_->setDataSet(rows);
+    const qlonglong dBytes = qlonglong(b->bytes) - qlonglong(a->bytes);
+    const qlonglong dCount = qlonglong(b->count) - qlonglong(a->count);
+    summary_->setText(QString("Δ %1%2, %3%4 bloques, %5 sitios")
+                      .arg(QString(dBytes > 0 ? "+" : ""), bytesToHuman(dBytes))
+                      .arg(QString(dCount > 0 ? "+" : "")).arg(dCount)
+                      .arg(rows.size()));
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <QWidget>
+#include <QSortFilterProxyModel>
+#include "frontend/model/TableModels.h"
+#include "memprof/proto/MetricsSnapshot.h"
+
+class QComboBox;
+class QLabel;
+class QLineEdit;
+class QPushButton;
+class QTableView;
+
+// Diff de snapshots de heap: los que toma el programa (memprof_take_snapshot)
+// y los capturados aquí sobre el último estado recibido. Muestra qué sitios
+// crecieron entre A y B.
+class SnapshotsTab : public QWidget {
+    Q_OBJECT
+public:
+    explicit SnapshotsTab(QWidget* parent=nullptr);
+    void updateSnapshot(const MetricsSnapshot& s);
+
+private slots:
+    void onCapture();
+    void recompute();
+
+private:
+    void rebuildCombos();
+    const HeapSnapshotItem* selected(const QComboBox* box) const;
+
+    SnapshotDiffModel*     model_ = nullptr;
+    QSortFilterProxyModel* proxy_ = nullptr;
+    QTableView*            table_ = nullptr;
+    QComboBox*             boxA_ = nullptr;
+    QComboBox*             boxB_ = nullptr;
+    QPushButton*           captureBtn_ = nullptr;
+    QLineEdit*             filterEdit_ = nullptr;
+    QLabel*                summary_ = nullptr;
+
+    QVector<HeapSnapshotItem> runtime_;   // del runtime, por id creciente
+    QVector<HeapSnapshotItem> local_;     // capturados en la GUI
+    QVector<LeakItem>         lastLeaks_; // bloques vivos del último snapshot (compartido, sin copia)
+    qulonglong                lastUptimeMs_ = 0;
+};
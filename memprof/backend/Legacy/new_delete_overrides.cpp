@@ -56,7 +56,8 @@ void* operator new(std::size_t n) {
   void* p = std::malloc(n);
   if (!p) throw std::bad_alloc();
 
-  memprof::register_alloc(p, n, /*file*/nullptr, /*line*/0, /*type*/nullptr, /*is_array*/false);
+  memprof::register_alloc(p, n, /*file*/nullptr, /*line*/0, /*type*/nullptr, /*is_array*/false,
+                          __builtin_return_address(0));
   return p;
 }
 
@@ -93,7 +94,8 @@ void* operator new[](std::size_t n) {
   void* p = std::malloc(n);
   if (!p) throw std::bad_alloc();
 
-  memprof::register_alloc(p, n, /*file*/nullptr, /*line*/0, /*type*/nullptr, /*is_array*/true);
+  memprof::register_alloc(p, n, /*file*/nullptr, /*line*/0, /*type*/nullptr, /*is_array*/true,
+                          __builtin_return_address(0));
   return p;
 }
 
@@ -130,7 +132,8 @@ void* operator new(std::size_t n, std::align_val_t al) {
   void* p = mp_aligned_alloc(n, alignment);
   if (!p) throw std::bad_alloc();
 
-  memprof::register_alloc(p, n, /*file*/nullptr, /*line*/0, /*type*/nullptr, /*is_array*/false);
+  memprof::register_alloc(p, n, /*file*/nullptr, /*line*/0, /*type*/nullptr, /*is_array*/false,
+                          __builtin_return_address(0));
   return p;
 }
 
@@ -171,7 +174,8 @@ void* operator new[](std::size_t n, std::align_val_t al) {
   void* p = mp_aligned_alloc(n, alignment);
   if (!p) throw std::bad_alloc();
 
-  memprof::register_alloc(p, n, /*file*/nullptr, /*line*/0, /*type*/nullptr, /*is_array*/true);
+  memprof::register_alloc(p, n, /*file*/nullptr, /*line*/0, /*type*/nullptr, /*is_array*/true,
+                          __builtin_return_address(0));
   return p;
 }
 
@@ -1,45 +1,134 @@
 #include "registry.hpp"
 #include "memprof.hpp"
+#include "memprof/core/EventPipeline.h"
 
 #include <atomic>
-#include <mutex>
-#include <unordered_map>
 #include <chrono>
-#include <thread>
+#include <mutex>
 #include <cstdio>
+#include <cstdlib>
 
 namespace {
 
-using clock_t = std::chrono::steady_clock;
+// ---------------------------------------------------------------------------
+// Tabla de vivos: direccionamiento abierto (sondeo lineal, borrado por
+// desplazamiento hacia atrás, sin tombstones).
+//
+// Los hooks solo publican en la tubería; la tabla la escribe únicamente
+// apply_batch, que la tubería ya serializa (un consumidor a la vez). Por eso
+// no hay shards ni locks por entrada: el mutex solo protege los lotes frente
+// a los lectores que recorren la tabla (dump), y los contadores son atómicos
+// para leerse desde cualquier hilo. La memoria se pide con malloc/calloc
+// directamente para no reentrar en los overrides de operator new.
+// ---------------------------------------------------------------------------
+constexpr std::size_t kInitialSlots = 4096;             // potencia de 2
 
-inline std::uint64_t now_ns() noexcept {
-    return std::chrono::duration_cast<std::chrono::nanoseconds>(
-        clock_t::now().time_since_epoch()).count();
+inline std::size_t mix_ptr(const void* p) noexcept {
+    // fmix64 (murmur3): los punteros de malloc comparten bits bajos y altos
+    auto k = static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(p));
+    k ^= k >> 33; k *= 0xff51afd7ed558ccdULL;
+    k ^= k >> 33; k *= 0xc4ceb9fe1a85ec53ULL;
+    k ^= k >> 33;
+    return static_cast<std::size_t>(k);
 }
 
-inline std::uint64_t thread_id_u64() noexcept {
-    auto id = std::this_thread::get_id();
-    // hash estable suficiente para métricas
-    return std::hash<std::thread::id>{}(id);
+struct Slot {
+    void*               key{nullptr};   // nullptr = libre
+    memprof::AllocInfo  info{};
+};
+
+struct Table {
+    Slot*        slots{nullptr};
+    std::size_t  mask{0};        // capacidad - 1
+    std::size_t  used{0};
+
+    bool grow() noexcept {
+        const std::size_t cap = slots ? (mask + 1) * 2 : kInitialSlots;
+        auto* fresh = static_cast<Slot*>(std::calloc(cap, sizeof(Slot)));
+        if (!fresh) return false;
+        const std::size_t nmask = cap - 1;
+        if (slots) {
+            for (std::size_t i = 0; i <= mask; ++i) {
+                if (!slots[i].key) continue;
+                std::size_t j = mix_ptr(slots[i].key) & nmask;
+                while (fresh[j].key) j = (j + 1) & nmask;
+                fresh[j] = slots[i];
+            }
+            std::free(slots);
+        }
+        slots = fresh;
+        mask  = nmask;
+        return true;
+    }
+
+    // Devuelve false si no hay memoria para crecer (la alloc queda sin registrar)
+    bool insert(void* p, const memprof::AllocInfo& ai, std::size_t& replaced) noexcept {
+        replaced = 0;
+        if (!slots || (used + 1) * 4 > (mask + 1) * 3) {   // factor de carga 0.75
+            if (!grow()) return false;
+        }
+        std::size_t i = mix_ptr(p) & mask;
+        while (slots[i].key && slots[i].key != p) i = (i + 1) & mask;
+        if (slots[i].key == p) {
+            // La dirección se reutilizó sin free visto: sustituimos
+            replaced = slots[i].info.size;
+        } else {
+            slots[i].key = p;
+            ++used;
+        }
+        slots[i].info = ai;
+        return true;
+    }
+
+    // 'max_ts': un free anterior a la alloc registrada pertenece a una vida
+    // previa de la dirección y no la borra.
+    bool erase(void* p, memprof::AllocInfo& out, std::uint64_t max_ts = UINT64_MAX) noexcept {
+        if (!slots) return false;
+        std::size_t i = mix_ptr(p) & mask;
+        while (slots[i].key != p) {
+            if (!slots[i].key) return false;
+            i = (i + 1) & mask;
+        }
+        if (slots[i].info.timestamp_ns > max_ts) return false;
+        out = slots[i].info;
+
+        // Borrado por desplazamiento hacia atrás: mantiene las cadenas de sondeo
+        std::size_t hole = i;
+        std::size_t j    = i;
+        for (;;) {
+            j = (j + 1) & mask;
+            if (!slots[j].key) break;
+            const std::size_t home = mix_ptr(slots[j].key) & mask;
+            // ¿'home' está cíclicamente en (hole, j]? entonces no se puede mover
+            const bool stays = (hole <= j) ? (hole < home && home <= j)
+                                           : (hole < home || home <= j);
+            if (stays) continue;
+            slots[hole] = slots[j];
+            hole = j;
+        }
+        slots[hole].key = nullptr;
+        --used;
+        return true;
+    }
+};
+
+// Suma de un solo escritor (el hilo que drena): load+store, sin RMW
+inline void bump(std::atomic<std::uint64_t>& c, std::int64_t d) noexcept {
+    c.store(c.load(std::memory_order_relaxed) + static_cast<std::uint64_t>(d),
+            std::memory_order_relaxed);
 }
 
 struct State {
-    std::unordered_map<void*, memprof::AllocInfo> live;
-    std::mutex mtx;
+    std::mutex    mtx;           // lotes de apply_batch frente a lectores (dump)
+    Table         table;
+    std::uint64_t idgen{0};
 
     std::atomic<std::uint64_t> bytes_current{0};
-    std::atomic<std::uint64_t> bytes_peak{0};
+    std::atomic<std::uint64_t> bytes_peak{0};      // exacto: mismo escritor que bytes_current
     std::atomic<std::uint64_t> allocs_total{0};
     std::atomic<std::uint64_t> allocs_active{0};
-    std::atomic<std::uint64_t> idgen{1};
 
     memprof::Sink sink{nullptr};
-
-    void update_peak(std::uint64_t cur) {
-        auto old = bytes_peak.load(std::memory_order_relaxed);
-        while (cur > old &&
-               !bytes_peak.compare_exchange_weak(old, cur, std::memory_order_relaxed)) { /* spin */ }
-    }
 };
 
 State& S() {
@@ -47,45 +136,38 @@ State& S() {
     return s;
 }
 
-} // anon
+void record_alloc(void* p, std::size_t size, const char* file, int line, const char* type,
+                  bool is_array, std::uint64_t tns, std::uint64_t tid, std::uint32_t stack) noexcept
+{
+    using memprof::AllocInfo;
+    using memprof::Event;
+    using memprof::EventKind;
+    auto& st = S();
 
-namespace memprof {
+    AllocInfo ai;
+    ai.size        = size;
+    ai.file        = file;
+    ai.line        = line;
+    ai.type        = type;
+    ai.timestamp_ns= tns;
+    ai.is_array    = is_array;
+    ai.thread_id   = tid;
+    ai.stack_id    = stack;
 
-void set_sink(Sink s) noexcept {
-    S().sink = s;
-}
+    ai.id = ++st.idgen;
+    std::size_t replaced = 0;
+    if (!st.table.insert(p, ai, replaced)) return;
 
-void register_alloc(void* p,
-                    std::size_t size,
-                    const char* file,
-                    int line,
-                    const char* type,
-                    bool is_array) noexcept
-{
-    if (!p) return;
-    auto& st = S();
-    const auto tns = now_ns();
-    const auto tid = thread_id_u64();
-    const auto id  = st.idgen.fetch_add(1, std::memory_order_relaxed);
-
-    {
-        std::lock_guard<std::mutex> lk(st.mtx);
-        AllocInfo ai;
-        ai.size        = size;
-        ai.file        = file;
-        ai.line        = line;
-        ai.type        = type;
-        ai.timestamp_ns= tns;
-        ai.id          = id;
-        ai.is_array    = is_array;
-        ai.thread_id   = tid;
-        st.live[p] = ai;
+    if (replaced) {
+        bump(st.bytes_current, -static_cast<std::int64_t>(replaced));
+        bump(st.allocs_active, -1);
     }
-
-    const auto cur = st.bytes_current.fetch_add(size, std::memory_order_relaxed) + size;
-    st.update_peak(cur);
-    st.allocs_total.fetch_add(1, std::memory_order_relaxed);
-    st.allocs_active.fetch_add(1, std::memory_order_relaxed);
+    bump(st.bytes_current, static_cast<std::int64_t>(size));
+    bump(st.allocs_total, 1);
+    bump(st.allocs_active, 1);
+    const auto cur = st.bytes_current.load(std::memory_order_relaxed);
+    if (cur > st.bytes_peak.load(std::memory_order_relaxed))
+        st.bytes_peak.store(cur, std::memory_order_relaxed);
 
     if (st.sink) {
         Event ev{ EventKind::Alloc, p, size, type, file, line, tns, is_array, tid };
@@ -93,65 +175,124 @@ void register_alloc(void* p,
     }
 }
 
-void register_free(void* p) noexcept {
-    if (!p) return;
+void record_free(void* p, std::uint64_t tns, std::uint64_t tid) noexcept {
+    using memprof::AllocInfo;
+    using memprof::Event;
+    using memprof::EventKind;
     auto& st = S();
 
-    std::size_t freed = 0;
-    const char* file = nullptr;
-    int line = 0;
-    const char* type = nullptr;
-    bool is_array = false;
-    std::uint64_t tns = now_ns();
-    std::uint64_t tid = thread_id_u64();
-
-    {
-        std::lock_guard<std::mutex> lk(st.mtx);
-        auto it = st.live.find(p);
-        if (it != st.live.end()) {
-            freed    = it->second.size;
-            file     = it->second.file;
-            line     = it->second.line;
-            type     = it->second.type;
-            is_array = it->second.is_array;
-            st.live.erase(it);
-        }
-    }
+    AllocInfo ai;
+    const bool found = st.table.erase(p, ai, tns);
 
-    if (freed) {
-        st.bytes_current.fetch_sub(freed, std::memory_order_relaxed);
-        st.allocs_active.fetch_sub(1, std::memory_order_relaxed);
+    if (found) {
+        bump(st.bytes_current, -static_cast<std::int64_t>(ai.size));
+        bump(st.allocs_active, -1);
     }
 
     if (st.sink) {
-        Event ev{ EventKind::Free, p, freed, type, file, line, tns, is_array, tid };
+        Event ev{ EventKind::Free, p, found ? ai.size : 0, ai.type, ai.file, ai.line,
+                  tns, ai.is_array, tid };
         st.sink(ev);
     }
 }
 
+// Los hooks publican en la tubería; este consumidor aplica los lotes (ya
+// ordenados por ts) a la tabla desde el hilo que drena.
+void apply_batch(const EventRecord* ev, std::size_t n, void*) {
+    std::lock_guard<std::mutex> lk(S().mtx);
+    for (std::size_t i = 0; i < n; ++i) {
+        const EventRecord& e = ev[i];
+        void* p = reinterpret_cast<void*>(e.ptr);
+        if (e.kind == EventRecord::Alloc)
+            record_alloc(p, static_cast<std::size_t>(e.size), e.file, e.line, e.type,
+                         e.is_array != 0, e.ts_ns, e.thread, e.stack);
+        else
+            record_free(p, e.ts_ns, e.thread);
+    }
+}
+
+EventPipeline& pipeline() noexcept {
+    static EventPipeline& p = [] () -> EventPipeline& {
+        EventPipeline& ep = EventPipeline::instance();
+        ep.addConsumer(&apply_batch, nullptr);
+        return ep;
+    }();
+    return p;
+}
+
+// Las consultas ven todo lo publicado hasta ahora
+inline void sync_pending() noexcept { pipeline().drain(true); }
+
+} // anon
+
+namespace memprof {
+
+void set_sink(Sink s) noexcept {
+    S().sink = s;
+}
+
+void register_alloc(void* p,
+                    std::size_t size,
+                    const char* file,
+                    int line,
+                    const char* type,
+                    bool is_array,
+                    const void* caller) noexcept
+{
+    if (!p) return;
+    pipeline().pushAlloc(p, size, file, line, type, is_array, caller);
+}
+
+void register_free(void* p) noexcept {
+    if (!p) return;
+    pipeline().pushFree(p);
+}
+
 // Métricas
-std::uint64_t current_bytes() noexcept { return S().bytes_current.load(std::memory_order_relaxed); }
-std::uint64_t peak_bytes()    noexcept { return S().bytes_peak.load(std::memory_order_relaxed); }
-std::uint64_t total_allocs()  noexcept { return S().allocs_total.load(std::memory_order_relaxed); }
-std::uint64_t active_allocs() noexcept { return S().allocs_active.load(std::memory_order_relaxed); }
+std::uint64_t current_bytes() noexcept {
+    sync_pending();
+    return S().bytes_current.load(std::memory_order_relaxed);
+}
+std::uint64_t peak_bytes() noexcept {
+    sync_pending();
+    return S().bytes_peak.load(std::memory_order_relaxed);
+}
+std::uint64_t total_allocs() noexcept {
+    sync_pending();
+    return S().allocs_total.load(std::memory_order_relaxed);
+}
+std::uint64_t active_allocs() noexcept {
+    sync_pending();
+    return S().allocs_active.load(std::memory_order_relaxed);
+}
 
 // Dump de fugas
 void dump_leaks_to_stdout() noexcept {
+    sync_pending();
     auto& st = S();
-    std::lock_guard<std::mutex> lk(st.mtx);
-    if (st.live.empty()) {
+    const auto n = active_allocs();
+    if (n == 0) {
         std::printf("[memprof] No leaks.\n");
         return;
     }
-    std::printf("[memprof] Leaks (%zu):\n", st.live.size());
-    for (const auto& [ptr, ai] : st.live) {
-        std::printf("  ptr=%p size=%zu file=%s line=%d type=%s ts=%llu %s\n",
-            ptr, ai.size,
+    std::printf("[memprof] Leaks (%llu):\n", (unsigned long long)n);
+    // printf puede pedir memoria: sin suprimir, un anillo lleno drenaría
+    // desde aquí y apply_batch esperaría por el mutex que ya tenemos
+    EventPipeline::ScopedSuppress quiet;
+    std::lock_guard<std::mutex> lk(st.mtx);
+    const Table& t = st.table;
+    for (std::size_t i = 0; t.slots && i <= t.mask; ++i) {
+        const Slot& s = t.slots[i];
+        if (!s.key) continue;
+        const auto& ai = s.info;
+        std::printf("  ptr=%p size=%zu file=%s line=%d type=%s ts=%llu %s stack=%u\n",
+            s.key, ai.size,
             ai.file ? ai.file : "(?)",
             ai.line,
             ai.type ? ai.type : "(?)",
             (unsigned long long)ai.timestamp_ns,
-            ai.is_array ? "[array]" : "[scalar]"
+            ai.is_array ? "[array]" : "[scalar]",
+            (unsigned)ai.stack_id
         );
     }
 }
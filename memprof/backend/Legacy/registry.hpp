@@ -13,6 +13,7 @@ namespace memprof {
         std::uint64_t id{0};
         bool         is_array{false};
         std::uint64_t thread_id{0};
+        std::uint32_t stack_id{0};     // id en StackTable (0 = sin pila capturada)
     };
 
     void register_alloc(void* p,
@@ -20,7 +21,8 @@ namespace memprof {
                         const char* file,
                         int line,
                         const char* type,
-                        bool is_array) noexcept;
+                        bool is_array,
+                        const void* caller = nullptr) noexcept;   // dirección de retorno del operador
 
     void register_free(void* p) noexcept;
 
@@ -0,0 +1,497 @@
+// Ingesta de logs de eventos JSON en MetricsAggregator: processEvent (una
+// línea) e ingestEvents (un buffer entero, en paralelo).
+//
+// Formato de cada línea:
+//   {"kind":"ALLOC","ptr":"0x..","size":N,"ts_ns":N,"file":"..","line":N,"type":"..","is_array":b}
+//   {"kind":"FREE","ptr":"0x..","size":N[,"ts_ns":N]}
+//
+// ingestEvents trabaja en tres fases:
+//   1. Parseo: el buffer se corta en trozos por líneas y cada hilo los
+//      recorre de una pasada (las búsquedas de '\n' y '"' van por memchr, que
+//      en glibc está vectorizado). Los sitios se internan en una tabla local
+//      por hilo y cada evento va al cubo de su shard (hash del puntero).
+//   2. Shards: cada shard reproduce en orden sus eventos sobre un mapa de vivos
+//      propio. Salen los bloques que siguen vivos, los contadores de las allocs
+//      que ya murieron y la serie de efectos sobre los bytes vivos.
+//   3. Fusión (un solo lock): las series de efectos se mezclan por posición en
+//      el log para reconstruir la timeline y el pico; los frees de bloques que
+//      el agregador ya tenía vivos se aplican ahí, y los vivos de cada shard se
+//      insertan en orden.
+#include "memprof/core/MetricsAggregator.h"
+#include "memprof/core/EventPipeline.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <deque>
+#include <queue>
+#include <thread>
+
+namespace {
+
+struct Locked {
+    EventPipeline::ScopedSuppress quiet;
+    std::lock_guard<std::mutex>   lk;
+    explicit Locked(std::mutex& m) : lk(m) {}
+};
+
+// ---------------------------------------------------------------------------
+// Parseo de una línea en una sola pasada
+// ---------------------------------------------------------------------------
+struct RawEvent {
+    enum Kind : uint8_t { None = 0, Alloc = 1, Free = 2 };
+    uint8_t          kind = None;
+    bool             is_array = false;
+    bool             has_ts = false;
+    uintptr_t        ptr = 0;
+    uint64_t         size = 0;
+    uint64_t         ts = 0;
+    int              line = 0;
+    std::string_view file, type;
+};
+
+class LineScanner {
+public:
+    // 'esc_*' guardan file/type si traen escapes (las vistas apuntan ahí)
+    bool parse(const char* p, const char* end, RawEvent& ev) {
+        p_ = p; end_ = end;
+        ev = RawEvent{};
+        if (!eat('{')) return false;
+        if (eat('}')) return false;
+        do {
+            std::string_view key;
+            if (!str(key, key_tmp_) || !eat(':')) return false;
+            if (!value(key, ev)) return false;
+        } while (eat(','));
+        return ev.kind != RawEvent::None && ev.ptr != 0;
+    }
+
+private:
+    void ws() { while (p_ < end_ && (*p_ == ' ' || *p_ == '\t' || *p_ == '\r')) ++p_; }
+    bool eat(char c) {
+        ws();
+        if (p_ < end_ && *p_ == c) { ++p_; return true; }
+        return false;
+    }
+
+    bool str(std::string_view& out, std::string& tmp) {
+        ws();
+        if (p_ >= end_ || *p_ != '"') return false;
+        const char* s = ++p_;
+        const auto* q = static_cast<const char*>(std::memchr(s, '"', static_cast<size_t>(end_ - s)));
+        if (!q) return false;
+        const auto* bs = static_cast<const char*>(std::memchr(s, '\\', static_cast<size_t>(q - s)));
+        if (!bs) { out = std::string_view(s, static_cast<size_t>(q - s)); p_ = q + 1; return true; }
+
+        // Con escapes: se decodifica (\uXXXX solo en el rango ASCII/BMP básico)
+        tmp.assign(s, static_cast<size_t>(bs - s));
+        p_ = bs;
+        while (p_ < end_ && *p_ != '"') {
+            if (*p_ != '\\') { tmp.push_back(*p_++); continue; }
+            if (++p_ >= end_) return false;
+            switch (const char c = *p_++) {
+                case 'b': tmp.push_back('\b'); break;
+                case 'f': tmp.push_back('\f'); break;
+                case 'n': tmp.push_back('\n'); break;
+                case 'r': tmp.push_back('\r'); break;
+                case 't': tmp.push_back('\t'); break;
+                case 'u': {
+                    unsigned cp = 0;
+                    if (end_ - p_ < 4 || std::from_chars(p_, p_ + 4, cp, 16).ptr != p_ + 4) return false;
+                    p_ += 4;
+                    if (cp < 0x80) tmp.push_back(static_cast<char>(cp));
+                    else if (cp < 0x800) {
+                        tmp.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+                        tmp.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+                    } else {
+                        tmp.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+                        tmp.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+                        tmp.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+                    }
+                    break;
+                }
+                default: tmp.push_back(c); break;
+            }
+        }
+        if (p_ >= end_) return false;
+        ++p_;
+        out = tmp;
+        return true;
+    }
+
+    // Entero: número o cadena "0x.."/decimal
+    bool u64(uint64_t& out) {
+        ws();
+        if (p_ < end_ && *p_ == '"') {
+            std::string_view s;
+            if (!str(s, num_tmp_)) return false;
+            int base = 10;
+            if (s.size() > 2 && s[0] == '0' && (s[1] == 'x' || s[1] == 'X')) { s.remove_prefix(2); base = 16; }
+            out = 0;
+            std::from_chars(s.data(), s.data() + s.size(), out, base);
+            return true;
+        }
+        if (p_ < end_ && *p_ == '-') {   // negativos (line): se truncan a 0 salvo vía i32
+            ++p_;
+            uint64_t v = 0;
+            const auto r = std::from_chars(p_, end_, v);
+            if (r.ec != std::errc()) return false;
+            p_ = r.ptr;
+            out = static_cast<uint64_t>(-static_cast<int64_t>(v));
+            return true;
+        }
+        const auto r = std::from_chars(p_, end_, out);
+        if (r.ec != std::errc()) return false;
+        p_ = r.ptr;
+        return true;
+    }
+
+    bool boolean(bool& out) {
+        ws();
+        if (end_ - p_ >= 4 && std::memcmp(p_, "true", 4) == 0)  { p_ += 4; out = true;  return true; }
+        if (end_ - p_ >= 5 && std::memcmp(p_, "false", 5) == 0) { p_ += 5; out = false; return true; }
+        return false;
+    }
+
+    // Valor desconocido: se salta hasta la siguiente ',' o '}' de este nivel
+    bool skip() {
+        ws();
+        if (p_ < end_ && *p_ == '"') { std::string_view s; return str(s, num_tmp_); }
+        int depth = 0;
+        while (p_ < end_) {
+            const char c = *p_;
+            if (c == '"') { std::string_view s; if (!str(s, num_tmp_)) return false; continue; }
+            if (depth == 0 && (c == ',' || c == '}')) return true;
+            if (c == '{' || c == '[') ++depth;
+            else if (c == '}' || c == ']') --depth;
+            ++p_;
+        }
+        return false;
+    }
+
+    bool value(std::string_view key, RawEvent& ev) {
+        uint64_t u = 0;
+        switch (key.size()) {
+            case 3:
+                if (key == "ptr") { if (!u64(u)) return false; ev.ptr = static_cast<uintptr_t>(u); return true; }
+                break;
+            case 4:
+                if (key == "kind") {
+                    std::string_view k;
+                    if (!str(k, num_tmp_)) return false;
+                    ev.kind = k == "ALLOC" ? RawEvent::Alloc : k == "FREE" ? RawEvent::Free : RawEvent::None;
+                    return true;
+                }
+                if (key == "size") { if (!u64(u)) return false; ev.size = u; return true; }
+                if (key == "file") return str(ev.file, file_tmp_);
+                if (key == "line") { if (!u64(u)) return false; ev.line = static_cast<int>(u); return true; }
+                if (key == "type") return str(ev.type, type_tmp_);
+                break;
+            case 5:
+                if (key == "ts_ns") { if (!u64(u)) return false; ev.ts = u; ev.has_ts = true; return true; }
+                break;
+            case 8:
+                if (key == "is_array") return boolean(ev.is_array);
+                break;
+            default:
+                break;
+        }
+        return skip();
+    }
+
+    const char* p_ = nullptr;
+    const char* end_ = nullptr;
+    std::string key_tmp_, num_tmp_, file_tmp_, type_tmp_;
+};
+
+// ---------------------------------------------------------------------------
+// Estructuras de la ingesta masiva
+// ---------------------------------------------------------------------------
+
+// Evento ya parseado, en el cubo de su shard. 'site' es local al hilo que lo
+// parseó hasta la fase 2.
+struct ShardEvent {
+    uint64_t  seq;        // posición en el log (orden total)
+    uint64_t  ts;         // UINT64_MAX en un free sin ts_ns
+    uintptr_t ptr;
+    uint64_t  size;
+    uint32_t  site;
+    uint8_t   kind;
+    bool      is_array;
+};
+
+// Tabla local de sitios de un hilo de parseo: (file, line, type) -> id local
+struct LocalSites {
+    struct Site { std::string_view file, type; int line; };
+    std::deque<std::string>                        owned;   // copias estables de file/type
+    std::unordered_map<std::string_view, uint32_t> strings;
+    std::unordered_map<uint64_t, uint32_t>         index;   // (file_id, type_id, line) empaquetados
+    std::vector<Site>                              sites;
+
+    uint32_t str(std::string_view s) {
+        auto it = strings.find(s);
+        if (it != strings.end()) return it->second;
+        owned.emplace_back(s);
+        const auto id = static_cast<uint32_t>(strings.size());
+        strings.emplace(owned.back(), id);
+        return id;
+    }
+    uint32_t site(std::string_view file, int line, std::string_view type) {
+        const uint64_t f = str(file);
+        const uint64_t t = str(type);
+        const uint64_t key = (f << 44) ^ (t << 24) ^ static_cast<uint32_t>(line);
+        auto it = index.find(key);
+        if (it != index.end()) {
+            const Site& s = sites[it->second];
+            // Colisión del empaquetado (más de 2^20 cadenas): se compara de verdad
+            if (s.line == line && strings.at(s.file) == f && strings.at(s.type) == t) return it->second;
+        }
+        const auto id = static_cast<uint32_t>(sites.size());
+        auto fi = strings.find(file);
+        auto ti = strings.find(type);
+        sites.push_back(Site{fi->first, ti->first, line});
+        index[key] = id;
+        return id;
+    }
+};
+
+// Resultado de un shard
+struct ShardOut {
+    struct Survivor { uint64_t seq; uintptr_t ptr; uint64_t size, ts; uint32_t site; bool is_array; };
+    // Efecto sobre los bytes vivos, en orden de log. external: free de un
+    // bloque que el shard no vio nacer (se resuelve contra el agregador)
+    struct Effect { uint64_t seq, ts; int64_t delta; uintptr_t ptr; bool external; };
+
+    std::vector<Survivor> live;
+    std::vector<Effect>   effects;
+    std::vector<std::pair<uint64_t, uint64_t>> dead_by_site;   // (allocs, bytes) ya liberados, por SiteId global
+    std::vector<std::pair<uint64_t, uint64_t>> dead_by_bin;    // ídem, por clase de tamaño
+    uint64_t              dead_allocs = 0;
+};
+
+inline size_t shardOf(uintptr_t ptr, size_t n) {
+    uint64_t h = static_cast<uint64_t>(ptr) * 0x9E3779B97F4A7C15ULL;
+    return static_cast<size_t>((h >> 32) % n);
+}
+
+} // anon
+
+// ============================ API ============================
+
+void MetricsAggregator::processEvent(const std::string& json) {
+    LineScanner sc;
+    RawEvent ev;
+    if (!sc.parse(json.data(), json.data() + json.size(), ev)) return;
+    Locked lk(mtx_);
+    if (ev.kind == RawEvent::Alloc) {
+        if (ev.size == 0) return;
+        onAlloc_locked(ev.ptr, ev.size, ev.ts, internSite_locked(ev.file, ev.line, ev.type), ev.is_array, now_ns());
+    } else {
+        onFree_locked(ev.ptr, now_ns(), ev.has_ts ? ev.ts : UINT64_MAX);
+    }
+}
+
+size_t MetricsAggregator::ingestEvents(std::string_view buf, unsigned threads) {
+    EventPipeline::ScopedSuppress quiet;
+    if (buf.empty()) return 0;
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    // Trozos de al menos 256 KB: por debajo no compensa lanzar hilos
+    const size_t max_parts = std::max<size_t>(1, buf.size() / (256 * 1024));
+    const size_t T = std::min<size_t>(threads, max_parts);
+    const size_t S = threads;
+
+    // Límites de trozo alineados a fin de línea
+    std::vector<size_t> cut(T + 1, buf.size());
+    cut[0] = 0;
+    for (size_t t = 1; t < T; ++t) {
+        size_t at = std::max(cut[t - 1], buf.size() * t / T);
+        const void* nl = at < buf.size() ? std::memchr(buf.data() + at, '\n', buf.size() - at) : nullptr;
+        cut[t] = nl ? static_cast<size_t>(static_cast<const char*>(nl) - buf.data()) + 1 : buf.size();
+    }
+
+    auto run = [](size_t n, auto&& fn) {
+        if (n == 1) { fn(size_t(0)); return; }
+        std::vector<std::thread> th;
+        th.reserve(n - 1);
+        for (size_t i = 1; i < n; ++i)
+            th.emplace_back([&fn, i] { EventPipeline::ScopedSuppress q; fn(i); });
+        fn(size_t(0));
+        for (auto& x : th) x.join();
+    };
+
+    // ---- fase 1: parseo y reparto ----
+    std::vector<LocalSites>                    local(T);
+    std::vector<std::vector<std::vector<ShardEvent>>> buckets(T, std::vector<std::vector<ShardEvent>>(S));
+    std::vector<size_t>                        parsed(T, 0);
+    run(T, [&](size_t t) {
+        LineScanner sc;
+        RawEvent    ev;
+        const char* p   = buf.data() + cut[t];
+        const char* end = buf.data() + cut[t + 1];
+        uint64_t    seq = uint64_t(t) << 40;   // orden total: trozo, luego línea
+        const size_t guess = static_cast<size_t>(end - p) / 96 / S + 16;
+        for (auto& b : buckets[t]) b.reserve(guess);
+        while (p < end) {
+            const auto* nl = static_cast<const char*>(std::memchr(p, '\n', static_cast<size_t>(end - p)));
+            const char* le = nl ? nl : end;
+            if (sc.parse(p, le, ev) && (ev.kind == RawEvent::Free || ev.size > 0)) {
+                ShardEvent se{seq++, ev.kind == RawEvent::Free && !ev.has_ts ? UINT64_MAX : ev.ts, ev.ptr, ev.size,
+                              ev.kind == RawEvent::Alloc ? local[t].site(ev.file, ev.line, ev.type) : 0,
+                              ev.kind, ev.is_array};
+                buckets[t][shardOf(ev.ptr, S)].push_back(se);
+                ++parsed[t];
+            }
+            p = le + 1;
+        }
+    });
+
+    // Sitios locales -> SiteId globales (pocos: un lock breve)
+    std::vector<std::vector<SiteId>> remap(T);
+    {
+        Locked lk(mtx_);
+        for (size_t t = 0; t < T; ++t) {
+            remap[t].reserve(local[t].sites.size());
+            for (const auto& s : local[t].sites) remap[t].push_back(internSite_locked(s.file, s.line, s.type));
+        }
+    }
+    size_t n_sites;
+    {
+        Locked lk(mtx_);
+        n_sites = sites_.size();
+    }
+    const uint64_t short_ns = short_lived_ns_.load(std::memory_order_relaxed);
+
+    // ---- fase 2: un shard por hilo ----
+    std::vector<ShardOut> out(S);
+    std::vector<std::vector<std::pair<SiteId, LifetimeHist>>> lives(S);   // vidas por sitio de cada shard
+    run(S, [&](size_t s) {
+        struct Block { uint64_t size, ts, seq; SiteId site; bool is_array; };
+        FlatPtrMap<Block> live;
+        ShardOut& o = out[s];
+        o.dead_by_site.assign(n_sites, {0, 0});
+        o.dead_by_bin.assign(kSizeBins, {0, 0});
+        std::vector<uint32_t> life_of(n_sites, 0);   // SiteId -> índice + 1 en lives[s]
+        size_t total = 0;
+        for (size_t t = 0; t < T; ++t) total += buckets[t][s].size();
+        live.reserve(total / 4 + 16);
+        o.effects.reserve(total);
+
+        auto die = [&](const Block& b) {
+            auto& d = o.dead_by_site[b.site];
+            ++d.first;
+            d.second += b.size;
+            auto& db = o.dead_by_bin[sizeBinIndex(b.size)];
+            ++db.first;
+            db.second += b.size;
+            ++o.dead_allocs;
+        };
+        for (size_t t = 0; t < T; ++t) {
+            for (const ShardEvent& e : buckets[t][s]) {
+                if (e.kind == RawEvent::Alloc) {
+                    bool inserted = false;
+                    Block& b = live.upsert(e.ptr, inserted);
+                    int64_t delta = static_cast<int64_t>(e.size);
+                    if (!inserted) { die(b); delta -= static_cast<int64_t>(b.size); }   // reutilizada sin free
+                    b = Block{e.size, e.ts, e.seq, remap[t][e.site], e.is_array};
+                    o.effects.push_back({e.seq, e.ts, delta, e.ptr, false});
+                } else {
+                    Block* b = live.find(e.ptr);
+                    if (b && b->ts > e.ts) continue;   // free de una vida anterior
+                    if (!b) { o.effects.push_back({e.seq, e.ts, 0, e.ptr, true}); continue; }
+                    Block dead{};
+                    live.erase(e.ptr, dead);
+                    die(dead);
+                    if (e.ts != UINT64_MAX) {
+                        uint32_t& li = life_of[dead.site];
+                        if (li == 0) { lives[s].emplace_back(dead.site, LifetimeHist{}); li = uint32_t(lives[s].size()); }
+                        lives[s][li - 1].second.add(e.ts - dead.ts, dead.size, 1, short_ns);
+                    }
+                    o.effects.push_back({e.seq, e.ts, -static_cast<int64_t>(dead.size), e.ptr, false});
+                }
+            }
+            std::vector<ShardEvent>().swap(buckets[t][s]);
+        }
+        o.live.reserve(live.size());
+        live.forEach([&](uintptr_t ptr, const Block& b) {
+            o.live.push_back({b.seq, ptr, b.size, b.ts, b.site, b.is_array});
+        });
+        std::sort(o.live.begin(), o.live.end(),
+                  [](const ShardOut::Survivor& a, const ShardOut::Survivor& b) { return a.seq < b.seq; });
+    });
+
+    // ---- fase 3: fusión ----
+    Locked lk(mtx_);
+    const uint64_t t_now = now_ns();
+
+    // Efectos en orden de log: timeline, pico y frees de bloques previos
+    using Head = std::pair<uint64_t, size_t>;   // (seq, shard)
+    std::priority_queue<Head, std::vector<Head>, std::greater<Head>> heap;
+    std::vector<size_t> pos(S, 0);
+    for (size_t s = 0; s < S; ++s)
+        if (!out[s].effects.empty()) heap.push({out[s].effects[0].seq, s});
+    int64_t  cur  = static_cast<int64_t>(current_bytes_.load(std::memory_order_relaxed));
+    int64_t  peak = cur;
+    uint64_t last_ts = 0;
+    while (!heap.empty()) {
+        const size_t s = heap.top().second;
+        heap.pop();
+        const ShardOut::Effect& e = out[s].effects[pos[s]];
+        if (e.external) {
+            const uint64_t freed = eraseLive_locked(e.ptr, e.ts);
+            if (freed != kNotLive) cur -= static_cast<int64_t>(freed);
+        } else {
+            cur += e.delta;
+        }
+        if (e.ts != UINT64_MAX) last_ts = e.ts;
+        peak = std::max(peak, cur);
+        pushTimelinePoint_locked(last_ts, cur > 0 ? static_cast<uint64_t>(cur) : 0, leak_bytes_);
+        if (++pos[s] < out[s].effects.size()) heap.push({out[s].effects[pos[s]].seq, s});
+    }
+
+    // Supervivientes en orden de log (el índice de antigüedad lo espera así)
+    for (size_t s = 0; s < S; ++s) pos[s] = 0;
+    for (size_t s = 0; s < S; ++s)
+        if (!out[s].live.empty()) heap.push({out[s].live[0].seq, s});
+    while (!heap.empty()) {
+        const size_t s = heap.top().second;
+        heap.pop();
+        const ShardOut::Survivor& b = out[s].live[pos[s]];
+        insertLive_locked(b.ptr, b.size, b.ts, b.site, b.is_array, 1.0f, 0);
+        if (++pos[s] < out[s].live.size()) heap.push({out[s].live[pos[s]].seq, s});
+    }
+
+    // Allocs que ya murieron dentro del log: solo cuentan en los acumulados
+    uint64_t dead = 0;
+    for (const ShardOut& o : out) {
+        dead += o.dead_allocs;
+        for (size_t site = 0; site < o.dead_by_site.size(); ++site) {
+            const auto& d = o.dead_by_site[site];
+            if (d.first == 0) continue;
+            fileRows_locked(SiteId(site), [&](FileStats& fs) {
+                fs.alloc_count += d.first;
+                fs.alloc_bytes += d.second;
+            });
+        }
+        for (size_t bi = 0; bi < kSizeBins; ++bi) {
+            bin_alloc_count_[bi] += o.dead_by_bin[bi].first;
+            bin_alloc_bytes_[bi] += o.dead_by_bin[bi].second;
+        }
+    }
+    total_allocs_.fetch_add(dead, std::memory_order_relaxed);
+    for (const auto& shard : lives)
+        for (const auto& [site, h] : shard) lifeHist_locked(site).merge(h);
+
+    uint64_t old_peak = peak_bytes_.load(std::memory_order_relaxed);
+    const uint64_t new_peak = peak > 0 ? static_cast<uint64_t>(peak) : 0;
+    while (new_peak > old_peak &&
+           !peak_bytes_.compare_exchange_weak(old_peak, new_peak, std::memory_order_relaxed)) {}
+    // Los picos intermedios del log no tienen desglose por sitio (los shards
+    // no lo llevan); solo se captura si el estado final cruza el umbral.
+    const uint64_t live_now = current_bytes_.load(std::memory_order_relaxed);
+    if (live_now >= peak_capture_at_) capturePeak_locked(live_now, t_now);
+    promoteLeaks_locked(t_now);
+
+    size_t n = 0;
+    for (size_t c : parsed) n += c;
+    return n;
+}
@@ -0,0 +1,301 @@
+#include "memprof/core/EventPipeline.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+namespace {
+
+inline uint64_t now_ns() noexcept {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+thread_local bool t_suppress = false;
+
+// Estado de muestreo por hilo: bytes que faltan para el siguiente punto y
+// generador xorshift64* (sembrado perezosamente con la dirección del TLS).
+thread_local int64_t  t_bytes_left = -1;   // < 0: sin sortear
+thread_local uint64_t t_rng = 0;
+
+inline uint64_t next_random() noexcept {
+    if (t_rng == 0) t_rng = (reinterpret_cast<uintptr_t>(&t_rng) ^ now_ns()) | 1;
+    t_rng ^= t_rng >> 12;
+    t_rng ^= t_rng << 25;
+    t_rng ^= t_rng >> 27;
+    return t_rng * 0x2545F4914F6CDD1DULL;
+}
+
+// Distancia exponencial de media 'mean' hasta el siguiente byte muestreado
+inline int64_t draw_interval(uint64_t mean) noexcept {
+    const double u = (double)((next_random() >> 11) + 1) * 0x1.0p-53;   // (0, 1]
+    const double d = -std::log(u) * (double)mean;
+    return d < 1.0 ? 1 : d > 9.0e18 ? INT64_MAX : (int64_t)d;
+}
+
+} // anon
+
+// Anillo SPSC de un hilo. tail lo escribe solo el productor, head solo el
+// consumidor de turno; cada índice en su propia línea de caché.
+struct EventPipeline::Ring {
+    alignas(64) std::atomic<size_t> tail{0};
+    std::atomic<uint32_t>           busy{0};      // hay un evento con ts tomado y sin publicar
+    std::atomic<uint64_t>           since{0};     // cota inferior del ts de lo que publique su dueño
+    alignas(64) std::atomic<size_t> head{0};
+    alignas(64) std::atomic<bool>   retired{false};  // el hilo dueño terminó
+    uint32_t    thread = 0;
+    Ring*       next = nullptr;
+    EventRecord rec[kRingCapacity];
+};
+
+namespace {
+
+// Al terminar el hilo, su anillo queda disponible para otro (tras vaciarse).
+// Lo que el hilo aún reserve/libere después (destructores TLS, libc) ya no
+// se registra: el anillo podría tener otro dueño.
+thread_local bool t_ring_dead = false;
+
+struct RingHolder {
+    EventPipeline::Ring* ring = nullptr;
+    ~RingHolder() {
+        t_ring_dead = true;
+        if (ring) ring->retired.store(true, std::memory_order_release);
+        ring = nullptr;
+    }
+};
+thread_local RingHolder t_ring;
+
+} // anon
+
+EventPipeline& EventPipeline::instance() {
+    // Sin operator new (podría reentrar en los hooks) y sin destructor: los
+    // hilos pueden seguir asignando memoria durante la salida del proceso.
+    static EventPipeline* p = [] {
+        void* mem = std::malloc(sizeof(EventPipeline));
+        auto* ep = ::new (mem) EventPipeline();
+        if (const char* rate = std::getenv("MEMPROF_SAMPLE_RATE"))
+            ep->setSampleInterval(std::strtoull(rate, nullptr, 10));
+        if (const char* depth = std::getenv("MEMPROF_STACK_DEPTH")) {
+            const char* mode = std::getenv("MEMPROF_STACK_MODE");
+            ep->setStackDepth(static_cast<unsigned>(std::strtoul(depth, nullptr, 10)),
+                              mode && std::strcmp(mode, "fp") == 0 ? StackTable::Mode::FramePointer
+                                                                   : StackTable::Mode::Unwind);
+        }
+        return ep;
+    }();
+    return *p;
+}
+
+EventPipeline::ScopedSuppress::ScopedSuppress() noexcept : prev(t_suppress) { t_suppress = true; }
+EventPipeline::ScopedSuppress::~ScopedSuppress() { t_suppress = prev; }
+
+bool EventPipeline::addConsumer(Consumer fn, void* ctx) {
+    std::lock_guard<std::mutex> lk(consumer_mtx_);
+    const size_t n = n_consumers_.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < n; ++i)
+        if (consumers_[i].fn == fn && consumers_[i].ctx == ctx) return true;
+    if (n >= kMaxConsumers) return false;
+    consumers_[n] = Slot{fn, ctx};
+    n_consumers_.store(n + 1, std::memory_order_release);
+    return true;
+}
+
+EventPipeline::Ring* EventPipeline::ringForThisThread() noexcept {
+    if (t_ring.ring) return t_ring.ring;
+    if (t_ring_dead) return nullptr;
+
+    // 1) Reutilizar el anillo vacío de un hilo que ya terminó
+    for (Ring* r = rings_.load(std::memory_order_acquire); r; r = r->next) {
+        bool expected = true;
+        if (r->retired.load(std::memory_order_acquire) &&
+            r->head.load(std::memory_order_acquire) == r->tail.load(std::memory_order_relaxed) &&
+            r->retired.compare_exchange_strong(expected, false, std::memory_order_acq_rel)) {
+            r->thread = next_thread_.fetch_add(1, std::memory_order_relaxed);
+            r->since.store(now_ns(), std::memory_order_relaxed);   // visible con busy (release)
+            t_ring.ring = r;
+            return r;
+        }
+    }
+
+    // 2) Uno nuevo (calloc: no pasa por los overrides de operator new)
+    void* mem = std::calloc(1, sizeof(Ring));
+    if (!mem) return nullptr;
+    Ring* r = ::new (mem) Ring();
+    r->thread = next_thread_.fetch_add(1, std::memory_order_relaxed);
+    r->since.store(now_ns(), std::memory_order_relaxed);
+    Ring* head = rings_.load(std::memory_order_relaxed);
+    do { r->next = head; }
+    while (!rings_.compare_exchange_weak(head, r, std::memory_order_release, std::memory_order_relaxed));
+    t_ring.ring = r;
+    return r;
+}
+
+bool EventPipeline::push(EventRecord& rec) noexcept {
+    Ring* r = ringForThisThread();
+    if (!r) return false;
+
+    // busy se publica antes de leer el reloj: si el consumidor lo ve a 0,
+    // el siguiente evento de este hilo tendrá ts posterior a su 'now'
+    r->busy.store(1, std::memory_order_seq_cst);
+    rec.ts_ns  = now_ns();
+    rec.thread = r->thread;
+
+    const size_t t = r->tail.load(std::memory_order_relaxed);
+    while (t - r->head.load(std::memory_order_acquire) >= kRingCapacity) {
+        // Lleno: drenamos nosotros si nadie lo está haciendo, si no cedemos
+        stalls_.fetch_add(1, std::memory_order_relaxed);
+        if (consumer_mtx_.try_lock()) {
+            drainLocked(false);   // vacía los anillos; lo reciente pasa a pending_
+            consumer_mtx_.unlock();
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    r->rec[t % kRingCapacity] = rec;
+    r->tail.store(t + 1, std::memory_order_release);
+    r->busy.store(0, std::memory_order_release);
+    return true;
+}
+
+void EventPipeline::setSampleInterval(uint64_t mean_bytes) noexcept {
+    sample_interval_.store(mean_bytes, std::memory_order_relaxed);
+}
+
+void EventPipeline::setStackDepth(unsigned depth, StackTable::Mode mode) noexcept {
+    if (depth > StackTable::kMaxDepth) depth = StackTable::kMaxDepth;
+    stack_mode_.store(mode, std::memory_order_relaxed);
+    stack_depth_.store(depth, std::memory_order_relaxed);
+}
+
+size_t EventPipeline::filterBit(uintptr_t ptr) noexcept {
+    const uint64_t h = (uint64_t)(ptr >> 4) * 0x9E3779B97F4A7C15ULL;
+    return (size_t)(h >> (64 - 22));
+}
+static_assert(EventPipeline::kSampleFilterBits == (size_t(1) << 22), "filterBit asume 2^22 bits");
+
+// Camino rápido: una resta por alloc no muestreada. Los puntos de Poisson que
+// caen dentro de una alloc cuentan como uno solo; por la falta de memoria de
+// la exponencial, el siguiente se sortea de nuevo desde el final del bloque.
+bool EventPipeline::sampleAlloc(uint64_t size, uint64_t interval, float& weight) noexcept {
+    if (t_bytes_left < 0) t_bytes_left = draw_interval(interval);
+    if ((uint64_t)t_bytes_left > size) {
+        t_bytes_left -= (int64_t)size;
+        return false;
+    }
+    t_bytes_left = draw_interval(interval);
+    const double p = -std::expm1(-(double)size / (double)interval);
+    weight = p > 0.0 ? (float)(1.0 / p) : 1.0f;
+    return true;
+}
+
+void EventPipeline::pushAlloc(void* ptr, uint64_t size, const char* file, int line,
+                              const char* type, bool is_array, const void* caller) noexcept {
+    if (!ptr || t_suppress) return;
+    float weight = 1.0f;
+    if (const uint64_t interval = sample_interval_.load(std::memory_order_relaxed)) {
+        if (!sampleAlloc(size, interval, weight)) return;
+        const size_t b = filterBit(reinterpret_cast<uintptr_t>(ptr));
+        sampled_bits_[b / 64].fetch_or(uint64_t(1) << (b % 64), std::memory_order_relaxed);
+    }
+    EventRecord e;
+    e.ptr      = reinterpret_cast<uintptr_t>(ptr);
+    e.size     = size;
+    e.file     = file;
+    e.type     = type;
+    e.line     = line;
+    e.kind     = EventRecord::Alloc;
+    e.is_array = is_array ? 1 : 0;
+    e.weight   = weight;
+    e.caller   = reinterpret_cast<uintptr_t>(caller);
+    if (const unsigned depth = stack_depth_.load(std::memory_order_relaxed)) {
+        // El unwinder y la primera reserva de la tabla pueden pedir memoria
+        ScopedSuppress quiet;
+        uintptr_t pcs[StackTable::kMaxDepth];
+        const size_t n = StackTable::capture(pcs, depth, kStackSkip, stack_mode_.load(std::memory_order_relaxed));
+        e.stack = StackTable::instance().intern(pcs, n);
+    }
+    push(e);
+}
+
+void EventPipeline::pushFree(void* ptr) noexcept {
+    if (!ptr || t_suppress) return;
+    if (sample_interval_.load(std::memory_order_relaxed) != 0) {
+        // Los bits no se borran: otro bloque muestreado puede compartirlo
+        const size_t b = filterBit(reinterpret_cast<uintptr_t>(ptr));
+        if (!(sampled_bits_[b / 64].load(std::memory_order_relaxed) & (uint64_t(1) << (b % 64)))) return;
+    }
+    EventRecord e;
+    e.ptr   = reinterpret_cast<uintptr_t>(ptr);
+    e.kind  = EventRecord::Free;
+    push(e);
+}
+
+size_t EventPipeline::drain(bool flush_all) {
+    std::lock_guard<std::mutex> lk(consumer_mtx_);
+    return drainLocked(flush_all);
+}
+
+size_t EventPipeline::drainLocked(bool flush_all) {
+    ScopedSuppress quiet;   // lo que reserven los consumidores no se registra
+    uint64_t watermark = flush_all ? UINT64_MAX : now_ns();
+
+    const auto by_ts = [](const EventRecord& a, const EventRecord& b) { return a.ts_ns < b.ts_ns; };
+
+    // pending_ y cada anillo ya vienen ordenados: se concatenan como tramos y
+    // solo se mezclan (O(n)) cuando un tramo empieza antes de donde acaba el lote
+    batch_.clear();
+    batch_.swap(pending_);
+    for (Ring* r = rings_.load(std::memory_order_acquire); r; r = r->next) {
+        const bool   in_flight = r->busy.load(std::memory_order_seq_cst) != 0;
+        const size_t h = r->head.load(std::memory_order_relaxed);
+        const size_t t = r->tail.load(std::memory_order_acquire);
+        // Un evento en vuelo tendrá ts >= el último publicado de su anillo y
+        // >= 'since' (el dueño tomó el anillo antes de leer el reloj). En un
+        // anillo recién creado solo está 'since': sin él, su primer evento
+        // podría llegar detrás de otros ya aplicados con ts mayor.
+        if (in_flight) {
+            uint64_t floor = r->since.load(std::memory_order_relaxed);
+            if (t != 0) floor = std::max(floor, r->rec[(t - 1) % kRingCapacity].ts_ns);
+            watermark = std::min(watermark, floor);
+        }
+        if (h == t) continue;
+        const size_t mid = batch_.size();
+        for (size_t i = h; i != t; ++i) batch_.push_back(r->rec[i % kRingCapacity]);
+        r->head.store(t, std::memory_order_release);
+        if (mid != 0 && by_ts(batch_[mid], batch_[mid - 1]))
+            std::inplace_merge(batch_.begin(), batch_.begin() + mid, batch_.end(), by_ts);
+    }
+    if (batch_.empty()) return 0;
+
+    const auto cut = std::lower_bound(batch_.begin(), batch_.end(), watermark,
+                     [](const EventRecord& e, uint64_t w) { return e.ts_ns < w; });
+    pending_.assign(cut, batch_.end());
+    const size_t n = static_cast<size_t>(cut - batch_.begin());
+    if (n == 0) return 0;
+
+    const size_t nc = n_consumers_.load(std::memory_order_acquire);
+    for (size_t i = 0; i < nc; ++i) consumers_[i].fn(batch_.data(), n, consumers_[i].ctx);
+    return n;
+}
+
+void EventPipeline::start(unsigned interval_ms) {
+    bool expected = false;
+    if (!running_.compare_exchange_strong(expected, true)) return;
+    if (worker_.joinable()) worker_.join();
+    worker_ = std::thread([this, interval_ms] {
+        ScopedSuppress quiet;
+        while (running_.load(std::memory_order_relaxed)) {
+            drain(false);
+            std::this_thread::sleep_for(std::chrono::milliseconds(interval_ms ? interval_ms : 1));
+        }
+    });
+}
+
+void EventPipeline::stop() {
+    running_.store(false, std::memory_order_relaxed);
+    if (worker_.joinable() && worker_.get_id() != std::this_thread::get_id()) worker_.join();
+    drain(true);
+}
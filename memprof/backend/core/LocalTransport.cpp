@@ -0,0 +1,188 @@
+// Transportes locales runtime -> GUI: socket AF_UNIX y anillo en memoria
+// compartida (protocolo en memprof/proto/LocalChannel.h).
+#include "memprof/core/Transport.h"
+#include "memprof/proto/LocalChannel.h"
+#include "SocketIo.h"
+
+#include <cstring>
+#include <new>
+
+#if !defined(_WIN32)
+  #include <fcntl.h>
+  #include <poll.h>
+  #include <sys/socket.h>
+  #include <sys/un.h>
+  #include <unistd.h>
+#endif
+#if defined(__linux__)
+  #include <sys/eventfd.h>
+  #include <sys/mman.h>
+#endif
+
+#if !defined(_WIN32)
+namespace {
+
+// Socket stream no bloqueante conectado a 'path' (-1 si falla)
+int connect_unix(const char* path, int timeout_ms) {
+    sockaddr_un addr{};
+    if (!path || !*path || std::strlen(path) >= sizeof(addr.sun_path)) return -1;
+    addr.sun_family = AF_UNIX;
+    std::strcpy(addr.sun_path, path);
+
+    const int s = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (s < 0) return -1;
+    sockio::setNonBlocking(s);
+#if defined(SO_NOSIGPIPE)
+    int one = 1;
+    ::setsockopt(s, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+    if (!sockio::connectTimeout(s, reinterpret_cast<sockaddr*>(&addr), sizeof(addr), timeout_ms)) {
+        ::close(s);
+        return -1;
+    }
+    return s;
+}
+
+// ------------------------------ unix: ------------------------------
+
+class UnixTransport final : public Transport {
+public:
+    ~UnixTransport() override { close(); }
+
+    bool connectTo(const char* path, int, int timeout_ms) override {
+        close();
+        sock_ = connect_unix(path, timeout_ms);
+        return sock_ != -1;
+    }
+    bool isConnected() const override { return sock_ != -1; }
+    void close() override {
+        if (sock_ != -1) { ::close(sock_); sock_ = -1; }
+    }
+    int64_t writeSome(const IoSlice* v, int n) override {
+        return sock_ == -1 ? -1 : sockio::writeSome(sock_, v, n);
+    }
+    bool waitWritable(int timeout_ms) override {
+        return sock_ != -1 && sockio::waitWritable(sock_, timeout_ms);
+    }
+
+private:
+    int sock_ = -1;
+};
+
+// ------------------------------ shm: ------------------------------
+
+#if defined(__linux__)
+class ShmTransport final : public Transport {
+public:
+    ~ShmTransport() override { close(); }
+
+    bool connectTo(const char* path, int, int timeout_ms) override {
+        close();
+        sock_ = connect_unix(path, timeout_ms);
+        if (sock_ == -1) return false;
+
+        const size_t len = shmring::mappingSize(shmring::kDefaultCapacity);
+        const int memfd = ::memfd_create("memprof-ring", MFD_CLOEXEC);
+        void* mem = MAP_FAILED;
+        if (memfd != -1 && ::ftruncate(memfd, static_cast<off_t>(len)) == 0)
+            mem = ::mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_SHARED, memfd, 0);
+        efd_ = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if (mem == MAP_FAILED || efd_ == -1) {
+            if (mem != MAP_FAILED) ::munmap(mem, len);
+            if (memfd != -1) ::close(memfd);
+            close();
+            return false;
+        }
+        ring_ = new (mem) shmring::Header();
+        ring_->capacity = shmring::kDefaultCapacity;
+        map_len_ = len;
+
+        // Saludo: kHello + {memfd, eventfd}. La GUI se queda con su copia
+        // del memfd; la nuestra ya no hace falta (el mapping sigue vivo).
+        char hello = shmring::kHello;
+        iovec iov{&hello, 1};
+        alignas(cmsghdr) char ctrl[CMSG_SPACE(2 * sizeof(int))] = {};
+        msghdr msg{};
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = ctrl;
+        msg.msg_controllen = sizeof(ctrl);
+        cmsghdr* cm = CMSG_FIRSTHDR(&msg);
+        cm->cmsg_level = SOL_SOCKET;
+        cm->cmsg_type  = SCM_RIGHTS;
+        cm->cmsg_len   = CMSG_LEN(2 * sizeof(int));
+        const int fds[2] = {memfd, efd_};
+        std::memcpy(CMSG_DATA(cm), fds, sizeof(fds));
+        const bool ok = ::sendmsg(sock_, &msg, sockio::kSendFlags) == 1;
+        ::close(memfd);
+        if (!ok) { close(); return false; }
+        return true;
+    }
+
+    bool isConnected() const override { return sock_ != -1; }
+
+    void close() override {
+        if (ring_) { ::munmap(ring_, map_len_); ring_ = nullptr; map_len_ = 0; }
+        if (efd_ != -1)  { ::close(efd_);  efd_  = -1; }
+        if (sock_ != -1) { ::close(sock_); sock_ = -1; }
+    }
+
+    int64_t writeSome(const IoSlice* v, int n) override {
+        if (!ring_ || peerGone()) return -1;
+        size_t total = 0;
+        for (int i = 0; i < n; ++i) {
+            const size_t k = shmring::write(ring_, static_cast<const char*>(v[i].data), v[i].len);
+            total += k;
+            if (k < v[i].len) break;   // lleno
+        }
+        if (total) notify();
+        return static_cast<int64_t>(total);
+    }
+
+    // Lleno: la GUI ya tiene aviso de lo publicado; se duerme hasta que libere
+    bool waitWritable(int timeout_ms) override {
+        if (!ring_) return false;
+        shmring::waitForSpace(ring_, timeout_ms);
+        return !peerGone();
+    }
+
+private:
+    void notify() {
+        const uint64_t one = 1;
+        [[maybe_unused]] const ssize_t r = ::write(efd_, &one, sizeof(one));   // EAGAIN: ya hay aviso pendiente
+    }
+
+    // El socket solo queda como testigo: HUP o EOF = la GUI cerró
+    bool peerGone() const {
+        pollfd p{sock_, POLLIN, 0};
+        if (::poll(&p, 1, 0) <= 0) return false;
+        if (p.revents & (POLLHUP | POLLERR | POLLNVAL)) return true;
+        char c;
+        return ::recv(sock_, &c, 1, MSG_PEEK | MSG_DONTWAIT) == 0;
+    }
+
+    int               sock_ = -1;
+    int               efd_  = -1;
+    shmring::Header*  ring_ = nullptr;
+    size_t            map_len_ = 0;
+};
+#endif
+
+} // namespace
+#endif
+
+std::unique_ptr<Transport> makeUnixTransport() {
+#if !defined(_WIN32)
+    return std::make_unique<UnixTransport>();
+#else
+    return nullptr;
+#endif
+}
+
+std::unique_ptr<Transport> makeShmTransport() {
+#if defined(__linux__)
+    return std::make_unique<ShmTransport>();
+#else
+    return nullptr;
+#endif
+}
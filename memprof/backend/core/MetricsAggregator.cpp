@@ -1,13 +1,36 @@
 #include "memprof/core/MetricsAggregator.h"
+#include "memprof/core/EventPipeline.h"
 
 #include <chrono>
-#include <cctype>
 #include <sstream>
 #include <algorithm>
+#include <bit>
 #include <mutex>
+#include <cstdlib>
+
+namespace {
+// Lock del agregador con las allocs del propio hilo suprimidas: lo que se
+// reserve dentro no se mide y, si el anillo del hilo se llenara, no intentará
+// drenar (el drenado vuelve a entrar en el agregador).
+struct Locked {
+    EventPipeline::ScopedSuppress quiet;
+    std::lock_guard<std::mutex>   lk;
+    explicit Locked(std::mutex& m) : lk(m) {}
+};
+} // anon
 
 MetricsAggregator::MetricsAggregator(size_t timeline_capacity)
-    : timeline_cap_(timeline_capacity ? timeline_capacity : 4096) {}
+    : timeline_cap_(timeline_capacity ? timeline_capacity : 4096) {
+    // id 0 reservado para "sin sitio": archivo "unknown", tipo vacío
+    internString_locked(file_index_, files_, "unknown");
+    internString_locked(type_index_, types_, "");
+    per_file_.resize(1);
+    sites_.push_back(SiteRec{});
+    caller_rows_.resize(1);
+    site_live_.resize(1);
+    site_life_.resize(1);
+    timeline_.reserve(timeline_cap_);
+}
 
 uint64_t MetricsAggregator::now_ns() {
     using namespace std::chrono;
@@ -20,245 +43,546 @@ uint64_t MetricsAggregator::now_ms() {
         std::chrono::system_clock::now().time_since_epoch()).count();
 }
 
-// -------- helpers JSON mínimos --------
+// -------- interning de sitios --------
+uint32_t MetricsAggregator::internString_locked(
+        std::unordered_map<std::string, uint32_t, StrHash, std::equal_to<>>& index,
+        std::vector<std::string>& names, std::string_view s) {
+    auto it = index.find(s);
+    if (it != index.end()) return it->second;
+    const auto id = static_cast<uint32_t>(names.size());
+    names.emplace_back(s);
+    index.emplace(names.back(), id);
+    return id;
+}
+
+MetricsAggregator::SiteId MetricsAggregator::internSite_locked(std::string_view file, int line,
+                                                               std::string_view type, uintptr_t pc) {
+    const uint32_t fid = internString_locked(file_index_, files_, file);
+    const uint32_t tid = internString_locked(type_index_, types_, type);
+    if (per_file_.size() < files_.size()) per_file_.resize(files_.size());
+
+    const SiteKey key{fid, tid, line, pc};
+    auto it = site_index_.find(key);
+    if (it != site_index_.end()) return it->second;
+    const auto id = static_cast<SiteId>(sites_.size());
+    sites_.push_back(SiteRec{fid, line, tid, pc});
+    site_live_.resize(sites_.size());
+    site_life_.resize(sites_.size());
+    caller_rows_.resize(sites_.size());
+    site_index_.emplace(key, id);
+    return id;
+}
+
+MetricsAggregator::SiteId MetricsAggregator::internSite(std::string_view file, int line,
+                                                        std::string_view type) {
+    Locked lk(mtx_);
+    return internSite_locked(file, line, type);
+}
+
+uintptr_t MetricsAggregator::parsePtr(const std::string& s) {
+    const int base = (s.rfind("0x", 0) == 0 || s.rfind("0X", 0) == 0) ? 16 : 10;
+    return static_cast<uintptr_t>(std::strtoull(s.c_str(), nullptr, base));
+}
+
+// -------- lógica principal --------
 namespace {
-inline void skipSpaces(const std::string& s, size_t& i) {
-    while (i < s.size() && std::isspace((unsigned char)s[i])) ++i;
-}
-bool parseJSONStringAt(const std::string& s, size_t& i, std::string& out) {
-    skipSpaces(s, i);
-    if (i >= s.size() || s[i] != '"') return false;
-    ++i;
-    std::string acc;
-    while (i < s.size()) {
-        char c = s[i++];
-        if (c == '\\') {
-            if (i >= s.size()) break;
-            char e = s[i++];
-            if (e == '"' || e == '\\' || e == '/') acc.push_back(e);
-            else if (e == 'b') acc.push_back('\b');
-            else if (e == 'f') acc.push_back('\f');
-            else if (e == 'n') acc.push_back('\n');
-            else if (e == 'r') acc.push_back('\r');
-            else if (e == 't') acc.push_back('\t');
-            else acc.push_back(e);
-        } else if (c == '"') {
-            out.swap(acc);
-            return true;
-        } else {
-            acc.push_back(c);
-        }
+inline void subSat(uint64_t& v, uint64_t d) { v = v >= d ? v - d : 0; }
+}
+
+MetricsAggregator::FileStats& MetricsAggregator::stackStats_locked(uint32_t stack) const {
+    if (stack >= per_stack_.size()) per_stack_.resize(size_t(stack) + 1);
+    return per_stack_[stack];
+}
+
+// Descuenta un bloque vivo de los agregados (bins, archivo, pila, totales)
+void MetricsAggregator::dropLive_locked(const LiveBlock& lb) {
+    const uint64_t est_bytes = lb.estBytes(), est_count = lb.estCount();
+    const size_t bi = sizeBinIndex(lb.size);
+    bin_bytes_[bi] -= est_bytes;
+    bin_count_[bi] -= est_count;
+
+    fileRows_locked(lb.site, [&](FileStats& fs) {
+        subSat(fs.live_count, est_count);
+        subSat(fs.live_bytes, est_bytes);
+    });
+    auto& su = site_live_[lb.site];
+    subSat(su.count, est_count);
+    subSat(su.bytes, est_bytes);
+    if (lb.stack) {
+        touchStack_locked(lb.stack);
+        auto& ss = stackStats_locked(lb.stack);
+        subSat(ss.live_count, est_count);
+        subSat(ss.live_bytes, est_bytes);
     }
-    return false;
+
+    current_bytes_.fetch_sub(est_bytes, std::memory_order_relaxed);
+    active_allocs_.fetch_sub(est_count, std::memory_order_relaxed);
 }
-bool seekFieldValue(const std::string& json, const std::string& field, size_t& i) {
-    const std::string q = "\"" + field + "\"";
-    size_t pos = json.find(q, i);
-    if (pos == std::string::npos) return false;
-    pos += q.size();
-    while (pos < json.size() && std::isspace((unsigned char)json[pos])) ++pos;
-    if (pos >= json.size() || json[pos] != ':') return false;
-    ++pos;
-    i = pos;
-    return true;
+
+void MetricsAggregator::onAlloc_locked(uintptr_t ptr, uint64_t size, uint64_t ts_ns,
+                                       SiteId site, bool is_array, uint64_t t_now, float weight,
+                                       uint32_t stack) {
+    const uint64_t cur = insertLive_locked(ptr, size, ts_ns, site, is_array, weight, stack);
+
+    uint64_t old_peak = peak_bytes_.load(std::memory_order_relaxed);
+    while (cur > old_peak &&
+           !peak_bytes_.compare_exchange_weak(old_peak, cur, std::memory_order_relaxed)) {}
+    if (cur >= peak_capture_at_) capturePeak_locked(cur, t_now);
+
+    promoteLeaks_locked(t_now);
+    pushTimelinePoint_locked(t_now, cur, leak_bytes_);
 }
-} // anon
 
-bool MetricsAggregator::extractString(const std::string& json, const std::string& field, std::string& out) {
-    size_t i = 0;
-    if (!seekFieldValue(json, field, i)) return false;
-    return parseJSONStringAt(json, i, out);
-}
-bool MetricsAggregator::extractBool(const std::string& json, const std::string& field, bool& out) {
-    size_t i = 0;
-    if (!seekFieldValue(json, field, i)) return false;
-    skipSpaces(json, i);
-    if (json.compare(i, 4, "true")  == 0) { out = true;  return true; }
-    if (json.compare(i, 5, "false") == 0) { out = false; return true; }
-    return false;
+// Alta en el conjunto vivo y en todos los agregados salvo pico y timeline.
+// Devuelve los bytes vivos resultantes.
+uint64_t MetricsAggregator::insertLive_locked(uintptr_t ptr, uint64_t size, uint64_t ts_ns, SiteId site,
+                                              bool is_array, float weight, uint32_t stack) {
+    if (site >= sites_.size()) site = 0;
+
+    bool inserted = false;
+    LiveBlock& lb = live_.upsert(ptr, inserted);
+    touchBlock_locked(ptr, !inserted);
+    if (!inserted) {
+        // Dirección reutilizada sin FREE visto: descontamos el bloque anterior
+        if (lb.is_leak) unmarkLeak_locked(ptr, lb);
+        else            ++age_stale_;
+        dropLive_locked(lb);
+    }
+    lb.size = size; lb.ts_ns = ts_ns; lb.site = site; lb.is_array = is_array; lb.is_leak = false;
+    lb.weight = weight; lb.stack = stack;
+    agePush_locked(ts_ns, ptr);
+
+    // Con muestreo, cada bloque registrado cuenta por 'weight' bloques reales
+    const uint64_t est_bytes = lb.estBytes(), est_count = lb.estCount();
+    total_allocs_.fetch_add(est_count, std::memory_order_relaxed);
+    active_allocs_.fetch_add(est_count, std::memory_order_relaxed);
+    const uint64_t cur = current_bytes_.fetch_add(est_bytes, std::memory_order_relaxed) + est_bytes;
+
+    const size_t bi = sizeBinIndex(size);
+    bin_bytes_[bi] += est_bytes;
+    bin_count_[bi] += est_count;
+    bin_alloc_bytes_[bi] += est_bytes;
+    bin_alloc_count_[bi] += est_count;
+
+    fileRows_locked(site, [&](FileStats& fs) {
+        fs.alloc_count += est_count;
+        fs.alloc_bytes += est_bytes;
+        fs.live_count  += est_count;
+        fs.live_bytes  += est_bytes;
+    });
+    site_live_[site].count += est_count;
+    site_live_[site].bytes += est_bytes;
+    if (stack) {
+        touchStack_locked(stack);
+        auto& ss = stackStats_locked(stack);
+        ss.alloc_count += est_count;
+        ss.alloc_bytes += est_bytes;
+        ss.live_count  += est_count;
+        ss.live_bytes  += est_bytes;
+    }
+    return cur;
 }
-bool MetricsAggregator::extractUint64(const std::string& json, const std::string& field, uint64_t& out) {
-    size_t i = 0;
-    if (!seekFieldValue(json, field, i)) return false;
-    skipSpaces(json, i);
-    if (i < json.size() && json[i] == '"') {
-        std::string tmp;
-        if (!parseJSONStringAt(json, i, tmp)) return false;
-        char* endp = nullptr;
-        int base = (tmp.rfind("0x", 0) == 0 || tmp.rfind("0X", 0) == 0) ? 16 : 10;
-        unsigned long long v = std::strtoull(tmp.c_str(), &endp, base);
-        out = (uint64_t)v;
-        return true;
-    } else {
-        uint64_t v = 0; bool any = false;
-        while (i < json.size() && std::isdigit((unsigned char)json[i])) {
-            any = true;
-            v = v * 10 + (uint64_t)(json[i] - '0');
-            ++i;
-        }
-        if (!any) return false;
-        out = v;
-        return true;
+
+void MetricsAggregator::onAlloc(uintptr_t ptr, uint64_t size, uint64_t ts_ns, SiteId site, bool is_array) {
+    Locked lk(mtx_);
+    onAlloc_locked(ptr, size, ts_ns, site, is_array, now_ns());
+}
+
+MetricsAggregator::SiteId MetricsAggregator::siteForLiteral_locked(const char* file, int line,
+                                                                   const char* type) {
+    const LiteralKey key{file, type, line};
+    auto it = literal_sites_.find(key);
+    if (it != literal_sites_.end()) return it->second;
+    const SiteId site = internSite_locked(file ? std::string_view(file) : std::string_view("unknown"), line,
+                                          type ? std::string_view(type) : std::string_view());
+    literal_sites_.emplace(key, site);
+    return site;
+}
+
+// Sin file/line: un sitio por (dirección del llamador, tipo). El archivo
+// queda "unknown" en los agregados; la GUI lo sustituye al simbolizar.
+MetricsAggregator::SiteId MetricsAggregator::siteForCaller_locked(uintptr_t pc, const char* type) {
+    const CallerKey key{pc, type};
+    auto it = caller_sites_.find(key);
+    if (it != caller_sites_.end()) return it->second;
+    const size_t known = sites_.size();
+    const SiteId site = internSite_locked("unknown", 0, type ? std::string_view(type) : std::string_view(), pc);
+    caller_sites_.emplace(key, site);
+    if (site >= known) unresolved_.push_back(site);
+    return site;
+}
+
+// Pasa un sitio por dirección de "unknown" a su archivo simbolizado. Su
+// SiteKey en site_index_ queda con el archivo viejo: solo se busca por
+// caller_sites_, y la dirección ya lo distingue de cualquier otro sitio.
+void MetricsAggregator::moveCallerSite_locked(SiteId site, std::string_view file, int line) {
+    const FileStats row = caller_rows_[site];
+    const uint32_t fid = internString_locked(file_index_, files_, file);
+    if (per_file_.size() < files_.size()) per_file_.resize(files_.size());
+
+    touchFile_locked(0);
+    auto& from = per_file_[0];
+    subSat(from.alloc_count, row.alloc_count);
+    subSat(from.alloc_bytes, row.alloc_bytes);
+    subSat(from.live_count,  row.live_count);
+    subSat(from.live_bytes,  row.live_bytes);
+    subSat(from.leak_count,  row.leak_count);
+    subSat(from.leak_bytes,  row.leak_bytes);
+
+    touchFile_locked(fid);
+    auto& to = per_file_[fid];
+    to.alloc_count += row.alloc_count;
+    to.alloc_bytes += row.alloc_bytes;
+    to.live_count  += row.live_count;
+    to.live_bytes  += row.live_bytes;
+    to.leak_count  += row.leak_count;
+    to.leak_bytes  += row.leak_bytes;
+
+    sites_[site].file_id = fid;
+    sites_[site].line    = line;
+}
+
+void MetricsAggregator::resolveCallerSites(CallerResolver resolve) {
+    Locked lk(mtx_);
+    size_t keep = 0;
+    std::string file;
+    for (const SiteId site : unresolved_) {
+        file.clear();
+        int line = 0;
+        if (!resolve(sites_[site].pc, file, line)) { unresolved_[keep++] = site; continue; }
+        // Sin archivo (módulo sin .debug_line) se queda en "unknown" para siempre
+        if (!file.empty()) moveCallerSite_locked(site, file, line);
+        caller_rows_[site] = FileStats{};
     }
+    unresolved_.resize(keep);
 }
-bool MetricsAggregator::extractInt(const std::string& json, const std::string& field, int& out) {
-    uint64_t u = 0;
-    if (!extractUint64(json, field, u)) return false;
-    out = (int)u;
-    return true;
+
+MetricsAggregator::CallSite MetricsAggregator::callSite_locked(const SiteRec& r) const {
+    return CallSite{files_[r.file_id], r.line, types_[r.type_id], r.pc};
+}
+
+void MetricsAggregator::onAlloc(uintptr_t ptr, uint64_t size, uint64_t ts_ns,
+                                const char* file, int line, const char* type, bool is_array) {
+    Locked lk(mtx_);
+    onAlloc_locked(ptr, size, ts_ns, siteForLiteral_locked(file, line, type), is_array, now_ns());
 }
 
-// -------- lógica principal --------
 void MetricsAggregator::onAlloc(const std::string& ptr, uint64_t size, uint64_t ts_ns,
                                 const std::string& file, int line,
                                 const std::string& type, bool is_array) {
-    total_allocs_.fetch_add(1, std::memory_order_relaxed);
-    active_allocs_.fetch_add(1, std::memory_order_relaxed);
-    uint64_t cur = current_bytes_.fetch_add(size, std::memory_order_relaxed) + size;
+    const uintptr_t p = parsePtr(ptr);
+    if (!p) return;
+    Locked lk(mtx_);
+    onAlloc_locked(p, size, ts_ns, internSite_locked(file, line, type), is_array, now_ns());
+}
 
-    uint64_t old_peak = peak_bytes_.load(std::memory_order_relaxed);
-    while (cur > old_peak &&
-           !peak_bytes_.compare_exchange_weak(old_peak, cur, std::memory_order_relaxed)) {}
+void MetricsAggregator::onFree(uintptr_t ptr, uint64_t hinted_size) {
+    Locked lk(mtx_);
+    (void)hinted_size;
+    onFree_locked(ptr, now_ns(), UINT64_MAX);
+}
 
-    {
-        std::lock_guard<std::mutex> lk(mtx_);
-        BlockInfo bi;
-        bi.ptr = ptr; bi.size = size; bi.file = file; bi.line = line; bi.type = type; bi.is_array = is_array; bi.ts_ns = ts_ns;
-        live_[ptr] = bi;
-
-        auto& fs = per_file_[file];
-        fs.alloc_count += 1;
-        fs.alloc_bytes += size;
-        fs.live_count  += 1;
-        fs.live_bytes  += size;
-
-        uint64_t t = now_ns();
-        uint64_t leak_b = computeLeakBytes_locked(t);
-        pushTimelinePoint_locked(t, cur, leak_b);
-    }
+bool MetricsAggregator::onFree_locked(uintptr_t ptr, uint64_t t_now, uint64_t free_ts) {
+    if (eraseLive_locked(ptr, free_ts) == kNotLive) return false;
+    uint64_t cur = current_bytes_.load(std::memory_order_relaxed);
+    promoteLeaks_locked(t_now);
+    pushTimelinePoint_locked(t_now, cur, leak_bytes_);
+    return true;
 }
 
-void MetricsAggregator::onFree(const std::string& ptr, uint64_t hinted_size) {
-    uint64_t sub = 0;
-    std::string file;
-    {
-        std::lock_guard<std::mutex> lk(mtx_);
-        auto it = live_.find(ptr);
-        if (it != live_.end()) {
-            sub = it->second.size;
-            file = it->second.file;
-
-            auto fit = per_file_.find(file);
-            if (fit != per_file_.end()) {
-                if (fit->second.live_count > 0)    fit->second.live_count -= 1;
-                if (fit->second.live_bytes >= sub) fit->second.live_bytes -= sub;
-                else                                fit->second.live_bytes = 0;
-            }
-            live_.erase(it);
+// Baja del conjunto vivo; devuelve los bytes (estimados) descontados o
+// kNotLive si 'ptr' no estaba vivo
+uint64_t MetricsAggregator::eraseLive_locked(uintptr_t ptr, uint64_t free_ts) {
+    LiveBlock* cur_lb = live_.find(ptr);
+    // Un free anterior a la alloc viva es de una vida previa de esa dirección
+    if (!cur_lb || cur_lb->ts_ns > free_ts) return kNotLive;
+    LiveBlock lb;
+    live_.erase(ptr, lb);
+    touchBlock_locked(ptr, true);
+
+    if (lb.is_leak) unmarkLeak_locked(ptr, lb);
+    else            ++age_stale_;   // su entrada en el anillo queda muerta
+    dropLive_locked(lb);
+    if (age_stale_ > 1024 && age_stale_ * 2 > age_size_) ageCompact_locked();
+    // Sin timestamp del free no hay vida que medir
+    if (free_ts != UINT64_MAX)
+        lifeHist_locked(lb.site).add(free_ts - lb.ts_ns, lb.estBytes(), lb.estCount(),
+                                     short_lived_ns_.load(std::memory_order_relaxed));
+    return lb.estBytes();
+}
+
+void MetricsAggregator::onEvents(const EventRecord* ev, size_t n) {
+    if (n == 0) return;
+    Locked lk(mtx_);
+    for (size_t i = 0; i < n; ++i) {
+        const EventRecord& e = ev[i];
+        if (e.kind == EventRecord::Alloc) {
+            const SiteId site = (!e.file && e.caller) ? siteForCaller_locked(e.caller, e.type)
+                                                      : siteForLiteral_locked(e.file, e.line, e.type);
+            onAlloc_locked(e.ptr, e.size, e.ts_ns, site, e.is_array != 0, e.ts_ns, e.weight, e.stack);
+        } else {
+            onFree_locked(e.ptr, e.ts_ns, e.ts_ns);
         }
     }
+    promoteLeaks_locked(now_ns());
+}
 
-    if (sub > 0) {
-        current_bytes_.fetch_sub(sub, std::memory_order_relaxed);
-        active_allocs_.fetch_sub(1, std::memory_order_relaxed);
+void MetricsAggregator::consumeEvents(const EventRecord* ev, size_t n, void* self) {
+    static_cast<MetricsAggregator*>(self)->onEvents(ev, n);
+}
 
-        std::lock_guard<std::mutex> lk(mtx_);
-        uint64_t t   = now_ns();
-        uint64_t cur = current_bytes_.load(std::memory_order_relaxed);
-        uint64_t leak_b = computeLeakBytes_locked(t);
-        pushTimelinePoint_locked(t, cur, leak_b);
-    } else {
-        (void)hinted_size;
+void MetricsAggregator::onFree(const std::string& ptr, uint64_t hinted_size) {
+    onFree(parsePtr(ptr), hinted_size);
+}
+
+// -------- índice de antigüedad / fugas incrementales --------
+void MetricsAggregator::agePush_locked(uint64_t ts_ns, uintptr_t ptr) {
+    if (age_size_ == age_ring_.size()) {
+        // Crecer desenrollando el anillo para que la cabeza quede en 0
+        std::vector<AgeEntry> grown(age_ring_.empty() ? 1024 : age_ring_.size() * 2);
+        for (size_t i = 0; i < age_size_; ++i)
+            grown[i] = age_ring_[(age_head_ + i) % age_ring_.size()];
+        age_ring_.swap(grown);
+        age_head_ = 0;
     }
+    age_ring_[(age_head_ + age_size_) % age_ring_.size()] = AgeEntry{ts_ns, ptr};
+    ++age_size_;
 }
 
-uint64_t MetricsAggregator::computeLeakBytes_locked(uint64_t now_ns_val) const {
+void MetricsAggregator::promoteLeaks_locked(uint64_t now_ns_val) const {
     const uint64_t thr_ns = leak_threshold_ms_.load(std::memory_order_relaxed) * 1000000ULL;
-    uint64_t leak = 0;
-    for (const auto& kv : live_) {
-        const auto& bi = kv.second;
-        if (now_ns_val > bi.ts_ns && (now_ns_val - bi.ts_ns) > thr_ns) {
-            leak += bi.size;
+    while (age_size_ > 0) {
+        const AgeEntry e = age_ring_[age_head_];
+        if (!(now_ns_val > e.ts_ns && (now_ns_val - e.ts_ns) > thr_ns)) break;
+        age_head_ = (age_head_ + 1) % age_ring_.size();
+        --age_size_;
+
+        // La entrada solo es válida si el bloque sigue vivo con ese mismo ts
+        LiveBlock* lb = live_.find(e.ptr);
+        if (!lb || lb->ts_ns != e.ts_ns || lb->is_leak) {
+            if (age_stale_ > 0) --age_stale_;
+            continue;
+        }
+        lb->is_leak = true;
+        touchBlock_locked(e.ptr, true);
+        leak_bytes_ += lb->estBytes();
+        leak_count_ += lb->estCount();
+        fileRows_locked(lb->site, [&](FileStats& fs) {
+            fs.leak_count += lb->estCount();
+            fs.leak_bytes += lb->estBytes();
+        });
+        if (lb->stack) {
+            touchStack_locked(lb->stack);
+            auto& ss = stackStats_locked(lb->stack);
+            ss.leak_count += lb->estCount();
+            ss.leak_bytes += lb->estBytes();
         }
+        leak_by_size_.emplace(lb->size, e.ptr);   // tamaño real: "mayor fuga" es un bloque concreto
     }
-    return leak;
+}
+
+void MetricsAggregator::unmarkLeak_locked(uintptr_t ptr, const LiveBlock& lb) {
+    const uint64_t est_bytes = lb.estBytes(), est_count = lb.estCount();
+    leak_bytes_ -= est_bytes;
+    leak_count_ -= est_count;
+    fileRows_locked(lb.site, [&](FileStats& fs) {
+        subSat(fs.leak_count, est_count);
+        subSat(fs.leak_bytes, est_bytes);
+    });
+    if (lb.stack) {
+        touchStack_locked(lb.stack);
+        auto& ss = stackStats_locked(lb.stack);
+        subSat(ss.leak_count, est_count);
+        subSat(ss.leak_bytes, est_bytes);
+    }
+    leak_by_size_.erase({lb.size, ptr});
+}
+
+void MetricsAggregator::ageCompact_locked() const {
+    size_t out = 0;
+    const size_t cap = age_ring_.size();
+    for (size_t i = 0; i < age_size_; ++i) {
+        const AgeEntry e = age_ring_[(age_head_ + i) % cap];
+        const LiveBlock* lb = live_.find(e.ptr);
+        if (!lb || lb->ts_ns != e.ts_ns || lb->is_leak) continue;
+        // out <= i: escribir en (head + out) nunca pisa algo aún no leído
+        age_ring_[(age_head_ + out) % cap] = e;
+        ++out;
+    }
+    age_size_  = out;
+    age_stale_ = 0;
+}
+
+void MetricsAggregator::rebuildLeakIndex_locked() {
+    // Cambio de umbral: se recalcula todo (operación rara, O(n log n))
+    leak_bytes_ = 0;
+    leak_count_ = 0;
+    leak_by_size_.clear();
+    for (auto& fs : per_file_)  { fs.leak_count = 0; fs.leak_bytes = 0; }
+    for (auto& fs : caller_rows_) { fs.leak_count = 0; fs.leak_bytes = 0; }
+    for (auto& ss : per_stack_) { ss.leak_count = 0; ss.leak_bytes = 0; }
+
+    std::vector<AgeEntry> all;
+    all.reserve(live_.size());
+    live_.forEachMut([&](uintptr_t ptr, LiveBlock& lb) {
+        lb.is_leak = false;
+        all.push_back(AgeEntry{lb.ts_ns, ptr});
+    });
+    std::sort(all.begin(), all.end(),
+              [](const AgeEntry& a, const AgeEntry& b) { return a.ts_ns < b.ts_ns; });
+
+    age_ring_.swap(all);
+    age_head_  = 0;
+    age_size_  = age_ring_.size();
+    age_stale_ = 0;
+    need_keyframe_ = true;   // cambian los is_leak de todos los bloques
+    promoteLeaks_locked(now_ns());
+}
+
+// -------- registro de cambios (deltas) --------
+void MetricsAggregator::touchBlock_locked(uintptr_t ptr, bool existed) const {
+    if (!changelog_on_ || need_keyframe_) return;
+    bool inserted = false;
+    uint8_t& flags = changed_.upsert(ptr, inserted);
+    if (!inserted) return;   // el primer toque del epoch decide 'existed'
+    flags = existed ? kExisted : 0;
+    // Si nadie recoge los cambios el registro no crece sin límite: se
+    // descarta y el siguiente corte será un keyframe.
+    if (changed_.size() > 2 * live_.size() + 65536) {
+        changed_.reset();
+        need_keyframe_ = true;
+    }
+}
+
+void MetricsAggregator::touchFile_locked(uint32_t file_id) const {
+    if (!changelog_on_ || need_keyframe_) return;
+    if (file_id >= file_dirty_.size()) file_dirty_.resize(files_.size() > file_id ? files_.size() : file_id + 1);
+    if (file_dirty_[file_id]) return;
+    file_dirty_[file_id] = 1;
+    dirty_files_.push_back(file_id);
+}
+
+void MetricsAggregator::touchStack_locked(uint32_t stack) const {
+    if (!changelog_on_ || need_keyframe_) return;
+    if (stack >= stack_dirty_.size()) stack_dirty_.resize(size_t(stack) + 1);
+    if (stack_dirty_[stack]) return;
+    stack_dirty_[stack] = 1;
+    dirty_stacks_.push_back(stack);
+}
+
+MetricsAggregator::BlockInfo MetricsAggregator::blockInfo(uintptr_t ptr, const LiveBlock& lb) {
+    return BlockInfo{ptr, lb.size, lb.ts_ns, lb.site, lb.is_array, lb.is_leak, lb.stack};
+}
+
+size_t MetricsAggregator::sizeBinIndex(uint64_t size) {
+    if (size < 4) return static_cast<size_t>(size);
+    // e = log2(size) >= 2; los dos bits bajo el más alto eligen la subclase
+    const unsigned e = static_cast<unsigned>(std::bit_width(size)) - 1;
+    const size_t   b = size_t(e - 1) * 4 + ((size >> (e - 2)) & 3);
+    return b < kSizeBins ? b : kSizeBins - 1;
+}
+
+uint64_t MetricsAggregator::sizeBinLow(size_t bin) {
+    if (bin < 4) return bin;
+    const unsigned e = static_cast<unsigned>(bin / 4) + 1;
+    return (4 + uint64_t(bin % 4)) << (e - 2);
+}
+
+void MetricsAggregator::collectDelta(Delta& out, bool keyframe) {
+    Locked lk(mtx_);
+    promoteLeaks_locked(now_ns());
+
+    out.upserts.clear();
+    out.removed.clear();
+    out.files.clear();
+    out.stacks.clear();
+    out.new_sites.clear();
+    out.base_epoch = epoch_;
+    out.epoch      = ++epoch_;
+    out.keyframe   = keyframe || need_keyframe_ || !changelog_on_;
+
+    if (out.keyframe) {
+        out.upserts.reserve(live_.size());
+        live_.forEach([&](uintptr_t ptr, const LiveBlock& lb) {
+            out.upserts.push_back(blockInfo(ptr, lb));
+        });
+        for (size_t fid = 0; fid < per_file_.size() && fid < files_.size(); ++fid)
+            if (per_file_[fid].alloc_count != 0) out.files.emplace_back(files_[fid], per_file_[fid]);
+        for (size_t sid = 1; sid < per_stack_.size(); ++sid)
+            if (per_stack_[sid].alloc_count != 0) out.stacks.emplace_back(uint32_t(sid), per_stack_[sid]);
+        sites_sent_ = 0;
+    } else {
+        changed_.forEach([&](uintptr_t ptr, const uint8_t& flags) {
+            if (const LiveBlock* lb = live_.find(ptr))
+                out.upserts.push_back(blockInfo(ptr, *lb));
+            else if (flags & kExisted)
+                out.removed.push_back(ptr);
+        });
+        for (uint32_t fid : dirty_files_)
+            if (fid < files_.size()) out.files.emplace_back(files_[fid], per_file_[fid]);
+        for (uint32_t sid : dirty_stacks_) out.stacks.emplace_back(sid, per_stack_[sid]);
+    }
+
+    out.first_site = sites_sent_;
+    for (size_t i = sites_sent_; i < sites_.size(); ++i)
+        out.new_sites.push_back(callSite_locked(sites_[i]));
+    sites_sent_ = static_cast<SiteId>(sites_.size());
+
+    changed_.reset();
+    for (uint32_t fid : dirty_files_) if (fid < file_dirty_.size()) file_dirty_[fid] = 0;
+    dirty_files_.clear();
+    for (uint32_t sid : dirty_stacks_) stack_dirty_[sid] = 0;
+    dirty_stacks_.clear();
+    need_keyframe_ = false;
+    changelog_on_  = true;
 }
 
 void MetricsAggregator::pushTimelinePoint_locked(uint64_t t_ns, uint64_t cur_b, uint64_t leak_b) {
-    timeline_.push_back(TimelinePoint{t_ns, cur_b, leak_b});
-    if (timeline_.size() > timeline_cap_) timeline_.pop_front();
+    if (timeline_.size() < timeline_cap_) {
+        timeline_.push_back(TimelinePoint{t_ns, cur_b, leak_b});
+    } else {
+        timeline_[timeline_head_] = TimelinePoint{t_ns, cur_b, leak_b};
+        timeline_head_ = (timeline_head_ + 1) % timeline_cap_;
+    }
 }
 
 void MetricsAggregator::computeLeaksKPIs_locked(uint64_t now_ns_val, LeaksKPIs& out) const {
-    const uint64_t thr_ns = leak_threshold_ms_.load(std::memory_order_relaxed) * 1000000ULL;
+    promoteLeaks_locked(now_ns_val);
 
-    std::unordered_map<std::string, std::pair<uint64_t,uint64_t>> per_file_leaks;
-    uint64_t count_leaks = 0, total_leak_b = 0;
-
-    uint64_t max_b = 0;
-    std::string max_ptr, max_file;
-
-    for (const auto& kv : live_) {
-        const auto& bi = kv.second;
-        if (now_ns_val > bi.ts_ns && (now_ns_val - bi.ts_ns) > thr_ns) {
-            ++count_leaks;
-            total_leak_b += bi.size;
-            auto& pf = per_file_leaks[bi.file];
-            pf.first  += 1;
-            pf.second += bi.size;
-
-            if (bi.size > max_b) {
-                max_b   = bi.size;
-                max_ptr = bi.ptr;
-                max_file= bi.file;
-            }
-        }
+    // Mayor fuga: último elemento del conjunto ordenado por tamaño
+    uint64_t  max_b = 0;
+    uintptr_t max_ptr = 0;
+    uint32_t  max_fid = 0;
+    if (!leak_by_size_.empty()) {
+        const auto& top = *leak_by_size_.rbegin();
+        max_b   = top.first;
+        max_ptr = top.second;
+        if (const LiveBlock* lb = live_.find(max_ptr)) max_fid = sites_[lb->site].file_id;
     }
 
-    std::string top_file; uint64_t top_count = 0, top_bytes = 0;
-    for (const auto& kv : per_file_leaks) {
-        if (kv.second.first > top_count || (kv.second.first == top_count && kv.second.second > top_bytes)) {
-            top_file  = kv.first;
-            top_count = kv.second.first;
-            top_bytes = kv.second.second;
+    // Archivo con más fugas: O(archivos), no O(bloques)
+    size_t top_fid = files_.size(); uint64_t top_count = 0, top_bytes = 0;
+    for (size_t fid = 0; fid < per_file_.size(); ++fid) {
+        const auto& fs = per_file_[fid];
+        if (fs.leak_count == 0) continue;
+        if (fs.leak_count > top_count || (fs.leak_count == top_count && fs.leak_bytes > top_bytes)) {
+            top_fid   = fid;
+            top_count = fs.leak_count;
+            top_bytes = fs.leak_bytes;
         }
     }
 
-    out.total_leak_bytes         = total_leak_b;
+    out.total_leak_bytes         = leak_bytes_;
     const uint64_t tallocs       = total_allocs_.load(std::memory_order_relaxed);
-    out.leak_rate                = (tallocs > 0) ? (double)count_leaks / (double)tallocs : 0.0;
-    out.largest.file             = max_file;
+    out.leak_rate                = (tallocs > 0) ? (double)leak_count_ / (double)tallocs : 0.0;
+    out.largest.file             = (max_b > 0) ? files_[max_fid] : std::string();
     out.largest.ptr              = max_ptr;
     out.largest.size             = max_b;
-    out.top_file_by_leaks.file   = top_file;
+    out.top_file_by_leaks.file   = (top_fid < files_.size()) ? files_[top_fid] : std::string();
     out.top_file_by_leaks.count  = top_count;
     out.top_file_by_leaks.bytes  = top_bytes;
 }
 
-void MetricsAggregator::processEvent(const std::string& json) {
-    std::string kind;
-    if (!extractString(json, "kind", kind)) return;
-
-    if (kind == "ALLOC") {
-        std::string ptr, file, type;
-        uint64_t size = 0, ts_ns = 0;
-        int line = 0; bool is_arr = false;
-        extractString(json, "ptr", ptr);
-        extractUint64(json, "size", size);
-        extractUint64(json, "ts_ns", ts_ns);
-        extractString(json, "file", file);
-        extractInt   (json, "line", line);
-        extractString(json, "type", type);
-        extractBool  (json, "is_array", is_arr);
-        if (!ptr.empty() && size > 0) onAlloc(ptr, size, ts_ns, file, line, type, is_arr);
-    } else if (kind == "FREE") {
-        std::string ptr; uint64_t hinted = 0;
-        extractString(json, "ptr", ptr);
-        extractUint64(json, "size", hinted);
-        if (!ptr.empty()) onFree(ptr, hinted);
-    }
-}
-
 void MetricsAggregator::getMetrics(uint64_t& current_bytes,
                                    uint64_t& peak_bytes,
                                    uint64_t& active_allocs,
@@ -268,38 +592,291 @@ void MetricsAggregator::getMetrics(uint64_t& current_bytes,
     peak_bytes    = peak_bytes_.load(std::memory_order_relaxed);
     active_allocs = active_allocs_.load(std::memory_order_relaxed);
     total_allocs  = total_allocs_.load(std::memory_order_relaxed);
-    std::lock_guard<std::mutex> lk(mtx_);
-    leak_bytes    = computeLeakBytes_locked(now_ns());
+    Locked lk(mtx_);
+    promoteLeaks_locked(now_ns());
+    leak_bytes    = leak_bytes_;
 }
 
 std::vector<MetricsAggregator::TimelinePoint> MetricsAggregator::getTimeline() const {
-    std::lock_guard<std::mutex> lk(mtx_);
-    return std::vector<TimelinePoint>(timeline_.begin(), timeline_.end());
+    Locked lk(mtx_);
+    std::vector<TimelinePoint> out;
+    out.reserve(timeline_.size());
+    // del más antiguo al más reciente
+    for (size_t i = 0; i < timeline_.size(); ++i)
+        out.push_back(timeline_[(timeline_head_ + i) % timeline_.size()]);
+    return out;
 }
 
 std::vector<MetricsAggregator::BlockInfo> MetricsAggregator::getBlocks() const {
-    std::lock_guard<std::mutex> lk(mtx_);
+    Locked lk(mtx_);
+    promoteLeaks_locked(now_ns());
     std::vector<BlockInfo> out;
     out.reserve(live_.size());
-    for (const auto& kv : live_) out.push_back(kv.second);
+    live_.forEach([&](uintptr_t ptr, const LiveBlock& lb) {
+        out.push_back(blockInfo(ptr, lb));
+    });
     return out;
 }
 
 std::unordered_map<std::string, MetricsAggregator::FileStats>
 MetricsAggregator::getFileStats() const {
-    std::lock_guard<std::mutex> lk(mtx_);
-    return per_file_;
+    Locked lk(mtx_);
+    promoteLeaks_locked(now_ns());
+    std::unordered_map<std::string, FileStats> out;
+    out.reserve(per_file_.size());
+    for (size_t fid = 0; fid < per_file_.size() && fid < files_.size(); ++fid) {
+        if (per_file_[fid].alloc_count == 0) continue;
+        out.emplace(files_[fid], per_file_[fid]);
+    }
+    return out;
+}
+
+std::vector<std::pair<uint32_t, MetricsAggregator::FileStats>> MetricsAggregator::getStackStats() const {
+    Locked lk(mtx_);
+    promoteLeaks_locked(now_ns());
+    std::vector<std::pair<uint32_t, FileStats>> out;
+    for (size_t sid = 1; sid < per_stack_.size(); ++sid)
+        if (per_stack_[sid].alloc_count != 0) out.emplace_back(uint32_t(sid), per_stack_[sid]);
+    return out;
+}
+
+std::vector<MetricsAggregator::SizeBin> MetricsAggregator::getSizeBins() const {
+    Locked lk(mtx_);
+    // El acumulado cubre a los vivos: su tramo no vacío basta
+    size_t first = 0, last = kSizeBins;
+    while (first < kSizeBins && bin_alloc_count_[first] == 0) ++first;
+    while (last > first && bin_alloc_count_[last - 1] == 0) --last;
+    std::vector<SizeBin> out;
+    out.reserve(last - first);
+    for (size_t i = first; i < last; ++i) {
+        SizeBin b;
+        b.lo          = sizeBinLow(i);
+        b.hi          = i + 1 < kSizeBins ? sizeBinLow(i + 1) : (UINT64_C(1) << 62);
+        b.bytes       = bin_bytes_[i];
+        b.count       = bin_count_[i];
+        b.alloc_bytes = bin_alloc_bytes_[i];
+        b.alloc_count = bin_alloc_count_[i];
+        out.push_back(b);
+    }
+    return out;
+}
+
+MetricsAggregator::CallSite MetricsAggregator::getSite(SiteId id) const {
+    Locked lk(mtx_);
+    if (id >= sites_.size()) id = 0;
+    const auto& r = sites_[id];
+    return callSite_locked(r);
+}
+
+std::vector<MetricsAggregator::CallSite> MetricsAggregator::getSites() const {
+    Locked lk(mtx_);
+    std::vector<CallSite> out;
+    out.reserve(sites_.size());
+    for (size_t i = 0; i < sites_.size(); ++i)
+        out.push_back(callSite_locked(sites_[i]));
+    return out;
+}
+
+// -------- snapshots de heap con nombre --------
+uint32_t MetricsAggregator::takeSnapshot(std::string_view label) {
+    Locked lk(mtx_);
+    HeapSnapshot snap;
+    snap.id    = next_snapshot_++;
+    snap.label = std::string(label);
+    snap.t_ns  = now_ns();
+
+    // Contadores por sitio compactados: sale ya ordenado por sitio
+    for (size_t i = 0; i < site_live_.size(); ++i) {
+        if (site_live_[i].count == 0) continue;
+        snap.bytes += site_live_[i].bytes;
+        snap.count += site_live_[i].count;
+        snap.sites.push_back(SiteUsage{static_cast<SiteId>(i), site_live_[i].bytes, site_live_[i].count});
+    }
+
+    if (snapshots_.size() >= kMaxSnapshots) snapshots_.erase(snapshots_.begin());
+    snapshots_.push_back(std::move(snap));
+    return snapshots_.back().id;
+}
+
+bool MetricsAggregator::getSnapshot(uint32_t id, HeapSnapshot& out) const {
+    Locked lk(mtx_);
+    for (const auto& s : snapshots_)
+        if (s.id == id) { out = s; return true; }
+    return false;
+}
+
+std::vector<MetricsAggregator::HeapSnapshot> MetricsAggregator::getSnapshots(uint32_t first_id) const {
+    Locked lk(mtx_);
+    std::vector<HeapSnapshot> out;
+    for (const auto& s : snapshots_)
+        if (s.id >= first_id) out.push_back(s);
+    return out;
+}
+
+std::vector<MetricsAggregator::SiteGrowth> MetricsAggregator::diff(uint32_t a, uint32_t b) const {
+    HeapSnapshot sa, sb;
+    if (!getSnapshot(a, sa) || !getSnapshot(b, sb)) return {};
+    return diff(sa, sb);
+}
+
+std::vector<MetricsAggregator::SiteGrowth> MetricsAggregator::diff(const HeapSnapshot& a, const HeapSnapshot& b) {
+    // Mezcla de dos listas ordenadas por sitio
+    std::vector<SiteGrowth> out;
+    size_t i = 0, j = 0;
+    while (i < a.sites.size() || j < b.sites.size()) {
+        SiteGrowth g;
+        if (j == b.sites.size() || (i < a.sites.size() && a.sites[i].site < b.sites[j].site)) {
+            g.site = a.sites[i].site;
+            g.bytes_a = a.sites[i].bytes; g.count_a = a.sites[i].count;
+            ++i;
+        } else if (i == a.sites.size() || b.sites[j].site < a.sites[i].site) {
+            g.site = b.sites[j].site;
+            g.bytes_b = b.sites[j].bytes; g.count_b = b.sites[j].count;
+            ++j;
+        } else {
+            g.site = a.sites[i].site;
+            g.bytes_a = a.sites[i].bytes; g.count_a = a.sites[i].count;
+            g.bytes_b = b.sites[j].bytes; g.count_b = b.sites[j].count;
+            ++i; ++j;
+        }
+        if (g.bytes_a != g.bytes_b || g.count_a != g.count_b) out.push_back(g);
+    }
+    std::sort(out.begin(), out.end(), [](const SiteGrowth& x, const SiteGrowth& y) {
+        return x.dBytes() != y.dBytes() ? x.dBytes() > y.dBytes() : x.site < y.site;
+    });
+    return out;
+}
+
+// -------- vida de los bloques por sitio --------
+size_t MetricsAggregator::lifetimeBucket(uint64_t life_ns) {
+    const uint64_t v = life_ns >> 6;   // resolución mínima: 64 ns
+    if (v < 4) return static_cast<size_t>(v);
+    const unsigned e = static_cast<unsigned>(std::bit_width(v)) - 1;   // >= 2
+    const size_t   b = size_t(e - 1) * 4 + ((v >> (e - 2)) & 3);
+    return b < kLifeBuckets ? b : kLifeBuckets - 1;
+}
+
+uint64_t MetricsAggregator::lifetimeBucketLowNs(size_t bucket) {
+    if (bucket < 4) return uint64_t(bucket) << 6;
+    const unsigned e = static_cast<unsigned>(bucket / 4) + 1;
+    return ((4 + uint64_t(bucket % 4)) << (e - 2)) << 6;
+}
+
+void MetricsAggregator::LifetimeHist::merge(const LifetimeHist& o) {
+    frees       += o.frees;
+    freed_bytes += o.freed_bytes;
+    short_lived += o.short_lived;
+    for (size_t i = 0; i < kLifeBuckets; ++i) buckets[i] += o.buckets[i];
+}
+
+// Límite superior del cubo donde cae el cuantil q
+uint64_t MetricsAggregator::LifetimeHist::percentileNs(double q) const {
+    if (frees == 0) return 0;
+    const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(q * static_cast<double>(frees))));
+    uint64_t acc = 0;
+    for (size_t i = 0; i < kLifeBuckets; ++i) {
+        acc += buckets[i];
+        if (acc >= rank) return lifetimeBucketLowNs(i + 1);
+    }
+    return lifetimeBucketLowNs(kLifeBuckets);
+}
+
+MetricsAggregator::LifetimeHist& MetricsAggregator::lifeHist_locked(SiteId site) {
+    uint32_t& idx = site_life_[site];
+    if (idx == 0) {
+        life_hists_.emplace_back();
+        life_site_.push_back(site);
+        life_dirty_.push_back(0);
+        idx = static_cast<uint32_t>(life_hists_.size());
+    }
+    if (!life_dirty_[idx - 1]) { life_dirty_[idx - 1] = 1; dirty_lives_.push_back(idx - 1); }
+    return life_hists_[idx - 1];
+}
+
+void MetricsAggregator::collectLifetimeStats(std::vector<LifetimeStats>& out, bool all, SiteId site_end) {
+    Locked lk(mtx_);
+    out.clear();
+    auto emit = [&](uint32_t i) {
+        const LifetimeHist& h = life_hists_[i];
+        out.push_back(LifetimeStats{life_site_[i], h.frees, h.freed_bytes, h.short_lived,
+                                    h.percentileNs(0.50), h.percentileNs(0.99)});
+    };
+    // Lo que no sale ahora sigue marcado para la siguiente llamada
+    size_t keep = 0;
+    for (uint32_t i : dirty_lives_) {
+        if (life_site_[i] >= site_end) { dirty_lives_[keep++] = i; continue; }
+        life_dirty_[i] = 0;
+        if (!all) emit(i);
+    }
+    dirty_lives_.resize(keep);
+    if (all)
+        for (uint32_t i = 0; i < life_hists_.size(); ++i)
+            if (life_site_[i] < site_end) emit(i);
+}
+
+bool MetricsAggregator::getLifetimeHistogram(SiteId site, std::vector<uint64_t>& buckets) const {
+    Locked lk(mtx_);
+    if (site >= site_life_.size() || site_life_[site] == 0) return false;
+    const LifetimeHist& h = life_hists_[site_life_[site] - 1];
+    buckets.assign(h.buckets, h.buckets + kLifeBuckets);
+    return true;
+}
+
+void MetricsAggregator::setShortLivedNs(uint64_t ns) {
+    short_lived_ns_.store(ns, std::memory_order_relaxed);
+}
+uint64_t MetricsAggregator::getShortLivedNs() const {
+    return short_lived_ns_.load(std::memory_order_relaxed);
+}
+
+// -------- captura automática en el pico --------
+// Solo se llega aquí cuando los vivos cruzan peak_capture_at_, así que el
+// camino normal de onAlloc paga una comparación. Sin límite de frecuencia:
+// un pico breve también se captura, y el margen geométrico ya acota cuántas
+// veces se copia (≈ ln(pico) / ln(1 + margen)).
+void MetricsAggregator::capturePeak_locked(uint64_t cur_b, uint64_t t_ns) {
+    peak_snap_.id++;
+    peak_snap_.label = "peak";
+    peak_snap_.t_ns  = t_ns;
+    peak_snap_.bytes = cur_b;
+    peak_snap_.count = active_allocs_.load(std::memory_order_relaxed);
+    peak_snap_.sites.clear();   // conserva la capacidad entre capturas
+    for (size_t i = 0; i < site_live_.size(); ++i) {
+        if (site_live_[i].count == 0) continue;
+        peak_snap_.sites.push_back(SiteUsage{static_cast<SiteId>(i), site_live_[i].bytes, site_live_[i].count});
+    }
+
+    const uint64_t step = static_cast<uint64_t>(static_cast<double>(cur_b) * peak_margin_);
+    peak_capture_at_ = cur_b + std::max<uint64_t>(step, 1);
+}
+
+void MetricsAggregator::setPeakCapture(double margin) {
+    Locked lk(mtx_);
+    peak_margin_ = margin;
+    if (margin < 0) peak_capture_at_ = UINT64_MAX;
+    else            peak_capture_at_ = peak_snap_.id ? peak_snap_.bytes + std::max<uint64_t>(
+                                           static_cast<uint64_t>(static_cast<double>(peak_snap_.bytes) * margin), 1)
+                                                     : 1;
+}
+
+bool MetricsAggregator::getPeakSnapshot(HeapSnapshot& out, uint32_t newer_than) const {
+    Locked lk(mtx_);
+    if (peak_snap_.id == 0 || peak_snap_.id <= newer_than) return false;
+    out = peak_snap_;
+    return true;
 }
 
 MetricsAggregator::LeaksKPIs MetricsAggregator::getLeaksKPIs() const {
     LeaksKPIs k{};
-    std::lock_guard<std::mutex> lk(mtx_);
+    Locked lk(mtx_);
     computeLeaksKPIs_locked(now_ns(), k);
     return k;
 }
 
 void MetricsAggregator::setLeakThresholdMs(uint64_t ms) {
-    leak_threshold_ms_.store(ms, std::memory_order_relaxed);
+    Locked lk(mtx_);
+    if (leak_threshold_ms_.exchange(ms, std::memory_order_relaxed) == ms) return;
+    rebuildLeakIndex_locked();
 }
 uint64_t MetricsAggregator::getLeakThresholdMs() const {
     return leak_threshold_ms_.load(std::memory_order_relaxed);
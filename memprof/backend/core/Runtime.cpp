@@ -2,53 +2,59 @@
 #include <atomic>
 #include <thread>
 #include <chrono>
-#include <sstream>
-#include <iomanip>
 #include <vector>
 #include <unordered_map>
 #include <algorithm>
 #include <string>
+#include <string_view>
 #include <cstdint>
 #include <cstddef>
-
+#include <cstdlib>
+
+#if defined(_WIN32)
+  #ifndef NOMINMAX
+    #define NOMINMAX
+  #endif
+  #include <windows.h>
+#else
+  #include <unistd.h>
+#endif
+
+#include "memprof/memprof_api.h"
+#include "memprof/core/EventPipeline.h"
 #include "memprof/core/MetricsAggregator.h"
+#include "memprof/core/StackTable.h"
+#include "memprof/core/Symbolizer.h"
 #include "memprof/core/TcpClient.h"
-
-// --- helper: escapado JSON seguro para strings de ruta/tipo ---
-static std::string json_escape(const std::string& s) {
-    std::string out; out.reserve(s.size() + 8);
-    for (unsigned char c : s) {
-        switch (c) {
-            case '\"': out += "\\\""; break;
-            case '\\': out += "\\\\"; break;
-            case '\b': out += "\\b";  break;
-            case '\f': out += "\\f";  break;
-            case '\n': out += "\\n";  break;
-            case '\r': out += "\\r";  break;
-            case '\t': out += "\\t";  break;
-            default:
-                if (c < 0x20) {
-                    char buf[7];
-                    std::snprintf(buf, sizeof(buf), "\\u%04X", c);
-                    out += buf;
-                } else {
-                    out += static_cast<char>(c);
-                }
-        }
-    }
-    return out;
-}
+#include "memprof/core/TraceWriter.h"
+#include "memprof/proto/JsonWriter.h"
+#include "memprof/proto/WireFormat.h"
 
 // ---------------- Estado global ----------------
 static std::atomic<bool> g_running{false};
 static std::string       g_host   = "127.0.0.1";
 static int               g_port   = 7070;
+static std::string       g_trace_prefix;          // vacío = sin grabación
+static uint64_t          g_trace_segment = 0;     // 0 = TraceWriter::kDefaultSegmentBytes
+static bool              g_trace_set = false;     // fijado por API (prevalece sobre el entorno)
+static bool              g_peak_set  = false;     // idem para la captura en el pico
 
 using steady_clock_t = std::chrono::steady_clock;
 static steady_clock_t::time_point g_start_tp;
 
 static MetricsAggregator g_agg;
 
+// Los hooks solo escriben en el anillo de su hilo; el hilo consumidor de la
+// tubería entrega los lotes a g_agg.
+static EventPipeline& pipeline() {
+    static EventPipeline& p = [] () -> EventPipeline& {
+        EventPipeline& ep = EventPipeline::instance();
+        ep.addConsumer(&MetricsAggregator::consumeEvents, &g_agg);
+        return ep;
+    }();
+    return p;
+}
+
 static inline uint64_t now_ns() {
     return std::chrono::duration_cast<std::chrono::nanoseconds>(
                steady_clock_t::now().time_since_epoch()).count();
@@ -57,12 +63,584 @@ static inline uint64_t uptime_ms() {
     return std::chrono::duration_cast<std::chrono::milliseconds>(
                steady_clock_t::now() - g_start_tp).count();
 }
-static std::string ptr_to_hex(const void* p) {
-    std::ostringstream oss;
-    oss << "0x" << std::hex << std::uppercase
-        << std::setw(sizeof(void*)*2) << std::setfill('0')
-        << reinterpret_cast<std::uintptr_t>(p);
-    return oss.str();
+// ---------------- Snapshot por tick ----------------
+// Todo lo que se envía en un tick, calculado una vez y serializado en JSON
+// (depuración, estado completo) o en tramas binarias (ver
+// memprof/proto/WireFormat.h): un keyframe cada kKeyframeTicks y deltas
+// entre medias.
+static constexpr int kKeyframeTicks = 40;   // ~10 s a 250 ms/tick
+
+struct Tick {
+    uint64_t uptime_ms     = 0;
+    uint64_t heap_current  = 0;
+    uint64_t heap_peak     = 0;
+    uint64_t active_allocs = 0;
+    uint64_t total_allocs  = 0;
+    double   alloc_rate    = 0.0;
+    double   free_rate     = 0.0;
+    uint64_t sample_interval = 0;   // != 0: los agregados son estimaciones
+    uint64_t dropped_frames  = 0;   // tramas descartadas por la cola del cliente (GUI lenta)
+    MetricsAggregator::LeaksKPIs kpis;
+
+    std::vector<MetricsAggregator::TimelinePoint> timeline;
+    std::vector<MetricsAggregator::SizeBin> bins;   // clases de tamaño (vivos + acumulado)
+
+    // Solo JSON: estado completo
+    std::vector<MetricsAggregator::BlockInfo>     blocks;
+    std::vector<MetricsAggregator::CallSite>      sites;
+    std::unordered_map<std::string, MetricsAggregator::FileStats> perfile;
+
+    // Solo binario: cambios desde el tick anterior
+    MetricsAggregator::Delta delta;
+    size_t                   timeline_from = 0;   // primer punto aún no enviado
+
+    // Pilas (StackTable). JSON: agregados de todas; binario: delta.stacks.
+    // Direcciones de los ids [stacks_first, stacks_first + stack_depth.size())
+    std::vector<std::pair<uint32_t, MetricsAggregator::FileStats>> stacks;
+    uint32_t                 stacks_first = 1;
+    std::vector<uint32_t>    stack_depth;
+    std::vector<uintptr_t>   stack_pcs;        // concatenadas
+
+    // Direcciones ya simbolizadas (JSON: todas; binario: las nuevas)
+    Symbolizer::Batch        symbols;
+
+    // Snapshots con nombre (JSON: todos; binario: los nuevos)
+    std::vector<MetricsAggregator::HeapSnapshot> heap_snapshots;
+
+    // Última captura automática en el pico (id 0 = ninguna). Se conserva entre
+    // ticks; en binario solo sale si es nueva o en keyframe.
+    MetricsAggregator::HeapSnapshot peak_snapshot;
+    bool                            send_peak = false;
+
+    // Vidas por sitio (JSON: todas; binario: las cambiadas, todas en keyframe)
+    std::vector<MetricsAggregator::LifetimeStats> lifetimes;
+    uint64_t                                      short_lived_ns = 0;
+};
+
+// Pide al simbolizador las direcciones que van a salir en este tick: las de
+// los sitios sin file/line y las de las pilas. Lo ya pedido se ignora.
+static void request_symbols(const std::vector<MetricsAggregator::CallSite>& sites, const Tick& t) {
+    auto& sym = Symbolizer::instance();
+    for (const auto& s : sites)
+        if (s.pc) sym.request(&s.pc, 1);
+    if (!t.stack_pcs.empty()) sym.request(t.stack_pcs.data(), t.stack_pcs.size());
+}
+
+// Archivo:línea de una dirección ya simbolizada (MetricsAggregator::resolveCallerSites)
+static bool resolve_caller(uintptr_t pc, std::string& file, int& line) {
+    auto& sym = Symbolizer::instance();
+    Symbolizer::Symbol s;
+    if (!sym.lookup(pc, s)) return false;
+    file = sym.string(s.file);
+    line = s.line;
+    return true;
+}
+
+// Añade al tick las direcciones de la pila 'id'
+static void append_stack_frames(uint32_t id, Tick& t) {
+    uintptr_t pcs[StackTable::kMaxDepth];
+    const size_t n = StackTable::instance().frames(id, pcs, StackTable::kMaxDepth);
+    t.stack_depth.push_back(static_cast<uint32_t>(n));
+    t.stack_pcs.insert(t.stack_pcs.end(), pcs, pcs + n);
+}
+
+// file/type de cada sitio, escapados una vez por tick (no por bloque). Los
+// buffers se reutilizan entre ticks.
+struct JsonSites {
+    std::string           text;
+    std::vector<uint32_t> off;   // sitio i: file = [off[2i], off[2i+1]), type = [off[2i+1], off[2i+2])
+
+    void build(const std::vector<MetricsAggregator::CallSite>& sites) {
+        text.clear();
+        off.clear();
+        json::Writer w(text);
+        off.push_back(0);
+        for (const auto& cs : sites) {
+            w.escape(cs.file); off.push_back(static_cast<uint32_t>(text.size()));
+            w.escape(cs.type); off.push_back(static_cast<uint32_t>(text.size()));
+        }
+    }
+    std::string_view file(size_t i) const { return {text.data() + off[2 * i], off[2 * i + 1] - off[2 * i]}; }
+    std::string_view type(size_t i) const { return {text.data() + off[2 * i + 1], off[2 * i + 2] - off[2 * i + 1]}; }
+};
+
+static void write_json(const Tick& t, JsonSites& js, std::string& out) {
+    out.clear();
+    json::Writer w(out);
+    js.build(t.sites);
+
+    // "k":"texto ya escapado" / "k":"0x..." (pc de un sitio, si tiene)
+    auto esc = [&](std::string_view k, std::string_view v) { w.key(k); w.ch('"'); w.raw(v); w.ch('"'); };
+    auto site_fields = [&](size_t site) {
+        if (t.sites[site].pc) { w.key("pc"); w.hex(t.sites[site].pc); w.ch(','); }
+        esc("file", js.file(site));           w.ch(',');
+        w.key("line"); w.i64(t.sites[site].line); w.ch(',');
+        esc("type", js.type(site));
+    };
+
+    w.ch('{');
+
+    // general + KPIs + tasas
+    w.raw("\"general\":{");
+    w.key("uptime_ms");       w.u64(t.uptime_ms);                          w.ch(',');
+    w.key("heap_current");    w.u64(t.heap_current);                       w.ch(',');
+    w.key("heap_peak");       w.u64(t.heap_peak);                          w.ch(',');
+    w.key("active_allocs");   w.u64(t.active_allocs);                      w.ch(',');
+    w.key("alloc_rate");      w.f64(t.alloc_rate);                         w.ch(',');
+    w.key("free_rate");       w.f64(t.free_rate);                          w.ch(',');
+    w.key("total_allocs");    w.u64(t.total_allocs);                       w.ch(',');
+    w.key("leak_bytes");      w.u64(t.kpis.total_leak_bytes);              w.ch(',');
+    w.key("leak_rate");       w.f64(t.kpis.leak_rate);                     w.ch(',');
+    w.key("largest_size");    w.u64(t.kpis.largest.size);                  w.ch(',');
+    w.key("largest_file");    w.str(t.kpis.largest.file);                  w.ch(',');
+    w.key("top_file");        w.str(t.kpis.top_file_by_leaks.file);        w.ch(',');
+    w.key("top_file_count");  w.u64(t.kpis.top_file_by_leaks.count);      w.ch(',');
+    w.key("top_file_bytes");  w.u64(t.kpis.top_file_by_leaks.bytes);      w.ch(',');
+    w.key("sample_interval"); w.u64(t.sample_interval);                    w.ch(',');
+    w.key("dropped_frames");  w.u64(t.dropped_frames);
+    w.raw("},");
+
+    // per_file
+    w.raw("\"per_file\":[");
+    bool first = true;
+    for (const auto& kv : t.perfile) {
+        const auto& fs = kv.second;
+        const uint64_t frees = (fs.alloc_count >= fs.live_count)
+                               ? (fs.alloc_count - fs.live_count) : 0ULL;
+        if (!first) w.ch(',');
+        first = false;
+        w.ch('{');
+        w.key("file");       w.str(kv.first);      w.ch(',');
+        w.key("totalBytes"); w.u64(fs.alloc_bytes); w.ch(',');
+        w.key("allocs");     w.u64(fs.alloc_count); w.ch(',');
+        w.key("frees");      w.u64(frees);          w.ch(',');
+        w.key("netBytes");   w.u64(fs.live_bytes);
+        w.ch('}');
+    }
+    w.raw("],");
+
+    // bins
+    w.raw("\"bins\":[");
+    for (size_t i = 0; i < t.bins.size(); ++i) {
+        const auto& b = t.bins[i];
+        if (i) w.ch(',');
+        w.ch('{');
+        w.key("lo");          w.u64(b.lo);          w.ch(',');
+        w.key("hi");          w.u64(b.hi);          w.ch(',');
+        w.key("bytes");       w.u64(b.bytes);       w.ch(',');
+        w.key("allocations"); w.u64(b.count);       w.ch(',');
+        w.key("alloc_bytes"); w.u64(b.alloc_bytes); w.ch(',');
+        w.key("alloc_count"); w.u64(b.alloc_count);
+        w.ch('}');
+    }
+    w.raw("],");
+
+    // leaks (bloques vivos) + is_leak (decidido por el agregador)
+    w.raw("\"leaks\":[");
+    for (size_t i = 0; i < t.blocks.size(); ++i) {
+        const auto& b = t.blocks[i];
+        const size_t site = b.site < t.sites.size() ? b.site : 0;
+        if (i) w.ch(',');
+        w.ch('{');
+        w.key("ptr");     w.hex(b.ptr);       w.ch(',');
+        w.key("size");    w.u64(b.size);      w.ch(',');
+        site_fields(site);                    w.ch(',');
+        w.key("ts_ns");   w.u64(b.ts_ns);     w.ch(',');
+        w.key("is_leak"); w.boolean(b.is_leak); w.ch(',');
+        w.key("stack");   w.u64(b.stack);
+        w.ch('}');
+    }
+    w.raw("],");
+
+    // stacks: agregados por pila + sus direcciones (ids de StackTable)
+    w.raw("\"stacks\":[");
+    for (size_t i = 0, off = 0; i < t.stacks.size(); ++i) {
+        const auto& fs = t.stacks[i].second;
+        if (i) w.ch(',');
+        w.ch('{');
+        w.key("id"); w.u64(t.stacks[i].first); w.ch(',');
+        w.key("frames");
+        w.ch('[');
+        const uint32_t depth = t.stack_depth[i];
+        for (uint32_t k = 0; k < depth; ++k) {
+            if (k) w.ch(',');
+            w.hex(t.stack_pcs[off + k]);
+        }
+        off += depth;
+        w.raw("],");
+        w.key("allocs");     w.u64(fs.alloc_count); w.ch(',');
+        w.key("totalBytes"); w.u64(fs.alloc_bytes); w.ch(',');
+        w.key("live_count"); w.u64(fs.live_count);  w.ch(',');
+        w.key("live_bytes"); w.u64(fs.live_bytes);  w.ch(',');
+        w.key("leak_count"); w.u64(fs.leak_count);  w.ch(',');
+        w.key("leak_bytes"); w.u64(fs.leak_bytes);
+        w.ch('}');
+    }
+    w.raw("],");
+
+    // symbols: direcciones resueltas (sitios sin file/line y marcos de pila)
+    w.raw("\"symbols\":[");
+    const auto& sb = t.symbols;
+    auto sym_str = [&sb](uint32_t id) -> std::string_view {
+        return id >= sb.first_string && id - sb.first_string < sb.strings.size()
+             ? std::string_view(sb.strings[id - sb.first_string]) : std::string_view();
+    };
+    for (size_t i = 0; i < sb.symbols.size(); ++i) {
+        const auto& [pc, sym] = sb.symbols[i];
+        if (i) w.ch(',');
+        w.ch('{');
+        w.key("pc");       w.hex(pc);                    w.ch(',');
+        w.key("function"); w.str(sym_str(sym.function)); w.ch(',');
+        w.key("file");     w.str(sym_str(sym.file));     w.ch(',');
+        w.key("line");     w.i64(sym.line);
+        w.ch('}');
+    }
+    w.raw("],");
+
+    // heap_snapshots: snapshots con nombre, una fila por sitio
+    auto heap_snapshot = [&](const MetricsAggregator::HeapSnapshot& hs) {
+        w.ch('{');
+        w.key("id");    w.u64(hs.id);                   w.ch(',');
+        w.key("label"); w.str(hs.label);                w.ch(',');
+        w.key("t_ms");  w.u64(hs.t_ns / 1'000'000ULL);  w.ch(',');
+        w.key("bytes"); w.u64(hs.bytes);                w.ch(',');
+        w.key("count"); w.u64(hs.count);                w.ch(',');
+        w.raw("\"sites\":[");
+        for (size_t k = 0; k < hs.sites.size(); ++k) {
+            const auto& u = hs.sites[k];
+            if (k) w.ch(',');
+            w.ch('{');
+            site_fields(u.site < t.sites.size() ? u.site : 0); w.ch(',');
+            w.key("bytes"); w.u64(u.bytes);                   w.ch(',');
+            w.key("count"); w.u64(u.count);
+            w.ch('}');
+        }
+        w.raw("]}");
+    };
+    w.raw("\"heap_snapshots\":[");
+    for (size_t i = 0; i < t.heap_snapshots.size(); ++i) {
+        if (i) w.ch(',');
+        heap_snapshot(t.heap_snapshots[i]);
+    }
+    w.raw("],");
+
+    // lifetimes: vida de los bloques liberados, por sitio
+    w.raw("\"lifetimes\":{");
+    w.key("short_ns"); w.u64(t.short_lived_ns);
+    w.raw(",\"sites\":[");
+    for (size_t i = 0; i < t.lifetimes.size(); ++i) {
+        const auto& l = t.lifetimes[i];
+        if (i) w.ch(',');
+        w.ch('{');
+        site_fields(l.site < t.sites.size() ? l.site : 0); w.ch(',');
+        w.key("frees");  w.u64(l.frees);        w.ch(',');
+        w.key("bytes");  w.u64(l.freed_bytes);  w.ch(',');
+        w.key("short");  w.u64(l.short_lived);  w.ch(',');
+        w.key("p50_ns"); w.u64(l.p50_ns);       w.ch(',');
+        w.key("p99_ns"); w.u64(l.p99_ns);
+        w.ch('}');
+    }
+    w.raw("]},");
+
+    // peak_snapshot: desglose por sitio de la última captura en el pico
+    w.key("peak_snapshot");
+    if (t.peak_snapshot.id) heap_snapshot(t.peak_snapshot);
+    else                    w.raw("null");
+    w.ch(',');
+
+    // timeline: [t_ms, heap_bytes]
+    w.raw("\"timeline\":[");
+    for (size_t i = 0; i < t.timeline.size(); ++i) {
+        const auto& p = t.timeline[i];
+        if (i) w.ch(',');
+        w.ch('[');
+        w.u64(p.t_ns / 1'000'000ULL); w.ch(',');
+        w.u64(p.cur_bytes);
+        w.ch(']');
+    }
+    w.ch(']');
+
+    w.ch('}');
+}
+
+// Tabla de strings de una trama: cada ruta/tipo se envía una vez
+class StringTable {
+public:
+    uint32_t id(const std::string& s) {
+        auto it = index_.find(s);
+        if (it != index_.end()) return it->second;
+        const auto id = static_cast<uint32_t>(order_.size());
+        order_.push_back(&s);
+        index_.emplace(s, id);
+        return id;
+    }
+    const std::vector<const std::string*>& order() const { return order_; }
+
+private:
+    std::unordered_map<std::string_view, uint32_t> index_;
+    std::vector<const std::string*>                order_;
+};
+
+static void write_binary(const Tick& t, std::string& out) {
+    out.clear();
+    wire::Writer w(out);
+    const auto& d = t.delta;
+
+    // Ids de string primero: la sección Strings tiene que ir delante
+    StringTable strings;
+    std::vector<std::pair<uint32_t, uint32_t>> site_ids(d.new_sites.size());
+    for (size_t i = 0; i < d.new_sites.size(); ++i)
+        site_ids[i] = { strings.id(d.new_sites[i].file), strings.id(d.new_sites[i].type) };
+    std::vector<uint32_t> file_ids;
+    file_ids.reserve(d.files.size());
+    for (const auto& kv : d.files) file_ids.push_back(strings.id(kv.first));
+    const uint32_t largest_file = strings.id(t.kpis.largest.file);
+    const uint32_t top_file     = strings.id(t.kpis.top_file_by_leaks.file);
+
+    const size_t frame = w.beginFrame(d.keyframe ? wire::Kind::Snapshot : wire::Kind::Delta);
+
+    size_t sec = w.beginSection(wire::Section::Epoch);
+    w.varint(d.epoch);
+    w.varint(d.base_epoch);
+    w.endSection(sec);
+
+    sec = w.beginSection(wire::Section::Strings);
+    w.varint(strings.order().size());
+    for (const std::string* s : strings.order()) w.bytes(*s);
+    w.endSection(sec);
+
+    sec = w.beginSection(wire::Section::Sites);
+    w.varint(d.first_site);
+    w.varint(d.new_sites.size());
+    for (size_t i = 0; i < d.new_sites.size(); ++i) {
+        w.varint(site_ids[i].first);
+        w.zigzag(d.new_sites[i].line);
+        w.varint(site_ids[i].second);
+    }
+    w.endSection(sec);
+
+    // Dirección del llamador de los sitios nuevos sin file/line (antes de Blocks)
+    size_t site_pcs = 0;
+    for (const auto& s : d.new_sites) site_pcs += s.pc != 0;
+    if (site_pcs) {
+        sec = w.beginSection(wire::Section::SitePcs);
+        w.varint(site_pcs);
+        for (size_t i = 0; i < d.new_sites.size(); ++i) {
+            if (!d.new_sites[i].pc) continue;
+            w.varint(d.first_site + i);
+            w.varint(d.new_sites[i].pc);
+        }
+        w.endSection(sec);
+    }
+
+    sec = w.beginSection(wire::Section::General);
+    w.varint(t.uptime_ms);
+    w.varint(t.heap_current);
+    w.varint(t.heap_peak);
+    w.varint(t.active_allocs);
+    w.varint(t.total_allocs);
+    w.varint(t.kpis.total_leak_bytes);
+    w.f64(t.alloc_rate);
+    w.f64(t.free_rate);
+    w.f64(t.kpis.leak_rate);
+    w.varint(t.kpis.largest.size);
+    w.varint(largest_file);
+    w.varint(top_file);
+    w.varint(t.kpis.top_file_by_leaks.count);
+    w.varint(t.kpis.top_file_by_leaks.bytes);
+    w.varint(t.sample_interval);
+    w.varint(t.dropped_frames);
+    w.endSection(sec);
+
+    sec = w.beginSection(wire::Section::PerFile);
+    w.varint(d.files.size());
+    for (size_t i = 0; i < d.files.size(); ++i) {
+        const auto& fs = d.files[i].second;
+        w.varint(file_ids[i]);
+        w.varint(fs.alloc_bytes);
+        w.varint(fs.alloc_count);
+        w.varint(fs.alloc_count >= fs.live_count ? fs.alloc_count - fs.live_count : 0);
+        w.varint(fs.live_bytes);
+    }
+    w.endSection(sec);
+
+    sec = w.beginSection(wire::Section::Bins);
+    w.varint(t.bins.size());
+    for (const auto& b : t.bins) {
+        w.varint(b.lo);
+        w.varint(b.hi);
+        w.varint(b.bytes);
+        w.varint(b.count);
+    }
+    w.endSection(sec);
+    sec = w.beginSection(wire::Section::AllocBins);
+    w.varint(t.bins.size());
+    for (const auto& b : t.bins) {
+        w.varint(b.alloc_bytes);
+        w.varint(b.alloc_count);
+    }
+    w.endSection(sec);
+
+    if (!t.stack_depth.empty()) {
+        sec = w.beginSection(wire::Section::StackFrames);
+        w.varint(t.stacks_first);
+        w.varint(t.stack_depth.size());
+        for (size_t i = 0, off = 0; i < t.stack_depth.size(); ++i) {
+            w.varint(t.stack_depth[i]);
+            for (uint32_t k = 0; k < t.stack_depth[i]; ++k) w.varint(t.stack_pcs[off + k]);
+            off += t.stack_depth[i];
+        }
+        w.endSection(sec);
+    }
+
+    if (!d.stacks.empty()) {
+        sec = w.beginSection(wire::Section::PerStack);
+        w.varint(d.stacks.size());
+        for (const auto& kv : d.stacks) {
+            const auto& fs = kv.second;
+            w.varint(kv.first);
+            w.varint(fs.alloc_bytes);
+            w.varint(fs.alloc_count);
+            w.varint(fs.live_count);
+            w.varint(fs.live_bytes);
+            w.varint(fs.leak_count);
+            w.varint(fs.leak_bytes);
+        }
+        w.endSection(sec);
+    }
+
+    sec = w.beginSection(wire::Section::Blocks);
+    w.varint(d.upserts.size());
+    for (const auto& b : d.upserts) {
+        w.varint(b.ptr);
+        w.varint(b.size);
+        w.varint(b.site);
+        w.varint(b.ts_ns);
+        w.u8(static_cast<uint8_t>((b.is_leak ? wire::BlockLeak : 0) | (b.is_array ? wire::BlockArray : 0) |
+                                  (b.stack ? wire::BlockStack : 0)));
+        if (b.stack) w.varint(b.stack);
+    }
+    w.endSection(sec);
+
+    // Símbolos: cadenas nuevas del simbolizador y direcciones resueltas
+    const auto& sb = t.symbols;
+    if (!sb.strings.empty()) {
+        sec = w.beginSection(wire::Section::SymbolStrings);
+        w.varint(sb.first_string);
+        w.varint(sb.strings.size());
+        for (const auto& s : sb.strings) w.bytes(s);
+        w.endSection(sec);
+    }
+    if (!sb.symbols.empty()) {
+        sec = w.beginSection(wire::Section::Symbols);
+        w.varint(sb.symbols.size());
+        for (const auto& [pc, s] : sb.symbols) {
+            w.varint(pc);
+            w.varint(s.function);
+            w.varint(s.file);
+            w.zigzag(s.line);
+        }
+        w.endSection(sec);
+    }
+    auto site_usage = [&w](const std::vector<MetricsAggregator::SiteUsage>& sites) {
+        w.varint(sites.size());
+        MetricsAggregator::SiteId prev = 0;
+        for (const auto& u : sites) {
+            w.varint(u.site - prev);
+            w.varint(u.bytes);
+            w.varint(u.count);
+            prev = u.site;
+        }
+    };
+    if (!t.heap_snapshots.empty()) {
+        sec = w.beginSection(wire::Section::HeapSnapshots);
+        w.varint(t.heap_snapshots.size());
+        for (const auto& hs : t.heap_snapshots) {
+            w.varint(hs.id);
+            w.bytes(hs.label);
+            w.varint(hs.t_ns / 1'000'000ULL);
+            w.varint(hs.bytes);
+            w.varint(hs.count);
+            site_usage(hs.sites);
+        }
+        w.endSection(sec);
+    }
+    if (!t.lifetimes.empty()) {
+        sec = w.beginSection(wire::Section::Lifetimes);
+        w.varint(t.short_lived_ns);
+        w.varint(t.lifetimes.size());
+        for (const auto& l : t.lifetimes) {
+            w.varint(l.site);
+            w.varint(l.frees);
+            w.varint(l.freed_bytes);
+            w.varint(l.short_lived);
+            w.varint(l.p50_ns);
+            w.varint(l.p99_ns);
+        }
+        w.endSection(sec);
+    }
+    if (t.send_peak) {
+        const auto& ps = t.peak_snapshot;
+        sec = w.beginSection(wire::Section::PeakSnapshot);
+        w.varint(ps.id);
+        w.varint(ps.t_ns / 1'000'000ULL);
+        w.varint(ps.bytes);
+        w.varint(ps.count);
+        site_usage(ps.sites);
+        w.endSection(sec);
+    }
+    if (!d.removed.empty()) {
+        sec = w.beginSection(wire::Section::Removed);
+        w.varint(d.removed.size());
+        uintptr_t prev = 0;
+        for (uintptr_t p : d.removed) { w.varint(p - prev); prev = p; }   // ya ordenados
+        w.endSection(sec);
+    }
+
+    sec = w.beginSection(wire::Section::Timeline);
+    const size_t from = t.timeline_from < t.timeline.size() ? t.timeline_from : t.timeline.size();
+    w.varint(t.timeline.size() - from);
+    uint64_t prev_ms = 0;
+    for (size_t i = from; i < t.timeline.size(); ++i) {
+        const uint64_t t_ms = t.timeline[i].t_ns / 1'000'000ULL;
+        w.varint(t_ms - prev_ms);
+        w.varint(t.timeline[i].cur_bytes);
+        prev_ms = t_ms;
+    }
+    w.endSection(sec);
+
+    w.endFrame(frame);
+}
+
+// MEMPROF_WIRE_FORMAT=json -> una línea JSON por tick (depuración)
+static bool wire_json_requested() {
+    const char* v = std::getenv("MEMPROF_WIRE_FORMAT");
+    return v && std::string_view(v) == "json";
+}
+
+// Identidad del proceso para el saludo (trama Hello): pid y binario sin ruta
+static uint64_t process_id() {
+#if defined(_WIN32)
+    return GetCurrentProcessId();
+#else
+    return static_cast<uint64_t>(::getpid());
+#endif
+}
+
+static std::string process_name() {
+    std::string path;
+#if defined(_WIN32)
+    char buf[MAX_PATH];
+    path.assign(buf, GetModuleFileNameA(nullptr, buf, sizeof(buf)));
+#elif defined(__APPLE__)
+    if (const char* p = getprogname()) path = p;
+#else
+    char buf[4096];
+    const ssize_t n = ::readlink("/proc/self/exe", buf, sizeof(buf));
+    if (n > 0) path.assign(buf, static_cast<size_t>(n));
+#endif
+    const size_t slash = path.find_last_of("/\\");
+    return slash == std::string::npos ? path : path.substr(slash + 1);
 }
 
 // ========== API pública que invocan wrappers/overrides ==========
@@ -70,20 +648,48 @@ extern "C" {
 
 void memprof_record_alloc(void* ptr, std::size_t sz, const char* file, int line) {
     if (!ptr) return;
-    g_agg.onAlloc(
-        ptr_to_hex(ptr),
-        static_cast<uint64_t>(sz),
-        now_ns(),
-        file ? std::string(file) : std::string("unknown"),
-        line,
-        "global_new",
-        false /*is_array*/
-    );
+    pipeline().pushAlloc(ptr, static_cast<uint64_t>(sz), file ? file : "unknown", line,
+                         "global_new", false /*is_array*/);
+}
+
+void memprof_record_alloc_ex(void* ptr, std::size_t sz, const char* file, int line, const char* type) {
+    if (!ptr) return;
+    pipeline().pushAlloc(ptr, static_cast<uint64_t>(sz), file ? file : "unknown", line,
+                         type ? type : "global_new", false /*is_array*/);
+}
+
+void memprof_record_alloc_pc(void* ptr, std::size_t sz, const char* type, const void* caller) {
+    if (!ptr) return;
+    pipeline().pushAlloc(ptr, static_cast<uint64_t>(sz), nullptr, 0, type ? type : "global_new",
+                         false /*is_array*/, caller);
 }
 
 void memprof_record_free(void* ptr) {
     if (!ptr) return;
-    g_agg.onFree(ptr_to_hex(ptr), /*hinted_size*/0);
+    pipeline().pushFree(ptr);
+}
+
+void memprof_set_sample_interval(std::size_t mean_bytes) {
+    pipeline().setSampleInterval(mean_bytes);
+}
+
+void memprof_set_trace_file(const char* path_prefix, std::size_t segment_bytes) {
+    EventPipeline::ScopedSuppress quiet;
+    g_trace_prefix  = path_prefix ? path_prefix : "";
+    g_trace_segment = segment_bytes;
+    g_trace_set     = true;
+}
+
+void memprof_set_peak_capture(double margin) {
+    g_peak_set = true;
+    g_agg.setPeakCapture(margin);
+}
+
+unsigned memprof_take_snapshot(const char* label) {
+    EventPipeline::ScopedSuppress quiet;
+    // Lo encolado hasta ahora tiene que estar en el agregador
+    pipeline().drain(true);
+    return g_agg.takeSnapshot(label ? label : "");
 }
 
 int memprof_init(const char* host, int port) {
@@ -92,8 +698,44 @@ int memprof_init(const char* host, int port) {
     g_start_tp = steady_clock_t::now();
     g_running.store(true, std::memory_order_relaxed);
 
+    // Grabación a disco: se registra antes de arrancar el consumidor para que
+    // también se vuelque lo encolado antes de memprof_init
+    if (!g_trace_set) {
+        EventPipeline::ScopedSuppress quiet;
+        if (const char* t = std::getenv("MEMPROF_TRACE")) g_trace_prefix = t;
+        if (const char* mb = std::getenv("MEMPROF_TRACE_SEGMENT_MB"))
+            g_trace_segment = std::strtoull(mb, nullptr, 10) << 20;
+    }
+    if (!g_peak_set) {
+        // MEMPROF_PEAK_MARGIN=0.1 (fracción; "off" o negativo la desactiva)
+        if (const char* m = std::getenv("MEMPROF_PEAK_MARGIN"))
+            g_agg.setPeakCapture(std::string_view(m) == "off" ? -1.0 : std::strtod(m, nullptr));
+    }
+    if (const char* sl = std::getenv("MEMPROF_SHORT_LIVED_US"))
+        g_agg.setShortLivedNs(std::strtoull(sl, nullptr, 10) * 1000ULL);
+    if (!g_trace_prefix.empty()) {
+        TraceWriter& tw = TraceWriter::instance();
+        if (tw.open(g_trace_prefix, g_trace_segment ? g_trace_segment : TraceWriter::kDefaultSegmentBytes))
+            pipeline().addConsumer(&TraceWriter::consumeEvents, &tw);
+    }
+
+    pipeline().start();
+    Symbolizer::instance().start();
+
     std::thread([]{
+        EventPipeline::ScopedSuppress quiet;   // el sender no se mide a sí mismo
         TcpClient client;
+        const bool as_json = wire_json_requested();
+        Tick tick;
+        std::string out;                        // se reutiliza entre ticks
+        std::string hello;                      // saludo de cada conexión
+        wire::writeHello(hello, process_id(), process_name());
+        JsonSites json_sites;                   // idem (modo JSON)
+        bool     need_keyframe = true;          // tras (re)conectar
+        int      since_keyframe = 0;
+        uint64_t last_sent_t_ns = 0;            // último punto de timeline enviado
+        uint32_t stacks_sent = 1;               // primer id de pila sin enviar
+        uint32_t snaps_sent = 0;                // primer id de snapshot sin enviar
 
         // --- estado previo para tasas ---
         uint64_t prev_total_allocs = 0;
@@ -103,31 +745,89 @@ int memprof_init(const char* host, int port) {
         while (g_running.load(std::memory_order_relaxed)) {
             if (!client.isConnected()) {
                 client.close();
-                client.connectTo(g_host.c_str(), g_port);
-                if (!client.isConnected()) {
-                    std::this_thread::sleep_for(std::chrono::milliseconds(250));
+                if (!client.connectTo(g_host.c_str(), g_port)) {
+                    // Espera creciente (250 ms .. 8 s) mientras no haya GUI
+                    std::this_thread::sleep_for(std::chrono::milliseconds(client.retryDelayMs()));
                     continue;
                 }
+                // Antes que cualquier trama: la GUI separa los procesos por él
+                if (!client.sendAll(hello.data(), hello.size())) {
+                    client.close();
+                    std::this_thread::sleep_for(std::chrono::milliseconds(client.retryDelayMs()));
+                    continue;
+                }
+                need_keyframe = true;
             }
+            const auto tick_end = steady_clock_t::now() + std::chrono::milliseconds(250);
 
             // ----- snapshot del agregador -----
-            const auto timeline = g_agg.getTimeline();
-            const auto blocks   = g_agg.getBlocks();
-            const auto perfile  = g_agg.getFileStats();
-
-            uint64_t heap_current = 0;
-            if (!timeline.empty()) heap_current = timeline.back().cur_bytes;
-            else for (const auto& b : blocks) heap_current += b.size;
-
-            uint64_t heap_peak = 0;
-            for (const auto& p : timeline) heap_peak = std::max(heap_peak, p.cur_bytes);
-
-            const uint64_t active_allocs = static_cast<uint64_t>(blocks.size());
-
-            MetricsAggregator::LeaksKPIs kpis = g_agg.getLeaksKPIs();
-
-            uint64_t total_allocs = 0;
-            for (const auto& kv : perfile) total_allocs += kv.second.alloc_count;
+            // Sitios por dirección ya simbolizados: sus filas pasan a su archivo
+            g_agg.resolveCallerSites(&resolve_caller);
+            uint64_t leak_bytes = 0;
+            g_agg.getMetrics(tick.heap_current, tick.heap_peak, tick.active_allocs,
+                             tick.total_allocs, leak_bytes);
+            tick.kpis      = g_agg.getLeaksKPIs();
+            tick.timeline  = g_agg.getTimeline();
+            tick.uptime_ms = uptime_ms();
+            tick.sample_interval = pipeline().sampleInterval();
+            tick.short_lived_ns  = g_agg.getShortLivedNs();
+
+            if (as_json) {
+                // Antes que getSites: un snapshot solo usa sitios ya internados
+                tick.heap_snapshots = g_agg.getSnapshots();
+                g_agg.getPeakSnapshot(tick.peak_snapshot, tick.peak_snapshot.id);
+                tick.blocks  = g_agg.getBlocks();
+                tick.perfile = g_agg.getFileStats();
+                tick.sites   = g_agg.getSites();
+                g_agg.collectLifetimeStats(tick.lifetimes, true, static_cast<uint32_t>(tick.sites.size()));
+                tick.stacks  = g_agg.getStackStats();
+                tick.stack_depth.clear();
+                tick.stack_pcs.clear();
+                for (const auto& kv : tick.stacks) append_stack_frames(kv.first, tick);
+                request_symbols(tick.sites, tick);
+                Symbolizer::instance().collect(tick.symbols, true);
+            } else {
+                const bool key = need_keyframe || ++since_keyframe >= kKeyframeTicks;
+                // Antes que collectDelta, por lo mismo que en JSON (los sitios
+                // que usen ya van en esta trama o en una anterior)
+                tick.heap_snapshots = g_agg.getSnapshots(key ? 0 : snaps_sent);
+                if (!tick.heap_snapshots.empty()) snaps_sent = tick.heap_snapshots.back().id + 1;
+                const bool new_peak = g_agg.getPeakSnapshot(tick.peak_snapshot, tick.peak_snapshot.id);
+                g_agg.collectDelta(tick.delta, key);
+                if (tick.delta.keyframe && !key) {
+                    // Keyframe impuesto por el agregador: van todos, pero solo
+                    // los tomados antes de collectDelta
+                    tick.heap_snapshots = g_agg.getSnapshots();
+                    while (!tick.heap_snapshots.empty() && tick.heap_snapshots.back().id >= snaps_sent)
+                        tick.heap_snapshots.pop_back();
+                }
+                if (tick.delta.keyframe) { since_keyframe = 0; last_sent_t_ns = 0; stacks_sent = 1; }
+                tick.send_peak = tick.peak_snapshot.id && (new_peak || tick.delta.keyframe);
+                // Solo sitios ya enviados (en esta trama o antes)
+                g_agg.collectLifetimeStats(tick.lifetimes, tick.delta.keyframe,
+                                           tick.delta.first_site + static_cast<uint32_t>(tick.delta.new_sites.size()));
+                // Pilas nuevas: todo id usado por un bloque ya está publicado
+                const uint32_t stacks_end = StackTable::instance().published();
+                tick.stacks_first = stacks_sent;
+                tick.stack_depth.clear();
+                tick.stack_pcs.clear();
+                for (uint32_t id = stacks_sent; id < stacks_end; ++id) append_stack_frames(id, tick);
+                stacks_sent = stacks_end;
+                // Lo pedido ahora sale en un tick posterior (el simbolizador es asíncrono)
+                request_symbols(tick.delta.new_sites, tick);
+                Symbolizer::instance().collect(tick.symbols, tick.delta.keyframe);
+                std::sort(tick.delta.removed.begin(), tick.delta.removed.end());
+                // Timeline: en deltas solo los puntos posteriores al último enviado
+                const auto& tl = tick.timeline;
+                tick.timeline_from = static_cast<size_t>(
+                    std::upper_bound(tl.begin(), tl.end(), last_sent_t_ns,
+                                     [](uint64_t t, const MetricsAggregator::TimelinePoint& p) { return t < p.t_ns; })
+                    - tl.begin());
+                if (!tl.empty()) last_sent_t_ns = tl.back().t_ns;
+                need_keyframe = false;
+            }
+            const uint64_t active_allocs = tick.active_allocs;
+            const uint64_t total_allocs  = tick.total_allocs;
 
             // --- tasas alloc/free (aprox) ---
             const auto now_tp = steady_clock_t::now();
@@ -138,126 +838,32 @@ int memprof_init(const char* host, int port) {
             const int64_t d_active = (int64_t)active_allocs - (int64_t)prev_active;
             const int64_t d_frees  = d_allocs - d_active; // frees ≈ allocs - delta(live)
 
-            const double alloc_rate = d_allocs > 0 ? (double)d_allocs / dt_s : 0.0;
-            const double free_rate  = d_frees  > 0 ? (double)d_frees  / dt_s : 0.0;
+            tick.alloc_rate = d_allocs > 0 ? (double)d_allocs / dt_s : 0.0;
+            tick.free_rate  = d_frees  > 0 ? (double)d_frees  / dt_s : 0.0;
 
             prev_total_allocs = total_allocs;
             prev_active       = active_allocs;
             prev_tp           = now_tp;
 
-            // --- bins por tamaño (potencias de 2) ---
-            struct Bin { uint64_t lo, hi, bytes, allocations; };
-            std::vector<uint64_t> edges;
-            for (uint64_t v = 1; v <= (1ull<<30); v <<= 1) edges.push_back(v);
-            edges.push_back(UINT64_C(1) << 62);
-            std::vector<Bin> bins(edges.size());
-            for (size_t i = 0; i < bins.size(); ++i) {
-                bins[i].lo = (i == 0 ? 0ULL : edges[i-1]);
-                bins[i].hi = edges[i];
-                bins[i].bytes = 0;
-                bins[i].allocations = 0;
-            }
-            auto pick_bin = [&](uint64_t sz)->size_t {
-                for (size_t i = 0; i < bins.size(); ++i)
-                    if (sz >= bins[i].lo && sz < bins[i].hi) return i;
-                return bins.size() - 1;
-            };
-            for (const auto& b : blocks) {
-                auto bi = pick_bin(b.size);
-                bins[bi].bytes += b.size;
-                bins[bi].allocations += 1;
-            }
-
-            // ----- JSON -----
-            std::ostringstream ss;
-            ss << '{';
-
-            // general + KPIs + tasas
-            ss << "\"general\":{"
-               << "\"uptime_ms\":"      << uptime_ms()      << ','
-               << "\"heap_current\":"   << heap_current     << ','
-               << "\"heap_peak\":"      << heap_peak        << ','
-               << "\"active_allocs\":"  << active_allocs    << ','
-               << "\"alloc_rate\":"     << alloc_rate       << ','
-               << "\"free_rate\":"      << free_rate        << ','
-               << "\"total_allocs\":"   << total_allocs     << ','
-               << "\"leak_bytes\":"     << kpis.total_leak_bytes << ','
-               << "\"leak_rate\":"      << kpis.leak_rate         << ','
-               << "\"largest_size\":"   << kpis.largest.size      << ','
-               << "\"largest_file\":\"" << json_escape(kpis.largest.file) << "\","
-               << "\"top_file\":\""     << json_escape(kpis.top_file_by_leaks.file) << "\","
-               << "\"top_file_count\":" << kpis.top_file_by_leaks.count  << ','
-               << "\"top_file_bytes\":" << kpis.top_file_by_leaks.bytes
-               << "},";
-
-            // per_file
-            ss << "\"per_file\":[";
-            bool first = true;
-            for (const auto& kv : perfile) {
-                const auto& file = kv.first;
-                const auto& fs   = kv.second;
-                const uint64_t frees = (fs.alloc_count >= fs.live_count)
-                                       ? (fs.alloc_count - fs.live_count) : 0ULL;
-                if (!first) ss << ',';
-                first = false;
-                ss << '{'
-                   << "\"file\":\""     << json_escape(file) << "\","
-                   << "\"totalBytes\":" << fs.alloc_bytes << ','
-                   << "\"allocs\":"     << fs.alloc_count << ','
-                   << "\"frees\":"      << frees          << ','
-                   << "\"netBytes\":"   << fs.live_bytes
-                   << '}';
-            }
-            ss << "],";
-
-            // bins
-            ss << "\"bins\":[";
-            for (size_t i = 0; i < bins.size(); ++i) {
-                if (i) ss << ',';
-                ss << '{'
-                   << "\"lo\":"          << bins[i].lo          << ','
-                   << "\"hi\":"          << bins[i].hi          << ','
-                   << "\"bytes\":"       << bins[i].bytes       << ','
-                   << "\"allocations\":" << bins[i].allocations
-                   << '}';
-            }
-            ss << "],";
-
-            // leaks (bloques vivos) + is_leak
-            const uint64_t now = now_ns();
-            const uint64_t thr_ns = g_agg.getLeakThresholdMs() * 1000000ULL;
-
-            ss << "\"leaks\":[";
-            for (size_t i = 0; i < blocks.size(); ++i) {
-                if (i) ss << ',';
-                const auto& b = blocks[i];
-                const bool is_leak = (now > b.ts_ns) && ((now - b.ts_ns) > thr_ns);
-                ss << '{'
-                   << "\"ptr\":\""   << b.ptr  << "\","
-                   << "\"size\":"    << b.size << ','
-                   << "\"file\":\""  << json_escape(b.file) << "\","
-                   << "\"line\":"    << b.line << ','
-                   << "\"type\":\""  << json_escape(b.type) << "\","
-                   << "\"ts_ns\":"   << b.ts_ns << ','
-                   << "\"is_leak\":" << (is_leak ? "true" : "false")
-                   << '}';
-            }
-            ss << "],";
-
-            // timeline: [t_ms, heap_bytes]
-            ss << "\"timeline\":[";
-            for (size_t i = 0; i < timeline.size(); ++i) {
-                if (i) ss << ',';
-                const auto& p = timeline[i];
-                const uint64_t t_ms = p.t_ns / 1'000'000ULL;
-                ss << '[' << t_ms << ',' << p.cur_bytes << ']';
-            }
-            ss << ']';
-
-            ss << '}';
-
-            client.sendLine(ss.str());
-            std::this_thread::sleep_for(std::chrono::milliseconds(250));
+            // --- clases de tamaño (mantenidas por el agregador en cada alloc/free) ---
+            tick.bins = g_agg.getSizeBins();
+
+            tick.dropped_frames = client.stats().frames_dropped;
+
+            if (as_json) write_json(tick, json_sites, out);
+            else         write_binary(tick, out);
+            // La cola se queda con 'out' (sin copia). Un JSON o un keyframe
+            // sustituyen a lo pendiente; si se descartó un delta (no por un
+            // keyframe que ya lo cubre), la cadena está rota y el siguiente
+            // tick manda keyframe.
+            const size_t dropped = client.enqueue(out, as_json, as_json || tick.delta.keyframe);
+            if (dropped > 0 && !as_json && !tick.delta.keyframe)
+                need_keyframe = true;
+            // Lo que no salga antes del próximo tick sigue en la cola
+            const auto budget = std::chrono::duration_cast<std::chrono::milliseconds>(tick_end - steady_clock_t::now());
+            if (!client.flush(static_cast<int>(std::max<int64_t>(0, budget.count()))))
+                client.close();   // se reconecta (y manda keyframe) en la siguiente vuelta
+            std::this_thread::sleep_until(tick_end);
         }
     }).detach();
 
@@ -266,6 +872,9 @@ int memprof_init(const char* host, int port) {
 
 void memprof_shutdown() {
     g_running.store(false, std::memory_order_relaxed);
+    pipeline().stop();
+    Symbolizer::instance().stop();
+    TraceWriter::instance().close();
 }
 
 } // extern "C"
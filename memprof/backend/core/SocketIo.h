@@ -0,0 +1,65 @@
+#pragma once
+// E/S no bloqueante sobre sockets POSIX (TCP y AF_UNIX), compartida por los
+// transportes de TcpClient.cpp y LocalTransport.cpp.
+#if !defined(_WIN32)
+#include "memprof/core/Transport.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+namespace sockio {
+
+#if defined(MSG_NOSIGNAL)
+inline constexpr int kSendFlags = MSG_NOSIGNAL | MSG_DONTWAIT;   // GUI cerrada -> error, no SIGPIPE
+#else
+inline constexpr int kSendFlags = MSG_DONTWAIT;                  // (SO_NOSIGPIPE en el socket)
+#endif
+inline constexpr int kMaxIov = 16;
+
+inline void setNonBlocking(int fd) {
+    ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+    ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+}
+
+// writev sin SIGPIPE: bytes escritos, 0 si el buffer del kernel está lleno,
+// -1 si la conexión murió
+inline int64_t writeSome(int fd, const IoSlice* v, int n) {
+    iovec iov[kMaxIov];
+    if (n > kMaxIov) n = kMaxIov;
+    for (int i = 0; i < n; ++i) iov[i] = {const_cast<void*>(v[i].data), v[i].len};
+    msghdr msg{};
+    msg.msg_iov = iov;
+    msg.msg_iovlen = static_cast<decltype(msg.msg_iovlen)>(n);
+    for (;;) {
+        const ssize_t w = ::sendmsg(fd, &msg, kSendFlags);
+        if (w >= 0) return w;
+        if (errno == EINTR) continue;
+        return errno == EAGAIN || errno == EWOULDBLOCK ? 0 : -1;
+    }
+}
+
+// true si se puede escribir o venció el plazo; false si la conexión murió
+inline bool waitWritable(int fd, int timeout_ms) {
+    pollfd p{fd, POLLOUT, 0};
+    const int r = ::poll(&p, 1, timeout_ms);
+    if (r < 0) return errno == EINTR;
+    return !(p.revents & (POLLERR | POLLHUP | POLLNVAL));
+}
+
+// connect con plazo sobre un socket ya no bloqueante
+inline bool connectTimeout(int fd, const sockaddr* addr, socklen_t len, int timeout_ms) {
+    if (::connect(fd, addr, len) == 0) return true;
+    if (errno != EINPROGRESS && errno != EAGAIN) return false;
+    pollfd p{fd, POLLOUT, 0};
+    if (::poll(&p, 1, timeout_ms) <= 0) return false;
+    int err = 0;
+    socklen_t el = sizeof(err);
+    return ::getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &el) == 0 && err == 0;
+}
+
+} // namespace sockio
+#endif
@@ -0,0 +1,169 @@
+#include "memprof/core/StackTable.h"
+
+#include <unwind.h>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <thread>
+
+namespace {
+
+constexpr uint32_t kNoId = UINT32_MAX;   // slot reservado pero sin hueco en el pool
+
+inline uint64_t hash_pcs(const uintptr_t* pcs, size_t depth) noexcept {
+    uint64_t h = 0xcbf29ce484222325ULL ^ depth;
+    for (size_t i = 0; i < depth; ++i) {
+        h ^= static_cast<uint64_t>(pcs[i]);
+        h *= 0x100000001b3ULL;
+        h ^= h >> 29;
+    }
+    return h ? h : 1;
+}
+
+struct UnwindState {
+    uintptr_t* out;
+    size_t     max;
+    size_t     skip;
+    size_t     n;
+};
+
+_Unwind_Reason_Code unwind_cb(_Unwind_Context* ctx, void* arg) {
+    auto* st = static_cast<UnwindState*>(arg);
+    const uintptr_t pc = static_cast<uintptr_t>(_Unwind_GetIP(ctx));
+    if (pc == 0) return _URC_END_OF_STACK;
+    if (st->skip > 0) { --st->skip; return _URC_NO_REASON; }
+    st->out[st->n++] = pc;
+    return st->n < st->max ? _URC_NO_REASON : _URC_END_OF_STACK;
+}
+
+} // anon
+
+StackTable& StackTable::instance() {
+    // Como EventPipeline: sin operator new y sin destructor
+    static StackTable* t = [] {
+        void* mem = std::malloc(sizeof(StackTable));
+        return ::new (mem) StackTable();
+    }();
+    return *t;
+}
+
+__attribute__((noinline))
+size_t StackTable::capture(uintptr_t* out, size_t max, size_t skip, Mode mode) noexcept {
+    if (max == 0) return 0;
+    if (mode == Mode::Unwind) {
+        // El primer marco que ve el unwinder es esta misma función
+        UnwindState st{out, max, skip + 1, 0};
+        _Unwind_Backtrace(&unwind_cb, &st);
+        return st.n;
+    }
+
+    // Cadena de frame pointers: [fp] = fp anterior, [fp + 1] = dirección de
+    // retorno. Se corta en cuanto un marco no parece de la misma pila.
+    size_t n = 0;
+    auto* fp = static_cast<uintptr_t*>(__builtin_frame_address(0));
+    while (fp && n < max) {
+        const uintptr_t ret  = fp[1];
+        auto*           next = reinterpret_cast<uintptr_t*>(fp[0]);
+        if (ret == 0) break;
+        if (skip > 0) --skip;
+        else          out[n++] = ret;
+        if (next <= fp || reinterpret_cast<uintptr_t>(next) - reinterpret_cast<uintptr_t>(fp) > (1u << 20) ||
+            (reinterpret_cast<uintptr_t>(next) & (sizeof(uintptr_t) - 1)) != 0)
+            break;
+        fp = next;
+    }
+    return n;
+}
+
+bool StackTable::ensureStorage() noexcept {
+    int st = init_.load(std::memory_order_acquire);
+    if (st == 2) return true;
+    if (st == 0 && init_.compare_exchange_strong(st, 1, std::memory_order_acq_rel)) {
+        void* s = std::calloc(kSlots, sizeof(Slot));
+        void* e = std::calloc(kSlots + 1, sizeof(Entry));
+        void* p = std::calloc(kPoolSlots, sizeof(uintptr_t));
+        if (!s || !e || !p) {
+            std::free(s); std::free(e); std::free(p);
+            init_.store(3, std::memory_order_release);
+            return false;
+        }
+        // calloc deja los atómicos a cero: equivale a su estado inicial
+        slots_.store(static_cast<Slot*>(s), std::memory_order_relaxed);
+        entries_.store(static_cast<Entry*>(e), std::memory_order_relaxed);
+        pool_.store(static_cast<uintptr_t*>(p), std::memory_order_relaxed);
+        init_.store(2, std::memory_order_release);
+        return true;
+    }
+    while ((st = init_.load(std::memory_order_acquire)) == 1) std::this_thread::yield();
+    return st == 2;
+}
+
+uint32_t StackTable::intern(const uintptr_t* pcs, size_t depth) noexcept {
+    if (depth == 0 || !ensureStorage()) return 0;
+    if (depth > kMaxDepth) depth = kMaxDepth;
+
+    const uint64_t h = hash_pcs(pcs, depth);
+    Slot*          slots = slots_.load(std::memory_order_acquire);
+    size_t         i = static_cast<size_t>(h) & (kSlots - 1);
+
+    for (size_t probe = 0; probe < kSlots; ++probe, i = (i + 1) & (kSlots - 1)) {
+        uint64_t cur = slots[i].hash.load(std::memory_order_acquire);
+        if (cur == 0) {
+            // Factor de carga máximo 3/4: a partir de ahí las pilas nuevas van sin id
+            if (next_id_.load(std::memory_order_relaxed) >= kSlots / 4 * 3) return 0;
+            if (slots[i].hash.compare_exchange_strong(cur, h, std::memory_order_acq_rel)) {
+                const size_t off = pool_used_.fetch_add(depth, std::memory_order_relaxed);
+                if (off + depth > kPoolSlots) {
+                    slots[i].id.store(kNoId, std::memory_order_release);
+                    return 0;
+                }
+                const uint32_t id = next_id_.fetch_add(1, std::memory_order_relaxed);
+                std::memcpy(pool_.load(std::memory_order_relaxed) + off, pcs, depth * sizeof(uintptr_t));
+                Entry& e = entries_.load(std::memory_order_relaxed)[id];
+                e.offset = static_cast<uint32_t>(off);
+                e.depth  = static_cast<uint32_t>(depth);
+                e.ready.store(true, std::memory_order_release);
+                slots[i].id.store(id, std::memory_order_release);
+                return id;
+            }
+            // Otro hilo ganó el slot: cur trae su hash
+        }
+        if (cur == h) {
+            // El ganador tarda unas pocas instrucciones en publicar el id
+            uint32_t id;
+            while ((id = slots[i].id.load(std::memory_order_acquire)) == 0) std::this_thread::yield();
+            return id == kNoId ? 0 : id;
+        }
+    }
+    return 0;
+}
+
+uint32_t StackTable::published() const noexcept {
+    const Entry* entries = init_.load(std::memory_order_acquire) == 2
+                         ? entries_.load(std::memory_order_relaxed) : nullptr;
+    if (!entries) return 1;
+    uint32_t p = published_.load(std::memory_order_relaxed);
+    const uint32_t n = next_id_.load(std::memory_order_acquire);
+    const uint32_t from = p;
+    while (p < n && entries[p].ready.load(std::memory_order_acquire)) ++p;
+    if (p != from) {
+        uint32_t cur = from;
+        while (cur < p && !published_.compare_exchange_weak(cur, p, std::memory_order_relaxed)) {}
+    }
+    return p;
+}
+
+size_t StackTable::depth(uint32_t id) const noexcept {
+    if (id == 0 || id > kSlots || init_.load(std::memory_order_acquire) != 2) return 0;
+    const Entry& e = entries_.load(std::memory_order_relaxed)[id];
+    return e.ready.load(std::memory_order_acquire) ? e.depth : 0;
+}
+
+size_t StackTable::frames(uint32_t id, uintptr_t* out, size_t max) const noexcept {
+    if (id == 0 || id > kSlots || init_.load(std::memory_order_acquire) != 2) return 0;
+    const Entry& e = entries_.load(std::memory_order_relaxed)[id];
+    if (!e.ready.load(std::memory_order_acquire)) return 0;
+    const size_t n = e.depth < max ? e.depth : max;
+    std::memcpy(out, pool_.load(std::memory_order_relaxed) + e.offset, n * sizeof(uintptr_t));
+    return n;
+}
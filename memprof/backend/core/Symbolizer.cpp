@@ -0,0 +1,552 @@
+#include "memprof/core/Symbolizer.h"
+#include "memprof/core/EventPipeline.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__linux__)
+  #include <cxxabi.h>
+  #include <dlfcn.h>
+  #include <elf.h>
+  #include <fcntl.h>
+  #include <link.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+  #define MEMPROF_HAVE_ELF 1
+#endif
+
+// Módulo cargado en el proceso. El ELF se mapea la primera vez que se
+// necesita y queda mapeado: los nombres de símbolo apuntan a su .strtab.
+struct Symbolizer::Module {
+    std::string path;
+    uintptr_t   bias = 0;                                   // dirección de carga
+    std::vector<std::pair<uintptr_t, uintptr_t>> ranges;    // PT_LOAD [lo, hi) absolutos
+
+    bool        loaded = false;
+    const uint8_t* map = nullptr;
+    size_t      map_size = 0;
+
+    struct Sym { uint64_t addr, size; const char* name; };
+    std::vector<Sym> syms;                                  // por addr
+
+    struct Row { uint64_t addr; uint32_t file; uint32_t line; bool end; };
+    std::vector<Row>         rows;                          // por (addr, fin de secuencia primero)
+    std::vector<std::string> files;
+
+    bool contains(uintptr_t pc) const {
+        for (const auto& r : ranges) if (pc >= r.first && pc < r.second) return true;
+        return false;
+    }
+};
+
+namespace {
+
+#if MEMPROF_HAVE_ELF
+
+// ---------------------------------------------------------------------------
+// Lectura acotada de DWARF: los errores dejan ok a false y devuelven ceros.
+// ---------------------------------------------------------------------------
+struct Cursor {
+    const uint8_t* p;
+    const uint8_t* end;
+    bool           ok = true;
+
+    size_t left() const { return static_cast<size_t>(end - p); }
+    bool   need(size_t n) { if (left() < n) { ok = false; p = end; return false; } return true; }
+
+    uint64_t fixed(size_t n) {
+        if (!need(n)) return 0;
+        uint64_t v = 0;
+        for (size_t i = 0; i < n; ++i) v |= static_cast<uint64_t>(p[i]) << (8 * i);
+        p += n;
+        return v;
+    }
+    uint8_t  u8()  { return static_cast<uint8_t>(fixed(1)); }
+    uint16_t u16() { return static_cast<uint16_t>(fixed(2)); }
+    uint32_t u32() { return static_cast<uint32_t>(fixed(4)); }
+    uint64_t u64() { return fixed(8); }
+
+    uint64_t uleb() {
+        uint64_t v = 0;
+        for (int shift = 0; p < end; shift += 7) {
+            const uint8_t b = *p++;
+            if (shift < 64) v |= static_cast<uint64_t>(b & 0x7F) << shift;
+            if (!(b & 0x80)) return v;
+        }
+        ok = false;
+        return 0;
+    }
+    int64_t sleb() {
+        int64_t v = 0;
+        int shift = 0;
+        uint8_t b = 0;
+        do {
+            if (p >= end) { ok = false; return 0; }
+            b = *p++;
+            if (shift < 64) v |= static_cast<int64_t>(b & 0x7F) << shift;
+            shift += 7;
+        } while (b & 0x80);
+        if (shift < 64 && (b & 0x40)) v |= -(static_cast<int64_t>(1) << shift);
+        return v;
+    }
+    const char* cstr() {
+        const auto* z = static_cast<const uint8_t*>(std::memchr(p, 0, left()));
+        if (!z) { ok = false; p = end; return ""; }
+        const char* s = reinterpret_cast<const char*>(p);
+        p = z + 1;
+        return s;
+    }
+    void skip(size_t n) { if (need(n)) p += n; }
+};
+
+struct Span { const uint8_t* data = nullptr; size_t size = 0; };
+
+inline const char* strAt(const Span& s, uint64_t off) {
+    if (!s.data || off >= s.size || !std::memchr(s.data + off, 0, s.size - off)) return "";
+    return reinterpret_cast<const char*>(s.data + off);
+}
+
+// DW_FORM_* usados por las cabeceras de línea v5
+enum : uint64_t {
+    kFormBlock = 0x09, kFormData1 = 0x0b, kFormData2 = 0x05, kFormData4 = 0x06, kFormData8 = 0x07,
+    kFormData16 = 0x1e, kFormString = 0x08, kFormStrp = 0x0e, kFormLineStrp = 0x1f, kFormUdata = 0x0f,
+    kFormStrx = 0x1a, kFormStrx1 = 0x25, kFormStrx2 = 0x26, kFormStrx3 = 0x27, kFormStrx4 = 0x28,
+};
+enum : uint64_t { kLnctPath = 1, kLnctDirIndex = 2 };
+
+// Lee un atributo de entrada de directorio/archivo (v5). Solo interesan
+// cadenas y enteros; el resto se salta.
+bool readForm(Cursor& c, uint64_t form, bool dwarf64, const Span& str, const Span& line_str,
+              const char*& s, uint64_t& u) {
+    s = nullptr; u = 0;
+    const size_t off_size = dwarf64 ? 8 : 4;
+    switch (form) {
+        case kFormString:   s = c.cstr(); break;
+        case kFormStrp:     s = strAt(str, c.fixed(off_size)); break;
+        case kFormLineStrp: s = strAt(line_str, c.fixed(off_size)); break;
+        case kFormStrx: case kFormUdata: u = c.uleb(); break;   // strx sin .debug_str_offsets: se ignora
+        case kFormStrx1: case kFormData1: u = c.u8(); break;
+        case kFormStrx2: case kFormData2: u = c.u16(); break;
+        case kFormStrx3: u = c.fixed(3); break;
+        case kFormStrx4: case kFormData4: u = c.u32(); break;
+        case kFormData8:    u = c.u64(); break;
+        case kFormData16:   c.skip(16); break;
+        case kFormBlock:    c.skip(static_cast<size_t>(c.uleb())); break;
+        default:            return false;
+    }
+    return c.ok;
+}
+
+std::string joinPath(const char* dir, const char* file) {
+    if (!file || !*file) return std::string();
+    if (file[0] == '/' || !dir || !*dir) return file;
+    std::string out(dir);
+    if (out.back() != '/') out += '/';
+    out += file;
+    return out;
+}
+
+// Recorre todas las unidades de .debug_line y añade sus filas al módulo
+void parseDebugLine(Symbolizer::Module& m, const Span& line, const Span& str, const Span& line_str) {
+    std::unordered_map<std::string, uint32_t> file_ids;
+    for (uint32_t i = 0; i < m.files.size(); ++i) file_ids.emplace(m.files[i], i);
+    auto fileId = [&](std::string path) -> uint32_t {
+        auto it = file_ids.find(path);
+        if (it != file_ids.end()) return it->second;
+        const auto id = static_cast<uint32_t>(m.files.size());
+        m.files.push_back(path);
+        file_ids.emplace(std::move(path), id);
+        return id;
+    };
+
+    Cursor all{line.data, line.data + line.size};
+    while (all.ok && all.left() > 0) {
+        // --- cabecera de la unidad ---
+        uint64_t unit_len = all.u32();
+        bool dwarf64 = false;
+        if (unit_len == 0xffffffffu) { unit_len = all.u64(); dwarf64 = true; }
+        if (!all.ok || unit_len > all.left()) return;
+        Cursor c{all.p, all.p + unit_len};
+        all.p += unit_len;
+
+        const uint16_t version = c.u16();
+        if (version < 2 || version > 5) continue;
+        uint8_t addr_size = sizeof(uintptr_t);
+        if (version >= 5) { addr_size = c.u8(); c.u8(); /* segment_selector_size */ }
+        const uint64_t header_len = dwarf64 ? c.u64() : c.u32();
+        if (!c.ok || header_len > c.left()) continue;
+        const uint8_t* program = c.p + header_len;
+
+        const uint8_t min_inst   = c.u8();
+        if (version >= 4) c.u8();                       // maximum_operations_per_instruction
+        c.u8();                                         // default_is_stmt
+        const int8_t  line_base  = static_cast<int8_t>(c.u8());
+        const uint8_t line_range = c.u8();
+        const uint8_t opcode_base = c.u8();
+        if (!c.ok || line_range == 0 || opcode_base == 0) continue;
+        uint8_t std_len[256] = {};
+        for (unsigned i = 1; i < opcode_base; ++i) std_len[i] = c.u8();
+
+        // --- directorios y archivos: índice de la unidad -> id del módulo ---
+        std::vector<std::string> dirs;
+        std::vector<uint32_t>    files;
+        if (version < 5) {
+            dirs.emplace_back();                          // 0 = directorio de compilación (desconocido)
+            for (;;) {
+                const char* d = c.cstr();
+                if (!c.ok || !*d) break;
+                dirs.emplace_back(d);
+            }
+            files.push_back(0);                           // los índices empiezan en 1
+            for (;;) {
+                const char* f = c.cstr();
+                if (!c.ok || !*f) break;
+                const uint64_t di = c.uleb(); c.uleb(); c.uleb();
+                files.push_back(fileId(joinPath(di < dirs.size() ? dirs[di].c_str() : "", f)));
+            }
+        } else {
+            auto readEntries = [&](auto&& onEntry) {
+                const uint8_t nfmt = c.u8();
+                std::vector<std::pair<uint64_t, uint64_t>> fmt(nfmt);
+                for (auto& f : fmt) { f.first = c.uleb(); f.second = c.uleb(); }
+                const uint64_t count = c.uleb();
+                for (uint64_t i = 0; i < count && c.ok; ++i) {
+                    const char* path = "";
+                    uint64_t    dir  = 0;
+                    for (const auto& f : fmt) {
+                        const char* s; uint64_t u;
+                        if (!readForm(c, f.second, dwarf64, str, line_str, s, u)) return false;
+                        if (f.first == kLnctPath && s) path = s;
+                        else if (f.first == kLnctDirIndex) dir = u;
+                    }
+                    onEntry(path, dir);
+                }
+                return c.ok;
+            };
+            if (!readEntries([&](const char* p, uint64_t) { dirs.emplace_back(p); })) continue;
+            if (!readEntries([&](const char* p, uint64_t d) {
+                    files.push_back(fileId(joinPath(d < dirs.size() ? dirs[d].c_str() : "", p)));
+                })) continue;
+        }
+        if (program > c.end) continue;
+        c.p = program;
+
+        // --- máquina de estados del programa de líneas ---
+        uint64_t address = 0;
+        uint64_t file = 1;
+        int64_t  ln = 1;
+        auto emit = [&](bool end_seq) {
+            const uint32_t fid = file < files.size() ? files[file] : UINT32_MAX;
+            m.rows.push_back(Symbolizer::Module::Row{address, fid, static_cast<uint32_t>(ln > 0 ? ln : 0), end_seq});
+        };
+        auto reset = [&] { address = 0; file = 1; ln = 1; };
+
+        while (c.ok && c.left() > 0) {
+            const uint8_t op = c.u8();
+            if (op >= opcode_base) {
+                const unsigned adj = op - opcode_base;
+                address += static_cast<uint64_t>(adj / line_range) * min_inst;
+                ln      += line_base + static_cast<int>(adj % line_range);
+                emit(false);
+                continue;
+            }
+            switch (op) {
+            case 0: {                                   // extendido
+                const uint64_t len = c.uleb();
+                if (len == 0 || len > c.left()) { c.ok = false; break; }
+                const uint8_t* next = c.p + len;
+                const uint8_t sub = c.u8();
+                if (sub == 1) { emit(true); reset(); }  // DW_LNE_end_sequence
+                else if (sub == 2) address = c.fixed(std::min<uint64_t>(len - 1, addr_size));   // set_address
+                else if (sub == 3 && version < 5) {     // define_file
+                    const char* f = c.cstr();
+                    const uint64_t di = c.uleb();
+                    files.push_back(fileId(joinPath(di < dirs.size() ? dirs[di].c_str() : "", f)));
+                }
+                c.p = next;
+                break;
+            }
+            case 1:  emit(false); break;                                     // copy
+            case 2:  address += c.uleb() * min_inst; break;                  // advance_pc
+            case 3:  ln += c.sleb(); break;                                  // advance_line
+            case 4:  file = c.uleb(); break;                                 // set_file
+            case 8:  address += static_cast<uint64_t>((255 - opcode_base) / line_range) * min_inst; break;
+            case 9:  address += c.u16(); break;                              // fixed_advance_pc
+            case 5: case 12: c.uleb(); break;                                // set_column, set_isa
+            case 6: case 7: case 10: case 11: break;                         // flags sin argumentos
+            default:
+                for (unsigned i = 0; i < std_len[op]; ++i) c.uleb();
+                break;
+            }
+        }
+    }
+}
+
+// Abre y mapea el ELF del módulo e indexa símbolos y líneas
+void loadModule(Symbolizer::Module& m) {
+    m.loaded = true;
+    const int fd = ::open(m.path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return;
+    struct stat st{};
+    if (::fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(Elf64_Ehdr))) { ::close(fd); return; }
+    void* p = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) return;
+    m.map = static_cast<const uint8_t*>(p);
+    m.map_size = static_cast<size_t>(st.st_size);
+
+    const auto* eh = reinterpret_cast<const Elf64_Ehdr*>(m.map);
+    if (std::memcmp(eh->e_ident, ELFMAG, SELFMAG) != 0 || eh->e_ident[EI_CLASS] != ELFCLASS64 ||
+        eh->e_ident[EI_DATA] != ELFDATA2LSB || eh->e_shentsize != sizeof(Elf64_Shdr) ||
+        eh->e_shoff == 0 || eh->e_shoff + uint64_t(eh->e_shnum) * sizeof(Elf64_Shdr) > m.map_size ||
+        eh->e_shstrndx >= eh->e_shnum)
+        return;
+
+    const auto* sh = reinterpret_cast<const Elf64_Shdr*>(m.map + eh->e_shoff);
+    auto span = [&](const Elf64_Shdr& s) -> Span {
+        if (s.sh_type == SHT_NOBITS || (s.sh_flags & SHF_COMPRESSED) ||
+            s.sh_offset > m.map_size || s.sh_size > m.map_size - s.sh_offset)
+            return {};
+        return Span{m.map + s.sh_offset, static_cast<size_t>(s.sh_size)};
+    };
+    const Span shstr = span(sh[eh->e_shstrndx]);
+
+    Span debug_line, debug_str, debug_line_str;
+    for (unsigned i = 0; i < eh->e_shnum; ++i) {
+        const Elf64_Shdr& s = sh[i];
+        if (s.sh_type == SHT_SYMTAB || s.sh_type == SHT_DYNSYM) {
+            if (s.sh_link >= eh->e_shnum || s.sh_entsize != sizeof(Elf64_Sym)) continue;
+            const Span syms = span(s), names = span(sh[s.sh_link]);
+            const auto* sym = reinterpret_cast<const Elf64_Sym*>(syms.data);
+            for (size_t k = 0; sym && k < syms.size / sizeof(Elf64_Sym); ++k) {
+                const unsigned type = ELF64_ST_TYPE(sym[k].st_info);
+                if ((type != STT_FUNC && type != STT_GNU_IFUNC) || sym[k].st_value == 0 ||
+                    sym[k].st_shndx == SHN_UNDEF)
+                    continue;
+                const char* name = strAt(names, sym[k].st_name);
+                if (*name) m.syms.push_back(Symbolizer::Module::Sym{sym[k].st_value, sym[k].st_size, name});
+            }
+            continue;
+        }
+        const char* name = strAt(shstr, s.sh_name);
+        if      (std::strcmp(name, ".debug_line") == 0)     debug_line = span(s);
+        else if (std::strcmp(name, ".debug_str") == 0)      debug_str = span(s);
+        else if (std::strcmp(name, ".debug_line_str") == 0) debug_line_str = span(s);
+    }
+
+    // .symtab y .dynsym se solapan: se ordena y se quita lo repetido
+    std::sort(m.syms.begin(), m.syms.end(), [](const auto& a, const auto& b) {
+        return a.addr != b.addr ? a.addr < b.addr : a.size > b.size;
+    });
+    m.syms.erase(std::unique(m.syms.begin(), m.syms.end(),
+                             [](const auto& a, const auto& b) { return a.addr == b.addr; }),
+                 m.syms.end());
+
+    if (debug_line.data) {
+        parseDebugLine(m, debug_line, debug_str, debug_line_str);
+        std::sort(m.rows.begin(), m.rows.end(), [](const auto& a, const auto& b) {
+            return a.addr != b.addr ? a.addr < b.addr : a.end > b.end;
+        });
+    }
+}
+
+int addModule(dl_phdr_info* info, size_t, void* arg) {
+    auto& mods = *static_cast<std::vector<std::unique_ptr<Symbolizer::Module>>*>(arg);
+    auto m = std::make_unique<Symbolizer::Module>();
+    m->bias = info->dlpi_addr;
+    for (int i = 0; i < info->dlpi_phnum; ++i) {
+        const auto& ph = info->dlpi_phdr[i];
+        if (ph.p_type != PT_LOAD) continue;
+        m->ranges.emplace_back(info->dlpi_addr + ph.p_vaddr, info->dlpi_addr + ph.p_vaddr + ph.p_memsz);
+    }
+    if (m->ranges.empty()) return 0;
+    for (const auto& known : mods)
+        if (known->ranges.front() == m->ranges.front()) return 0;   // ya conocido
+
+    if (info->dlpi_name && *info->dlpi_name) {
+        m->path = info->dlpi_name;
+    } else {
+        char buf[4096];
+        const ssize_t n = ::readlink("/proc/self/exe", buf, sizeof(buf) - 1);
+        if (n > 0) m->path.assign(buf, static_cast<size_t>(n));
+    }
+    mods.push_back(std::move(m));
+    return 0;
+}
+
+std::string demangle(const char* name) {
+    int status = 0;
+    char* d = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+    if (status != 0 || !d) return name;
+    std::string out(d);
+    std::free(d);
+    return out;
+}
+
+#endif // MEMPROF_HAVE_ELF
+
+} // anon
+
+// ============================ Symbolizer ============================
+
+Symbolizer::Symbolizer() {
+    strings_.emplace_back();             // id 0 = ""
+    string_index_.emplace(std::string(), 0);
+}
+
+Symbolizer::~Symbolizer() { stop(); }
+
+Symbolizer& Symbolizer::instance() {
+    // Nunca se destruye: el sender puede seguir usándolo durante la salida
+    static Symbolizer* s = [] {
+        EventPipeline::ScopedSuppress quiet;
+        return new Symbolizer();
+    }();
+    return *s;
+}
+
+void Symbolizer::start() {
+    std::lock_guard<std::mutex> lk(mtx_);
+    if (running_) return;
+    running_ = true;
+    worker_ = std::thread([this] { run(); });
+}
+
+void Symbolizer::stop() {
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        if (!running_) return;
+        running_ = false;
+    }
+    cv_.notify_all();
+    if (worker_.joinable() && worker_.get_id() != std::this_thread::get_id()) worker_.join();
+}
+
+void Symbolizer::request(const uintptr_t* pcs, size_t n) {
+    bool added = false;
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        for (size_t i = 0; i < n; ++i) {
+            if (pcs[i] == 0 || !seen_.insert(pcs[i]).second) continue;
+            queue_.push_back(pcs[i]);
+            added = true;
+        }
+    }
+    if (added) cv_.notify_one();
+}
+
+void Symbolizer::run() {
+    EventPipeline::ScopedSuppress quiet;   // ni el ELF ni los nombres cuentan como heap del programa
+    std::vector<uintptr_t> work;
+    std::vector<std::pair<uintptr_t, Symbol>> done;
+    struct Raw { std::string function, file; int32_t line; };
+    std::vector<Raw> raw;
+
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lk(mtx_);
+            cv_.wait(lk, [&] { return !running_ || !queue_.empty(); });
+            if (!running_) return;
+            work.swap(queue_);
+        }
+
+        // Resolución sin el lock: las cadenas se internan después, en bloque
+        raw.clear();
+        for (uintptr_t pc : work) {
+            Raw r{std::string(), std::string(), 0};
+#if MEMPROF_HAVE_ELF
+            if (Module* m = moduleFor(pc)) {
+                const uint64_t addr = pc - 1 - m->bias;   // dentro de la instrucción de llamada
+                auto s = std::upper_bound(m->syms.begin(), m->syms.end(), addr,
+                                          [](uint64_t a, const Module::Sym& x) { return a < x.addr; });
+                if (s != m->syms.begin()) {
+                    --s;
+                    if (s->size == 0 || addr < s->addr + s->size) r.function = demangle(s->name);
+                }
+                auto row = std::upper_bound(m->rows.begin(), m->rows.end(), addr,
+                                            [](uint64_t a, const Module::Row& x) { return a < x.addr; });
+                if (row != m->rows.begin()) {
+                    --row;
+                    if (!row->end && row->file < m->files.size()) {
+                        r.file = m->files[row->file];
+                        r.line = static_cast<int32_t>(row->line);
+                    }
+                }
+                if (r.function.empty() && r.file.empty()) {
+                    // Sin símbolos: al menos módulo+offset
+                    const size_t slash = m->path.rfind('/');
+                    char off[32];
+                    std::snprintf(off, sizeof(off), "+0x%llx", static_cast<unsigned long long>(addr + 1));
+                    r.function = (slash == std::string::npos ? m->path : m->path.substr(slash + 1)) + off;
+                }
+            }
+#endif
+            raw.push_back(std::move(r));
+        }
+
+        std::lock_guard<std::mutex> lk(mtx_);
+        for (size_t i = 0; i < work.size(); ++i) {
+            Symbol s;
+            s.function = internString_locked(raw[i].function);
+            s.file     = internString_locked(raw[i].file);
+            s.line     = raw[i].line;
+            resolved_.emplace(work[i], s);
+            order_.push_back(work[i]);
+        }
+        work.clear();
+    }
+}
+
+Symbolizer::Module* Symbolizer::moduleFor(uintptr_t pc) {
+#if MEMPROF_HAVE_ELF
+    for (int pass = 0; pass < 2; ++pass) {
+        for (auto& m : modules_) {
+            if (!m->contains(pc)) continue;
+            if (!m->loaded) loadModule(*m);
+            return m.get();
+        }
+        if (pass == 0) dl_iterate_phdr(&addModule, &modules_);   // dlopen nuevo
+    }
+#else
+    (void)pc;
+#endif
+    return nullptr;
+}
+
+uint32_t Symbolizer::internString_locked(const std::string& s) {
+    auto it = string_index_.find(s);
+    if (it != string_index_.end()) return it->second;
+    const auto id = static_cast<uint32_t>(strings_.size());
+    strings_.push_back(s);
+    string_index_.emplace(s, id);
+    return id;
+}
+
+void Symbolizer::collect(Batch& out, bool full) {
+    std::lock_guard<std::mutex> lk(mtx_);
+    if (full) { sent_strings_ = 1; sent_symbols_ = 0; }
+    out.first_string = sent_strings_;
+    out.strings.assign(strings_.begin() + sent_strings_, strings_.end());
+    out.symbols.clear();
+    out.symbols.reserve(order_.size() - sent_symbols_);
+    for (size_t i = sent_symbols_; i < order_.size(); ++i)
+        out.symbols.emplace_back(order_[i], resolved_[order_[i]]);
+    sent_strings_ = static_cast<uint32_t>(strings_.size());
+    sent_symbols_ = order_.size();
+}
+
+bool Symbolizer::lookup(uintptr_t pc, Symbol& out) const {
+    std::lock_guard<std::mutex> lk(mtx_);
+    auto it = resolved_.find(pc);
+    if (it == resolved_.end()) return false;
+    out = it->second;
+    return true;
+}
+
+std::string Symbolizer::string(uint32_t id) const {
+    std::lock_guard<std::mutex> lk(mtx_);
+    return id < strings_.size() ? strings_[id] : std::string();
+}
@@ -1,6 +1,12 @@
 #include "memprof/core/TcpClient.h"
+#include "memprof/proto/LocalChannel.h"
+#include "SocketIo.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
 #include <cstring>
 #include <string>
+#include <string_view>
 #include <cstdint>   // <-- NECESARIO para uint16_t
 
 #if defined(_WIN32)
@@ -13,12 +19,35 @@
   #include <sys/socket.h>
   #include <arpa/inet.h>
   #include <netdb.h>
+  #include <netinet/in.h>
+  #include <netinet/tcp.h>
   #include <unistd.h>
   #define INVALID_SOCKET (-1)
   #define SOCKET_ERROR   (-1)
 #endif
 
-TcpClient::TcpClient() {
+namespace {
+
+// Buffer de envío del kernel: que quepa una trama típica sin esperar a la GUI
+constexpr int kSendBufBytes = 4 << 20;
+
+// IPv4 + TCP no bloqueante, TCP_NODELAY (cada trama sale entera de una vez)
+class TcpTransport final : public Transport {
+public:
+    TcpTransport();
+    ~TcpTransport() override;
+
+    bool connectTo(const char* host, int port, int timeout_ms) override;
+    bool isConnected() const override;
+    void close() override;
+    int64_t writeSome(const IoSlice* v, int n) override;
+    bool waitWritable(int timeout_ms) override;
+
+private:
+    int sock_ = -1; // descriptor (SOCKET en Windows convertido a int)
+};
+
+TcpTransport::TcpTransport() {
 #if defined(_WIN32)
     if (!g_wsastarted) {
         WSADATA wsaData;
@@ -27,14 +56,14 @@ TcpClient::TcpClient() {
 #endif
 }
 
-TcpClient::~TcpClient() {
+TcpTransport::~TcpTransport() {
     close();
 #if defined(_WIN32)
     // no WSACleanup global (se comparte con otros sockets)
 #endif
 }
 
-bool TcpClient::connectTo(const char* host, int port) {
+bool TcpTransport::connectTo(const char* host, int port, int timeout_ms) {
     close();
     if (!host || !*host || port <= 0) return false;
 
@@ -71,14 +100,36 @@ bool TcpClient::connectTo(const char* host, int port) {
     }
 #endif
 
-    if (::connect(s, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == SOCKET_ERROR) {
 #if defined(_WIN32)
+    u_long nb = 1;
+    ioctlsocket(s, FIONBIO, &nb);
+    bool ok = ::connect(s, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0;
+    if (!ok && WSAGetLastError() == WSAEWOULDBLOCK) {
+        fd_set wr, ex;
+        FD_ZERO(&wr); FD_SET(s, &wr);
+        FD_ZERO(&ex); FD_SET(s, &ex);
+        timeval tv{timeout_ms / 1000, (timeout_ms % 1000) * 1000};
+        ok = ::select(0, nullptr, &wr, &ex, &tv) > 0 && FD_ISSET(s, &wr);
+    }
+    if (!ok) {
         ::closesocket(s);
+        return false;
+    }
 #else
+    sockio::setNonBlocking(s);
+    if (!sockio::connectTimeout(s, reinterpret_cast<sockaddr*>(&addr), sizeof(addr), timeout_ms)) {
         ::close(s);
-#endif
         return false;
     }
+#endif
+
+    const int one = 1;
+    ::setsockopt(s, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&one), sizeof(one));
+    // Solo se agranda: fijarlo desactiva el autoajuste del kernel
+    int cur = 0;
+    socklen_t cl = sizeof(cur);
+    if (::getsockopt(s, SOL_SOCKET, SO_SNDBUF, reinterpret_cast<char*>(&cur), &cl) == 0 && cur < kSendBufBytes)
+        ::setsockopt(s, SOL_SOCKET, SO_SNDBUF, reinterpret_cast<const char*>(&kSendBufBytes), sizeof(kSendBufBytes));
 
 #if defined(_WIN32)
     sock_ = static_cast<int>(s);
@@ -88,11 +139,11 @@ bool TcpClient::connectTo(const char* host, int port) {
     return true;
 }
 
-bool TcpClient::isConnected() const {
+bool TcpTransport::isConnected() const {
     return sock_ != -1;
 }
 
-void TcpClient::close() {
+void TcpTransport::close() {
     if (sock_ != -1) {
 #if defined(_WIN32)
         ::closesocket(static_cast<SOCKET>(sock_));
@@ -103,21 +154,208 @@ void TcpClient::close() {
     }
 }
 
-bool TcpClient::sendLine(const std::string& line) {
+int64_t TcpTransport::writeSome(const IoSlice* v, int n) {
+    if (sock_ == -1) return -1;
+#if defined(_WIN32)
+    WSABUF bufs[16];
+    if (n > 16) n = 16;
+    for (int i = 0; i < n; ++i) {
+        bufs[i].buf = const_cast<CHAR*>(static_cast<const CHAR*>(v[i].data));
+        bufs[i].len = static_cast<ULONG>(v[i].len);
+    }
+    DWORD sent = 0;
+    if (WSASend(static_cast<SOCKET>(sock_), bufs, static_cast<DWORD>(n), &sent, 0, nullptr, nullptr) == 0)
+        return static_cast<int64_t>(sent);
+    return WSAGetLastError() == WSAEWOULDBLOCK ? 0 : -1;
+#else
+    return sockio::writeSome(sock_, v, n);
+#endif
+}
+
+bool TcpTransport::waitWritable(int timeout_ms) {
     if (sock_ == -1) return false;
-    std::string buf = line;
-    buf.push_back('\n');
-    const char* data = buf.c_str();
-    size_t left = buf.size();
-    while (left > 0) {
 #if defined(_WIN32)
-        int sent = ::send(static_cast<SOCKET>(sock_), data, static_cast<int>(left), 0);
+    fd_set wr, ex;
+    FD_ZERO(&wr); FD_SET(static_cast<SOCKET>(sock_), &wr);
+    FD_ZERO(&ex); FD_SET(static_cast<SOCKET>(sock_), &ex);
+    timeval tv{timeout_ms / 1000, (timeout_ms % 1000) * 1000};
+    return ::select(0, nullptr, &wr, &ex, &tv) >= 0 && !FD_ISSET(static_cast<SOCKET>(sock_), &ex);
 #else
-        ssize_t sent = ::send(sock_, data, left, 0);
+    return sockio::waitWritable(sock_, timeout_ms);
 #endif
-        if (sent <= 0) return false;
-        left -= static_cast<size_t>(sent);
-        data += sent;
+}
+
+} // namespace
+
+std::unique_ptr<Transport> makeTcpTransport() { return std::make_unique<TcpTransport>(); }
+
+// ---------------- TcpClient: elige el transporte por el endpoint ----------------
+
+TcpClient::TcpClient() = default;
+TcpClient::~TcpClient() = default;
+
+bool TcpClient::connectTo(const char* host, int port) {
+    if (!host) return false;
+    const std::string_view ep(host);
+    Kind kind = Kind::Tcp;
+    std::string_view where = ep;
+    if (ep.rfind("unix:", 0) == 0)     { kind = Kind::Unix; where = ep.substr(5); }
+    else if (ep.rfind("shm:", 0) == 0) { kind = Kind::Shm;  where = ep.substr(4); }
+
+    std::string path(where);
+    if (kind != Kind::Tcp && path.empty()) {
+        const char* env = std::getenv("MEMPROF_SOCKET");
+        path = env && *env ? env : shmring::kDefaultSocket;
+    }
+    if (kind != kind_ || !impl_) {
+        impl_ = kind == Kind::Unix ? makeUnixTransport()
+              : kind == Kind::Shm  ? makeShmTransport()
+                                   : makeTcpTransport();
+        kind_ = kind;
+    }
+    close();
+    if (impl_ && impl_->connectTo(path.c_str(), port, kConnectTimeoutMs)) {
+        retry_ms_ = 0;
+        ++stats_.connects;
+        return true;
+    }
+    retry_ms_ = retry_ms_ ? std::min(retry_ms_ * 2, kMaxRetryMs) : kMinRetryMs;
+    return false;
+}
+
+bool TcpClient::isConnected() const {
+    return impl_ && impl_->isConnected();
+}
+
+void TcpClient::close() {
+    if (impl_) impl_->close();
+    while (!queue_.empty()) {
+        recycle(std::move(queue_.front().buf));
+        queue_.pop_front();
+    }
+    head_sent_    = 0;
+    queued_bytes_ = 0;
+}
+
+void TcpClient::recycle(std::string&& buf) {
+    if (spare_.size() >= 2) return;
+    buf.clear();
+    spare_.push_back(std::move(buf));
+}
+
+void TcpClient::dropAt(size_t i) {
+    ++stats_.frames_dropped;
+    stats_.bytes_dropped += queue_[i].size();
+    queued_bytes_        -= queue_[i].size();
+    recycle(std::move(queue_[i].buf));
+    queue_.erase(queue_.begin() + static_cast<std::ptrdiff_t>(i));
+}
+
+size_t TcpClient::enqueue(std::string& frame, bool newline, bool supersedes) {
+    // La primera puede estar a medias: nunca se descarta
+    const size_t keep = head_sent_ > 0 ? 1 : 0;
+    size_t dropped = 0;
+    if (supersedes)
+        for (; queue_.size() > keep; ++dropped) dropAt(keep);
+
+    Pending p;
+    p.buf.swap(frame);
+    p.newline = newline;
+    queued_bytes_ += p.size();
+    queue_.push_back(std::move(p));
+    if (!spare_.empty()) { frame.swap(spare_.back()); spare_.pop_back(); }
+
+    // Cola acotada: fuera las más antiguas (nunca la recién encolada)
+    while ((queue_.size() > kMaxQueuedFrames || queued_bytes_ > kMaxQueuedBytes) && queue_.size() > keep + 1) {
+        dropAt(keep);
+        ++dropped;
+    }
+    return dropped;
+}
+
+void TcpClient::consume(size_t n) {
+    while (n > 0) {
+        Pending& f = queue_.front();
+        const size_t left = f.size() - head_sent_;
+        if (n < left) { head_sent_ += n; return; }
+        n -= left;
+        head_sent_ = 0;
+        queued_bytes_ -= f.size();
+        ++stats_.frames_sent;
+        recycle(std::move(f.buf));
+        queue_.pop_front();
+    }
+}
+
+bool TcpClient::flush(int wait_ms) {
+    if (queue_.empty()) return true;
+    if (!impl_) return false;
+    static const char kNewline = '\n';
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(wait_ms);
+    while (!queue_.empty()) {
+        // Hasta 16 tramos: cuerpo (+ '\n') de cada trama, la primera desde head_sent_
+        IoSlice v[16];
+        int n = 0;
+        size_t off = head_sent_;
+        for (const Pending& f : queue_) {
+            if (n + 2 > 16) break;
+            if (off < f.buf.size()) v[n++] = {f.buf.data() + off, f.buf.size() - off};
+            if (f.newline) v[n++] = {&kNewline, 1};
+            off = 0;
+        }
+        const int64_t w = impl_->writeSome(v, n);
+        if (w < 0) return false;
+        if (w > 0) { consume(static_cast<size_t>(w)); continue; }
+
+        const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now()).count();
+        if (left <= 0) return true;   // sigue en la cola para el próximo flush
+        if (!impl_->waitWritable(static_cast<int>(left))) return false;
     }
     return true;
 }
+
+bool TcpClient::sendBlocking(const IoSlice* v, int n) {
+    // flush() y waitWritable() vuelven con éxito al vencer su espera: sin un
+    // plazo total, una GUI que no lee dejaría al sender aquí para siempre
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(kSendTimeoutMs);
+    auto left_ms = [&deadline] {
+        return static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now()).count());
+    };
+    while (!queue_.empty()) {
+        const int left = left_ms();
+        if (left <= 0 || !flush(std::min(left, 100))) return false;
+    }
+    if (!impl_) return false;
+    IoSlice cur[2];
+    int k = 0;
+    for (int i = 0; i < n && k < 2; ++i) cur[k++] = v[i];
+    while (k > 0) {
+        const int64_t w = impl_->writeSome(cur, k);
+        if (w < 0) return false;
+        if (w == 0) {
+            const int left = left_ms();
+            if (left <= 0 || !impl_->waitWritable(std::min(left, 100))) return false;
+            continue;
+        }
+        size_t left = static_cast<size_t>(w);
+        while (k > 0 && left >= cur[0].len) {
+            left -= cur[0].len;
+            cur[0] = cur[1];
+            --k;
+        }
+        if (k > 0) { cur[0].data = static_cast<const char*>(cur[0].data) + left; cur[0].len -= left; }
+    }
+    return true;
+}
+
+bool TcpClient::sendLine(const std::string& line) {
+    const IoSlice v[2] = {{line.data(), line.size()}, {"\n", 1}};
+    return sendBlocking(v, 2);
+}
+
+bool TcpClient::sendAll(const void* data, size_t n) {
+    const IoSlice v[1] = {{data, n}};
+    return sendBlocking(v, 1);
+}
@@ -0,0 +1,259 @@
+#include "memprof/core/TraceWriter.h"
+#include "memprof/core/EventPipeline.h"
+#include "memprof/core/StackTable.h"
+#include "memprof/proto/TraceFormat.h"
+#include "memprof/proto/WireFormat.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+#if defined(__linux__)
+  #include <fcntl.h>
+  #include <link.h>
+  #include <sys/mman.h>
+  #include <unistd.h>
+#endif
+
+namespace {
+
+inline uint64_t realtime_ns() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::system_clock::now().time_since_epoch()).count());
+}
+inline uint64_t steady_ns() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+} // anon
+
+TraceWriter& TraceWriter::instance() {
+    // Como Symbolizer: nunca se destruye (el consumidor puede drenar en la salida)
+    static TraceWriter* w = [] {
+        EventPipeline::ScopedSuppress quiet;
+        return new TraceWriter();
+    }();
+    return *w;
+}
+
+bool TraceWriter::open(const std::string& prefix, uint64_t segment_bytes) {
+    EventPipeline::ScopedSuppress quiet;
+    std::lock_guard<std::mutex> lk(mtx_);
+    if (open_) return true;
+    prefix_        = prefix;
+    segment_bytes_ = segment_bytes < kMinSegmentBytes ? kMinSegmentBytes : segment_bytes;
+    index_         = 0;
+    open_          = openSegment_locked();
+    if (!open_) std::fprintf(stderr, "[memprof] trace: cannot create %s.*.mpt\n", prefix.c_str());
+    return open_;
+}
+
+void TraceWriter::close() {
+    std::lock_guard<std::mutex> lk(mtx_);
+    if (!open_) return;
+    closeSegment_locked();
+    open_ = false;
+}
+
+bool TraceWriter::isOpen() const {
+    std::lock_guard<std::mutex> lk(mtx_);
+    return open_;
+}
+
+uint64_t TraceWriter::segments() const {
+    std::lock_guard<std::mutex> lk(mtx_);
+    return index_;
+}
+
+void TraceWriter::consumeEvents(const EventRecord* ev, size_t n, void* ctx) {
+    static_cast<TraceWriter*>(ctx)->append(ev, n);
+}
+
+#if defined(__linux__)
+
+bool TraceWriter::openSegment_locked() {
+    char path[4096];
+    std::snprintf(path, sizeof(path), "%s.%06u.mpt", prefix_.c_str(), index_);
+    fd_ = ::open(path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd_ < 0) return false;
+    if (::ftruncate(fd_, static_cast<off_t>(segment_bytes_)) != 0) {
+        ::close(fd_); fd_ = -1;
+        return false;
+    }
+    void* m = ::mmap(nullptr, segment_bytes_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (m == MAP_FAILED) {
+        ::close(fd_); fd_ = -1;
+        return false;
+    }
+    map_ = static_cast<char*>(m);
+    ::madvise(map_, segment_bytes_, MADV_SEQUENTIAL);
+
+    auto* h = reinterpret_cast<trace::SegmentHeader*>(map_);
+    std::memcpy(h->magic, trace::kMagic, sizeof(h->magic));
+    h->version         = trace::kVersion;
+    h->header_size     = sizeof(trace::SegmentHeader);
+    h->index           = index_;
+    h->pid             = static_cast<uint32_t>(::getpid());
+    h->base_ts_ns      = last_ts_ ? last_ts_ : steady_ns();
+    h->wall_ns         = realtime_ns();
+    h->sample_interval = EventPipeline::instance().sampleInterval();
+    h->records         = 0;
+    h->reserved        = 0;
+
+    used_    = sizeof(trace::SegmentHeader);
+    records_ = 0;
+    last_ts_ = h->base_ts_ns;
+    strings_.clear();
+    stacks_.clear();
+    ++index_;
+
+    writeModules_locked();
+    h->used = used_;
+    return true;
+}
+
+void TraceWriter::closeSegment_locked() {
+    if (!map_) return;
+    auto* h = reinterpret_cast<trace::SegmentHeader*>(map_);
+    h->used    = used_;
+    h->records = records_;
+    ::msync(map_, used_, MS_ASYNC);
+    ::munmap(map_, segment_bytes_);
+    map_ = nullptr;
+    // Si falla, el archivo conserva su tamaño completo: 'used' sigue siendo válido
+    (void)!::ftruncate(fd_, static_cast<off_t>(used_));
+    ::close(fd_);
+    fd_ = -1;
+}
+
+// Módulos cargados al abrir el segmento (base + ruta) para poder simbolizar
+// las direcciones de Stack y caller sin el proceso. Lo que se cargue después
+// aparece en el segmento siguiente.
+void TraceWriter::writeModules_locked() {
+    scratch_.clear();
+    dl_iterate_phdr([](dl_phdr_info* info, size_t, void* arg) -> int {
+        auto* out = static_cast<std::string*>(arg);
+        std::string path = info->dlpi_name ? info->dlpi_name : "";
+        if (path.empty()) {
+            char buf[4096];
+            const ssize_t n = ::readlink("/proc/self/exe", buf, sizeof(buf) - 1);
+            if (n > 0) path.assign(buf, static_cast<size_t>(n));
+        }
+        wire::Writer w(*out);
+        w.u8(static_cast<uint8_t>(trace::Rec::Module));
+        w.varint(info->dlpi_addr);
+        w.bytes(path);
+        return 0;
+    }, &scratch_);
+    const uint64_t room = segment_bytes_ - used_;
+    if (scratch_.size() <= room) {
+        std::memcpy(map_ + used_, scratch_.data(), scratch_.size());
+        used_ += scratch_.size();
+    }
+}
+
+#else
+
+bool TraceWriter::openSegment_locked() { return false; }
+void TraceWriter::closeSegment_locked() {}
+void TraceWriter::writeModules_locked() {}
+
+#endif
+
+uint32_t TraceWriter::stringId_locked(const char* s) {
+    if (!s) return 0;
+    auto it = strings_.find(s);
+    return it != strings_.end() ? it->second : 0;
+}
+
+// Registro del evento, precedido de las definiciones String/Stack que aún no
+// estén en el segmento actual
+void TraceWriter::encode_locked(const EventRecord& e, std::string& out) {
+    wire::Writer w(out);
+
+    auto def_string = [&](const char* s) {
+        if (!s || strings_.count(s)) return;
+        const auto id = static_cast<uint32_t>(strings_.size() + 1);
+        strings_.emplace(s, id);
+        w.u8(static_cast<uint8_t>(trace::Rec::String));
+        w.varint(id);
+        w.bytes(s);
+    };
+
+    if (e.kind == EventRecord::Alloc) {
+        def_string(e.file);
+        def_string(e.type);
+        if (e.stack && stacks_.insert(e.stack).second) {
+            uintptr_t pcs[StackTable::kMaxDepth];
+            const size_t depth = StackTable::instance().frames(e.stack, pcs, StackTable::kMaxDepth);
+            w.u8(static_cast<uint8_t>(trace::Rec::Stack));
+            w.varint(e.stack);
+            w.varint(depth);
+            for (size_t i = 0; i < depth; ++i) w.varint(pcs[i]);
+        }
+
+        w.u8(static_cast<uint8_t>(trace::Rec::Alloc));
+        w.zigzag(static_cast<int64_t>(e.ts_ns - last_ts_));
+        w.varint(e.ptr);
+        w.varint(e.size);
+        w.varint(stringId_locked(e.file));
+        w.zigzag(e.line);
+        w.varint(stringId_locked(e.type));
+        w.varint(e.thread);
+        const bool weighted = e.weight != 1.0f;
+        w.u8(static_cast<uint8_t>((e.is_array ? trace::AllocArray : 0) | (e.stack ? trace::AllocStack : 0) |
+                                  (e.caller ? trace::AllocCaller : 0) | (weighted ? trace::AllocWeight : 0)));
+        if (e.stack)  w.varint(e.stack);
+        if (e.caller) w.varint(e.caller);
+        if (weighted) {
+            uint32_t bits;
+            std::memcpy(&bits, &e.weight, sizeof(bits));
+            w.u32(bits);
+        }
+    } else {
+        w.u8(static_cast<uint8_t>(trace::Rec::Free));
+        w.zigzag(static_cast<int64_t>(e.ts_ns - last_ts_));
+        w.varint(e.ptr);
+        w.varint(e.thread);
+    }
+}
+
+void TraceWriter::append(const EventRecord* ev, size_t n) {
+    std::lock_guard<std::mutex> lk(mtx_);
+    if (!open_ || !map_) return;
+
+    for (size_t i = 0; i < n; ++i) {
+        scratch_.clear();
+        encode_locked(ev[i], scratch_);
+        if (used_ + scratch_.size() > segment_bytes_) {
+            // Segmento lleno: el siguiente empieza con tablas vacías, así que
+            // el registro se recodifica con sus definiciones
+            closeSegment_locked();
+            if (!openSegment_locked()) {
+                std::fprintf(stderr, "[memprof] trace: cannot open segment %u, recording stopped\n", index_);
+                open_ = false;
+                return;
+            }
+            scratch_.clear();
+            encode_locked(ev[i], scratch_);
+            if (used_ + scratch_.size() > segment_bytes_) {
+                // No cabe ni en uno vacío: se descarta, y con él las
+                // definiciones que encode_locked dio por emitidas (el
+                // segmento recién abierto solo lleva sus Module)
+                strings_.clear();
+                stacks_.clear();
+                continue;
+            }
+        }
+        std::memcpy(map_ + used_, scratch_.data(), scratch_.size());
+        used_ += scratch_.size();
+        last_ts_ = ev[i].ts_ns;
+        ++records_;
+    }
+
+    // Visible para un lector aunque el proceso muera antes de cerrar
+    auto* h = reinterpret_cast<trace::SegmentHeader*>(map_);
+    h->used    = used_;
+    h->records = records_;
+}
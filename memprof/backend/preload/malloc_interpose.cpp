@@ -0,0 +1,241 @@
+// memprof/backend/preload/malloc_interpose.cpp
+//
+// Interposición de la familia malloc para perfilar binarios sin recompilar:
+//
+//   LD_PRELOAD=/ruta/libmemprof_preload.so MEMPROF_HOST=127.0.0.1 MEMPROF_PORT=7070 ./app
+//   LD_PRELOAD=... MEMPROF_HOST=shm:/tmp/memprof.sock ./app   # misma máquina, sin TCP
+//
+// Cada función resuelve la real con dlsym(RTLD_NEXT) y registra el evento en
+// la misma tubería que usan los overrides de new/delete (memprof_record_*).
+// dlsym puede pedir memoria (calloc) antes de que haya nada resuelto: esas
+// peticiones salen de un arena estático que nunca se libera.
+#include <dlfcn.h>
+#include <malloc.h>
+#include <unistd.h>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include "memprof/memprof_api.h"
+
+#define MP_EXPORT extern "C" __attribute__((visibility("default")))
+
+namespace {
+
+using malloc_fn         = void* (*)(size_t);
+using free_fn           = void  (*)(void*);
+using calloc_fn         = void* (*)(size_t, size_t);
+using realloc_fn        = void* (*)(void*, size_t);
+using posix_memalign_fn = int   (*)(void**, size_t, size_t);
+using aligned_alloc_fn  = void* (*)(size_t, size_t);
+using memalign_fn       = void* (*)(size_t, size_t);
+
+struct Real {
+    malloc_fn         malloc = nullptr;
+    free_fn           free = nullptr;
+    calloc_fn         calloc = nullptr;
+    realloc_fn        realloc = nullptr;
+    posix_memalign_fn posix_memalign = nullptr;
+    aligned_alloc_fn  aligned_alloc = nullptr;
+    memalign_fn       memalign = nullptr;
+};
+Real g_real;
+
+enum : int { kUnresolved = 0, kResolving = 1, kResolved = 2 };
+std::atomic<int>  g_state{kUnresolved};
+std::atomic<bool> g_ready{false};    // runtime inicializado: a partir de aquí se registra
+
+// initial-exec: el acceso al TLS no puede acabar en __tls_get_addr -> malloc
+[[gnu::tls_model("initial-exec")]] thread_local bool t_in_hook = false;
+
+// ---------------------------------------------------------------------------
+// Arena de arranque: bump allocator para lo que pida dlsym. Cada bloque lleva
+// delante su tamaño (para realloc) y queda alineado a 16.
+// ---------------------------------------------------------------------------
+constexpr size_t kArenaSize = 64 * 1024;
+constexpr size_t kArenaHdr  = 16;
+alignas(16) unsigned char g_arena[kArenaSize];
+std::atomic<size_t>       g_arena_used{0};
+
+inline bool in_arena(const void* p) {
+    const auto* c = static_cast<const unsigned char*>(p);
+    return c >= g_arena && c < g_arena + kArenaSize;
+}
+
+void* arena_alloc(size_t n, size_t align = 16) {
+    if (align < 16) align = 16;
+    size_t off = g_arena_used.load(std::memory_order_relaxed);
+    for (;;) {
+        const size_t start = (off + kArenaHdr + align - 1) & ~(align - 1);
+        const size_t end   = start + ((n + 15) & ~size_t(15));
+        if (end > kArenaSize) return nullptr;
+        if (g_arena_used.compare_exchange_weak(off, end, std::memory_order_relaxed)) {
+            std::memcpy(g_arena + start - sizeof(size_t), &n, sizeof(size_t));
+            return g_arena + start;   // memoria estática: ya viene a cero
+        }
+    }
+}
+
+inline size_t arena_size(const void* p) {
+    size_t n;
+    std::memcpy(&n, static_cast<const unsigned char*>(p) - sizeof(size_t), sizeof(size_t));
+    return n;
+}
+
+template <typename Fn>
+inline Fn sym(const char* name) { return reinterpret_cast<Fn>(dlsym(RTLD_NEXT, name)); }
+
+// Devuelve true si las funciones reales están disponibles. Durante la
+// resolución (recursión desde dlsym u otro hilo) devuelve false y el
+// llamador tira del arena.
+bool resolve() {
+    int st = g_state.load(std::memory_order_acquire);
+    if (st == kResolved) return true;
+    if (st == kResolving) return false;
+    if (!g_state.compare_exchange_strong(st, kResolving, std::memory_order_acq_rel))
+        return g_state.load(std::memory_order_acquire) == kResolved;
+
+    g_real.malloc         = sym<malloc_fn>("malloc");
+    g_real.free           = sym<free_fn>("free");
+    g_real.calloc         = sym<calloc_fn>("calloc");
+    g_real.realloc        = sym<realloc_fn>("realloc");
+    g_real.posix_memalign = sym<posix_memalign_fn>("posix_memalign");
+    g_real.aligned_alloc  = sym<aligned_alloc_fn>("aligned_alloc");
+    g_real.memalign       = sym<memalign_fn>("memalign");
+    if (!g_real.malloc || !g_real.free || !g_real.calloc || !g_real.realloc) {
+        static const char msg[] = "[memprof] preload: dlsym(RTLD_NEXT) failed\n";
+        (void)!write(2, msg, sizeof(msg) - 1);
+        std::abort();
+    }
+    g_state.store(kResolved, std::memory_order_release);
+    return true;
+}
+
+// El registro reserva memoria a su vez: con t_in_hook esas llamadas van
+// directas a las funciones reales sin registrarse.
+struct HookScope {
+    bool active;
+    HookScope() noexcept : active(!t_in_hook && g_ready.load(std::memory_order_relaxed)) {
+        if (active) t_in_hook = true;
+    }
+    ~HookScope() { if (active) t_in_hook = false; }
+};
+
+// always_inline: la captura de pilas omite un nº fijo de marcos propios
+// (EventPipeline::kStackSkip), también sin optimizar. 'caller' se toma en
+// cada función exportada: es la dirección de retorno al programa.
+[[gnu::always_inline]] inline void record_alloc(const HookScope& hs, void* p, size_t n, const char* type,
+                                                const void* caller) {
+    if (hs.active && p) memprof_record_alloc_pc(p, n, type, caller);
+}
+inline void record_free(const HookScope& hs, void* p) {
+    if (hs.active && p) memprof_record_free(p);
+}
+
+} // anon
+
+// ============================ interposición ============================
+
+MP_EXPORT void* malloc(size_t n) {
+    if (!resolve()) return arena_alloc(n);
+    HookScope hs;
+    void* p = g_real.malloc(n);
+    record_alloc(hs, p, n, "malloc", __builtin_return_address(0));
+    return p;
+}
+
+MP_EXPORT void free(void* p) {
+    if (!p || in_arena(p)) return;
+    if (!resolve()) return;          // no puede venir de la libc real todavía
+    HookScope hs;
+    record_free(hs, p);              // antes de liberar: la dirección aún no se reutiliza
+    g_real.free(p);
+}
+
+MP_EXPORT void* calloc(size_t n, size_t sz) {
+    if (sz != 0 && n > SIZE_MAX / sz) { errno = ENOMEM; return nullptr; }
+    if (!resolve()) return arena_alloc(n * sz);
+    HookScope hs;
+    void* p = g_real.calloc(n, sz);
+    record_alloc(hs, p, n * sz, "calloc", __builtin_return_address(0));
+    return p;
+}
+
+MP_EXPORT void* realloc(void* old, size_t n) {
+    if (old && in_arena(old)) {
+        // Bloque del arena: se migra a memoria real (el viejo no se libera)
+        void* p = malloc(n);
+        if (p) {
+            const size_t k = arena_size(old);
+            std::memcpy(p, old, k < n ? k : n);
+        }
+        return p;
+    }
+    if (!resolve()) return old ? nullptr : arena_alloc(n);
+    HookScope hs;
+    // El free de 'old' se registra antes, como en free(): después otro hilo
+    // podría recibir la misma dirección y registrar su alloc primero
+    const size_t old_n = old ? malloc_usable_size(old) : 0;
+    record_free(hs, old);
+    void* p = g_real.realloc(old, n);
+    if (!p && n != 0) {
+        // Falló: 'old' sigue vivo (con el tamaño utilizable, el pedido se perdió)
+        record_alloc(hs, old, old_n, "realloc", __builtin_return_address(0));
+        return p;
+    }
+    record_alloc(hs, p, n, "realloc", __builtin_return_address(0));   // realloc(p, 0) libera
+    return p;
+}
+
+MP_EXPORT int posix_memalign(void** out, size_t align, size_t n) {
+    if (!resolve()) {
+        void* p = arena_alloc(n, align);
+        if (!p) return ENOMEM;
+        *out = p;
+        return 0;
+    }
+    HookScope hs;
+    const int rc = g_real.posix_memalign(out, align, n);
+    if (rc == 0) record_alloc(hs, *out, n, "posix_memalign", __builtin_return_address(0));
+    return rc;
+}
+
+MP_EXPORT void* aligned_alloc(size_t align, size_t n) {
+    if (!resolve()) return arena_alloc(n, align);
+    HookScope hs;
+    void* p = g_real.aligned_alloc(align, n);
+    record_alloc(hs, p, n, "aligned_alloc", __builtin_return_address(0));
+    return p;
+}
+
+MP_EXPORT void* memalign(size_t align, size_t n) {
+    if (!resolve()) return arena_alloc(n, align);
+    HookScope hs;
+    void* p = g_real.memalign(align, n);
+    record_alloc(hs, p, n, "memalign", __builtin_return_address(0));
+    return p;
+}
+
+// ============================ ciclo de vida ============================
+// Este TU se enlaza el último en la .so: su constructor corre después de la
+// inicialización estática del runtime (Runtime.cpp, EventPipeline.cpp).
+
+__attribute__((constructor)) static void memprof_preload_init() {
+    resolve();
+    const char* host = std::getenv("MEMPROF_HOST");
+    const char* port = std::getenv("MEMPROF_PORT");
+    t_in_hook = true;
+    memprof_init(host && *host ? host : "127.0.0.1", port && *port ? std::atoi(port) : 7070);
+    t_in_hook = false;
+    g_ready.store(true, std::memory_order_release);
+}
+
+__attribute__((destructor)) static void memprof_preload_fini() {
+    g_ready.store(false, std::memory_order_release);
+    t_in_hook = true;
+    memprof_shutdown();
+    t_in_hook = false;
+}
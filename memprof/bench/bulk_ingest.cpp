@@ -0,0 +1,150 @@
+// memprof/bench/bulk_ingest.cpp
+// Ingesta de un log NDJSON de ALLOC/FREE: processEvent línea a línea frente a
+// ingestEvents con 1..N hilos. Comprueba además que ambos caminos dejan el
+// mismo estado (totales, pico, estadísticas por archivo, clases de tamaño y
+// vidas por sitio).
+//
+// Uso: bench_bulk_ingest [max_hilos] [eventos]
+#include "memprof/core/MetricsAggregator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr uint64_t kWindow = 4096;   // bloques vivos a la vez
+constexpr uint64_t kLeakEvery = 97;  // una de cada N allocs no se libera nunca
+
+inline uintptr_t fake_ptr(uint64_t i) { return (uintptr_t(1) << 40) | (uintptr_t(i) << 4); }
+
+// Log sintético: allocs con una ventana deslizante de frees, 16 sitios
+std::string make_log(uint64_t allocs) {
+    static const char* files[] = {"src/a.cpp", "src/b.cpp", "src/c.cpp", "src/dir/d.cpp"};
+    static const char* types[] = {"int", "Node", "std::string", "char"};
+    std::string out;
+    out.reserve(allocs * 2 * 110);
+    char line[256];
+    uint64_t ts = 1'000'000;
+    for (uint64_t i = 0; i < allocs; ++i) {
+        const unsigned s = unsigned(i % 16);
+        std::snprintf(line, sizeof(line),
+                      "{\"kind\":\"ALLOC\",\"ptr\":\"0x%llx\",\"size\":%llu,\"ts_ns\":%llu,\"file\":\"%s\","
+                      "\"line\":%u,\"type\":\"%s\",\"is_array\":%s}\n",
+                      (unsigned long long)fake_ptr(i), (unsigned long long)(16 + (i * 7919) % 4096),
+                      (unsigned long long)(ts += 100), files[s % 4], 10 + s, types[s / 4],
+                      (s & 1) ? "true" : "false");
+        out += line;
+        if (i >= kWindow && (i - kWindow) % kLeakEvery != 0) {
+            std::snprintf(line, sizeof(line), "{\"kind\":\"FREE\",\"ptr\":\"0x%llx\",\"size\":0,\"ts_ns\":%llu}\n",
+                          (unsigned long long)fake_ptr(i - kWindow), (unsigned long long)(ts += 100));
+            out += line;
+        }
+    }
+    return out;
+}
+
+struct State {
+    uint64_t cur = 0, peak = 0, active = 0, total = 0, leak = 0;
+    std::unordered_map<std::string, MetricsAggregator::FileStats> files;
+    std::vector<MetricsAggregator::SizeBin> bins;
+    std::unordered_map<std::string, MetricsAggregator::LifetimeStats> lives;   // por "file:line:type"
+};
+
+State state_of(MetricsAggregator& agg) {
+    State s;
+    agg.getMetrics(s.cur, s.peak, s.active, s.total, s.leak);
+    s.files = agg.getFileStats();
+    s.bins  = agg.getSizeBins();
+    // Los SiteId dependen del orden de interning: se comparan por nombre
+    std::vector<MetricsAggregator::LifetimeStats> lives;
+    agg.collectLifetimeStats(lives, true);
+    for (const auto& l : lives) {
+        const auto cs = agg.getSite(l.site);
+        s.lives[cs.file + ':' + std::to_string(cs.line) + ':' + cs.type] = l;
+    }
+    return s;
+}
+
+bool same(const State& a, const State& b) {
+    if (a.cur != b.cur || a.peak != b.peak || a.active != b.active || a.total != b.total) return false;
+    if (a.files.size() != b.files.size()) return false;
+    for (const auto& [name, fa] : a.files) {
+        auto it = b.files.find(name);
+        if (it == b.files.end()) return false;
+        const auto& fb = it->second;
+        if (fa.alloc_count != fb.alloc_count || fa.alloc_bytes != fb.alloc_bytes ||
+            fa.live_count != fb.live_count || fa.live_bytes != fb.live_bytes)
+            return false;
+    }
+    if (a.bins.size() != b.bins.size()) return false;
+    for (size_t i = 0; i < a.bins.size(); ++i) {
+        const auto& x = a.bins[i];
+        const auto& y = b.bins[i];
+        if (x.lo != y.lo || x.bytes != y.bytes || x.count != y.count ||
+            x.alloc_bytes != y.alloc_bytes || x.alloc_count != y.alloc_count)
+            return false;
+    }
+    if (a.lives.size() != b.lives.size()) return false;
+    for (const auto& [name, la] : a.lives) {
+        auto it = b.lives.find(name);
+        if (it == b.lives.end()) return false;
+        const auto& lb = it->second;
+        if (la.frees != lb.frees || la.freed_bytes != lb.freed_bytes || la.short_lived != lb.short_lived ||
+            la.p50_ns != lb.p50_ns || la.p99_ns != lb.p99_ns)
+            return false;
+    }
+    return true;
+}
+
+double secs_since(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+} // anon
+
+int main(int argc, char** argv) {
+    const unsigned hw = std::max(1u, std::thread::hardware_concurrency());
+    const unsigned max_threads = argc > 1 ? unsigned(std::atoi(argv[1])) : hw;
+    const uint64_t allocs      = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1'000'000ULL;
+
+    const std::string log = make_log(allocs);
+    uint64_t events = 0;
+    for (char c : log) events += c == '\n';
+    std::printf("log: %llu eventos, %.1f MB\n", (unsigned long long)events, double(log.size()) / 1e6);
+
+    // Referencia: una línea por llamada
+    MetricsAggregator seq;
+    auto t0 = std::chrono::steady_clock::now();
+    size_t from = 0;
+    std::string line;
+    while (from < log.size()) {
+        size_t nl = log.find('\n', from);
+        if (nl == std::string::npos) nl = log.size();
+        line.assign(log, from, nl - from);
+        seq.processEvent(line);
+        from = nl + 1;
+    }
+    const double base = secs_since(t0);
+    const State ref = state_of(seq);
+    std::printf("%8s %14s %10s %8s\n", "threads", "[Mevents/s]", "speedup", "estado");
+    std::printf("%8s %14.2f %10s %8s\n", "line", double(events) / base / 1e6, "1.00x", "ref");
+
+    int rc = 0;
+    for (unsigned n = 1; n <= max_threads; n = (n < max_threads && n * 2 > max_threads) ? max_threads : n * 2) {
+        MetricsAggregator bulk;
+        t0 = std::chrono::steady_clock::now();
+        const size_t got = bulk.ingestEvents(log, n);
+        const double secs = secs_since(t0);
+        const bool ok = got == events && same(ref, state_of(bulk));
+        if (!ok) rc = 1;
+        std::printf("%8u %14.2f %9.2fx %8s\n", n, double(events) / secs / 1e6, base / secs, ok ? "ok" : "DIFIERE");
+        if (n == max_threads) break;
+    }
+    return rc;
+}
@@ -0,0 +1,184 @@
+// memprof/bench/json_snapshot.cpp
+// Serialización de la sección "leaks" del snapshot JSON (modo depuración del
+// runtime) con N bloques vivos: el camino anterior (std::ostringstream +
+// json_escape) frente a json::Writer sobre un buffer reutilizado entre ticks.
+// Comprueba que ambos producen exactamente los mismos bytes.
+//
+// Uso: bench_json_snapshot [bloques] [ticks]   (medir en Release: sin
+// optimizar pesan las llamadas pequeñas del escritor)
+#include "memprof/proto/JsonWriter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Site  { uintptr_t pc; std::string file; int line; std::string type; };
+struct Block { uintptr_t ptr; uint64_t size; uint32_t site; uint64_t ts_ns; bool is_leak; uint32_t stack; };
+
+// ---- camino anterior (copia de Runtime.cpp antes de json::Writer) ----
+
+std::string json_escape(const std::string& s) {
+    std::string out; out.reserve(s.size() + 8);
+    for (unsigned char c : s) {
+        switch (c) {
+            case '\"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\b': out += "\\b";  break;
+            case '\f': out += "\\f";  break;
+            case '\n': out += "\\n";  break;
+            case '\r': out += "\\r";  break;
+            case '\t': out += "\\t";  break;
+            default:
+                if (c < 0x20) {
+                    char buf[7];
+                    std::snprintf(buf, sizeof(buf), "\\u%04X", c);
+                    out += buf;
+                } else {
+                    out += static_cast<char>(c);
+                }
+        }
+    }
+    return out;
+}
+
+const char* ptr_to_hex(uintptr_t p, char (&buf)[2 + sizeof(void*) * 2 + 1]) {
+    static constexpr char kDigits[] = "0123456789ABCDEF";
+    constexpr int n = sizeof(void*) * 2;
+    buf[0] = '0'; buf[1] = 'x';
+    for (int i = n - 1; i >= 0; --i) { buf[2 + i] = kDigits[p & 0xF]; p >>= 4; }
+    buf[2 + n] = '\0';
+    return buf;
+}
+
+void legacy(const std::vector<Site>& sites, const std::vector<Block>& blocks, std::string& out) {
+    std::ostringstream ss;
+    std::vector<std::string> site_file(sites.size()), site_type(sites.size());
+    for (size_t i = 0; i < sites.size(); ++i) {
+        site_file[i] = json_escape(sites[i].file);
+        site_type[i] = json_escape(sites[i].type);
+    }
+    char hexbuf[2 + sizeof(void*) * 2 + 1];
+    ss << "\"leaks\":[";
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        const auto& b = blocks[i];
+        const size_t site = b.site;
+        if (i) ss << ',';
+        ss << '{'
+           << "\"ptr\":\""   << ptr_to_hex(b.ptr, hexbuf) << "\","
+           << "\"size\":"    << b.size << ',';
+        if (sites[site].pc) ss << "\"pc\":\"" << ptr_to_hex(sites[site].pc, hexbuf) << "\",";
+        ss
+           << "\"file\":\""  << site_file[site] << "\","
+           << "\"line\":"    << sites[site].line << ','
+           << "\"type\":\""  << site_type[site] << "\","
+           << "\"ts_ns\":"   << b.ts_ns << ','
+           << "\"is_leak\":" << (b.is_leak ? "true" : "false") << ','
+           << "\"stack\":"   << b.stack
+           << '}';
+    }
+    ss << ']';
+    out = ss.str();
+}
+
+// ---- json::Writer (mismo esquema que write_json en Runtime.cpp) ----
+
+struct Scratch {
+    std::string           text;
+    std::vector<uint32_t> off;
+};
+
+void writer(const std::vector<Site>& sites, const std::vector<Block>& blocks,
+            Scratch& js, std::string& out) {
+    js.text.clear();
+    js.off.clear();
+    json::Writer e(js.text);
+    js.off.push_back(0);
+    for (const auto& s : sites) {
+        e.escape(s.file); js.off.push_back(static_cast<uint32_t>(js.text.size()));
+        e.escape(s.type); js.off.push_back(static_cast<uint32_t>(js.text.size()));
+    }
+    auto piece = [&js](size_t k) {
+        return std::string_view(js.text.data() + js.off[k], js.off[k + 1] - js.off[k]);
+    };
+
+    out.clear();
+    json::Writer w(out);
+    w.raw("\"leaks\":[");
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        const auto& b = blocks[i];
+        const size_t site = b.site;
+        if (i) w.ch(',');
+        w.ch('{');
+        w.key("ptr");  w.hex(b.ptr);  w.ch(',');
+        w.key("size"); w.u64(b.size); w.ch(',');
+        if (sites[site].pc) { w.key("pc"); w.hex(sites[site].pc); w.ch(','); }
+        w.key("file"); w.ch('"'); w.raw(piece(2 * site)); w.raw("\",");
+        w.key("line"); w.i64(sites[site].line); w.ch(',');
+        w.key("type"); w.ch('"'); w.raw(piece(2 * site + 1)); w.raw("\",");
+        w.key("ts_ns");   w.u64(b.ts_ns);       w.ch(',');
+        w.key("is_leak"); w.boolean(b.is_leak); w.ch(',');
+        w.key("stack");   w.u64(b.stack);
+        w.ch('}');
+    }
+    w.ch(']');
+}
+
+// 256 sitios (algunos con rutas que necesitan escape) y bloques repartidos
+void make_data(size_t n, std::vector<Site>& sites, std::vector<Block>& blocks) {
+    static const char* types[] = {"int", "Node", "std::string", "std::vector<int>", "char"};
+    for (unsigned s = 0; s < 256; ++s) {
+        std::string file = "src/module" + std::to_string(s % 32) + "/file" + std::to_string(s) + ".cpp";
+        if (s % 17 == 0) file = "C:\\proj\\src\\win" + std::to_string(s) + ".cpp";
+        if (s % 53 == 0) file += "\t\"raro\"";
+        sites.push_back({s % 3 ? uintptr_t(0x400000 + s * 0x40) : 0, file, int(10 + s), types[s % 5]});
+    }
+    blocks.reserve(n);
+    uint64_t ts = 1'000'000;
+    for (size_t i = 0; i < n; ++i)
+        blocks.push_back({(uintptr_t(0x7f00) << 32) | (uintptr_t(i) << 4),
+                          16 + (i * 7919) % 4096, uint32_t((i * 31) % sites.size()),
+                          ts += 137, i % 11 == 0, uint32_t(1 + i % 1000)});
+}
+
+double ms_since(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const size_t n     = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1'000'000;
+    const int    ticks = argc > 2 ? std::max(1, std::atoi(argv[2])) : 5;
+
+    std::vector<Site> sites;
+    std::vector<Block> blocks;
+    make_data(n, sites, blocks);
+    std::printf("bloques: %zu  sitios: %zu  ticks: %d\n", blocks.size(), sites.size(), ticks);
+
+    // El buffer de salida de cada camino vive entre ticks, como en el runtime
+    std::string a, b;
+    Scratch js;
+    double ta = 1e300, tb = 1e300;
+    for (int k = 0; k < ticks; ++k) {
+        auto t0 = std::chrono::steady_clock::now();
+        legacy(sites, blocks, a);
+        ta = std::min(ta, ms_since(t0));
+
+        t0 = std::chrono::steady_clock::now();
+        writer(sites, blocks, js, b);
+        tb = std::min(tb, ms_since(t0));
+    }
+
+    const bool same = a == b;
+    std::printf("%-14s %10.1f ms  %8.1f MB/s\n", "ostringstream", ta, a.size() / 1e3 / ta);
+    std::printf("%-14s %10.1f ms  %8.1f MB/s  (x%.1f)\n", "json::Writer", tb, b.size() / 1e3 / tb, ta / tb);
+    std::printf("salida: %.1f MB  %s\n", b.size() / 1e6, same ? "idéntica" : "DISTINTA");
+    return same ? 0 : 1;
+}
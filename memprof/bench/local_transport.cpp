@@ -0,0 +1,190 @@
+// memprof/bench/local_transport.cpp
+// Coste por tick de cada transporte runtime -> GUI en la misma máquina:
+// TCP por loopback, socket AF_UNIX y anillo en memoria compartida. Un hilo
+// lector hace de GUI; por cada trama se mide desde sendAll hasta que el lector
+// la tiene entera (latencia) y el CPU del proceso (emisor + lector). Comprueba
+// además que los bytes llegan intactos.
+//
+// Uso: bench_local_transport [trama_KB] [tramas]
+#include "memprof/core/TcpClient.h"
+#include "memprof/proto/LocalChannel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr int kPort = 7181;
+
+// Patrón de periodo 251: el byte en la posición absoluta i es (i % 251) * 31 % 251.
+// g_ref lo repite de forma que g_ref + (i % 251) vale para cualquier tramo
+// de hasta kRefSpan bytes (memcmp/memcpy en vez de byte a byte).
+constexpr size_t kPeriod  = 251;
+constexpr size_t kRefSpan = 4u << 20;
+std::vector<char> g_ref;
+
+const char* ref_at(uint64_t at) { return g_ref.data() + at % kPeriod; }
+
+// Lector: cuenta bytes, verifica el patrón y despierta al emisor
+struct Sink {
+    std::atomic<uint64_t> got{0};
+    std::atomic<bool>     bad{false};
+    void feed(const char* p, size_t n) {
+        const uint64_t at = got.load(std::memory_order_relaxed);
+        for (size_t off = 0; off < n; off += kRefSpan) {
+            const size_t k = std::min(kRefSpan, n - off);
+            if (std::memcmp(p + off, ref_at(at + off), k) != 0) bad.store(true, std::memory_order_relaxed);
+        }
+        got.store(at + n, std::memory_order_release);
+        got.notify_one();
+    }
+};
+
+int listen_tcp() {
+    const int s = ::socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    ::setsockopt(s, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in a{};
+    a.sin_family = AF_INET;
+    a.sin_port = htons(kPort);
+    a.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::bind(s, reinterpret_cast<sockaddr*>(&a), sizeof(a)) != 0 || ::listen(s, 1) != 0) { ::close(s); return -1; }
+    return s;
+}
+
+int listen_unix(const std::string& path) {
+    ::unlink(path.c_str());
+    const int s = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un a{};
+    a.sun_family = AF_UNIX;
+    std::strncpy(a.sun_path, path.c_str(), sizeof(a.sun_path) - 1);
+    if (::bind(s, reinterpret_cast<sockaddr*>(&a), sizeof(a)) != 0 || ::listen(s, 1) != 0) { ::close(s); return -1; }
+    return s;
+}
+
+// GUI de mentira: stream (tcp/unix) o anillo (shm), hasta que el emisor cierre
+void reader(int lfd, Sink& sink) {
+    const int c = ::accept(lfd, nullptr, nullptr);
+    if (c < 0) return;
+    std::vector<char> buf(256 * 1024);
+    iovec iov{buf.data(), buf.size()};
+    alignas(cmsghdr) char ctrl[CMSG_SPACE(2 * sizeof(int))];
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = ctrl;
+    msg.msg_controllen = sizeof(ctrl);
+    ssize_t n = ::recvmsg(c, &msg, 0);
+    cmsghdr* cm = n == 1 && buf[0] == shmring::kHello ? CMSG_FIRSTHDR(&msg) : nullptr;
+    if (!cm) {
+        while (n > 0) {
+            sink.feed(buf.data(), size_t(n));
+            n = ::recv(c, buf.data(), buf.size(), 0);
+        }
+        ::close(c);
+        return;
+    }
+    int fds[2];
+    std::memcpy(fds, CMSG_DATA(cm), sizeof(fds));
+    struct stat st{};
+    ::fstat(fds[0], &st);
+    auto* ring = static_cast<shmring::Header*>(
+        ::mmap(nullptr, size_t(st.st_size), PROT_READ | PROT_WRITE, MAP_SHARED, fds[0], 0));
+    ::close(fds[0]);
+    if (ring == MAP_FAILED || !shmring::valid(ring, size_t(st.st_size))) { sink.bad = true; ::close(c); return; }
+    pollfd p[2] = {{fds[1], POLLIN, 0}, {c, POLLIN, 0}};
+    for (;;) {
+        ::poll(p, 2, -1);
+        if (p[0].revents & POLLIN) {
+            uint64_t v;
+            [[maybe_unused]] ssize_t r = ::read(fds[1], &v, sizeof(v));
+        }
+        shmring::read(ring, [&](const char* d, size_t k) { sink.feed(d, k); });
+        if (p[1].revents) break;   // el emisor cerró
+    }
+    ::munmap(ring, size_t(st.st_size));
+    ::close(fds[1]);
+    ::close(c);
+}
+
+double cpu_secs() {
+    rusage ru{};
+    ::getrusage(RUSAGE_SELF, &ru);
+    return double(ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) + double(ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1e6;
+}
+
+bool run(const char* name, const char* endpoint, int lfd, size_t frame, int frames) {
+    if (lfd < 0) { std::printf("%8s  no se pudo escuchar\n", name); return false; }
+    std::string payload(frame, '\0');
+    Sink sink;
+    std::thread th(reader, lfd, std::ref(sink));
+    TcpClient client;
+    if (!client.connectTo(endpoint, kPort)) {
+        std::printf("%8s  no conecta\n", name);
+        ::shutdown(lfd, SHUT_RDWR);
+        th.join();
+        return false;
+    }
+
+    std::vector<double> lat;
+    lat.reserve(size_t(frames));
+    uint64_t sent = 0;
+    bool ok = true;
+    const double cpu0 = cpu_secs();
+    for (int f = 0; f < frames && ok; ++f) {
+        for (size_t off = 0; off < frame; off += kRefSpan)
+            std::memcpy(&payload[off], ref_at(sent + off), std::min(kRefSpan, frame - off));
+        const auto t0 = std::chrono::steady_clock::now();
+        ok = client.sendAll(payload.data(), payload.size());
+        sent += frame;
+        for (uint64_t g; ok && (g = sink.got.load(std::memory_order_acquire)) < sent;) sink.got.wait(g);
+        lat.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count());
+    }
+    const double cpu = cpu_secs() - cpu0;
+    client.close();
+    th.join();
+    ::close(lfd);
+
+    ok = ok && !sink.bad && sink.got == sent;
+    std::sort(lat.begin(), lat.end());
+    std::printf("%8s %12.1f %12.1f %14.1f %8s\n", name, lat[lat.size() / 2], lat[lat.size() * 99 / 100],
+                cpu / frames * 1e6, ok ? "ok" : "ERROR");
+    return ok;
+}
+
+} // anon
+
+int main(int argc, char** argv) {
+    const size_t frame = (argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 64) * 1024;
+    const int frames   = argc > 2 ? std::atoi(argv[2]) : 2000;
+    const std::string path = "/tmp/memprof-bench-" + std::to_string(::getpid()) + ".sock";
+    g_ref.resize(kRefSpan + kPeriod);
+    for (size_t i = 0; i < g_ref.size(); ++i) g_ref[i] = char((i % kPeriod) * 31 % kPeriod);
+
+    std::printf("trama %zu KB, %d tramas\n", frame / 1024, frames);
+    std::printf("%8s %12s %12s %14s %8s\n", "", "p50 [us]", "p99 [us]", "CPU/trama [us]", "datos");
+    int rc = 0;
+    rc |= !run("tcp",  "127.0.0.1", listen_tcp(), frame, frames);
+    rc |= !run("unix", ("unix:" + path).c_str(), listen_unix(path), frame, frames);
+    rc |= !run("shm",  ("shm:" + path).c_str(), listen_unix(path), frame, frames);
+    ::unlink(path.c_str());
+    return rc;
+}
@@ -0,0 +1,190 @@
+// memprof/bench/registry_scaling.cpp
+// Coste de register_alloc/register_free con 1..N hilos, comparado con la
+// implementación anterior (un std::mutex global + std::unordered_map).
+//
+// La API legacy publica en la tubería de eventos y la tabla la escribe un
+// solo hilo (el que drena). Las dos mitades se miden por separado, por
+// rondas: los productores publican a la vez como mucho un anillo lleno cada
+// uno (ninguno se para a drenar) y después el hilo principal aplica la ronda.
+//   push:  coste por operación en cada productor y su total agregado; es lo
+//          que pagan los hilos de la aplicación y lo que debe escalar.
+//   apply: ritmo del aplicado en serie (drenar, ordenar, tabla); no escala
+//          con los hilos y acota lo que se puede sostener de forma continua.
+// La referencia (lock global) se mide de extremo a extremo: en ella el
+// productor paga también el aplicado.
+//
+// Uso: bench_registry_scaling [max_hilos] [ops_por_hilo]
+#include "registry.hpp"
+#include "memprof/core/EventPipeline.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+// ---- Referencia: el esquema antiguo (lock global) ----
+struct GlobalLockRegistry {
+    std::mutex mtx;
+    std::unordered_map<void*, memprof::AllocInfo> live;
+
+    void alloc(void* p, std::size_t n) {
+        memprof::AllocInfo ai; ai.size = n;
+        std::lock_guard<std::mutex> lk(mtx);
+        live[p] = ai;
+    }
+    void free(void* p) {
+        std::lock_guard<std::mutex> lk(mtx);
+        live.erase(p);
+    }
+};
+
+constexpr std::size_t kWindow = 1024; // bloques vivos por hilo
+
+// Direcciones sintéticas únicas por hilo (alineadas a 16 como malloc)
+inline void* fake_ptr(unsigned t, std::uint64_t i) {
+    return reinterpret_cast<void*>((std::uintptr_t(t + 1) << 40) | (std::uintptr_t(i % (kWindow * 4)) << 4));
+}
+
+using Clock = std::chrono::steady_clock;
+
+inline double seconds(Clock::time_point a, Clock::time_point b) {
+    return std::chrono::duration<double>(b - a).count();
+}
+
+// Paso 'i' de un hilo: alloc + free de hace kWindow; pasado 'ops', solo los
+// frees que quedan. Como mucho dos eventos por paso.
+template <typename AllocFn, typename FreeFn>
+inline void step(unsigned t, std::uint64_t i, std::uint64_t ops, AllocFn& alloc, FreeFn& release) {
+    if (i < ops) {
+        alloc(fake_ptr(t, i), 16 + (i & 255));
+        if (i >= kWindow) release(fake_ptr(t, i - kWindow));
+    } else {
+        release(fake_ptr(t, i - kWindow));
+    }
+}
+
+inline std::uint64_t total_steps(std::uint64_t ops) { return ops + std::min<std::uint64_t>(ops, kWindow); }
+
+// Barrera de espera activa (productores + hilo principal)
+class SpinBarrier {
+public:
+    explicit SpinBarrier(unsigned n) : n_(n) {}
+    void wait() {
+        const unsigned g = gen_.load(std::memory_order_acquire);
+        if (count_.fetch_add(1, std::memory_order_acq_rel) + 1 == n_) {
+            count_.store(0, std::memory_order_relaxed);
+            gen_.fetch_add(1, std::memory_order_release);
+            return;
+        }
+        while (gen_.load(std::memory_order_acquire) == g) std::this_thread::yield();
+    }
+private:
+    const unsigned        n_;
+    std::atomic<unsigned> count_{0};
+    std::atomic<unsigned> gen_{0};
+};
+
+// Referencia: alloc+free por segundo, de extremo a extremo
+template <typename AllocFn, typename FreeFn>
+double run_global(unsigned nthreads, std::uint64_t ops, AllocFn alloc, FreeFn release) {
+    std::vector<std::thread> th;
+    th.reserve(nthreads);
+    const auto t0 = Clock::now();
+    for (unsigned t = 0; t < nthreads; ++t) {
+        th.emplace_back([=]() mutable {
+            for (std::uint64_t i = 0, n = total_steps(ops); i < n; ++i) step(t, i, ops, alloc, release);
+        });
+    }
+    for (auto& x : th) x.join();
+    return double(nthreads) * double(ops) * 2.0 / seconds(t0, Clock::now());
+}
+
+struct PipelineResult {
+    double push_ns_per_op = 0;   // media por productor
+    double push_ops       = 0;   // agregado [ops/s] durante las fases de push
+    double apply_ops      = 0;   // aplicado en serie [ops/s]
+};
+
+// Tubería por rondas: en cada una los productores publican como mucho un
+// anillo (kRingCapacity eventos) y el hilo principal lo aplica con drain(true)
+PipelineResult run_pipeline(unsigned nthreads, std::uint64_t ops) {
+    constexpr std::uint64_t kRound = EventPipeline::kRingCapacity / 2;   // pasos por ronda
+    const std::uint64_t steps  = total_steps(ops);
+    const std::uint64_t rounds = (steps + kRound - 1) / kRound;
+
+    auto alloc   = [](void* p, std::size_t sz) { memprof::register_alloc(p, sz, nullptr, 0, nullptr, false); };
+    auto release = [](void* p) { memprof::register_free(p); };
+
+    SpinBarrier barrier(nthreads + 1);
+    std::vector<double> busy(nthreads, 0.0);   // segundos de push de cada productor
+    std::vector<std::thread> th;
+    th.reserve(nthreads);
+    for (unsigned t = 0; t < nthreads; ++t) {
+        th.emplace_back([&, t]() mutable {
+            for (std::uint64_t r = 0; r < rounds; ++r) {
+                barrier.wait();
+                const auto a = Clock::now();
+                for (std::uint64_t i = r * kRound, e = std::min(steps, i + kRound); i < e; ++i)
+                    step(t, i, ops, alloc, release);
+                busy[t] += seconds(a, Clock::now());
+                barrier.wait();
+            }
+        });
+    }
+
+    double push_wall = 0, apply_wall = 0;
+    for (std::uint64_t r = 0; r < rounds; ++r) {
+        barrier.wait();
+        const auto a = Clock::now();
+        barrier.wait();                            // todos publicaron
+        const auto b = Clock::now();
+        EventPipeline::instance().drain(true);     // aplica la ronda
+        apply_wall += seconds(b, Clock::now());
+        push_wall  += seconds(a, b);
+    }
+    for (auto& x : th) x.join();
+
+    const double events = double(nthreads) * double(ops) * 2.0;
+    double busy_sum = 0;
+    for (double b : busy) busy_sum += b;
+    PipelineResult out;
+    out.push_ns_per_op = busy_sum / events * 1e9;
+    out.push_ops       = events / push_wall;
+    out.apply_ops      = events / apply_wall;
+    return out;
+}
+
+} // anon
+
+int main(int argc, char** argv) {
+    const unsigned hw = std::max(1u, std::thread::hardware_concurrency());
+    const unsigned max_threads = argc > 1 ? unsigned(std::atoi(argv[1])) : hw;
+    const std::uint64_t ops    = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1'000'000ULL;
+
+    std::printf("%8s %14s %14s %15s %15s %12s\n", "threads", "push [ns/op]", "push [Mops/s]",
+                "apply [Mops/s]", "global [Mops/s]", "push/global");
+    for (unsigned n = 1; n <= max_threads; n = (n < max_threads && n * 2 > max_threads) ? max_threads : n * 2) {
+        const PipelineResult pipe = run_pipeline(n, ops);
+        const std::uint64_t left = memprof::active_allocs();
+
+        GlobalLockRegistry ref;
+        const double global = run_global(n, ops,
+            [&ref](void* p, std::size_t sz) { ref.alloc(p, sz); },
+            [&ref](void* p) { ref.free(p); });
+
+        std::printf("%8u %14.1f %14.2f %15.2f %15.2f %11.2fx\n", n, pipe.push_ns_per_op,
+                    pipe.push_ops / 1e6, pipe.apply_ops / 1e6, global / 1e6, pipe.push_ops / global);
+        if (left != 0)
+            std::printf("  [!] quedaron %llu bloques vivos\n", (unsigned long long)left);
+        if (n == max_threads) break;
+    }
+    return 0;
+}
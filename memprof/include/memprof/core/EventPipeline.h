@@ -0,0 +1,129 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "memprof/core/EventRecord.h"
+#include "memprof/core/StackTable.h"
+
+// Tubería de eventos entre los hooks de new/delete y los consumidores
+// (MetricsAggregator, registro legacy...).
+//
+// Cada hilo productor escribe en su propio anillo SPSC (sin locks: un store
+// relaxed del registro y un store release del índice). Un hilo consumidor
+// drena todos los anillos cada pocos ms, ordena el lote por timestamp y lo
+// entrega de una vez a los consumidores registrados.
+//
+// Si el anillo de un hilo se llena, ese hilo drena él mismo (toma el papel de
+// consumidor) o cede la CPU hasta que haya hueco: nunca se pierden eventos.
+// Los hilos del profiler (consumidor, sender) usan ScopedSuppress.
+//
+// Modo muestreo (setSampleInterval / MEMPROF_SAMPLE_RATE): cada hilo registra
+// solo las allocs en las que cae un punto de un proceso de Poisson sobre los
+// bytes asignados (intervalo medio R, como el heap profiler de tcmalloc). Una
+// alloc de n bytes se muestrea con p = 1 - exp(-n/R) y lleva peso 1/p, de modo
+// que los agregados ponderados son estimadores insesgados. Los frees se
+// filtran con un mapa de bits de punteros muestreados (los falsos positivos
+// llegan como frees de bloques desconocidos y se ignoran).
+//
+// Captura de pilas (setStackDepth / MEMPROF_STACK_DEPTH, MEMPROF_STACK_MODE=fp):
+// cada alloc registrada lleva el id de su pila en StackTable.
+class EventPipeline {
+public:
+    // Consumidor de lotes ordenados por ts. Se invoca desde el hilo que drena.
+    using Consumer = void (*)(const EventRecord* ev, size_t n, void* ctx);
+
+    static EventPipeline& instance();
+
+    // Hasta kMaxConsumers; registrar el mismo (fn, ctx) dos veces no duplica.
+    bool addConsumer(Consumer fn, void* ctx);
+
+    // --- lado productor (cualquier hilo, sin locks) ---
+    // 'caller': dirección de retorno del operador/función interceptada
+    // (__builtin_return_address(0)); se simboliza fuera de este hilo.
+    void pushAlloc(void* ptr, uint64_t size, const char* file, int line,
+                   const char* type, bool is_array, const void* caller = nullptr) noexcept;
+    void pushFree(void* ptr) noexcept;
+
+    // --- lado consumidor ---
+    // Drena todos los anillos. Se entrega solo hasta la marca de agua: 'now',
+    // o el último ts publicado de un anillo cuyo hilo está a mitad de push
+    // (su evento en vuelo puede ser anterior a lo ya leído de otros hilos).
+    // Lo posterior se retiene para el siguiente drenado, así una alloc
+    // publicada tarde no queda detrás de su free. 'flush_all' entrega también
+    // los retenidos. Devuelve nº entregados.
+    size_t drain(bool flush_all = false);
+
+    void start(unsigned interval_ms = 5);   // lanza el hilo consumidor
+    void stop();                            // lo detiene y vacía todo
+
+    uint64_t stalls() const { return stalls_.load(std::memory_order_relaxed); }
+
+    // Intervalo medio de muestreo en bytes (0 = registrar todo). Debe fijarse
+    // antes de que haya bloques vivos registrados: sus frees se filtrarían.
+    // Valor inicial: variable de entorno MEMPROF_SAMPLE_RATE.
+    void     setSampleInterval(uint64_t mean_bytes) noexcept;
+    uint64_t sampleInterval() const noexcept { return sample_interval_.load(std::memory_order_relaxed); }
+
+    // Profundidad de pila a capturar por alloc (0 = no capturar, máx.
+    // StackTable::kMaxDepth). Valor inicial: MEMPROF_STACK_DEPTH.
+    void     setStackDepth(unsigned depth, StackTable::Mode mode = StackTable::Mode::Unwind) noexcept;
+    unsigned stackDepth() const noexcept { return stack_depth_.load(std::memory_order_relaxed); }
+
+    // Mientras exista en un hilo, sus allocs/frees no se registran. Lo usan los
+    // hilos del propio profiler para no medirse a sí mismos.
+    struct ScopedSuppress {
+        ScopedSuppress() noexcept;
+        ~ScopedSuppress();
+        ScopedSuppress(const ScopedSuppress&) = delete;
+        ScopedSuppress& operator=(const ScopedSuppress&) = delete;
+        bool prev;
+    };
+
+    static constexpr size_t   kRingCapacity = 4096;           // registros por hilo (288 KB en 64 bits)
+    static constexpr size_t   kMaxConsumers = 4;
+    static constexpr size_t   kSampleFilterBits = size_t(1) << 22;   // 512 KB
+    // Marcos propios que se omiten al capturar: pushAlloc, la entrada del
+    // runtime (register_alloc / memprof_record_alloc_ex) y el operador o
+    // función interceptada (operator new, malloc...)
+    static constexpr size_t   kStackSkip = 3;
+
+    struct Ring;
+
+private:
+    EventPipeline() = default;
+
+    Ring* ringForThisThread() noexcept;
+    bool  push(EventRecord& r) noexcept;   // sella ts/thread y publica
+    bool  sampleAlloc(uint64_t size, uint64_t interval, float& weight) noexcept;
+    static size_t filterBit(uintptr_t ptr) noexcept;
+    size_t drainLocked(bool flush_all);
+
+    std::atomic<Ring*>    rings_{nullptr};        // lista (solo se añade)
+    std::atomic<uint32_t> next_thread_{1};
+
+    std::mutex                 consumer_mtx_;     // un solo consumidor a la vez
+    std::vector<EventRecord>   pending_;          // retenidos por la marca de agua
+    std::vector<EventRecord>   batch_;
+
+    struct Slot { Consumer fn = nullptr; void* ctx = nullptr; };
+    Slot                    consumers_[kMaxConsumers];
+    std::atomic<size_t>     n_consumers_{0};
+
+    std::atomic<bool>       running_{false};
+    std::thread             worker_;
+    std::atomic<uint64_t>   stalls_{0};
+
+    std::atomic<uint64_t>   sample_interval_{0};
+    std::atomic<uint64_t>   sampled_bits_[kSampleFilterBits / 64] = {};   // ptr muestreado (aprox.)
+
+    std::atomic<unsigned>         stack_depth_{0};
+    std::atomic<StackTable::Mode> stack_mode_{StackTable::Mode::Unwind};
+};
+
+// El tamaño del anillo citado arriba: 4096 registros de 72 B en 64 bits
+static_assert(sizeof(void*) != 8 || sizeof(EventRecord) * EventPipeline::kRingCapacity == 288 * 1024,
+              "actualizar el tamaño del anillo en el comentario de kRingCapacity");
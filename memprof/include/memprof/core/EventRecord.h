@@ -0,0 +1,22 @@
+#pragma once
+#include <cstdint>
+
+// Registro binario compacto de un evento alloc/free tal como lo escriben los
+// hooks en su anillo por hilo. file/type deben ser cadenas de vida estática
+// (__FILE__, literales) o nullptr: el consumidor las lee más tarde.
+struct EventRecord {
+    enum Kind : uint8_t { Alloc = 0, Free = 1 };
+
+    uint64_t    ts_ns = 0;      // steady_clock, común a todos los hilos
+    uintptr_t   ptr = 0;
+    uint64_t    size = 0;       // 0 en Free
+    const char* file = nullptr;
+    const char* type = nullptr;
+    int32_t     line = 0;
+    uint32_t    thread = 0;     // nº de hilo secuencial (índice de anillo)
+    uint8_t     kind = Alloc;
+    uint8_t     is_array = 0;
+    float       weight = 1.0f;  // Alloc muestreada: bloques reales que representa (1 = exacto)
+    uint32_t    stack = 0;      // id en StackTable (0 = sin pila capturada)
+    uintptr_t   caller = 0;     // dirección de retorno del hook (atribución sin file/line)
+};
@@ -0,0 +1,136 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Mapa puntero -> V de direccionamiento abierto (sondeo lineal, borrado por
+// desplazamiento hacia atrás). Claves y valores viven en un único vector
+// contiguo: no hay un nodo en el heap por entrada y, una vez dimensionado, ni
+// insertar ni borrar reservan memoria. La clave 0 se reserva como "vacío"
+// (nullptr nunca se registra).
+template <typename V>
+class FlatPtrMap {
+public:
+    struct Slot {
+        std::uintptr_t key = 0;
+        V              value{};
+    };
+
+    FlatPtrMap() = default;
+
+    std::size_t size()  const { return used_; }
+    bool        empty() const { return used_ == 0; }
+
+    void clear() {
+        slots_.clear();
+        mask_ = 0;
+        used_ = 0;
+    }
+
+    // Vacía conservando la capacidad (para mapas que se llenan y vacían en ciclos)
+    void reset() {
+        if (used_ == 0) return;
+        for (auto& s : slots_) s.key = 0;
+        used_ = 0;
+    }
+
+    void reserve(std::size_t n) {
+        std::size_t cap = 16;
+        while (cap * 3 < n * 4) cap <<= 1;
+        if (cap > slots_.size()) rehash(cap);
+    }
+
+    V* find(std::uintptr_t key) {
+        if (slots_.empty() || key == 0) return nullptr;
+        for (std::size_t i = home(key);; i = (i + 1) & mask_) {
+            if (slots_[i].key == key) return &slots_[i].value;
+            if (slots_[i].key == 0)   return nullptr;
+        }
+    }
+    const V* find(std::uintptr_t key) const {
+        return const_cast<FlatPtrMap*>(this)->find(key);
+    }
+
+    // Inserta o devuelve el existente; 'inserted' indica cuál de los dos.
+    V& upsert(std::uintptr_t key, bool& inserted) {
+        if ((used_ + 1) * 4 > slots_.size() * 3) rehash(slots_.empty() ? 16 : slots_.size() * 2);
+        std::size_t i = home(key);
+        while (slots_[i].key != 0 && slots_[i].key != key) i = (i + 1) & mask_;
+        inserted = (slots_[i].key == 0);
+        if (inserted) {
+            slots_[i].key = key;
+            slots_[i].value = V{};
+            ++used_;
+        }
+        return slots_[i].value;
+    }
+
+    // Borra la clave copiando su valor en 'out'; false si no estaba.
+    bool erase(std::uintptr_t key, V& out) {
+        if (slots_.empty() || key == 0) return false;
+        std::size_t i = home(key);
+        while (slots_[i].key != key) {
+            if (slots_[i].key == 0) return false;
+            i = (i + 1) & mask_;
+        }
+        out = std::move(slots_[i].value);
+
+        std::size_t hole = i, j = i;
+        for (;;) {
+            j = (j + 1) & mask_;
+            if (slots_[j].key == 0) break;
+            const std::size_t h = home(slots_[j].key);
+            const bool stays = (hole <= j) ? (hole < h && h <= j) : (hole < h || h <= j);
+            if (stays) continue;
+            slots_[hole] = std::move(slots_[j]);
+            hole = j;
+        }
+        slots_[hole].key = 0;
+        --used_;
+        return true;
+    }
+
+    // Recorre las entradas vivas: fn(key, const V&)
+    template <typename Fn>
+    void forEach(Fn&& fn) const {
+        for (const auto& s : slots_)
+            if (s.key != 0) fn(s.key, s.value);
+    }
+    template <typename Fn>
+    void forEachMut(Fn&& fn) {
+        for (auto& s : slots_)
+            if (s.key != 0) fn(s.key, s.value);
+    }
+
+    std::size_t memoryBytes() const { return slots_.capacity() * sizeof(Slot); }
+
+    static std::size_t hashKey(std::uintptr_t k) {
+        // fmix64: las direcciones de malloc comparten los bits bajos
+        std::uint64_t x = static_cast<std::uint64_t>(k);
+        x ^= x >> 33; x *= 0xff51afd7ed558ccdULL;
+        x ^= x >> 33; x *= 0xc4ceb9fe1a85ec53ULL;
+        x ^= x >> 33;
+        return static_cast<std::size_t>(x);
+    }
+
+private:
+    std::size_t home(std::uintptr_t k) const { return hashKey(k) & mask_; }
+
+    void rehash(std::size_t cap) {
+        std::vector<Slot> old;
+        old.swap(slots_);
+        slots_.assign(cap, Slot{});
+        mask_ = cap - 1;
+        for (auto& s : old) {
+            if (s.key == 0) continue;
+            std::size_t i = home(s.key);
+            while (slots_[i].key != 0) i = (i + 1) & mask_;
+            slots_[i] = std::move(s);
+        }
+    }
+
+    std::vector<Slot> slots_;
+    std::size_t       mask_ = 0;
+    std::size_t       used_ = 0;
+};
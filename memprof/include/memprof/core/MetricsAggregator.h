@@ -1,29 +1,47 @@
 #pragma once
 #include <string>
+#include <string_view>
 #include <unordered_map>
-#include <deque>
 #include <vector>
 #include <atomic>
 #include <mutex>
+#include <set>
 #include <cstdint>
+#include <cmath>
+
+#include "memprof/core/EventRecord.h"
+#include "memprof/core/FlatPtrMap.h"
 
 class MetricsAggregator {
 public:
-    struct BlockInfo {
-        std::string ptr;     // dirección como string/hex
-        uint64_t    size = 0;
+    // Id interno de un sitio de llamada (file, line, type). 0 = sin asignar.
+    using SiteId = uint32_t;
+
+    struct CallSite {
         std::string file;
         int         line = 0;
         std::string type;
+        uintptr_t   pc = 0;      // dirección del llamador si no hay file/line (ver Symbolizer)
+    };
+
+    struct BlockInfo {
+        uintptr_t   ptr = 0;     // dirección (entera; se formatea al serializar)
+        uint64_t    size = 0;
+        uint64_t    ts_ns = 0;   // timestamp de alloc
+        SiteId      site = 0;    // ver getSite()/getSites()
         bool        is_array = false;
-        uint64_t    ts_ns = 0; // timestamp de alloc
+        bool        is_leak = false; // superó el umbral de antigüedad
+        uint32_t    stack = 0;   // id en StackTable (0 = sin pila)
     };
 
+    // Agregados por archivo; también por pila (getStackStats)
     struct FileStats {
         uint64_t alloc_count = 0;  // nº total de allocs vistos
         uint64_t alloc_bytes = 0;  // bytes totales asignados (histórico)
         uint64_t live_count  = 0;  // allocs vivos
         uint64_t live_bytes  = 0;  // bytes vivos
+        uint64_t leak_count  = 0;  // vivos que superan el umbral
+        uint64_t leak_bytes  = 0;
     };
 
     struct TimelinePoint {
@@ -32,25 +50,110 @@ public:
         uint64_t leak_bytes = 0;
     };
 
+    // Clase de tamaño [lo, hi): vivos y acumulado histórico (todas las allocs)
+    struct SizeBin {
+        uint64_t lo = 0, hi = 0;
+        uint64_t bytes = 0, count = 0;
+        uint64_t alloc_bytes = 0, alloc_count = 0;
+    };
+
+    // Cambios desde el corte anterior (ver collectDelta). En un keyframe
+    // 'upserts'/'files'/'new_sites' contienen el estado completo.
+    struct Delta {
+        uint64_t epoch = 0;          // corte que produce este delta
+        uint64_t base_epoch = 0;     // corte sobre el que se aplica
+        bool     keyframe = false;
+        std::vector<BlockInfo>  upserts;   // bloques nuevos o modificados (p.ej. promovidos a leak)
+        std::vector<uintptr_t>  removed;   // vivos en base_epoch que ya no lo están
+        std::vector<std::pair<std::string, FileStats>> files;   // filas por archivo modificadas
+        std::vector<std::pair<uint32_t, FileStats>>    stacks;  // filas por pila modificadas
+        SiteId                  first_site = 0;                  // id de new_sites[0]
+        std::vector<CallSite>   new_sites;
+    };
+
     struct LeaksKPIs {
         uint64_t total_leak_bytes = 0;
         double   leak_rate = 0.0;
-        struct { std::string file, ptr; uint64_t size = 0; } largest;
+        struct { std::string file; uintptr_t ptr = 0; uint64_t size = 0; } largest;
         struct { std::string file; uint64_t count = 0, bytes = 0; } top_file_by_leaks;
     };
 
+    // Snapshot de heap con nombre (takeSnapshot): el conjunto vivo reducido a
+    // una fila por sitio, ordenadas por SiteId. No guarda bloques.
+    struct SiteUsage {
+        SiteId   site = 0;
+        uint64_t bytes = 0, count = 0;
+    };
+    struct HeapSnapshot {
+        uint32_t    id = 0;
+        std::string label;
+        uint64_t    t_ns = 0;
+        uint64_t    bytes = 0, count = 0;   // totales vivos
+        std::vector<SiteUsage> sites;
+    };
+
+    // Un sitio entre dos snapshots (a -> b)
+    struct SiteGrowth {
+        SiteId   site = 0;
+        uint64_t bytes_a = 0, bytes_b = 0;
+        uint64_t count_a = 0, count_b = 0;
+        int64_t  dBytes() const { return (int64_t)bytes_b - (int64_t)bytes_a; }
+        int64_t  dCount() const { return (int64_t)count_b - (int64_t)count_a; }
+    };
+
+    // Vida de los bloques (free - alloc) de un sitio, acumulada desde el
+    // arranque. Percentiles con la resolución del histograma (<= 25 %).
+    struct LifetimeStats {
+        SiteId   site = 0;
+        uint64_t frees = 0;          // bloques liberados (estimados con muestreo)
+        uint64_t freed_bytes = 0;
+        uint64_t short_lived = 0;    // con vida < getShortLivedNs()
+        uint64_t p50_ns = 0, p99_ns = 0;
+    };
+
+    // Histograma de vidas: 4 cubos exactos de 64 ns y después 4 subcubos por
+    // potencia de 2 (estilo HDR) hasta ~34 h; el último recoge el resto.
+    static constexpr size_t kLifeBuckets = 160;
+    static size_t   lifetimeBucket(uint64_t life_ns);
+    static uint64_t lifetimeBucketLowNs(size_t bucket);   // límite inferior (ns)
+
 public:
     explicit MetricsAggregator(size_t timeline_capacity = 4096);
 
-    // Ingesta de eventos (desde tus hooks/new/delete)
+    // Interna (file, line, type) y devuelve su id estable. Las búsquedas de un
+    // sitio ya conocido no reservan memoria.
+    SiteId internSite(std::string_view file, int line, std::string_view type);
+
+    // Ingesta nativa (desde tus hooks/new/delete): claves enteras, sin strings.
+    void onAlloc(uintptr_t ptr, uint64_t size, uint64_t ts_ns, SiteId site, bool is_array);
+    // Variante para literales (__FILE__, nombres de tipo): cachea por la
+    // dirección de los char*, que deben vivir lo que dure el proceso.
+    void onAlloc(uintptr_t ptr, uint64_t size, uint64_t ts_ns,
+                 const char* file, int line, const char* type, bool is_array);
+    void onFree (uintptr_t ptr, uint64_t hinted_size);
+
+    // Lote ordenado por ts (desde EventPipeline): un solo lock para todo el lote.
+    void onEvents(const EventRecord* ev, size_t n);
+    // Adaptador para EventPipeline::addConsumer (ctx = MetricsAggregator*)
+    static void consumeEvents(const EventRecord* ev, size_t n, void* self);
+
+    // Compatibilidad: puntero como string ("0x..." o decimal)
     void onAlloc(const std::string& ptr, uint64_t size, uint64_t ts_ns,
                  const std::string& file, int line,
                  const std::string& type, bool is_array);
     void onFree (const std::string& ptr, uint64_t hinted_size);
 
-    // Ingesta “texto json” (si envías eventos en JSON)
+    // Ingesta “texto json” (si envías eventos en JSON): un evento por llamada
     void processEvent(const std::string& json);
 
+    // Ingesta masiva de un log de eventos JSON, uno por línea (mismo formato
+    // que processEvent). Se trocea por líneas y se parsea en paralelo; los
+    // eventos se reparten por hash del puntero entre 'threads' shards (alloc y
+    // free de una dirección caen en el mismo) y los resultados se funden al
+    // final bajo un solo lock, respetando el orden del log. 0 = un hilo por
+    // núcleo. Devuelve el nº de eventos reconocidos.
+    size_t ingestEvents(std::string_view ndjson, unsigned threads = 0);
+
     // Consulta de métricas agregadas
     void getMetrics(uint64_t& current_bytes,
                     uint64_t& peak_bytes,
@@ -59,32 +162,266 @@ public:
                     uint64_t& leak_bytes) const;
 
     std::vector<TimelinePoint> getTimeline() const;
-    std::vector<BlockInfo>     getBlocks()   const;   // ← UNA sola declaración
+    // Clases de tamaño mantenidas al vuelo (ver sizeBinIndex); solo el tramo
+    // entre la primera y la última no vacías
+    std::vector<SizeBin>       getSizeBins() const;
+    std::vector<BlockInfo>     getBlocks()   const;
     std::unordered_map<std::string, FileStats> getFileStats() const;
+    std::vector<std::pair<uint32_t, FileStats>> getStackStats() const;   // (id de pila, agregados)
     LeaksKPIs getLeaksKPIs() const;
 
+    // Cierra un epoch y devuelve lo cambiado desde el anterior, en O(cambios).
+    // La primera llamada, la que pida 'keyframe' o la siguiente a un cambio
+    // global (umbral de leak, registro desbordado) devuelven el estado completo.
+    // El registro de cambios solo se mantiene a partir de la primera llamada.
+    void collectDelta(Delta& out, bool keyframe);
+
+    // Guarda el conjunto vivo actual con 'label' y devuelve su id (>= 1).
+    // O(sitios) bajo el lock; se conservan los kMaxSnapshots últimos.
+    uint32_t takeSnapshot(std::string_view label);
+    bool     getSnapshot(uint32_t id, HeapSnapshot& out) const;
+    std::vector<HeapSnapshot> getSnapshots(uint32_t first_id = 0) const;   // ids >= first_id
+    // Sitios que cambian de a a b, de mayor a menor crecimiento en bytes.
+    // Vacío si alguno de los ids ya no existe.
+    std::vector<SiteGrowth> diff(uint32_t a, uint32_t b) const;
+    static std::vector<SiteGrowth> diff(const HeapSnapshot& a, const HeapSnapshot& b);
+
+    static constexpr size_t kMaxSnapshots = 64;
+
+    // Desglose por sitio en el pico: se captura cuando los bytes vivos
+    // superan la última captura en 'margin' (fracción, 0.05 = +5 %), así que
+    // la última está a menos de un margen del pico real y el nº de capturas
+    // crece con el logaritmo del pico. Sale de contadores por sitio
+    // mantenidos al vuelo: O(sitios), no O(bloques vivos). margin < 0
+    // desactiva la captura.
+    void setPeakCapture(double margin);
+    // Última captura (label "peak", id = nº de captura). false si no hay
+    // ninguna o si su id no es mayor que 'newer_than'.
+    bool getPeakSnapshot(HeapSnapshot& out, uint32_t newer_than = 0) const;
+
+    // Vidas por sitio: solo se registran los frees con timestamp (los de la
+    // tubería y los de logs con ts_ns). 'all' = todos los sitios con frees;
+    // si no, los que cambiaron desde la llamada anterior. Los sitios >=
+    // 'site_end' (aún no enviados) quedan pendientes para otra llamada.
+    void collectLifetimeStats(std::vector<LifetimeStats>& out, bool all, SiteId site_end = UINT32_MAX);
+    // Cubos del histograma de un sitio (kLifeBuckets); false si no tiene frees
+    bool getLifetimeHistogram(SiteId site, std::vector<uint64_t>& buckets) const;
+    // Umbral de "vida corta" (por defecto 1 ms); afecta a los frees futuros
+    void     setShortLivedNs(uint64_t ns);
+    uint64_t getShortLivedNs() const;
+
+    CallSite              getSite(SiteId id) const;
+    std::vector<CallSite> getSites() const;      // indexado por SiteId
+
+    // Sitios por dirección (sin file/line) aún en "unknown": 'resolve(pc,
+    // file, line)' devuelve false si la dirección sigue pendiente. Los que
+    // se resuelven a un archivo pasan a él con todo lo acumulado (allocs,
+    // vivos, fugas), y las dos filas salen en el siguiente delta.
+    using CallerResolver = bool (*)(uintptr_t pc, std::string& file, int& line);
+    void resolveCallerSites(CallerResolver resolve);
+
     void     setLeakThresholdMs(uint64_t ms);
     uint64_t getLeakThresholdMs() const;
 
     static uint64_t now_ns();
     static uint64_t now_ms();
+    static uintptr_t parsePtr(const std::string& s);
 
 private:
-    // JSON helpers (mínimos)
-    static bool extractString(const std::string& json, const std::string& field, std::string& out);
-    static bool extractBool  (const std::string& json, const std::string& field, bool& out);
-    static bool extractUint64(const std::string& json, const std::string& field, uint64_t& out);
-    static bool extractInt   (const std::string& json, const std::string& field, int& out);
+    // Bloque vivo tal como se guarda (la clave es el puntero)
+    struct LiveBlock {
+        uint64_t size = 0;
+        uint64_t ts_ns = 0;
+        SiteId   site = 0;
+        float    weight = 1.0f;      // bloques reales que representa (muestreo)
+        uint32_t stack = 0;          // id en StackTable
+        bool     is_array = false;
+        bool     is_leak = false;
+
+        // Contribución a los agregados: exacta sin muestreo, estimada con él
+        uint64_t estBytes() const { return weight == 1.0f ? size : (uint64_t)std::llround((double)size * weight); }
+        uint64_t estCount() const { return weight == 1.0f ? 1 : (uint64_t)std::llround(weight); }
+    };
+
+    // Histograma de vidas de un sitio (memoria fija)
+    struct LifetimeHist {
+        uint64_t frees = 0, freed_bytes = 0, short_lived = 0;
+        uint64_t buckets[kLifeBuckets] = {};
+        void add(uint64_t life_ns, uint64_t bytes, uint64_t count, uint64_t short_ns) {
+            buckets[lifetimeBucket(life_ns)] += count;
+            frees       += count;
+            freed_bytes += bytes;
+            if (life_ns < short_ns) short_lived += count;
+        }
+        void merge(const LifetimeHist& o);
+        uint64_t percentileNs(double q) const;
+    };
+
+    // Entrada del índice por antigüedad (orden de llegada ~ orden de ts)
+    struct AgeEntry {
+        uint64_t  ts_ns = 0;
+        uintptr_t ptr = 0;
+    };
+
+    struct SiteRec {
+        uint32_t  file_id = 0;
+        int       line = 0;
+        uint32_t  type_id = 0;
+        uintptr_t pc = 0;
+    };
+
+    struct SiteKey {
+        uint32_t file_id, type_id; int line; uintptr_t pc;
+        bool operator==(const SiteKey&) const = default;
+    };
+    struct SiteKeyHash {
+        size_t operator()(const SiteKey& k) const {
+            return ((size_t)k.file_id * 0x9E3779B97F4A7C15ULL) ^ ((size_t)k.type_id << 32) ^ (size_t)(unsigned)k.line ^
+                   std::hash<uintptr_t>{}(k.pc);
+        }
+    };
+    struct CallerKey {
+        uintptr_t pc; const char* type;
+        bool operator==(const CallerKey&) const = default;
+    };
+    struct CallerKeyHash {
+        size_t operator()(const CallerKey& k) const {
+            return std::hash<uintptr_t>{}(k.pc) ^ (std::hash<const void*>{}(k.type) << 1);
+        }
+    };
+    struct LiteralKey {
+        const char* file; const char* type; int line;
+        bool operator==(const LiteralKey&) const = default;
+    };
+    struct LiteralKeyHash {
+        size_t operator()(const LiteralKey& k) const {
+            return std::hash<const void*>{}(k.file) ^ (std::hash<const void*>{}(k.type) << 1) ^ (size_t)(unsigned)k.line;
+        }
+    };
+    struct StrHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view s) const { return std::hash<std::string_view>{}(s); }
+    };
 
-    uint64_t computeLeakBytes_locked(uint64_t now_ns_val) const;
+    SiteId   internSite_locked(std::string_view file, int line, std::string_view type, uintptr_t pc = 0);
+    uint32_t internString_locked(std::unordered_map<std::string, uint32_t, StrHash, std::equal_to<>>& index,
+                                 std::vector<std::string>& names, std::string_view s);
+    SiteId   siteForLiteral_locked(const char* file, int line, const char* type);
+    SiteId   siteForCaller_locked(uintptr_t pc, const char* type);
+    CallSite callSite_locked(const SiteRec& r) const;
+    void     moveCallerSite_locked(SiteId site, std::string_view file, int line);
+    // Aplica 'f' a las filas por archivo que toca un cambio del sitio: la de
+    // su archivo y, si espera simbolizar, también la suya (caller_rows_)
+    template <class F> void fileRows_locked(SiteId site, F&& f) const {
+        const SiteRec& r = sites_[site];
+        touchFile_locked(r.file_id);
+        f(per_file_[r.file_id]);
+        if (r.pc && r.file_id == 0) f(caller_rows_[site]);
+    }
+    void     onAlloc_locked(uintptr_t ptr, uint64_t size, uint64_t ts_ns, SiteId site, bool is_array,
+                            uint64_t t_now, float weight = 1.0f, uint32_t stack = 0);
+    uint64_t insertLive_locked(uintptr_t ptr, uint64_t size, uint64_t ts_ns, SiteId site, bool is_array,
+                               float weight, uint32_t stack);
+    static constexpr uint64_t kNotLive = UINT64_MAX;
+    uint64_t eraseLive_locked(uintptr_t ptr, uint64_t free_ts);
+    void     dropLive_locked(const LiveBlock& lb);
+    FileStats& stackStats_locked(uint32_t stack) const;
+    static BlockInfo blockInfo(uintptr_t ptr, const LiveBlock& lb);
+    bool     onFree_locked(uintptr_t ptr, uint64_t t_now, uint64_t free_ts);
+
+    // Índice de antigüedad: promueve a "leak" los bloques que cruzan el umbral.
+    // Coste amortizado O(1) por evento; es const porque solo materializa un
+    // estado que depende del reloj (de ahí los miembros mutable).
+    void     promoteLeaks_locked(uint64_t now_ns_val) const;
+    void     agePush_locked(uint64_t ts_ns, uintptr_t ptr);
+    void     ageCompact_locked() const;
+    void     unmarkLeak_locked(uintptr_t ptr, const LiveBlock& lb);
+    void     rebuildLeakIndex_locked();
     void     computeLeaksKPIs_locked(uint64_t now_ns_val, LeaksKPIs& out) const;
     void     pushTimelinePoint_locked(uint64_t t_ns, uint64_t cur_b, uint64_t leak_b);
+    void     capturePeak_locked(uint64_t cur_b, uint64_t t_ns);
+    LifetimeHist& lifeHist_locked(SiteId site);
+
+    // Registro de cambios: 'existed' = el bloque estaba vivo en el último corte
+    void     touchBlock_locked(uintptr_t ptr, bool existed) const;
+    void     touchFile_locked(uint32_t file_id) const;
+    void     touchStack_locked(uint32_t stack) const;
+    // Clase 0..3 = tamaños 0..3; después 4 subclases por potencia de 2
+    // ([4,5) [5,6) ... [8,10) [10,12) ...) hasta 2^40; la última acumula el resto
+    static size_t   sizeBinIndex(uint64_t size);
+    static uint64_t sizeBinLow(size_t bin);
 
 private:
     mutable std::mutex mtx_;
-    std::unordered_map<std::string, BlockInfo>  live_;
-    std::unordered_map<std::string, FileStats>  per_file_;
-    std::deque<TimelinePoint>                   timeline_;
+    mutable FlatPtrMap<LiveBlock>               live_;
+
+    // Tablas de interning: archivo/tipo -> id, (file,line,type) -> SiteId
+    std::vector<std::string>                    files_;        // file_id -> ruta
+    std::vector<std::string>                    types_;        // type_id -> tipo
+    std::unordered_map<std::string, uint32_t, StrHash, std::equal_to<>> file_index_;
+    std::unordered_map<std::string, uint32_t, StrHash, std::equal_to<>> type_index_;
+    std::vector<SiteRec>                        sites_;        // SiteId -> rec (0 reservado)
+    std::unordered_map<SiteKey, SiteId, SiteKeyHash>       site_index_;
+    std::unordered_map<LiteralKey, SiteId, LiteralKeyHash> literal_sites_;
+    std::unordered_map<CallerKey, SiteId, CallerKeyHash>   caller_sites_;
+    std::vector<SiteId>                         unresolved_;   // sitios por dirección en "unknown"
+
+    mutable std::vector<FileStats>              per_file_;     // indexado por file_id
+    mutable std::vector<FileStats>              caller_rows_;  // por SiteId: lo que el sitio aporta a "unknown"
+    mutable std::vector<FileStats>              per_stack_;    // indexado por id de pila
+    std::vector<SiteUsage>                      site_live_;    // vivos por SiteId ('site' sin usar)
+
+    // Vidas por sitio: solo los sitios con algún free tienen histograma
+    std::vector<uint32_t>                       site_life_;    // SiteId -> índice + 1 en life_hists_ (0 = ninguno)
+    std::vector<LifetimeHist>                   life_hists_;
+    std::vector<SiteId>                         life_site_;    // índice -> SiteId
+    std::vector<uint8_t>                        life_dirty_;   // por índice
+    std::vector<uint32_t>                       dirty_lives_;
+    std::atomic<uint64_t>                       short_lived_ns_{1'000'000};
+
+    // Bloques aún no promovidos, en anillo (cabeza = más antiguo). Las entradas
+    // de bloques ya liberados se descartan al llegar a la cabeza o al compactar.
+    mutable std::vector<AgeEntry>               age_ring_;
+    mutable size_t                              age_head_  = 0;
+    mutable size_t                              age_size_  = 0;
+    mutable size_t                              age_stale_ = 0;  // entradas muertas estimadas
+
+    // Totales de fugas mantenidos incrementalmente
+    mutable uint64_t                            leak_bytes_ = 0;
+    mutable uint64_t                            leak_count_ = 0;
+    mutable std::set<std::pair<uint64_t, uintptr_t>> leak_by_size_; // (size, ptr) para "mayor fuga"
+
+    // Histogramas por clase de tamaño: vivos y acumulado
+    static constexpr size_t kSizeBins = 160;
+    uint64_t                                    bin_bytes_[kSizeBins] = {};
+    uint64_t                                    bin_count_[kSizeBins] = {};
+    uint64_t                                    bin_alloc_bytes_[kSizeBins] = {};
+    uint64_t                                    bin_alloc_count_[kSizeBins] = {};
+
+    // Registro de cambios entre cortes (collectDelta)
+    static constexpr uint8_t kExisted = 1;
+    bool                                        changelog_on_ = false;
+    mutable bool                                need_keyframe_ = true;
+    mutable FlatPtrMap<uint8_t>                 changed_;      // ptr -> kExisted?
+    mutable std::vector<uint8_t>                file_dirty_;   // por file_id
+    mutable std::vector<uint32_t>               dirty_files_;
+    mutable std::vector<uint8_t>                stack_dirty_;  // por id de pila
+    mutable std::vector<uint32_t>               dirty_stacks_;
+    uint64_t                                    epoch_ = 0;
+    SiteId                                      sites_sent_ = 0;
+
+    // Snapshots con nombre, del más antiguo al más nuevo
+    std::vector<HeapSnapshot>                   snapshots_;
+    uint32_t                                    next_snapshot_ = 1;
+
+    // Captura automática en el pico (capturePeak_locked)
+    HeapSnapshot                                peak_snap_;           // id 0 = aún ninguna
+    uint64_t                                    peak_capture_at_ = 1; // bytes vivos que disparan la siguiente
+    double                                      peak_margin_ = 0.05;   // < 0: desactivada
+
+    // Timeline como anillo de capacidad fija (sin reservas en caliente)
+    std::vector<TimelinePoint>                  timeline_;
+    size_t                                      timeline_head_ = 0;  // índice del más antiguo
     size_t                                      timeline_cap_;
 
     std::atomic<uint64_t> total_allocs_{0};
@@ -93,3 +430,4 @@ private:
     std::atomic<uint64_t> peak_bytes_{0};
     std::atomic<uint64_t> leak_threshold_ms_{3000}; // p.ej. 3s
 };
+
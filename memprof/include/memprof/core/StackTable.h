@@ -0,0 +1,63 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Tabla global de pilas de llamada deduplicadas. Cada pila distinta recibe un
+// id de 32 bits estable (secuencial desde 1; 0 = sin pila) que es lo que
+// viaja en los eventos y se guarda por bloque.
+//
+// intern() se llama desde los hooks: sin locks ni operator new. Las pilas se
+// identifican por un hash de 64 bits de sus direcciones (dos pilas distintas
+// con el mismo hash se tratan como una). La memoria se reserva con calloc la
+// primera vez y la tabla nunca se vacía; llena, intern() devuelve 0.
+class StackTable {
+public:
+    static constexpr size_t kMaxDepth = 64;
+
+    enum class Mode : uint8_t {
+        Unwind,         // _Unwind_Backtrace: no necesita frame pointers
+        FramePointer,   // recorre rbp/x29: más barato, requiere -fno-omit-frame-pointer
+    };
+
+    static StackTable& instance();
+
+    // Captura la pila del llamador (sin los 'skip' marcos más internos).
+    // Devuelve el nº de direcciones escritas en out (como mucho max).
+    static size_t capture(uintptr_t* out, size_t max, size_t skip, Mode mode) noexcept;
+
+    uint32_t intern(const uintptr_t* pcs, size_t depth) noexcept;
+
+    // Ids publicados: [1, published()). Los ids se asignan en orden, pero uno
+    // puede estar a medio escribir: published() se detiene en el primero así.
+    uint32_t published() const noexcept;
+
+    // Copia las direcciones de 'id' (hasta max). 0 si el id no existe aún.
+    size_t frames(uint32_t id, uintptr_t* out, size_t max) const noexcept;
+    size_t depth(uint32_t id) const noexcept;
+
+    static constexpr size_t kSlots     = size_t(1) << 16;   // ids como mucho kSlots/4*3
+    static constexpr size_t kPoolSlots = size_t(1) << 20;   // direcciones totales (8 MB)
+
+private:
+    StackTable() = default;
+    bool ensureStorage() noexcept;
+
+    struct Slot {
+        std::atomic<uint64_t> hash{0};   // 0 = libre
+        std::atomic<uint32_t> id{0};     // 0 = reservado y aún sin id
+    };
+    struct Entry {
+        uint32_t              offset = 0;
+        uint32_t              depth = 0;
+        std::atomic<bool>     ready{false};
+    };
+
+    std::atomic<Slot*>      slots_{nullptr};
+    std::atomic<Entry*>     entries_{nullptr};    // indexado por id
+    std::atomic<uintptr_t*> pool_{nullptr};
+    std::atomic<int>        init_{0};             // 0 sin memoria, 1 reservando, 2 lista, 3 fallo
+    std::atomic<uint32_t>   next_id_{1};
+    std::atomic<size_t>     pool_used_{0};
+    mutable std::atomic<uint32_t> published_{1};  // caché de published()
+};
@@ -0,0 +1,88 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Simbolizador en segundo plano: traduce direcciones de código (callers y
+// marcos de pila) a función y archivo:línea leyendo los ELF cargados
+// (.symtab/.dynsym y la tabla de líneas DWARF .debug_line, versiones 2-5).
+//
+// request() solo encola; un hilo propio resuelve fuera de los hilos que
+// asignan memoria. Cachés: por dirección (nunca se resuelve dos veces) y por
+// módulo (cada ELF se abre y se indexa una sola vez, la primera vez que una
+// dirección cae en él). Las cadenas (funciones, rutas) se internan en una
+// tabla incremental: collect() devuelve solo lo nuevo desde la última vez,
+// para enviarlo a la GUI una vez por cadena.
+//
+// Limitaciones: ELF de 64 bits little-endian; secciones de depuración
+// comprimidas y archivos .debug separados no se leen (queda la función del
+// symtab, sin línea).
+class Symbolizer {
+public:
+    // Ids en la tabla de cadenas; 0 = "" (desconocido)
+    struct Symbol {
+        uint32_t function = 0;
+        uint32_t file = 0;
+        int32_t  line = 0;
+    };
+
+    // Resultado incremental (o completo con 'full')
+    struct Batch {
+        uint32_t                                  first_string = 0;   // id de strings[0]
+        std::vector<std::string>                  strings;
+        std::vector<std::pair<uintptr_t, Symbol>> symbols;
+    };
+
+    static Symbolizer& instance();
+
+    void start();
+    void stop();
+
+    // Encola direcciones de retorno aún no vistas (se resuelve pc - 1)
+    void request(const uintptr_t* pcs, size_t n);
+
+    // Con 'full' devuelve todo lo resuelto (keyframe); si no, lo resuelto y
+    // las cadenas añadidas desde la llamada anterior.
+    void collect(Batch& out, bool full);
+
+    // Consulta directa (JSON): false si aún no está resuelta
+    bool        lookup(uintptr_t pc, Symbol& out) const;
+    std::string string(uint32_t id) const;
+
+    struct Module;   // ELF cargado (definido en el .cpp)
+
+private:
+    Symbolizer();
+    ~Symbolizer();
+
+    void     run();
+    Symbol   resolve(uintptr_t pc);
+    Module*  moduleFor(uintptr_t pc);
+    uint32_t internString_locked(const std::string& s);
+
+    mutable std::mutex       mtx_;
+    std::condition_variable  cv_;
+    std::vector<uintptr_t>   queue_;
+    std::unordered_set<uintptr_t> seen_;        // encoladas o resueltas
+
+    std::unordered_map<uintptr_t, Symbol> resolved_;
+    std::vector<uintptr_t>   order_;            // orden de resolución (para collect)
+    size_t                   sent_symbols_ = 0;
+
+    std::vector<std::string>                  strings_;   // id -> cadena (0 = "")
+    std::unordered_map<std::string, uint32_t> string_index_;
+    uint32_t                 sent_strings_ = 1;
+
+    // Solo las toca el hilo del simbolizador
+    std::vector<std::unique_ptr<Module>> modules_;
+
+    bool        running_ = false;
+    std::thread worker_;
+};
@@ -1,20 +1,83 @@
 #pragma once
 #include <string>
 #include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <vector>
 
-// Cliente TCP muy simple (no Qt) para el runtime
+#include "memprof/core/Transport.h"
+
+// Cliente (no Qt) del runtime hacia la GUI. Por defecto TCP; con endpoint
+// "unix:ruta" o "shm:ruta" usa un transporte local (LocalChannel.h).
+//
+// Los envíos no bloquean: las tramas van a una cola acotada que flush()
+// vacía con escrituras scatter-gather según el socket admite. Si la GUI no
+// lee, la cola se llena y se descartan las tramas más antiguas que aún no
+// han empezado a salir (una a medias nunca: cortaría el flujo).
 class TcpClient {
 public:
+    struct Stats {
+        uint64_t frames_sent    = 0;
+        uint64_t frames_dropped = 0;   // descartadas sin llegar a enviarse
+        uint64_t bytes_dropped  = 0;
+        uint64_t connects       = 0;   // conexiones establecidas
+    };
+
+    static constexpr int    kConnectTimeoutMs = 1000;
+    static constexpr int    kSendTimeoutMs    = 2000;   // plazo total de un envío bloqueante
+    static constexpr int    kMinRetryMs       = 250;    // espera entre intentos: x2 por fallo
+    static constexpr int    kMaxRetryMs       = 8000;
+    static constexpr size_t kMaxQueuedFrames  = 8;
+    static constexpr size_t kMaxQueuedBytes   = size_t(64) << 20;
+
     TcpClient();
     ~TcpClient();
 
+    // Conecta con plazo (kConnectTimeoutMs). Cada fallo dobla retryDelayMs().
     bool connectTo(const char* host, int port);
+    int  retryDelayMs() const { return retry_ms_ ? retry_ms_ : kMinRetryMs; }
     bool isConnected() const;
-    void close();
+    void close();   // descarta la cola: la conexión siguiente empieza de cero
+
+    // Encola una trama sin copiarla: la cola se queda con el contenido de
+    // 'frame' y le devuelve un buffer reciclado (vacío). 'newline' añade '\n'
+    // al enviar (JSON). 'supersedes': la trama contiene el estado completo y
+    // sustituye a las pendientes (keyframe o JSON). Devuelve cuántas tramas
+    // se descartaron para hacerle sitio.
+    size_t enqueue(std::string& frame, bool newline, bool supersedes);
+    // Envía lo encolado; espera como mucho 'wait_ms' a que el socket admita
+    // más. false si la conexión murió (el llamador cierra y reconecta).
+    bool flush(int wait_ms);
+    size_t queuedFrames() const { return queue_.size(); }
+    const Stats& stats() const { return stats_; }
 
-    // Envía una línea y añade '\n'
+    // Envíos bloqueantes (vacían antes la cola). false si la conexión murió
+    // o si en kSendTimeoutMs no salió todo (GUI conectada pero sin leer): el
+    // llamador cierra y reconecta, el flujo puede haber quedado a medias.
     bool sendLine(const std::string& line);
+    bool sendAll(const void* data, size_t n);
 
 private:
-    int sock_ = -1; // descriptor (SOCKET en Windows convertido a int)
+    enum class Kind { None, Tcp, Unix, Shm };
+    struct Pending {
+        std::string buf;
+        bool        newline = false;
+        size_t size() const { return buf.size() + (newline ? 1 : 0); }
+    };
+
+    bool sendBlocking(const IoSlice* v, int n);
+    void consume(size_t n);
+    void dropAt(size_t i);
+    void recycle(std::string&& buf);
+
+    Kind kind_ = Kind::None;
+    std::unique_ptr<Transport> impl_;
+    int retry_ms_ = 0;
+
+    std::deque<Pending>      queue_;
+    size_t                   head_sent_ = 0;      // bytes ya enviados de queue_.front()
+    size_t                   queued_bytes_ = 0;
+    std::vector<std::string> spare_;              // buffers para devolver en enqueue
+    Stats                    stats_;
 };
@@ -0,0 +1,65 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "memprof/core/EventRecord.h"
+
+// Modo grabación: consumidor de EventPipeline que vuelca cada alloc/free a
+// segmentos de traza en disco (formato en memprof/proto/TraceFormat.h).
+//
+// Cada segmento es un archivo de tamaño fijo que se reserva con ftruncate y se
+// mapea entero; los registros se copian al mapeo en orden y el kernel los
+// escribe en segundo plano. Al llenarse se trunca a lo usado, se desmapea y se
+// abre el siguiente: la memoria y la E/S quedan acotadas a un segmento y
+// siempre son secuenciales. Todo el trabajo ocurre en el hilo que drena la
+// tubería, nunca en los hilos que asignan memoria.
+class TraceWriter {
+public:
+    static constexpr uint64_t kDefaultSegmentBytes = uint64_t(64) << 20;
+    static constexpr uint64_t kMinSegmentBytes     = uint64_t(64) << 10;
+
+    static TraceWriter& instance();
+
+    // Crea <prefix>.000000.mpt y siguientes. false si no se pudo abrir.
+    bool open(const std::string& prefix, uint64_t segment_bytes = kDefaultSegmentBytes);
+    void close();                 // trunca el segmento actual a lo usado
+    bool isOpen() const;
+
+    // Para EventPipeline::addConsumer (ctx = TraceWriter*)
+    static void consumeEvents(const EventRecord* ev, size_t n, void* ctx);
+    void append(const EventRecord* ev, size_t n);
+
+    uint64_t segments() const;    // segmentos abiertos hasta ahora
+
+private:
+    TraceWriter() = default;
+
+    bool openSegment_locked();
+    void closeSegment_locked();
+    void encode_locked(const EventRecord& e, std::string& out);
+    uint32_t stringId_locked(const char* s);
+    void writeModules_locked();
+
+    mutable std::mutex mtx_;
+    std::string prefix_;
+    uint64_t    segment_bytes_ = kDefaultSegmentBytes;
+    uint32_t    index_ = 0;       // siguiente segmento
+    bool        open_ = false;
+
+    // Segmento actual
+    int         fd_ = -1;
+    char*       map_ = nullptr;
+    uint64_t    used_ = 0;
+    uint64_t    records_ = 0;
+    uint64_t    last_ts_ = 0;
+
+    // Tablas del segmento actual (se vacían al abrir otro)
+    std::unordered_map<const char*, uint32_t> strings_;   // file/type tienen vida estática
+    std::unordered_set<uint32_t>              stacks_;    // ids de pila ya emitidos
+
+    std::string scratch_;         // registro en construcción
+};
@@ -0,0 +1,34 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Tramo de un envío scatter-gather (equivalente portable de iovec)
+struct IoSlice {
+    const void* data = nullptr;
+    size_t      len  = 0;
+};
+
+// Canal de bytes runtime -> GUI, no bloqueante. TcpClient elige la
+// implementación según el endpoint (ver memprof/proto/LocalChannel.h para la
+// sintaxis) y lleva encima la cola de tramas.
+class Transport {
+public:
+    virtual ~Transport() = default;
+
+    // 'where' es la IPv4 (TCP) o la ruta del socket (unix/shm); 'port' solo
+    // lo usa TCP. Falla si no conecta en 'timeout_ms'.
+    virtual bool connectTo(const char* where, int port, int timeout_ms) = 0;
+    virtual bool isConnected() const = 0;
+    virtual void close() = 0;
+    // Escribe sin bloquear lo que quepa de los tramos (en orden): bytes
+    // escritos, 0 si no cabe nada, -1 si la conexión murió
+    virtual int64_t writeSome(const IoSlice* v, int n) = 0;
+    // Espera hasta 'timeout_ms' a que quepa algo; false si la conexión murió
+    virtual bool waitWritable(int timeout_ms) = 0;
+};
+
+std::unique_ptr<Transport> makeTcpTransport();
+// nullptr si la plataforma no lo soporta
+std::unique_ptr<Transport> makeUnixTransport();
+std::unique_ptr<Transport> makeShmTransport();
@@ -0,0 +1,45 @@
+#pragma once
+#include <cstddef>
+
+//
+// API C que expone el runtime (debe coincidir 1:1 con backend/core/Runtime.cpp)
+//
+extern "C" {
+    // 'host' es una IPv4 (TCP a 'port') o un endpoint local: "unix:/ruta.sock"
+    // (socket AF_UNIX) o "shm:/ruta.sock" (anillo en memoria compartida, solo
+    // Linux); ver memprof/proto/LocalChannel.h. Con LD_PRELOAD, MEMPROF_HOST.
+    int  memprof_init(const char* host, int port);
+    void memprof_shutdown();
+
+    void memprof_record_alloc(void* ptr, std::size_t sz, const char* file, int line);
+    // Igual, con tipo explícito ("malloc", "calloc"...). file/type deben ser
+    // literales o cadenas que vivan lo que el proceso.
+    void memprof_record_alloc_ex(void* ptr, std::size_t sz, const char* file, int line, const char* type);
+    // Sin file/line: 'caller' (dirección de retorno del hook) se simboliza
+    // en segundo plano para atribuir la alloc a función y archivo:línea.
+    void memprof_record_alloc_pc(void* ptr, std::size_t sz, const char* type, const void* caller);
+    void memprof_record_free (void* ptr);
+
+    // Muestreo estadístico: registra ~1 alloc cada 'mean_bytes' bytes y
+    // reporta estimaciones (0 = exacto). Llamar antes de memprof_init; por
+    // defecto toma MEMPROF_SAMPLE_RATE del entorno.
+    void memprof_set_sample_interval(std::size_t mean_bytes);
+
+    // Modo grabación: además de enviar a la GUI, vuelca cada alloc/free a
+    // <path_prefix>.NNNNNN.mpt en segmentos de 'segment_bytes' (0 = 64 MB).
+    // Llamar antes de memprof_init; por defecto toma MEMPROF_TRACE (y
+    // MEMPROF_TRACE_SEGMENT_MB) del entorno. nullptr/"" lo desactiva.
+    void memprof_set_trace_file(const char* path_prefix, std::size_t segment_bytes);
+
+    // Snapshot de heap con nombre ("warm", "tras 1h de carga"...): guarda el
+    // conjunto vivo agrupado por sitio para compararlo con otro (diff por
+    // sitio en la GUI y en memprof-analyze --diff). Devuelve su id (>= 1).
+    unsigned memprof_take_snapshot(const char* label);
+
+    // Captura automática en el pico: cada vez que el heap vivo supera la
+    // captura anterior en 'margin' (fracción, 0.05 = +5 %) se guarda su
+    // desglose por sitio y se envía a la GUI; la última queda a menos de un
+    // margen del pico real. margin < 0 la desactiva. Por defecto 0.05, o
+    // MEMPROF_PEAK_MARGIN del entorno.
+    void memprof_set_peak_capture(double margin);
+}
@@ -0,0 +1,178 @@
+#pragma once
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+// Escáner JSON mínimo sobre un buffer (contraparte de JsonWriter.h): recorre
+// objetos/arrays clave a clave sin construir un DOM y salta lo que no
+// interesa. Los enteros se leen exactos (64 bits, sin pasar por double). Los
+// errores dejan ok = false y el llamador descarta el documento.
+namespace json {
+
+struct Reader {
+    const char* p;
+    const char* end;
+    bool        ok = true;
+
+    void ws() { while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) ++p; }
+
+    bool eat(char c) {
+        ws();
+        if (p < end && *p == c) { ++p; return true; }
+        return false;
+    }
+    void expect(char c) { if (!eat(c)) ok = false; }
+    char peek() { ws(); return p < end ? *p : '\0'; }
+
+    // Cadena: sin escapes se devuelve una vista del buffer; con escapes se
+    // decodifica en 'tmp'
+    std::string_view str(std::string& tmp) {
+        ws();
+        if (p >= end || *p != '"') { ok = false; return {}; }
+        const char* s = ++p;
+        while (p < end && *p != '"' && *p != '\\') ++p;
+        if (p < end && *p == '"') return std::string_view(s, static_cast<size_t>(p++ - s));
+
+        tmp.assign(s, static_cast<size_t>(p - s));
+        while (p < end && *p != '"') {
+            if (*p != '\\') { tmp.push_back(*p++); continue; }
+            if (++p >= end) break;
+            switch (const char c = *p++) {
+                case 'b': tmp.push_back('\b'); break;
+                case 'f': tmp.push_back('\f'); break;
+                case 'n': tmp.push_back('\n'); break;
+                case 'r': tmp.push_back('\r'); break;
+                case 't': tmp.push_back('\t'); break;
+                case 'u': {
+                    unsigned cp = 0;
+                    if (end - p < 4 || std::from_chars(p, p + 4, cp, 16).ptr != p + 4) { ok = false; return {}; }
+                    p += 4;
+                    if (cp < 0x80) tmp.push_back(static_cast<char>(cp));
+                    else if (cp < 0x800) {
+                        tmp.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+                        tmp.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+                    } else {
+                        tmp.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+                        tmp.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+                        tmp.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+                    }
+                    break;
+                }
+                default: tmp.push_back(c); break;   // \" \\ \/
+            }
+        }
+        if (p >= end) { ok = false; return {}; }
+        ++p;
+        return tmp;
+    }
+
+    // Entero sin signo (los doubles se truncan; las cadenas "0x.." y
+    // decimales se aceptan)
+    uint64_t u64() {
+        ws();
+        uint64_t v = 0;
+        if (p < end && *p == '"') {
+            std::string tmp;
+            std::string_view s = str(tmp);
+            int base = 10;
+            if (s.size() > 2 && s[0] == '0' && (s[1] == 'x' || s[1] == 'X')) { s.remove_prefix(2); base = 16; }
+            std::from_chars(s.data(), s.data() + s.size(), v, base);
+            return v;
+        }
+        const auto r = std::from_chars(p, end, v);
+        if (r.ec != std::errc()) { ok = false; return 0; }
+        p = r.ptr;
+        fraction();
+        return v;
+    }
+
+    int64_t i64() {
+        ws();
+        int64_t v = 0;
+        if (p < end && *p == '"') {
+            std::string tmp;
+            const std::string_view s = str(tmp);
+            std::from_chars(s.data(), s.data() + s.size(), v);
+            return v;
+        }
+        const auto r = std::from_chars(p, end, v);
+        if (r.ec != std::errc()) { ok = false; return 0; }
+        p = r.ptr;
+        fraction();
+        return v;
+    }
+
+    double f64() {
+        ws();
+        double v = 0.0;
+        const auto r = std::from_chars(p, end, v);
+        if (r.ec != std::errc()) { ok = false; return 0.0; }
+        p = r.ptr;
+        return v;
+    }
+
+    bool boolean() {
+        ws();
+        if (end - p >= 4 && std::memcmp(p, "true", 4) == 0) { p += 4; return true; }
+        if (end - p >= 5 && std::memcmp(p, "false", 5) == 0) { p += 5; return false; }
+        ok = false;
+        return false;
+    }
+
+    // Salta un valor cualquiera
+    void skip() {
+        ws();
+        if (p >= end) { ok = false; return; }
+        if (*p == '"') { std::string tmp; str(tmp); return; }
+        if (*p == '{' || *p == '[') {
+            int depth = 0;
+            while (p < end) {
+                const char c = *p;
+                if (c == '"') { std::string tmp; str(tmp); if (!ok) return; continue; }
+                ++p;
+                if (c == '{' || c == '[') ++depth;
+                else if ((c == '}' || c == ']') && --depth == 0) return;
+            }
+            ok = false;
+            return;
+        }
+        while (p < end && *p != ',' && *p != '}' && *p != ']' && *p != ' ' && *p != '\n') ++p;
+    }
+
+    // Recorre un objeto: fn(key) debe consumir el valor
+    template <typename Fn>
+    void object(Fn&& fn) {
+        expect('{');
+        if (!ok || eat('}')) return;
+        std::string tmp;
+        do {
+            const std::string_view key = str(tmp);
+            expect(':');
+            if (!ok) return;
+            fn(key);
+            if (!ok) return;
+        } while (eat(','));
+        expect('}');
+    }
+
+    template <typename Fn>
+    void array(Fn&& fn) {
+        expect('[');
+        if (!ok || eat(']')) return;
+        do {
+            fn();
+            if (!ok) return;
+        } while (eat(','));
+        expect(']');
+    }
+
+private:
+    // Parte fraccionaria/exponente de un número leído como entero: se descarta
+    void fraction() {
+        if (p < end && (*p == '.' || *p == 'e' || *p == 'E')) skip();
+    }
+};
+
+} // namespace json
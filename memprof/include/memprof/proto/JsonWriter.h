@@ -0,0 +1,97 @@
+#pragma once
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Escritor JSON del modo depuración (MEMPROF_WIRE_FORMAT=json): añade a un
+// std::string reutilizable entre ticks, números con std::to_chars (sin
+// locale ni ostream) y escapado directo sobre la salida, sin strings
+// intermedios. No valida la estructura: comas y llaves las pone el llamador.
+namespace json {
+
+class Writer {
+public:
+    explicit Writer(std::string& out) : out_(out) {}
+
+    void raw(std::string_view s) { out_.append(s.data(), s.size()); }
+    void ch(char c) { out_.push_back(c); }
+
+    // Clave literal ya válida en JSON: "k":
+    void key(std::string_view k) {
+        out_.push_back('"');
+        raw(k);
+        out_.append("\":", 2);
+    }
+
+    void u64(uint64_t v) { num(v); }
+    void i64(int64_t v)  { num(v); }
+    // Representación más corta que relee el mismo double; inf/nan no
+    // existen en JSON y salen como 0
+    void f64(double v) {
+        if (!std::isfinite(v)) { out_.push_back('0'); return; }
+        char buf[32];
+        const auto r = std::to_chars(buf, buf + sizeof(buf), v);
+        out_.append(buf, static_cast<size_t>(r.ptr - buf));
+    }
+    void boolean(bool b) { b ? raw("true") : raw("false"); }
+
+    // "texto" escapado
+    void str(std::string_view s) {
+        out_.push_back('"');
+        escape(s);
+        out_.push_back('"');
+    }
+
+    // Escapa sin comillas: los tramos sin caracteres especiales van de un golpe
+    void escape(std::string_view s) {
+        size_t run = 0;
+        for (size_t i = 0; i < s.size(); ++i) {
+            const auto c = static_cast<unsigned char>(s[i]);
+            if (c >= 0x20 && c != '"' && c != '\\') continue;
+            out_.append(s.data() + run, i - run);
+            run = i + 1;
+            switch (c) {
+                case '"':  out_.append("\\\"", 2); break;
+                case '\\': out_.append("\\\\", 2); break;
+                case '\b': out_.append("\\b", 2);  break;
+                case '\f': out_.append("\\f", 2);  break;
+                case '\n': out_.append("\\n", 2);  break;
+                case '\r': out_.append("\\r", 2);  break;
+                case '\t': out_.append("\\t", 2);  break;
+                default: {
+                    static constexpr char kHex[] = "0123456789ABCDEF";
+                    const char u[6] = {'\\', 'u', '0', '0', kHex[c >> 4], kHex[c & 0xF]};
+                    out_.append(u, sizeof(u));
+                }
+            }
+        }
+        out_.append(s.data() + run, s.size() - run);
+    }
+
+    // "0x" + hex en mayúsculas con ceros a la izquierda, entre comillas
+    void hex(uintptr_t p) {
+        static constexpr char kDigits[] = "0123456789ABCDEF";
+        constexpr int n = sizeof(void*) * 2;
+        char buf[2 + n + 2];
+        buf[0] = '"'; buf[1] = '0'; buf[2] = 'x';
+        for (int i = n - 1; i >= 0; --i) { buf[3 + i] = kDigits[p & 0xF]; p >>= 4; }
+        buf[3 + n] = '"';
+        out_.append(buf, sizeof(buf));
+    }
+
+    std::string& buffer() { return out_; }
+
+private:
+    template <class T>
+    void num(T v) {
+        char buf[24];
+        const auto r = std::to_chars(buf, buf + sizeof(buf), v);
+        out_.append(buf, static_cast<size_t>(r.ptr - buf));
+    }
+
+    std::string& out_;
+};
+
+} // namespace json
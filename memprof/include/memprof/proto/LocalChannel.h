@@ -0,0 +1,122 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__linux__)
+  #include <linux/futex.h>
+  #include <sys/syscall.h>
+  #include <time.h>
+  #include <unistd.h>
+#endif
+
+// Transportes runtime -> GUI en la misma máquina (alternativa al TCP por
+// loopback). El endpoint de memprof_init / MEMPROF_HOST elige el transporte:
+//
+//   "127.0.0.1" (o cualquier IPv4) : TCP al puerto indicado (por defecto)
+//   "unix:/ruta.sock"              : socket AF_UNIX de tipo stream
+//   "shm:/ruta.sock"               : anillo en memoria compartida (solo Linux)
+//
+// Sin ruta ("unix:", "shm:") se usa MEMPROF_SOCKET o kDefaultSocket. La GUI
+// escucha en la misma ruta y distingue ambos modos por el primer mensaje:
+//
+// - unix: el cliente escribe directamente las tramas (o líneas JSON) en el
+//   socket, igual que por TCP.
+// - shm: el primer mensaje es el byte kHello con dos descriptores adjuntos
+//   (SCM_RIGHTS): un memfd con el anillo y un eventfd. Las tramas van por el
+//   anillo; el productor escribe en el eventfd tras cada envío y el socket
+//   solo sirve para detectar la desconexión.
+//
+// El anillo es SPSC de bytes: Header seguido de 'capacity' bytes (potencia
+// de dos). head/tail son contadores monotónicos (posición = valor & (cap-1)).
+// Con el anillo lleno el productor duerme en un futex sobre tail_seq, que el
+// consumidor incrementa cada vez que libera espacio.
+namespace shmring {
+
+inline constexpr const char* kDefaultSocket   = "/tmp/memprof.sock";
+inline constexpr uint32_t    kMagic           = 0x5253504Du;   // "MPSR"
+inline constexpr uint32_t    kVersion         = 1;
+inline constexpr uint64_t    kDefaultCapacity = 4u << 20;      // 4 MB
+inline constexpr char        kHello           = 'R';
+
+struct Header {
+    uint32_t magic    = kMagic;
+    uint32_t version  = kVersion;
+    uint64_t capacity = 0;
+    alignas(64) std::atomic<uint64_t> head{0};       // bytes escritos (productor)
+    alignas(64) std::atomic<uint64_t> tail{0};       // bytes consumidos (consumidor)
+    std::atomic<uint32_t> tail_seq{0};               // futex: +1 al liberar espacio
+    std::atomic<uint32_t> writer_waiting{0};         // el productor duerme en tail_seq
+};
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "el anillo compartido necesita atómicos sin lock");
+
+inline size_t mappingSize(uint64_t capacity) { return sizeof(Header) + static_cast<size_t>(capacity); }
+inline char*  dataOf(Header* h) { return reinterpret_cast<char*>(h) + sizeof(Header); }
+
+// El consumidor no se fía de lo que llega por el memfd
+inline bool valid(const Header* h, size_t mapped) {
+    return h->magic == kMagic && h->version == kVersion && h->capacity >= 4096 &&
+           (h->capacity & (h->capacity - 1)) == 0 && mappingSize(h->capacity) <= mapped;
+}
+
+inline uint64_t freeSpace(const Header* h) {
+    return h->capacity - (h->head.load(std::memory_order_relaxed) - h->tail.load(std::memory_order_acquire));
+}
+
+#if defined(__linux__)
+// Futex compartido entre procesos (sin FUTEX_PRIVATE_FLAG): mapping MAP_SHARED
+inline void futexWait(std::atomic<uint32_t>* word, uint32_t expected, int timeout_ms) {
+    timespec ts{timeout_ms / 1000, (timeout_ms % 1000) * 1'000'000L};
+    ::syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAIT, expected, &ts, nullptr, 0);
+}
+inline void futexWake(std::atomic<uint32_t>* word) {
+    ::syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAKE, 1, nullptr, nullptr, 0);
+}
+#else
+inline void futexWait(std::atomic<uint32_t>*, uint32_t, int) {}
+inline void futexWake(std::atomic<uint32_t>*) {}
+#endif
+
+// Productor: copia lo que quepa y lo publica. Devuelve los bytes escritos.
+inline size_t write(Header* h, const char* src, size_t n) {
+    const uint64_t cap  = h->capacity;
+    const uint64_t head = h->head.load(std::memory_order_relaxed);
+    const uint64_t tail = h->tail.load(std::memory_order_acquire);
+    const size_t   k    = static_cast<size_t>(n < cap - (head - tail) ? n : cap - (head - tail));
+    if (k == 0) return 0;
+    const size_t at    = static_cast<size_t>(head & (cap - 1));
+    const size_t first = k < cap - at ? k : static_cast<size_t>(cap - at);
+    std::memcpy(dataOf(h) + at, src, first);
+    std::memcpy(dataOf(h), src + first, k - first);
+    h->head.store(head + k, std::memory_order_release);
+    return k;
+}
+
+// Productor: duerme hasta que haya espacio o pasen 'timeout_ms'
+inline void waitForSpace(Header* h, int timeout_ms) {
+    h->writer_waiting.store(1, std::memory_order_seq_cst);
+    const uint32_t seq = h->tail_seq.load(std::memory_order_seq_cst);
+    if (freeSpace(h) == 0) futexWait(&h->tail_seq, seq, timeout_ms);
+}
+
+// Consumidor: entrega todo lo disponible a sink(ptr, len) (uno o dos tramos),
+// libera el espacio y despierta al productor si esperaba. Devuelve los bytes.
+template <class Sink>
+inline size_t read(Header* h, Sink&& sink) {
+    const uint64_t cap  = h->capacity;
+    const uint64_t tail = h->tail.load(std::memory_order_relaxed);
+    const uint64_t head = h->head.load(std::memory_order_acquire);
+    const uint64_t n    = head - tail;
+    if (n == 0 || n > cap) return 0;
+    const size_t at    = static_cast<size_t>(tail & (cap - 1));
+    const size_t first = static_cast<size_t>(n < cap - at ? n : cap - at);
+    sink(dataOf(h) + at, first);
+    if (n > first) sink(dataOf(h), static_cast<size_t>(n) - first);
+    h->tail.store(head, std::memory_order_release);
+    h->tail_seq.fetch_add(1, std::memory_order_seq_cst);
+    if (h->writer_waiting.exchange(0, std::memory_order_seq_cst)) futexWake(&h->tail_seq);
+    return static_cast<size_t>(n);
+}
+
+} // namespace shmring
@@ -25,6 +25,9 @@ struct BinRange {
     qulonglong hi = 0;
     qlonglong  bytes = 0;
     int        allocations = 0;
+    // Acumulado histórico de la clase (clases de tamaño del runtime)
+    qulonglong allocBytes = 0;
+    qulonglong allocCount = 0;
 };
 
 // --- Estadísticas por archivo ---
@@ -45,6 +48,62 @@ struct LeakItem {
     QString    type;
     qulonglong ts_ns = 0; // timestamp de asignación (steady)
     bool       isLeak = false; // decidido en el runtime/backend
+    unsigned   stackId = 0;    // pila de asignación (StackStat::id; 0 = sin pila)
+    qulonglong pc = 0;         // dirección del llamador si el sitio no trae file/line
+    QString    function;       // función de 'pc' (simbolizada en el runtime)
+};
+
+// --- Dirección de código simbolizada (callers y marcos de pila) ---
+struct FrameSymbol {
+    qulonglong pc = 0;
+    QString    function;   // nombre demangled, o "modulo+0xoff" sin símbolo
+    QString    file;       // vacío si el módulo no tiene .debug_line
+    int        line = 0;
+};
+
+// --- Agregados por pila de llamada (captura de pilas activa) ---
+struct StackStat {
+    unsigned            id = 0;
+    QVector<qulonglong> frames;     // direcciones de retorno, la más interna primero
+    qulonglong totalBytes = 0;      // bytes acumulados en allocs
+    qulonglong allocs     = 0;
+    qulonglong liveCount  = 0;
+    qulonglong liveBytes  = 0;
+    qulonglong leakCount  = 0;
+    qulonglong leakBytes  = 0;
+};
+
+// --- Snapshot de heap con nombre: conjunto vivo agrupado por sitio ---
+struct SiteUsageItem {
+    QString    file;
+    int        line = 0;
+    QString    type;
+    qulonglong pc = 0;         // sitio sin file/line (ver LeakItem::pc)
+    qulonglong bytes = 0;
+    qulonglong count = 0;
+};
+
+struct HeapSnapshotItem {
+    unsigned   id = 0;         // del runtime (memprof_take_snapshot); 0 = capturado en la GUI
+                               // en peakSnapshot: nº de captura, 0 = ninguna
+    QString    label;
+    qulonglong tMs = 0;        // misma base que la timeline
+    qulonglong bytes = 0;
+    qulonglong count = 0;
+    QVector<SiteUsageItem> sites;
+};
+
+// --- Vida de los bloques liberados de un sitio (acumulada) ---
+struct SiteLifetime {
+    QString    file;
+    int        line = 0;
+    QString    type;
+    qulonglong pc = 0;         // sitio sin file/line (ver LeakItem::pc)
+    qulonglong frees = 0;
+    qulonglong bytes = 0;      // bytes liberados
+    qulonglong shortLived = 0; // vida < MetricsSnapshot::shortLivedNs
+    qulonglong p50Ns = 0;
+    qulonglong p99Ns = 0;
 };
 
 // --- Snapshot que consume la GUI ---
@@ -58,6 +117,8 @@ struct MetricsSnapshot {
     double     allocRate   = 0.0;   // alloc/s (runtime)
     double     freeRate    = 0.0;   // free/s  (runtime)
     qulonglong uptimeMs    = 0;
+    qulonglong sampleInterval = 0;  // bytes medios entre muestras; 0 = exacto (sin muestreo)
+    qulonglong droppedFrames  = 0;  // tramas que el runtime descartó porque la GUI no leía
 
     // KPIs de fugas (runtime)
     double     leakRate      = 0.0;       // leaks / total allocs
@@ -71,4 +132,10 @@ struct MetricsSnapshot {
     QVector<BinRange>  bins;
     QVector<FileStat>  perFile;
     QVector<LeakItem>  leaks;
+    QVector<StackStat> stacks;
+    QVector<FrameSymbol> symbols;   // direcciones resueltas hasta ahora
+    QVector<HeapSnapshotItem> heapSnapshots;   // snapshots con nombre del runtime
+    HeapSnapshotItem          peakSnapshot;    // desglose por sitio en el último pico capturado
+    QVector<SiteLifetime>     lifetimes;       // sitios con algún free
+    qulonglong                shortLivedNs = 0;   // umbral de SiteLifetime::shortLived
 };
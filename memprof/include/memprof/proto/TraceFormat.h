@@ -0,0 +1,67 @@
+#pragma once
+#include <cstdint>
+
+// Formato de las trazas en disco (modo grabación: MEMPROF_TRACE o
+// memprof_set_trace_file). Una sesión se guarda como una serie de segmentos
+//
+//   <prefijo>.000000.mpt, <prefijo>.000001.mpt, ...
+//
+// de tamaño fijo, escritos en secuencia por TraceWriter a través de mmap. Cada
+// segmento empieza con una SegmentHeader y sigue con registros de solo-añadir:
+//
+//   tag u8 | cuerpo
+//
+// con la misma codificación que WireFormat.h (v = varint, z = zigzag,
+// bytes = v len + datos, f32 = float IEEE-754 LE):
+//
+//   String : v id, bytes                      (file/type; ids desde 1, 0 = nulo)
+//   Stack  : v id, v depth, depth × v pc      (id de StackTable)
+//   Module : v base, bytes path               (para simbolizar fuera de línea)
+//   Alloc  : z Δts_ns, v ptr, v size, v file, z line, v type, v thread,
+//            u8 flags [, v stack][, v caller][, f32 weight]
+//   Free   : z Δts_ns, v ptr, v thread
+//
+// Cada segmento es autocontenido: String/Stack se emiten antes del primer
+// registro que los usa dentro del segmento y los Module al abrirlo. Los Δts
+// parten de base_ts_ns. 'used' se actualiza tras cada lote, así que una traza
+// cortada por un crash se lee hasta el último lote completo; al cerrar
+// normalmente el archivo se trunca a 'used'.
+//
+// Lectura: trace::SegmentReader (TraceReader.h). memprof-analyze reproduce
+// una sesión entera a partir de su primer segmento.
+namespace trace {
+
+inline constexpr char     kMagic[4] = {'M', 'P', 'T', 'R'};
+inline constexpr uint16_t kVersion  = 1;
+
+struct SegmentHeader {          // 64 bytes, little-endian
+    char     magic[4];
+    uint16_t version;
+    uint16_t header_size;       // sizeof(SegmentHeader)
+    uint32_t index;             // nº de segmento (desde 0)
+    uint32_t pid;
+    uint64_t base_ts_ns;        // steady_clock (mismo reloj que los eventos)
+    uint64_t wall_ns;           // CLOCK_REALTIME al abrir el segmento
+    uint64_t used;              // bytes válidos, cabecera incluida
+    uint64_t records;           // registros Alloc + Free
+    uint64_t sample_interval;   // != 0: allocs muestreadas (ver AllocWeight)
+    uint64_t reserved;
+};
+static_assert(sizeof(SegmentHeader) == 64, "SegmentHeader debe ocupar 64 bytes");
+
+enum class Rec : uint8_t {
+    String = 1,
+    Stack  = 2,
+    Module = 3,
+    Alloc  = 4,
+    Free   = 5,
+};
+
+enum AllocFlags : uint8_t {
+    AllocArray  = 1u << 0,
+    AllocStack  = 1u << 1,   // sigue v stack
+    AllocCaller = 1u << 2,   // sigue v caller (sin file/line)
+    AllocWeight = 1u << 3,   // sigue f32 weight (muestreo; sin él, 1)
+};
+
+} // namespace trace
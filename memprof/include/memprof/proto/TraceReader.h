@@ -0,0 +1,116 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+#include "memprof/proto/TraceFormat.h"
+#include "memprof/proto/WireFormat.h"
+
+// Lector de un segmento de traza (contraparte de TraceWriter): valida la
+// cabecera y recorre los registros en orden sin copiar cadenas. Los Δts se
+// acumulan desde base_ts_ns, así que Record::ts_ns sale absoluto. Un
+// registro truncado o con tag desconocido termina la lectura con ok = false
+// (lo leído hasta ahí sigue siendo válido).
+namespace trace {
+
+struct Record {
+    Rec      kind = Rec::Alloc;
+    uint64_t ts_ns = 0;             // Alloc/Free
+    uint64_t ptr = 0;
+    uint64_t size = 0;
+    uint32_t file = 0, type = 0;    // ids de String (0 = nulo)
+    int32_t  line = 0;
+    uint32_t thread = 0;
+    uint8_t  flags = 0;             // AllocFlags
+    uint32_t stack = 0;
+    uint64_t caller = 0;
+    float    weight = 1.0f;
+
+    uint32_t              id = 0;   // String/Stack
+    std::string_view      text;     // String: contenido; Module: ruta (vista del segmento)
+    uint64_t              base = 0; // Module
+    std::vector<uint64_t> pcs;      // Stack
+};
+
+class SegmentReader {
+public:
+    // 'n': bytes disponibles del archivo; se lee hasta header.used
+    SegmentReader(const void* data, size_t n) : in_(nullptr, 0) {
+        if (n < sizeof(SegmentHeader)) { ok_ = false; return; }
+        std::memcpy(&h_, data, sizeof(h_));
+        if (std::memcmp(h_.magic, kMagic, sizeof(kMagic)) != 0 || h_.version != kVersion ||
+            h_.header_size < sizeof(SegmentHeader) || h_.used < h_.header_size || h_.used > n) {
+            ok_ = false;
+            return;
+        }
+        const auto* p = static_cast<const char*>(data);
+        in_  = wire::Reader(p + h_.header_size, static_cast<size_t>(h_.used - h_.header_size));
+        ts_  = h_.base_ts_ns;
+    }
+
+    bool ok() const { return ok_; }
+    const SegmentHeader& header() const { return h_; }
+
+    // false al llegar a 'used' o ante un registro malformado (ver ok())
+    bool next(Record& r) {
+        if (!ok_ || in_.atEnd()) return false;
+        r.kind = static_cast<Rec>(in_.u8());
+        switch (r.kind) {
+            case Rec::String:
+                r.id   = static_cast<uint32_t>(in_.varint());
+                r.text = in_.bytes();
+                break;
+            case Rec::Stack: {
+                r.id = static_cast<uint32_t>(in_.varint());
+                const uint64_t depth = in_.varint();
+                if (depth > in_.remaining()) { ok_ = false; return false; }
+                r.pcs.resize(static_cast<size_t>(depth));
+                for (auto& pc : r.pcs) pc = in_.varint();
+                break;
+            }
+            case Rec::Module:
+                r.base = in_.varint();
+                r.text = in_.bytes();
+                break;
+            case Rec::Alloc:
+                ts_     += static_cast<uint64_t>(in_.zigzag());
+                r.ts_ns  = ts_;
+                r.ptr    = in_.varint();
+                r.size   = in_.varint();
+                r.file   = static_cast<uint32_t>(in_.varint());
+                r.line   = static_cast<int32_t>(in_.zigzag());
+                r.type   = static_cast<uint32_t>(in_.varint());
+                r.thread = static_cast<uint32_t>(in_.varint());
+                r.flags  = in_.u8();
+                r.stack  = (r.flags & AllocStack)  ? static_cast<uint32_t>(in_.varint()) : 0;
+                r.caller = (r.flags & AllocCaller) ? in_.varint() : 0;
+                r.weight = 1.0f;
+                if (r.flags & AllocWeight) {
+                    const uint32_t bits = in_.u32();
+                    std::memcpy(&r.weight, &bits, sizeof(bits));
+                }
+                break;
+            case Rec::Free:
+                ts_     += static_cast<uint64_t>(in_.zigzag());
+                r.ts_ns  = ts_;
+                r.ptr    = in_.varint();
+                r.thread = static_cast<uint32_t>(in_.varint());
+                break;
+            default:
+                ok_ = false;
+                return false;
+        }
+        if (!in_.ok()) ok_ = false;
+        return ok_;
+    }
+
+private:
+    SegmentHeader h_{};
+    wire::Reader  in_;
+    uint64_t      ts_ = 0;
+    bool          ok_ = true;
+};
+
+} // namespace trace
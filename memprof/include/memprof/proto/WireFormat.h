@@ -0,0 +1,299 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+// Protocolo binario runtime -> GUI (alternativa compacta al JSON por línea).
+//
+// Cada mensaje es una trama con cabecera fija de 12 bytes (little-endian):
+//
+//   magic[4] = "MPWF" | version u8 | kind u8 | flags u16 | length u32
+//
+// seguida de 'length' bytes de payload. El primer byte ('M') no puede empezar
+// una línea JSON ('{'), así que el receptor distingue ambos modos sin
+// negociación. El modo JSON se conserva para depurar (MEMPROF_WIRE_FORMAT=json).
+//
+// El payload de un Snapshot es una secuencia de secciones etiquetadas:
+//
+//   tag u8 | varint len | cuerpo[len]
+//
+// Un decodificador salta las etiquetas que no conoce; añadir secciones no
+// obliga a subir la versión. Cuerpos de la versión 1 (v = varint,
+// z = varint zigzag, f = double IEEE-754 LE, s = índice en la tabla Strings):
+//
+//   Epoch    : v epoch, v base_epoch
+//   Strings  : v n, n × (v len, bytes)
+//   Sites    : v first, v n, n × (s file, z line, s type) (ids first..first+n-1)
+//   General  : v uptime_ms, heap_current, heap_peak, active_allocs,
+//              total_allocs, leak_bytes; f alloc_rate, free_rate, leak_rate;
+//              v largest_size; s largest_file; s top_file;
+//              v top_file_count, top_file_bytes[, sample_interval[, dropped_frames]]
+//   PerFile  : v n, n × (s file, v totalBytes, v allocs, v frees, v netBytes)
+//   Bins     : v n, n × (v lo, v hi, v bytes, v allocations)   (vivos por clase de tamaño)
+//   AllocBins: v n, n × (v alloc_bytes, v alloc_count)  (acumulado de las mismas
+//              clases, en el orden de Bins; va detrás de Bins)
+//   Blocks   : v n, n × (v ptr, v size, v site, v ts_ns, u8 flags
+//              [, v stack si flags & BlockStack])
+//   StackFrames (pilas): v first, v n, n × (v depth, depth × v pc)
+//              (ids first..first+n-1)
+//   PerStack : v n, n × (v id, v totalBytes, v allocs, v live_count,
+//              v live_bytes, v leak_count, v leak_bytes)
+//   SymbolStrings: v first, v n, n × (v len, bytes)     (ids first..first+n-1)
+//   Symbols  : v n, n × (v pc, v function, v file, z line) (ids en SymbolStrings)
+//   SitePcs  : v n, n × (v site, v pc)   (sitios sin file/line: dirección del llamador)
+//   HeapSnapshots: v n, n × (v id, bytes label, v t_ms, v bytes, v count,
+//              v k, k × (v Δsite, v bytes, v count))  (snapshots con nombre; sitios
+//              ordenados, Δ desde el anterior)
+//   PeakSnapshot: v id, v t_ms, v bytes, v count, v k, k × (v Δsite, v bytes, v count)
+//              (última captura automática en el pico; id = nº de captura)
+//   Lifetimes: v short_ns, v n, n × (v site, v frees, v bytes, v short, v p50_ns, v p99_ns)
+//              (vida de los bloques liberados por sitio, acumulada; short = vida < short_ns)
+//   Removed  : v n, n × v Δptr                          (ordenados, Δ desde el anterior)
+//   Timeline : v n, n × (v Δt_ms, v cur_bytes)           (Δ desde el anterior)
+//
+// Una trama Snapshot (keyframe) trae el estado completo y reemplaza el que
+// tenga el receptor. Una trama Delta solo trae lo cambiado desde base_epoch:
+// Blocks/PerFile/PerStack son altas o modificaciones por clave (ptr /
+// archivo / id de pila), Removed son bajas, Sites, StackFrames y
+// SymbolStrings añaden ids nuevos, Symbols añade direcciones resueltas,
+// HeapSnapshots añade snapshots tomados desde la trama anterior,
+// PeakSnapshot reemplaza la captura en el pico, Lifetimes reemplaza las filas
+// de sus sitios y Timeline añade puntos. La tabla SymbolStrings es propia del simbolizador y
+// persiste entre tramas (Strings es local a cada trama). Un receptor cuyo epoch no coincide con
+// base_epoch descarta deltas hasta el siguiente keyframe. General, Bins y
+// AllocBins siempre van completos.
+//
+// Cada conexión empieza con una trama Hello que identifica al proceso (la GUI
+// admite varios a la vez). Va también en modo JSON, antes de la primera
+// línea; su payload no tiene secciones:
+//
+//   Hello    : v pid, v len, bytes nombre del binario
+namespace wire {
+
+inline constexpr char     kMagic[4]     = {'M', 'P', 'W', 'F'};
+inline constexpr uint8_t  kVersion      = 1;
+inline constexpr size_t   kHeaderSize   = 12;
+inline constexpr uint32_t kMaxFrameSize = 512u * 1024u * 1024u;   // cordura al decodificar
+
+enum class Kind : uint8_t {
+    Snapshot = 1,   // keyframe
+    Delta    = 2,
+    Hello    = 3,   // identidad del proceso (primera trama de la conexión)
+};
+
+enum class Section : uint8_t {
+    Strings     = 1,
+    Sites       = 2,
+    General     = 3,
+    PerFile     = 4,
+    Bins        = 5,
+    Blocks      = 6,
+    Timeline    = 7,
+    Removed     = 8,
+    Epoch       = 9,
+    StackFrames = 10,
+    PerStack    = 11,
+    SymbolStrings = 12,
+    Symbols     = 13,
+    SitePcs     = 14,
+    HeapSnapshots = 15,
+    PeakSnapshot  = 16,
+    Lifetimes     = 17,
+    AllocBins     = 18,
+};
+
+enum BlockFlags : uint8_t {
+    BlockLeak  = 1u << 0,
+    BlockArray = 1u << 1,
+    BlockStack = 1u << 2,   // sigue un varint con el id de pila
+};
+
+struct FrameHeader {
+    uint8_t  version = 0;
+    Kind     kind = Kind::Snapshot;
+    uint16_t flags = 0;
+    uint32_t length = 0;     // bytes de payload (sin la cabecera)
+};
+
+// ---------------------------------------------------------------------------
+// Escritura: todo se añade a un std::string reutilizable entre tramas.
+// ---------------------------------------------------------------------------
+class Writer {
+public:
+    explicit Writer(std::string& out) : out_(out) {}
+
+    void u8(uint8_t v) { out_.push_back(static_cast<char>(v)); }
+    void u16(uint16_t v) { for (int i = 0; i < 2; ++i) u8(static_cast<uint8_t>(v >> (8 * i))); }
+    void u32(uint32_t v) { for (int i = 0; i < 4; ++i) u8(static_cast<uint8_t>(v >> (8 * i))); }
+
+    void varint(uint64_t v) {
+        char buf[10];
+        size_t n = 0;
+        while (v >= 0x80) { buf[n++] = static_cast<char>((v & 0x7F) | 0x80); v >>= 7; }
+        buf[n++] = static_cast<char>(v);
+        out_.append(buf, n);
+    }
+    void zigzag(int64_t v) { varint((static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63)); }
+
+    void f64(double d) {
+        uint64_t bits;
+        std::memcpy(&bits, &d, sizeof(bits));
+        for (int i = 0; i < 8; ++i) u8(static_cast<uint8_t>(bits >> (8 * i)));
+    }
+
+    void bytes(std::string_view s) { varint(s.size()); out_.append(s.data(), s.size()); }
+
+    // Trama: beginFrame() devuelve el offset de la cabecera para endFrame()
+    size_t beginFrame(Kind kind, uint16_t flags = 0) {
+        const size_t at = out_.size();
+        out_.append(kMagic, sizeof(kMagic));
+        u8(kVersion);
+        u8(static_cast<uint8_t>(kind));
+        u16(flags);
+        u32(0);                      // longitud, se parchea al cerrar
+        return at;
+    }
+    void endFrame(size_t at) { patchU32(at + 8, static_cast<uint32_t>(out_.size() - at - kHeaderSize)); }
+
+    // Sección: la longitud se escribe al cerrar como varint de 5 bytes fijos
+    // (relleno con bits de continuación) para no tener que mover el cuerpo.
+    size_t beginSection(Section tag) {
+        u8(static_cast<uint8_t>(tag));
+        const size_t at = out_.size();
+        out_.append(5, '\0');
+        return at;
+    }
+    void endSection(size_t at) {
+        uint32_t len = static_cast<uint32_t>(out_.size() - at - 5);
+        for (int i = 0; i < 5; ++i) {
+            uint8_t b = static_cast<uint8_t>(len & 0x7F);
+            len >>= 7;
+            if (i < 4) b |= 0x80;
+            out_[at + i] = static_cast<char>(b);
+        }
+    }
+
+    std::string& buffer() { return out_; }
+
+private:
+    void patchU32(size_t at, uint32_t v) {
+        for (int i = 0; i < 4; ++i) out_[at + i] = static_cast<char>(v >> (8 * i));
+    }
+    std::string& out_;
+};
+
+// Trama Hello completa al final de 'out'
+inline void writeHello(std::string& out, uint64_t pid, std::string_view name) {
+    Writer w(out);
+    const size_t f = w.beginFrame(Kind::Hello);
+    w.varint(pid);
+    w.bytes(name);
+    w.endFrame(f);
+}
+
+// ---------------------------------------------------------------------------
+// Lectura sin copias sobre un buffer ajeno. Los errores no lanzan: dejan
+// ok() a false y devuelven ceros; el llamador comprueba al final.
+// ---------------------------------------------------------------------------
+class Reader {
+public:
+    Reader(const void* data, size_t n)
+        : p_(static_cast<const uint8_t*>(data)), end_(p_ + n) {}
+
+    bool   ok()        const { return ok_; }
+    bool   atEnd()     const { return p_ >= end_; }
+    size_t remaining() const { return static_cast<size_t>(end_ - p_); }
+
+    uint8_t u8() {
+        if (p_ >= end_) { ok_ = false; return 0; }
+        return *p_++;
+    }
+
+    uint64_t varint() {
+        uint64_t v = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (p_ >= end_) { ok_ = false; return 0; }
+            const uint8_t b = *p_++;
+            v |= static_cast<uint64_t>(b & 0x7F) << shift;
+            if (!(b & 0x80)) return v;
+        }
+        ok_ = false;
+        return 0;
+    }
+    int64_t zigzag() {
+        const uint64_t u = varint();
+        return static_cast<int64_t>((u >> 1) ^ (~(u & 1) + 1));
+    }
+
+    uint32_t u32() {
+        if (remaining() < 4) { ok_ = false; p_ = end_; return 0; }
+        uint32_t v = 0;
+        for (int i = 0; i < 4; ++i) v |= static_cast<uint32_t>(p_[i]) << (8 * i);
+        p_ += 4;
+        return v;
+    }
+
+    double f64() {
+        if (remaining() < 8) { ok_ = false; p_ = end_; return 0.0; }
+        uint64_t bits = 0;
+        for (int i = 0; i < 8; ++i) bits |= static_cast<uint64_t>(p_[i]) << (8 * i);
+        p_ += 8;
+        double d;
+        std::memcpy(&d, &bits, sizeof(d));
+        return d;
+    }
+
+    // Vista sobre el buffer original (válida mientras lo sea el buffer)
+    std::string_view bytes() {
+        const uint64_t n = varint();
+        if (!ok_ || n > remaining()) { ok_ = false; p_ = end_; return {}; }
+        std::string_view s(reinterpret_cast<const char*>(p_), static_cast<size_t>(n));
+        p_ += n;
+        return s;
+    }
+
+    // Siguiente sección: devuelve false al terminar el payload o si está
+    // malformada. 'body' queda acotado al cuerpo de la sección.
+    bool nextSection(Section& tag, Reader& body) {
+        if (atEnd() || !ok_) return false;
+        tag = static_cast<Section>(u8());
+        const uint64_t n = varint();
+        if (!ok_ || n > remaining()) { ok_ = false; return false; }
+        body = Reader(p_, static_cast<size_t>(n));
+        p_ += n;
+        return true;
+    }
+
+private:
+    const uint8_t* p_;
+    const uint8_t* end_;
+    bool           ok_ = true;
+};
+
+// ¿Empieza 'data' por una cabecera de trama? (para distinguir del JSON)
+inline bool looksLikeFrame(const char* data, size_t n) {
+    const size_t k = n < sizeof(kMagic) ? n : sizeof(kMagic);
+    return k > 0 && std::memcmp(data, kMagic, k) == 0;
+}
+
+enum class FrameStatus { Ok, NeedMore, Bad };
+
+// Valida la cabecera al inicio de 'data'. Con Ok, la trama completa ocupa
+// kHeaderSize + h.length bytes y ya están todos disponibles.
+inline FrameStatus peekFrame(const char* data, size_t n, FrameHeader& h) {
+    if (n < kHeaderSize) return looksLikeFrame(data, n) ? FrameStatus::NeedMore : FrameStatus::Bad;
+    if (std::memcmp(data, kMagic, sizeof(kMagic)) != 0) return FrameStatus::Bad;
+    const auto* u = reinterpret_cast<const uint8_t*>(data);
+    h.version = u[4];
+    h.kind    = static_cast<Kind>(u[5]);
+    h.flags   = static_cast<uint16_t>(u[6] | (u[7] << 8));
+    h.length  = static_cast<uint32_t>(u[8]) | (static_cast<uint32_t>(u[9]) << 8) |
+                (static_cast<uint32_t>(u[10]) << 16) | (static_cast<uint32_t>(u[11]) << 24);
+    if (h.version == 0 || h.length > kMaxFrameSize) return FrameStatus::Bad;
+    if (n - kHeaderSize < h.length) return FrameStatus::NeedMore;
+    return FrameStatus::Ok;
+}
+
+} // namespace wire
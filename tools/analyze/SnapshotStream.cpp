@@ -0,0 +1,343 @@
+#include "SnapshotStream.h"
+
+#include <charconv>
+#include <cstring>
+#include <string_view>
+
+#include "memprof/proto/JsonReader.h"
+#include "memprof/proto/WireFormat.h"
+
+namespace analyze {
+
+namespace {
+
+std::string siteName(std::string_view file, int64_t line, std::string_view type) {
+    std::string out(file.empty() ? std::string_view("unknown") : file);
+    out += ':';
+    out += std::to_string(line);
+    if (!type.empty()) {
+        out += " (";
+        out.append(type.data(), type.size());
+        out += ')';
+    }
+    return out;
+}
+
+} // anon
+
+// El runtime reenvía todos los snapshots en cada línea JSON y en cada
+// keyframe: solo se añaden los de id nuevo
+void SnapshotStream::addHeapSnapshot(HeapSnapshot&& hs) {
+    if (!heap_snaps_.empty() && hs.id <= heap_snaps_.back().id) return;
+    heap_snaps_.push_back(std::move(hs));
+}
+
+// ------------------------------- JSON --------------------------------------
+
+bool SnapshotStream::parseJsonLine(const char* p, const char* end) {
+    json::Reader j{p, end};
+    Sample& s = cur_;
+    s.live_by_file.clear();
+    s.leak_by_file.clear();
+    s.bins.clear();
+
+    std::string file_tmp;
+    j.object([&](std::string_view key) {
+        if (key == "general") {
+            j.object([&](std::string_view k) {
+                if      (k == "uptime_ms")     s.uptime_ms     = j.u64();
+                else if (k == "heap_current")  s.heap_current  = j.u64();
+                else if (k == "heap_peak")     s.heap_peak     = j.u64();
+                else if (k == "active_allocs") s.active_allocs = j.u64();
+                else if (k == "total_allocs")  s.total_allocs  = j.u64();
+                else if (k == "leak_bytes")    s.leak_bytes    = j.u64();
+                else j.skip();
+            });
+        } else if (key == "per_file") {
+            j.array([&] {
+                std::string_view file;
+                uint64_t net = 0;
+                j.object([&](std::string_view k) {
+                    if      (k == "file")     file = j.str(file_tmp);
+                    else if (k == "netBytes") net  = j.u64();
+                    else j.skip();
+                });
+                if (j.ok) s.live_by_file[std::string(file)] = net;
+            });
+        } else if (key == "bins") {
+            j.array([&] {
+                Bin b;
+                j.object([&](std::string_view k) {
+                    if      (k == "lo")          b.lo          = j.u64();
+                    else if (k == "hi")          b.hi          = j.u64();
+                    else if (k == "bytes")       b.bytes       = j.u64();
+                    else if (k == "allocations") b.allocations = j.u64();
+                    else j.skip();
+                });
+                s.bins.push_back(b);
+            });
+        } else if (key == "leaks") {
+            j.array([&] {
+                std::string_view file;
+                uint64_t size = 0;
+                bool     leak = false;
+                j.object([&](std::string_view k) {
+                    if      (k == "file")    file = j.str(file_tmp);
+                    else if (k == "size")    size = j.u64();
+                    else if (k == "is_leak") leak = j.boolean();
+                    else j.skip();
+                });
+                if (j.ok && leak) s.leak_by_file[std::string(file)] += size;
+            });
+        } else if (key == "heap_snapshots" || key == "peak_snapshot") {
+            const bool peak = key == "peak_snapshot";
+            auto snapshot = [&] {
+                HeapSnapshot hs;
+                std::string label_tmp, type_tmp;
+                j.object([&](std::string_view k) {
+                    if      (k == "id")    hs.id    = static_cast<uint32_t>(j.u64());
+                    else if (k == "label") hs.label = std::string(j.str(label_tmp));
+                    else if (k == "t_ms")  hs.t_ms  = j.u64();
+                    else if (k == "bytes") hs.bytes = j.u64();
+                    else if (k == "count") hs.count = j.u64();
+                    else if (k == "sites") {
+                        j.array([&] {
+                            std::string_view file, type;
+                            int64_t line = 0;
+                            SiteUsage u;
+                            j.object([&](std::string_view sk) {
+                                if      (sk == "file")  file    = j.str(file_tmp);
+                                else if (sk == "type")  type    = j.str(type_tmp);
+                                else if (sk == "line")  line    = static_cast<int64_t>(j.u64());
+                                else if (sk == "bytes") u.bytes = j.u64();
+                                else if (sk == "count") u.count = j.u64();
+                                else j.skip();
+                            });
+                            u.site = siteName(file, line, type);
+                            hs.sites.push_back(std::move(u));
+                        });
+                    } else j.skip();
+                });
+                if (!j.ok) return;
+                if (peak) peak_ = std::move(hs);
+                else      addHeapSnapshot(std::move(hs));
+            };
+            if (!peak)              j.array(snapshot);
+            else if (j.peek() == '{') snapshot();
+            else                    j.skip();   // null: aún sin captura
+        } else {
+            j.skip();
+        }
+    });
+    return j.ok;
+}
+
+// ------------------------------ binario ------------------------------------
+
+void SnapshotStream::dropBlock(const Block& b) {
+    if (!b.leak || b.site >= site_file_.size()) return;
+    auto it = cur_.leak_by_file.find(site_file_[b.site]);
+    if (it == cur_.leak_by_file.end()) return;
+    it->second = it->second > b.size ? it->second - b.size : 0;
+    if (it->second == 0) cur_.leak_by_file.erase(it);
+}
+
+bool SnapshotStream::applyFrame(const char* payload, size_t n, bool keyframe) {
+    if (!keyframe && !bin_valid_) return false;   // esperando keyframe
+    Sample& s = cur_;
+    if (keyframe) {
+        s = Sample{};
+        site_file_.clear();
+        site_name_.clear();
+        blocks_.clear();
+        bin_valid_ = true;
+    }
+
+    std::vector<std::string> strings;   // tabla local de la trama
+    auto str = [&](uint64_t id) -> const std::string& {
+        static const std::string empty;
+        return id < strings.size() ? strings[id] : empty;
+    };
+
+    wire::Reader r(payload, n);
+    wire::Section tag;
+    wire::Reader body(nullptr, 0);
+    while (r.nextSection(tag, body)) {
+        switch (tag) {
+        case wire::Section::Epoch: {
+            const uint64_t epoch = body.varint();
+            const uint64_t base  = body.varint();
+            if (!keyframe && base != epoch_) { bin_valid_ = false; return false; }
+            epoch_ = epoch;
+            break;
+        }
+        case wire::Section::Strings: {
+            const uint64_t cnt = body.varint();
+            if (cnt > body.remaining()) { bin_valid_ = false; return false; }
+            for (uint64_t i = 0; i < cnt && body.ok(); ++i) strings.emplace_back(body.bytes());
+            break;
+        }
+        case wire::Section::Sites: {
+            const uint64_t first = body.varint();
+            const uint64_t cnt   = body.varint();
+            if (cnt > body.remaining() || first > site_file_.size()) { bin_valid_ = false; return false; }
+            site_file_.resize(first);
+            site_name_.resize(first);
+            for (uint64_t i = 0; i < cnt && body.ok(); ++i) {
+                const std::string& file = str(body.varint());
+                const int64_t      line = body.zigzag();
+                site_file_.push_back(file);
+                site_name_.push_back(siteName(file, line, str(body.varint())));
+            }
+            break;
+        }
+        case wire::Section::General:
+            s.uptime_ms     = body.varint();
+            s.heap_current  = body.varint();
+            s.heap_peak     = body.varint();
+            s.active_allocs = body.varint();
+            s.total_allocs  = body.varint();
+            s.leak_bytes    = body.varint();
+            break;
+        case wire::Section::PerFile: {
+            const uint64_t cnt = body.varint();
+            for (uint64_t i = 0; i < cnt && body.ok(); ++i) {
+                const std::string& file = str(body.varint());
+                body.varint(); body.varint(); body.varint();   // totalBytes, allocs, frees
+                s.live_by_file[file] = body.varint();
+            }
+            break;
+        }
+        case wire::Section::Bins: {
+            const uint64_t cnt = body.varint();
+            s.bins.clear();
+            for (uint64_t i = 0; i < cnt && body.ok(); ++i) {
+                Bin b;
+                b.lo = body.varint(); b.hi = body.varint();
+                b.bytes = body.varint(); b.allocations = body.varint();
+                s.bins.push_back(b);
+            }
+            break;
+        }
+        case wire::Section::Blocks: {
+            const uint64_t cnt = body.varint();
+            for (uint64_t i = 0; i < cnt && body.ok(); ++i) {
+                const uint64_t ptr = body.varint();
+                Block b;
+                b.size = body.varint();
+                b.site = static_cast<uint32_t>(body.varint());
+                body.varint();   // ts_ns
+                const uint8_t flags = body.u8();
+                if (flags & wire::BlockStack) body.varint();
+                b.leak = (flags & wire::BlockLeak) != 0;
+                auto [it, fresh] = blocks_.try_emplace(ptr, b);
+                if (!fresh) { dropBlock(it->second); it->second = b; }
+                if (b.leak && b.site < site_file_.size()) s.leak_by_file[site_file_[b.site]] += b.size;
+            }
+            break;
+        }
+        case wire::Section::HeapSnapshots: {
+            const uint64_t cnt = body.varint();
+            for (uint64_t i = 0; i < cnt && body.ok(); ++i) {
+                HeapSnapshot hs;
+                hs.id    = static_cast<uint32_t>(body.varint());
+                hs.label = std::string(body.bytes());
+                hs.t_ms  = body.varint();
+                hs.bytes = body.varint();
+                hs.count = body.varint();
+                const uint64_t k = body.varint();
+                uint64_t site = 0;
+                for (uint64_t j = 0; j < k && body.ok(); ++j) {
+                    site += body.varint();
+                    SiteUsage u;
+                    u.site  = site < site_name_.size() ? site_name_[site] : "site#" + std::to_string(site);
+                    u.bytes = body.varint();
+                    u.count = body.varint();
+                    hs.sites.push_back(std::move(u));
+                }
+                if (body.ok()) addHeapSnapshot(std::move(hs));
+            }
+            break;
+        }
+        case wire::Section::PeakSnapshot: {
+            HeapSnapshot ps;
+            ps.id    = static_cast<uint32_t>(body.varint());
+            ps.label = "peak";
+            ps.t_ms  = body.varint();
+            ps.bytes = body.varint();
+            ps.count = body.varint();
+            const uint64_t k = body.varint();
+            uint64_t site = 0;
+            for (uint64_t j = 0; j < k && body.ok(); ++j) {
+                site += body.varint();
+                SiteUsage u;
+                u.site  = site < site_name_.size() ? site_name_[site] : "site#" + std::to_string(site);
+                u.bytes = body.varint();
+                u.count = body.varint();
+                ps.sites.push_back(std::move(u));
+            }
+            if (body.ok()) peak_ = std::move(ps);
+            break;
+        }
+        case wire::Section::Removed: {
+            const uint64_t cnt = body.varint();
+            uint64_t ptr = 0;
+            for (uint64_t i = 0; i < cnt && body.ok(); ++i) {
+                ptr += body.varint();
+                auto it = blocks_.find(ptr);
+                if (it == blocks_.end()) continue;
+                dropBlock(it->second);
+                blocks_.erase(it);
+            }
+            break;
+        }
+        default:
+            break;   // Timeline, pilas, símbolos o sección desconocida
+        }
+        if (!body.ok()) { bin_valid_ = false; return false; }
+    }
+    if (!r.ok()) { bin_valid_ = false; return false; }
+    return true;
+}
+
+// ------------------------------ entrada ------------------------------------
+
+size_t SnapshotStream::feed(const char* data, size_t n, bool eof) {
+    size_t off = 0;
+    while (off < n) {
+        const char c = data[off];
+        if (c == '\n' || c == '\r' || c == ' ' || c == '\t') { ++off; continue; }
+
+        if (wire::looksLikeFrame(data + off, n - off)) {
+            wire::FrameHeader h;
+            const auto st = wire::peekFrame(data + off, n - off, h);
+            if (st == wire::FrameStatus::NeedMore && !eof) break;
+            if (st != wire::FrameStatus::Ok) {
+                // Cabecera inválida o trama cortada: se resincroniza en la siguiente
+                ++errors_;
+                bin_valid_ = false;
+                ++off;
+                continue;
+            }
+            if (h.kind == wire::Kind::Hello) {   // identidad del proceso: no es un snapshot
+                off += wire::kHeaderSize + h.length;
+                continue;
+            }
+            const bool ok = applyFrame(data + off + wire::kHeaderSize, h.length, h.kind == wire::Kind::Snapshot);
+            if (ok) { ++snapshots_; cb_(cur_); }
+            else    ++errors_;
+            off += wire::kHeaderSize + h.length;
+            continue;
+        }
+
+        const void* nl = std::memchr(data + off, '\n', n - off);
+        if (!nl && !eof) break;
+        const char* line_end = nl ? static_cast<const char*>(nl) : data + n;
+        if (c == '{' && parseJsonLine(data + off, line_end)) { ++snapshots_; cb_(cur_); }
+        else ++errors_;
+        off = static_cast<size_t>(line_end - data) + (nl ? 1 : 0);
+    }
+    return off;
+}
+
+} // namespace analyze
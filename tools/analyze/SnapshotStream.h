@@ -0,0 +1,88 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Decodificador en streaming de una captura del runtime: líneas JSON
+// (MEMPROF_WIRE_FORMAT=json) o tramas binarias (memprof/proto/WireFormat.h),
+// mezcladas o no. No construye un DOM: cada snapshot se reduce al vuelo a un
+// Sample y se entrega al callback; solo se guarda el estado que exigen los
+// deltas binarios (bloques vivos y sitios).
+namespace analyze {
+
+struct Bin {
+    uint64_t lo = 0, hi = 0, bytes = 0, allocations = 0;
+};
+
+// Snapshot de heap con nombre (memprof_take_snapshot): bytes vivos por sitio
+struct SiteUsage {
+    std::string site;   // "archivo:línea (tipo)"
+    uint64_t    bytes = 0, count = 0;
+};
+
+struct HeapSnapshot {
+    uint32_t    id = 0;
+    std::string label;
+    uint64_t    t_ms = 0;
+    uint64_t    bytes = 0, count = 0;
+    std::vector<SiteUsage> sites;
+};
+
+struct Sample {
+    uint64_t uptime_ms     = 0;
+    uint64_t heap_current  = 0;
+    uint64_t heap_peak     = 0;
+    uint64_t active_allocs = 0;
+    uint64_t total_allocs  = 0;
+    uint64_t leak_bytes    = 0;
+    std::unordered_map<std::string, uint64_t> live_by_file;   // bytes vivos (per_file.netBytes)
+    std::unordered_map<std::string, uint64_t> leak_by_file;   // Σ size de bloques is_leak
+    std::vector<Bin> bins;
+};
+
+class SnapshotStream {
+public:
+    using Callback = std::function<void(const Sample&)>;
+
+    explicit SnapshotStream(Callback cb) : cb_(std::move(cb)) {}
+
+    // Procesa todos los registros completos de [data, data + n) y devuelve los
+    // bytes consumidos; el resto se vuelve a pasar con más datos. Con 'eof' la
+    // última línea JSON no necesita '\n'.
+    size_t feed(const char* data, size_t n, bool eof);
+
+    uint64_t snapshots() const { return snapshots_; }
+    uint64_t errors() const { return errors_; }   // líneas/tramas descartadas
+
+    // Snapshots con nombre vistos en toda la captura, por id creciente
+    const std::vector<HeapSnapshot>& heapSnapshots() const { return heap_snaps_; }
+    // Última captura automática en el pico (label "peak"; id 0 = ninguna)
+    const HeapSnapshot& peakSnapshot() const { return peak_; }
+
+private:
+    bool parseJsonLine(const char* p, const char* end);
+    bool applyFrame(const char* payload, size_t n, bool keyframe);
+
+    struct Block { uint32_t site; uint64_t size; bool leak; };
+    void dropBlock(const Block& b);
+    void addHeapSnapshot(HeapSnapshot&& hs);
+
+    Callback cb_;
+    Sample   cur_;
+    uint64_t snapshots_ = 0;
+    uint64_t errors_ = 0;
+
+    // Estado de los deltas binarios
+    bool     bin_valid_ = false;
+    uint64_t epoch_ = 0;
+    std::vector<std::string>               site_file_;
+    std::vector<std::string>               site_name_;   // para HeapSnapshots
+    std::vector<HeapSnapshot>              heap_snaps_;
+    HeapSnapshot                           peak_;
+    std::unordered_map<uint64_t, Block>    blocks_;
+};
+
+} // namespace analyze
@@ -0,0 +1,175 @@
+#include "TraceReplay.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+#include "memprof/proto/TraceReader.h"
+
+namespace analyze {
+
+// 0..3 exactas y después 4 subclases por potencia de 2; la última acumula el resto
+size_t TraceReplay::sizeBin(uint64_t size) {
+    if (size < 4) return static_cast<size_t>(size);
+    const unsigned e = static_cast<unsigned>(std::bit_width(size)) - 1;
+    const size_t   b = size_t(e - 1) * 4 + ((size >> (e - 2)) & 3);
+    return b < kSizeBins ? b : kSizeBins - 1;
+}
+
+uint64_t TraceReplay::sizeBinLow(size_t bin) {
+    if (bin < 4) return bin;
+    const unsigned e = static_cast<unsigned>(bin / 4) + 1;
+    return (4 + uint64_t(bin % 4)) << (e - 2);
+}
+
+bool TraceReplay::feedSegment(const void* data, size_t n) {
+    trace::SegmentReader in(data, n);
+    if (!in.ok()) { ++errors_; return false; }
+    ++segments_;
+    // Cada segmento es autocontenido: sus ids de String y sus módulos
+    seg_strings_.clear();
+    modules_.clear();
+    if (!start_ns_) {
+        start_ns_     = in.header().base_ts_ns;
+        next_tick_ns_ = start_ns_ + kTickMs * 1'000'000;
+    }
+    trace::Record r;
+    while (in.next(r)) onRecord(r);
+    if (!in.ok()) ++errors_;
+    return true;
+}
+
+void TraceReplay::finish() {
+    if (last_ns_) emit(last_ns_);
+}
+
+uint32_t TraceReplay::fileId(std::string_view name) {
+    auto it = file_index_.find(std::string(name));
+    if (it != file_index_.end()) return it->second;
+    const auto id = static_cast<uint32_t>(files_.size());
+    files_.emplace_back(name);
+    file_index_.emplace(files_.back(), id);
+    per_file_.resize(files_.size());
+    return id;
+}
+
+uint32_t TraceReplay::callerFile(uint64_t pc) {
+    auto it = std::upper_bound(modules_.begin(), modules_.end(), pc,
+                               [](uint64_t v, const Module& m) { return v < m.base; });
+    if (it == modules_.begin()) return fileId("unknown");
+    return std::prev(it)->file;
+}
+
+void TraceReplay::onRecord(const trace::Record& r) {
+    switch (r.kind) {
+        case trace::Rec::String:
+            seg_strings_[r.id] = fileId(r.text);
+            return;
+        case trace::Rec::Module: {
+            const Module m{r.base, fileId(r.text)};
+            modules_.insert(std::upper_bound(modules_.begin(), modules_.end(), m,
+                                             [](const Module& a, const Module& b) { return a.base < b.base; }),
+                            m);
+            return;
+        }
+        case trace::Rec::Stack:
+            return;
+        default:
+            break;
+    }
+
+    // Cortes pendientes hasta este evento (tiempo de traza, no de reloj)
+    while (r.ts_ns >= next_tick_ns_) {
+        emit(next_tick_ns_);
+        next_tick_ns_ += kTickMs * 1'000'000;
+    }
+    last_ns_ = r.ts_ns;
+
+    if (r.kind == trace::Rec::Free) {
+        drop(r.ptr, r.ts_ns);
+        return;
+    }
+
+    drop(r.ptr, UINT64_MAX);   // dirección reutilizada sin free visto
+    uint32_t file;
+    if (r.file) {
+        auto it = seg_strings_.find(r.file);
+        file = it != seg_strings_.end() ? it->second : fileId("unknown");
+    } else {
+        file = r.caller ? callerFile(r.caller) : fileId("unknown");
+    }
+    const bool exact = r.weight == 1.0f;
+    const uint64_t bytes = exact ? r.size : static_cast<uint64_t>(std::llround(double(r.size) * r.weight));
+    const uint64_t count = exact ? 1 : static_cast<uint64_t>(std::llround(r.weight));
+    live_[r.ptr] = Block{r.size, bytes, count, r.ts_ns, file, false};
+    age_.emplace_back(r.ts_ns, r.ptr);
+
+    heap_   += bytes;
+    active_ += count;
+    total_  += count;
+    peak_    = std::max(peak_, heap_);
+    per_file_[file].live += bytes;
+    const size_t bi = sizeBin(r.size);
+    bin_bytes_[bi]  += bytes;
+    bin_count_[bi]  += count;
+    bin_allocs_[bi] += count;
+}
+
+// 'ts': un free anterior a la alloc viva es de una vida previa de la dirección
+void TraceReplay::drop(uint64_t ptr, uint64_t ts) {
+    auto it = live_.find(ptr);
+    if (it == live_.end() || it->second.ts > ts) return;
+    const Block& b = it->second;
+    heap_   -= b.bytes;
+    active_ -= b.count;
+    per_file_[b.file].live -= b.bytes;
+    if (b.leak) {
+        leak_bytes_ -= b.bytes;
+        per_file_[b.file].leak -= b.bytes;
+    }
+    const size_t bi = sizeBin(b.size);
+    bin_bytes_[bi] -= b.bytes;
+    bin_count_[bi] -= b.count;
+    live_.erase(it);
+}
+
+void TraceReplay::promote(uint64_t now) {
+    while (age_head_ < age_.size() && now > age_[age_head_].first &&
+           now - age_[age_head_].first > leak_ns_) {
+        const auto [ts, ptr] = age_[age_head_++];
+        auto it = live_.find(ptr);
+        if (it == live_.end() || it->second.ts != ts || it->second.leak) continue;
+        it->second.leak = true;
+        leak_bytes_ += it->second.bytes;
+        per_file_[it->second.file].leak += it->second.bytes;
+    }
+    if (age_head_ > 4096 && age_head_ * 2 > age_.size()) {
+        age_.erase(age_.begin(), age_.begin() + static_cast<std::ptrdiff_t>(age_head_));
+        age_head_ = 0;
+    }
+}
+
+void TraceReplay::emit(uint64_t now) {
+    promote(now);
+    Sample s;
+    s.uptime_ms     = (now - start_ns_) / 1'000'000;
+    s.heap_current  = heap_;
+    s.heap_peak     = peak_;
+    s.active_allocs = active_;
+    s.total_allocs  = total_;
+    s.leak_bytes    = leak_bytes_;
+    for (size_t f = 0; f < per_file_.size(); ++f) {
+        if (per_file_[f].live) s.live_by_file.emplace(files_[f], per_file_[f].live);
+        if (per_file_[f].leak) s.leak_by_file.emplace(files_[f], per_file_[f].leak);
+    }
+    // Como getSizeBins: el tramo entre la primera y la última clase usada
+    size_t first = 0, last = kSizeBins;
+    while (first < kSizeBins && bin_allocs_[first] == 0) ++first;
+    while (last > first && bin_allocs_[last - 1] == 0) --last;
+    for (size_t i = first; i < last; ++i)
+        s.bins.push_back(Bin{sizeBinLow(i), i + 1 < kSizeBins ? sizeBinLow(i + 1) : (UINT64_C(1) << 62),
+                             bin_bytes_[i], bin_count_[i]});
+    cb_(s);
+}
+
+} // namespace analyze
@@ -0,0 +1,72 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "SnapshotStream.h"
+
+namespace trace { struct Record; }
+
+// Reproduce una traza grabada (<prefijo>.NNNNNN.mpt, ver TraceFormat.h) y la
+// reduce a la misma serie de Sample que una captura del runtime: un corte
+// cada kTickMs de tiempo de traza, como el tick del sender. No hay
+// simbolizador: las allocs sin file/line (preload) cuentan para la ruta del
+// módulo que contiene su caller. Fugas: bloques vivos más antiguos que
+// 'leak_ms' respecto al último evento, con el mismo índice por antigüedad
+// que MetricsAggregator.
+namespace analyze {
+
+class TraceReplay {
+public:
+    static constexpr uint64_t kTickMs = 250;
+
+    TraceReplay(SnapshotStream::Callback cb, uint64_t leak_ms = 3000)
+        : cb_(std::move(cb)), leak_ns_(leak_ms * 1'000'000) {}
+
+    // Segmento completo en memoria; false si la cabecera no es válida.
+    // Un registro malformado corta el segmento y cuenta en errors().
+    bool feedSegment(const void* data, size_t n);
+    void finish();   // último corte
+
+    uint64_t segments() const { return segments_; }
+    uint64_t errors() const { return errors_; }
+
+private:
+    struct Block { uint64_t size, bytes, count, ts; uint32_t file; bool leak; };
+    struct Module { uint64_t base; uint32_t file; };
+
+    void onRecord(const trace::Record& r);
+    void drop(uint64_t ptr, uint64_t ts);
+    void promote(uint64_t now);
+    void emit(uint64_t now);
+    uint32_t fileId(std::string_view name);
+    uint32_t callerFile(uint64_t pc);
+
+    SnapshotStream::Callback cb_;
+    uint64_t leak_ns_;
+    uint64_t segments_ = 0, errors_ = 0;
+    uint64_t start_ns_ = 0, next_tick_ns_ = 0, last_ns_ = 0;
+
+    // Archivos (globales a la traza) y tablas del segmento actual
+    std::vector<std::string>                  files_;
+    std::unordered_map<std::string, uint32_t> file_index_;
+    std::unordered_map<uint32_t, uint32_t>    seg_strings_;   // id de String -> archivo
+    std::vector<Module>                       modules_;       // por base creciente
+
+    std::unordered_map<uint64_t, Block> live_;
+    std::vector<std::pair<uint64_t, uint64_t>> age_;          // (ts, ptr) en orden de llegada
+    size_t   age_head_ = 0;
+    struct FileRow { uint64_t live = 0, leak = 0; };
+    std::vector<FileRow> per_file_;
+    // Mismas clases de tamaño que MetricsAggregator (sizeBinIndex)
+    static constexpr size_t kSizeBins = 160;
+    static size_t   sizeBin(uint64_t size);
+    static uint64_t sizeBinLow(size_t bin);
+    uint64_t bin_bytes_[kSizeBins] = {}, bin_count_[kSizeBins] = {}, bin_allocs_[kSizeBins] = {};
+
+    uint64_t heap_ = 0, peak_ = 0, active_ = 0, total_ = 0, leak_bytes_ = 0;
+};
+
+} // namespace analyze
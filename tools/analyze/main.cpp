@@ -0,0 +1,569 @@
+// tools/analyze/main.cpp
+//
+// memprof-analyze: resume una captura del runtime sin GUI y la compara con
+// presupuestos, para cortar regresiones de memoria en CI.
+//
+//   nc -l 7070 > run.cap &  ./app           # o MEMPROF_WIRE_FORMAT=json
+//   memprof-analyze run.cap --max-peak 256M --max-file-leak-growth 1M
+//   memprof-analyze run.cap --diff warm,after-load   # snapshots con nombre
+//   MEMPROF_TRACE=rec ./app && memprof-analyze rec.000000.mpt --max-leak 0
+//
+// Un archivo .mpt se reproduce como traza grabada, con sus segmentos
+// siguientes (ver TraceReplay). Sin archivo (o con "-") lee de stdin. Código de salida: 0 dentro de
+// presupuesto, 1 algún presupuesto superado, 2 error de uso o captura vacía.
+#include "SnapshotStream.h"
+#include "TraceReplay.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using analyze::Bin;
+using analyze::HeapSnapshot;
+using analyze::Sample;
+
+namespace {
+
+struct Options {
+    const char* input = nullptr;        // nullptr = stdin
+    uint64_t    warmup_ms = 0;          // snapshots anteriores no cuentan como línea base
+    size_t      top = 10;
+    bool        json = false;
+    const char* diff = nullptr;         // "A,B": etiquetas o #id de memprof_take_snapshot
+    uint64_t    leak_ms = 3000;         // trazas: antigüedad para contar como fuga
+
+    std::optional<uint64_t> max_peak;
+    std::optional<uint64_t> max_final_heap;
+    std::optional<uint64_t> max_leak;
+    std::optional<uint64_t> max_file_leak_growth;
+    std::optional<double>   max_heap_slope;     // bytes/s
+    std::optional<double>   max_hist_drift;     // 0..1
+    std::optional<uint64_t> max_site_growth;    // entre los snapshots de --diff
+};
+
+void usage() {
+    std::fprintf(stderr,
+        "uso: memprof-analyze [captura|-] [opciones]\n"
+        "  --warmup-ms MS              ignora los snapshots con uptime < MS\n"
+        "  --top N                     archivos listados (10)\n"
+        "  --json                      resumen en JSON por stdout\n"
+        "  --diff A,B                  crecimiento por sitio entre dos snapshots con\n"
+        "                              nombre (etiqueta o #id; por defecto el primero\n"
+        "                              y el último si hay --max-site-growth); \"peak\"\n"
+        "                              es la captura automática en el pico\n"
+        "  --leak-ms MS                trazas .mpt: antigüedad de una fuga (3000)\n"
+        "presupuestos (tamaños con sufijo k/M/G opcional):\n"
+        "  --max-peak SIZE             pico de heap\n"
+        "  --max-final-heap SIZE       heap al final de la captura\n"
+        "  --max-leak SIZE             bytes en fugas al final\n"
+        "  --max-file-leak-growth SIZE crecimiento de fugas de un archivo\n"
+        "  --max-heap-slope SIZE       pendiente del heap (bytes/s)\n"
+        "  --max-hist-drift F          deriva del histograma de tamaños (0..1)\n"
+        "  --max-site-growth SIZE      crecimiento de un sitio entre los snapshots de --diff\n");
+}
+
+bool parseSize(const char* s, uint64_t& out) {
+    char* end = nullptr;
+    errno = 0;
+    const double v = std::strtod(s, &end);
+    if (errno || end == s || v < 0) return false;
+    double mul = 1;
+    switch (*end) {
+        case 'k': case 'K': mul = 1024.0; ++end; break;
+        case 'm': case 'M': mul = 1024.0 * 1024; ++end; break;
+        case 'g': case 'G': mul = 1024.0 * 1024 * 1024; ++end; break;
+        default: break;
+    }
+    if (*end == 'B' || *end == 'b') ++end;
+    if (*end) return false;
+    out = static_cast<uint64_t>(v * mul);
+    return true;
+}
+
+bool parseArgs(int argc, char** argv, Options& o) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view a = argv[i];
+        auto value = [&]() -> const char* { return i + 1 < argc ? argv[++i] : nullptr; };
+        auto size  = [&](std::optional<uint64_t>& dst) {
+            const char* v = value();
+            uint64_t x;
+            if (!v || !parseSize(v, x)) return false;
+            dst = x;
+            return true;
+        };
+        bool ok = true;
+        if      (a == "--max-peak")             ok = size(o.max_peak);
+        else if (a == "--max-final-heap")       ok = size(o.max_final_heap);
+        else if (a == "--max-leak")             ok = size(o.max_leak);
+        else if (a == "--max-file-leak-growth") ok = size(o.max_file_leak_growth);
+        else if (a == "--max-site-growth")      ok = size(o.max_site_growth);
+        else if (a == "--max-heap-slope") {
+            std::optional<uint64_t> x;
+            ok = size(x);
+            if (ok) o.max_heap_slope = static_cast<double>(*x);
+        } else if (a == "--max-hist-drift") {
+            const char* v = value();
+            ok = v != nullptr;
+            if (ok) o.max_hist_drift = std::strtod(v, nullptr);
+        } else if (a == "--warmup-ms") {
+            uint64_t x;
+            const char* v = value();
+            ok = v && parseSize(v, x);
+            if (ok) o.warmup_ms = x;
+        } else if (a == "--leak-ms") {
+            uint64_t x;
+            const char* v = value();
+            ok = v && parseSize(v, x);
+            if (ok) o.leak_ms = x;
+        } else if (a == "--top") {
+            const char* v = value();
+            ok = v != nullptr;
+            if (ok) o.top = std::strtoul(v, nullptr, 10);
+        } else if (a == "--diff") {
+            o.diff = value();
+            ok = o.diff && std::strchr(o.diff, ',');
+        } else if (a == "--json") {
+            o.json = true;
+        } else if (a == "-h" || a == "--help") {
+            return false;
+        } else if (a == "-" || a[0] != '-') {
+            if (o.input) return false;
+            o.input = argv[i];
+            if (a == "-") o.input = nullptr;
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            std::fprintf(stderr, "memprof-analyze: argumento inválido: %s\n", argv[i]);
+            return false;
+        }
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Reducción en streaming: solo se guardan el primer snapshot (tras el warmup)
+// y el último, más acumuladores de la serie del heap.
+// ---------------------------------------------------------------------------
+inline bool hasBytes(const std::vector<Bin>& v) {
+    return std::any_of(v.begin(), v.end(), [](const Bin& x) { return x.bytes > 0; });
+}
+
+struct Reducer {
+    uint64_t warmup_ms = 0;
+
+    uint64_t count = 0;
+    bool     have_first = false;
+    Sample   first;
+    Sample   last;
+    std::vector<Bin> first_bins;   // primer histograma con bytes (base de la deriva)
+    uint64_t peak = 0;
+    uint64_t heap_min = UINT64_MAX;
+    uint64_t peak_at_ms = 0;
+
+    // Mínimos cuadrados de heap_current frente al tiempo (s)
+    double sx = 0, sy = 0, sxx = 0, sxy = 0;
+
+    void operator()(const Sample& s) {
+        if (s.heap_peak > peak) { peak = s.heap_peak; peak_at_ms = s.uptime_ms; }
+        if (s.uptime_ms < warmup_ms) return;
+        ++count;
+        if (!have_first) { first = s; have_first = true; }
+        if (first_bins.empty() && hasBytes(s.bins)) first_bins = s.bins;
+        heap_min = std::min(heap_min, s.heap_current);
+        const double x = static_cast<double>(s.uptime_ms) / 1000.0;
+        const double y = static_cast<double>(s.heap_current);
+        sx += x; sy += y; sxx += x * x; sxy += x * y;
+        last = s;
+    }
+
+    double slope() const {
+        const double n = static_cast<double>(count);
+        const double den = n * sxx - sx * sx;
+        return count >= 2 && den > 0 ? (n * sxy - sx * sy) / den : 0.0;
+    }
+    double meanHeap() const { return count ? sy / static_cast<double>(count) : 0.0; }
+};
+
+struct FileGrowth {
+    std::string file;
+    int64_t     leak_delta = 0;
+    uint64_t    leak_last = 0;
+    int64_t     live_delta = 0;
+};
+
+std::vector<FileGrowth> fileGrowth(const Sample& a, const Sample& b) {
+    std::vector<FileGrowth> out;
+    auto get = [](const std::unordered_map<std::string, uint64_t>& m, const std::string& k) -> uint64_t {
+        auto it = m.find(k);
+        return it == m.end() ? 0 : it->second;
+    };
+    std::unordered_map<std::string, size_t> idx;
+    auto row = [&](const std::string& f) -> FileGrowth& {
+        auto [it, fresh] = idx.try_emplace(f, out.size());
+        if (fresh) out.push_back(FileGrowth{f});
+        return out[it->second];
+    };
+    for (const auto& m : {&a.leak_by_file, &b.leak_by_file, &a.live_by_file, &b.live_by_file})
+        for (const auto& kv : *m) row(kv.first);
+    for (auto& g : out) {
+        g.leak_last  = get(b.leak_by_file, g.file);
+        g.leak_delta = static_cast<int64_t>(g.leak_last) - static_cast<int64_t>(get(a.leak_by_file, g.file));
+        g.live_delta = static_cast<int64_t>(get(b.live_by_file, g.file)) -
+                       static_cast<int64_t>(get(a.live_by_file, g.file));
+    }
+    std::sort(out.begin(), out.end(), [](const FileGrowth& x, const FileGrowth& y) {
+        return x.leak_delta != y.leak_delta ? x.leak_delta > y.leak_delta : x.live_delta > y.live_delta;
+    });
+    return out;
+}
+
+// Deriva del histograma: distancia de variación total entre los repartos de
+// bytes por bin del primer histograma con bytes y del último snapshot
+// (0 = igual, 1 = disjuntos). Los primeros ticks pueden llegar sin bins.
+struct BinDrift { uint64_t lo, hi; double share_a, share_b; };
+
+double histDrift(const std::vector<Bin>& a, const std::vector<Bin>& b, std::vector<BinDrift>& bins) {
+    auto total = [](const std::vector<Bin>& v) {
+        uint64_t t = 0;
+        for (const auto& x : v) t += x.bytes;
+        return t;
+    };
+    const double ta = static_cast<double>(total(a));
+    const double tb = static_cast<double>(total(b));
+    bins.clear();
+    for (const auto& x : a) bins.push_back({x.lo, x.hi, ta > 0 ? x.bytes / ta : 0.0, 0.0});
+    for (const auto& y : b) {
+        auto it = std::find_if(bins.begin(), bins.end(),
+                               [&](const BinDrift& d) { return d.lo == y.lo && d.hi == y.hi; });
+        const double share = tb > 0 ? y.bytes / tb : 0.0;
+        if (it != bins.end()) it->share_b = share;
+        else                  bins.push_back({y.lo, y.hi, 0.0, share});
+    }
+    if (ta == 0 || tb == 0) return 0.0;
+    double d = 0;
+    for (const auto& x : bins) d += std::fabs(x.share_a - x.share_b);
+    return d / 2;
+}
+
+// Crecimiento por sitio entre dos snapshots con nombre
+struct SiteGrowth {
+    std::string site;
+    uint64_t    bytes_a = 0, bytes_b = 0;
+    uint64_t    count_a = 0, count_b = 0;
+    int64_t dBytes() const { return static_cast<int64_t>(bytes_b) - static_cast<int64_t>(bytes_a); }
+    int64_t dCount() const { return static_cast<int64_t>(count_b) - static_cast<int64_t>(count_a); }
+};
+
+std::vector<SiteGrowth> siteGrowth(const HeapSnapshot& a, const HeapSnapshot& b) {
+    std::vector<SiteGrowth> out;
+    std::unordered_map<std::string_view, size_t> idx;
+    auto row = [&](const std::string& site) -> SiteGrowth& {
+        auto [it, fresh] = idx.try_emplace(site, out.size());
+        if (fresh) out.push_back(SiteGrowth{site});
+        return out[it->second];
+    };
+    for (const auto& u : a.sites) { auto& g = row(u.site); g.bytes_a += u.bytes; g.count_a += u.count; }
+    for (const auto& u : b.sites) { auto& g = row(u.site); g.bytes_b += u.bytes; g.count_b += u.count; }
+    out.erase(std::remove_if(out.begin(), out.end(),
+                             [](const SiteGrowth& g) { return g.dBytes() == 0 && g.dCount() == 0; }),
+              out.end());
+    std::sort(out.begin(), out.end(), [](const SiteGrowth& x, const SiteGrowth& y) {
+        return x.dBytes() != y.dBytes() ? x.dBytes() > y.dBytes() : x.dCount() > y.dCount();
+    });
+    return out;
+}
+
+// "etiqueta" o "#id"; con etiquetas repetidas gana la última. "peak" es la
+// captura automática en el pico salvo que un snapshot se llame así.
+const HeapSnapshot* findSnapshot(const analyze::SnapshotStream& stream, std::string_view key) {
+    const auto& snaps = stream.heapSnapshots();
+    if (key.size() > 1 && key[0] == '#') {
+        const auto id = std::strtoul(std::string(key.substr(1)).c_str(), nullptr, 10);
+        for (const auto& s : snaps)
+            if (s.id == id) return &s;
+        return nullptr;
+    }
+    for (auto it = snaps.rbegin(); it != snaps.rend(); ++it)
+        if (it->label == key) return &*it;
+    if (key == "peak" && stream.peakSnapshot().id) return &stream.peakSnapshot();
+    return nullptr;
+}
+
+// Lee la captura entera (mmap) o stdin por bloques
+// Mapea 'path' entero y se lo pasa a fn(data, n); un archivo vacío no llama
+template <class Fn>
+bool withMapped(const char* path, Fn&& fn) {
+    const int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) { std::perror(path); return false; }
+    struct stat st{};
+    if (::fstat(fd, &st) != 0) { std::perror(path); ::close(fd); return false; }
+    const size_t n = static_cast<size_t>(st.st_size);
+    if (n == 0) { ::close(fd); return true; }
+    void* m = ::mmap(nullptr, n, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (m == MAP_FAILED) { std::perror(path); return false; }
+    ::madvise(m, n, MADV_SEQUENTIAL);
+    fn(static_cast<const char*>(m), n);
+    ::munmap(m, n);
+    return true;
+}
+
+bool isTrace(const char* path) {
+    return path && std::string_view(path).ends_with(".mpt");
+}
+
+// <prefijo>.NNNNNN.mpt: desde ese segmento hasta el primero que falte
+bool replayTrace(const Options& o, analyze::TraceReplay& replay) {
+    const std::string_view in = o.input;
+    const std::string_view stem = in.substr(0, in.size() - 4);
+    const size_t dot = stem.rfind('.');
+    unsigned index = 0;
+    if (dot == std::string_view::npos ||
+        std::from_chars(stem.data() + dot + 1, stem.data() + stem.size(), index).ptr != stem.data() + stem.size()) {
+        std::fprintf(stderr, "memprof-analyze: %s no es un segmento <prefijo>.NNNNNN.mpt\n", o.input);
+        return false;
+    }
+    const std::string prefix(stem.substr(0, dot));
+    std::string path = o.input;
+    for (;;) {
+        bool valid = true;
+        if (!withMapped(path.c_str(), [&](const char* p, size_t n) { valid = replay.feedSegment(p, n); }))
+            return false;
+        if (!valid) std::fprintf(stderr, "memprof-analyze: %s: cabecera de segmento inválida\n", path.c_str());
+        char next[32];
+        std::snprintf(next, sizeof(next), ".%06u.mpt", ++index);
+        path = prefix + next;
+        if (::access(path.c_str(), F_OK) != 0) break;
+    }
+    replay.finish();
+    return true;
+}
+
+bool consume(const Options& o, analyze::SnapshotStream& stream) {
+    if (o.input)
+        return withMapped(o.input, [&](const char* p, size_t n) { stream.feed(p, n, true); });
+
+    std::vector<char> buf(size_t(1) << 20);
+    size_t have = 0;
+    for (;;) {
+        if (have == buf.size()) buf.resize(buf.size() * 2);   // registro mayor que el buffer
+        const ssize_t r = ::read(0, buf.data() + have, buf.size() - have);
+        if (r < 0) {
+            if (errno == EINTR) continue;
+            std::perror("stdin");
+            return false;
+        }
+        have += static_cast<size_t>(r);
+        const size_t used = stream.feed(buf.data(), have, r == 0);
+        std::memmove(buf.data(), buf.data() + used, have - used);
+        have -= used;
+        if (r == 0) return true;
+    }
+}
+
+void printJsonString(const std::string& s) {
+    std::putchar('"');
+    for (unsigned char c : s) {
+        if (c == '"' || c == '\\') std::printf("\\%c", c);
+        else if (c < 0x20)         std::printf("\\u%04X", c);
+        else                       std::putchar(c);
+    }
+    std::putchar('"');
+}
+
+// Tablas de texto: cabecera y filas con los mismos anchos, medidos en
+// caracteres visibles y no en bytes ("Δ" ocupa dos en UTF-8)
+constexpr int kNameCol = 40;   // archivo / sitio (tras la sangría de 2)
+constexpr int kNumCol  = 12;
+
+size_t displayWidth(std::string_view s) {
+    size_t w = 0;
+    for (unsigned char c : s) w += (c & 0xC0) != 0x80;   // no cuenta continuaciones
+    return w;
+}
+
+void printPadded(std::string_view s, int width, bool left) {
+    const size_t w = displayWidth(s);
+    const int pad = w < size_t(width) ? width - int(w) : 0;
+    if (!left) std::printf("%*s", pad, "");
+    std::fwrite(s.data(), 1, s.size(), stdout);
+    if (left) std::printf("%*s", pad, "");
+}
+
+void printTableHeader(const char* label, const char* c1, const char* c2, const char* c3) {
+    printPadded(label, 2 + kNameCol, true);
+    for (const char* c : {c1, c2, c3}) {
+        std::putchar(' ');
+        printPadded(c, kNumCol, false);
+    }
+    std::putchar('\n');
+}
+
+void printRowName(const std::string& name) {
+    std::printf("  ");
+    printPadded(name, kNameCol, true);
+}
+
+} // anon
+
+int main(int argc, char** argv) {
+    Options o;
+    if (!parseArgs(argc, argv, o)) { usage(); return 2; }
+
+    Reducer red;
+    red.warmup_ms = o.warmup_ms;
+    analyze::SnapshotStream stream([&red](const Sample& s) { red(s); });
+    analyze::TraceReplay    replay([&red](const Sample& s) { red(s); }, o.leak_ms);
+    if (!(isTrace(o.input) ? replayTrace(o, replay) : consume(o, stream))) return 2;
+    if (red.count == 0) {
+        std::fprintf(stderr, "memprof-analyze: sin snapshots válidos (%" PRIu64 " descartados)\n",
+                     stream.errors() + replay.errors());
+        return 2;
+    }
+
+    const Sample& a = red.first;
+    const Sample& b = red.last;
+    const auto    growth = fileGrowth(a, b);
+    std::vector<BinDrift> bins;
+    const double drift = histDrift(red.first_bins, b.bins, bins);
+    const double slope = red.slope();
+    const int64_t max_file_growth = growth.empty() ? 0 : std::max<int64_t>(0, growth.front().leak_delta);
+
+    // ----- diff de snapshots con nombre -----
+    const auto& snaps = stream.heapSnapshots();
+    const HeapSnapshot* snap_a = nullptr;
+    const HeapSnapshot* snap_b = nullptr;
+    std::vector<SiteGrowth> sites;
+    if (o.diff || o.max_site_growth) {
+        if (o.diff) {
+            const std::string_view d = o.diff;
+            const size_t comma = d.find(',');
+            snap_a = findSnapshot(stream, d.substr(0, comma));
+            snap_b = findSnapshot(stream, d.substr(comma + 1));
+        } else if (snaps.size() >= 2) {
+            snap_a = &snaps.front();
+            snap_b = &snaps.back();
+        }
+        if (!snap_a || !snap_b) {
+            std::fprintf(stderr, "memprof-analyze: snapshots no encontrados (%zu en la captura:", snaps.size());
+            for (const auto& s : snaps) std::fprintf(stderr, " #%u %s", s.id, s.label.c_str());
+            std::fprintf(stderr, ")\n");
+            return 2;
+        }
+        sites = siteGrowth(*snap_a, *snap_b);
+    }
+    const int64_t max_site_growth = sites.empty() ? 0 : std::max<int64_t>(0, sites.front().dBytes());
+
+    // ----- presupuestos -----
+    struct Check { const char* name; double value, limit; };
+    std::vector<Check> checks;
+    if (o.max_peak)             checks.push_back({"peak", double(red.peak), double(*o.max_peak)});
+    if (o.max_final_heap)       checks.push_back({"final_heap", double(b.heap_current), double(*o.max_final_heap)});
+    if (o.max_leak)             checks.push_back({"leak", double(b.leak_bytes), double(*o.max_leak)});
+    if (o.max_file_leak_growth) checks.push_back({"file_leak_growth", double(max_file_growth),
+                                                  double(*o.max_file_leak_growth)});
+    if (o.max_heap_slope)       checks.push_back({"heap_slope", slope, *o.max_heap_slope});
+    if (o.max_hist_drift)       checks.push_back({"hist_drift", drift, *o.max_hist_drift});
+    if (o.max_site_growth)      checks.push_back({"site_growth", double(max_site_growth), double(*o.max_site_growth)});
+    bool failed = false;
+    for (const auto& c : checks) failed |= c.value > c.limit;
+
+    const size_t top = std::min(o.top, growth.size());
+    if (o.json) {
+        std::printf("{\"snapshots\":%" PRIu64 ",\"discarded\":%" PRIu64 ",", red.count, stream.errors());
+        std::printf("\"duration_ms\":%" PRIu64 ",", b.uptime_ms - a.uptime_ms);
+        std::printf("\"heap\":{\"peak\":%" PRIu64 ",\"peak_at_ms\":%" PRIu64 ",\"min\":%" PRIu64
+                    ",\"mean\":%.0f,\"final\":%" PRIu64 ",\"slope_bytes_per_s\":%.1f},",
+                    red.peak, red.peak_at_ms, red.heap_min, red.meanHeap(), b.heap_current, slope);
+        std::printf("\"leaks\":{\"first\":%" PRIu64 ",\"final\":%" PRIu64 ",\"files\":[",
+                    a.leak_bytes, b.leak_bytes);
+        for (size_t i = 0; i < top; ++i) {
+            std::printf("%s{\"file\":", i ? "," : "");
+            printJsonString(growth[i].file);
+            std::printf(",\"leak_growth\":%" PRId64 ",\"leak_bytes\":%" PRIu64 ",\"live_growth\":%" PRId64 "}",
+                        growth[i].leak_delta, growth[i].leak_last, growth[i].live_delta);
+        }
+        std::printf("]},\"hist_drift\":%.4f,\"bins\":[", drift);
+        bool first_bin = true;
+        for (const auto& d : bins) {
+            if (d.share_a == 0 && d.share_b == 0) continue;
+            std::printf("%s{\"lo\":%" PRIu64 ",\"hi\":%" PRIu64 ",\"share_first\":%.4f,\"share_last\":%.4f}",
+                        first_bin ? "" : ",", d.lo, d.hi, d.share_a, d.share_b);
+            first_bin = false;
+        }
+        std::printf("]");
+        if (snap_a) {
+            std::printf(",\"diff\":{\"a\":{\"id\":%u,\"label\":", snap_a->id);
+            printJsonString(snap_a->label);
+            std::printf(",\"bytes\":%" PRIu64 "},\"b\":{\"id\":%u,\"label\":", snap_a->bytes, snap_b->id);
+            printJsonString(snap_b->label);
+            std::printf(",\"bytes\":%" PRIu64 "},\"sites\":[", snap_b->bytes);
+            for (size_t i = 0; i < std::min(o.top, sites.size()); ++i) {
+                std::printf("%s{\"site\":", i ? "," : "");
+                printJsonString(sites[i].site);
+                std::printf(",\"bytes_growth\":%" PRId64 ",\"count_growth\":%" PRId64 ",\"bytes\":%" PRIu64 "}",
+                            sites[i].dBytes(), sites[i].dCount(), sites[i].bytes_b);
+            }
+            std::printf("]}");
+        }
+        std::printf(",\"budgets\":[");
+        for (size_t i = 0; i < checks.size(); ++i)
+            std::printf("%s{\"name\":\"%s\",\"value\":%.1f,\"limit\":%.1f,\"ok\":%s}", i ? "," : "",
+                        checks[i].name, checks[i].value, checks[i].limit,
+                        checks[i].value > checks[i].limit ? "false" : "true");
+        std::printf("],\"ok\":%s}\n", failed ? "false" : "true");
+        return failed ? 1 : 0;
+    }
+
+    std::printf("snapshots      %" PRIu64 " (%" PRIu64 " descartados), %.1f s\n", red.count, stream.errors(),
+                double(b.uptime_ms - a.uptime_ms) / 1000.0);
+    std::printf("heap           pico %" PRIu64 " B (a los %.1f s), min %" PRIu64 " B, media %.0f B, final %" PRIu64 " B\n",
+                red.peak, double(red.peak_at_ms) / 1000.0, red.heap_min, red.meanHeap(), b.heap_current);
+    std::printf("tendencia      %+.1f B/s\n", slope);
+    std::printf("fugas          %" PRIu64 " B -> %" PRIu64 " B\n", a.leak_bytes, b.leak_bytes);
+    if (top) {
+        printTableHeader("por archivo", "Δfugas", "fugas", "Δvivos");
+        for (size_t i = 0; i < top; ++i) {
+            printRowName(growth[i].file);
+            std::printf(" %+*" PRId64 " %*" PRIu64 " %+*" PRId64 "\n", kNumCol, growth[i].leak_delta,
+                        kNumCol, growth[i].leak_last, kNumCol, growth[i].live_delta);
+        }
+    }
+    std::printf("histograma     deriva %.4f\n", drift);
+    for (const auto& d : bins)
+        if (std::fabs(d.share_a - d.share_b) >= 0.01)
+            std::printf("  [%" PRIu64 ", %" PRIu64 ")  %5.1f%% -> %5.1f%%\n", d.lo, d.hi,
+                        d.share_a * 100, d.share_b * 100);
+    if (snap_a) {
+        std::printf("diff           #%u %s -> #%u %s: %+" PRId64 " B, %+" PRId64 " bloques\n", snap_a->id,
+                    snap_a->label.c_str(), snap_b->id, snap_b->label.c_str(),
+                    static_cast<int64_t>(snap_b->bytes) - static_cast<int64_t>(snap_a->bytes),
+                    static_cast<int64_t>(snap_b->count) - static_cast<int64_t>(snap_a->count));
+        const size_t n = std::min(o.top, sites.size());
+        if (n) printTableHeader("por sitio", "Δbytes", "Δbloques", "bytes");
+        for (size_t i = 0; i < n; ++i) {
+            printRowName(sites[i].site);
+            std::printf(" %+*" PRId64 " %+*" PRId64 " %*" PRIu64 "\n", kNumCol, sites[i].dBytes(),
+                        kNumCol, sites[i].dCount(), kNumCol, sites[i].bytes_b);
+        }
+    }
+    for (const auto& c : checks)
+        std::printf("%-14s %s  %.1f (límite %.1f)\n", c.name, c.value > c.limit ? "FALLO" : "ok", c.value, c.limit);
+    return failed ? 1 : 0;
+}